@@ -9,7 +9,10 @@
 #include "CustomPGE.h"
 
 #include <cassert>
+#include <cmath>
+#include <ctime>
 #include <filesystem>  // requires cpp17
+#include <random>
 #include <set>
 #include <sstream>
 
@@ -20,6 +23,86 @@
 
 
 static constexpr char* CVAR_CL_SERVER_IP = "cl_server_ip";
+static constexpr char* CVAR_CL_LANGUAGE = "cl_language";
+static constexpr char* CVAR_NET_STATS_DUMP_FILE = "net_stats_dump_file";
+static constexpr char* CVAR_NET_STATS_DUMP_INTERVAL_SECS = "net_stats_dump_interval_secs";
+static constexpr char* CVAR_NET_CAPTURE_FILE = "net_capture_file";
+static constexpr char* CVAR_NET_REPLAY_FILE = "net_replay_file";
+static constexpr char* CVAR_NET_DECODE_THREAD = "net_decode_thread";
+static constexpr char* CVAR_NET_COND_LATENCY_MS = "net_cond_latency_ms";
+static constexpr char* CVAR_NET_COND_JITTER_MS = "net_cond_jitter_ms";
+static constexpr char* CVAR_NET_COND_LOSS_PERCENT = "net_cond_loss_percent";
+static constexpr char* CVAR_NET_COND_DUPLICATE_PERCENT = "net_cond_duplicate_percent";
+static constexpr char* CVAR_NET_COND_REORDER_PERCENT = "net_cond_reorder_percent";
+static constexpr char* CVAR_NET_COND_SEED = "net_cond_seed";
+static constexpr char* CVAR_LOG_ASYNC_FILE = "log_async_file";
+static constexpr char* CVAR_LOG_LEVELS = "log_levels";
+static constexpr char* CVAR_LOG_RATE_LIMIT_PER_SEC = "log_rate_limit_per_sec";
+static constexpr char* CVAR_BENCH_COLLISION_PLAYERS = "bench_collision_players";
+static constexpr char* CVAR_BENCH_VT_FRAMES = "bench_vt_frames";
+static constexpr char* CVAR_BENCH_OVERLAY_FRAMES = "bench_overlay_frames";
+static constexpr char* CVAR_BENCH_NET_COND_SECS = "bench_net_cond_secs";
+static constexpr char* CVAR_BENCH_PROJECTILES = "bench_projectiles";
+static constexpr char* CVAR_GFX_ARENA_STREAMING = "gfx_arena_streaming";
+static constexpr char* CVAR_GFX_ARENA_CHUNK_SIZE = "gfx_arena_chunk_size";
+static constexpr char* CVAR_GFX_ARENA_STREAM_RADIUS = "gfx_arena_stream_radius";
+static constexpr char* CVAR_GFX_ARENA_STREAM_UNLOAD_RADIUS = "gfx_arena_stream_unload_radius";
+static constexpr char* CVAR_GFX_ARENA_STREAM_BUDGET_KB = "gfx_arena_stream_budget_kb";
+static constexpr char* CVAR_GFX_MESH_OPTIMIZE = "gfx_mesh_optimize";
+static constexpr char* CVAR_GFX_TEXTURE_CACHE_BUDGET_KB = "gfx_texture_cache_budget_kb";
+static constexpr char* CVAR_GFX_VSYNC = "gfx_vsync";
+static constexpr char* CVAR_ASSET_PACK_FILE = "asset_pack_file";
+static constexpr char* CVAR_ASSET_PACK_BUILD = "asset_pack_build";
+static constexpr char* CVAR_ASSET_PACK_VERIFY = "asset_pack_verify";
+static constexpr char* CVAR_SV_MATCHES = "sv_matches";
+static constexpr char* CVAR_SV_MATCH_MAX_PLAYERS = "sv_match_max_players";
+static constexpr char* CVAR_SV_MATCH_THREADS = "sv_match_threads";
+static constexpr char* CVAR_SV_SEND_RATE_MIN = "sv_send_rate_min";
+static constexpr char* CVAR_SV_SEND_RATE_MAX = "sv_send_rate_max";
+static constexpr char* CVAR_SV_SEND_RATE_MAX_QUEUE_MS = "sv_send_rate_max_queue_ms";
+static constexpr char* CVAR_SV_SEND_RATE_MIN_QUALITY = "sv_send_rate_min_quality";
+static constexpr char* CVAR_SV_PROJECTILES_MAX = "sv_projectiles_max";
+
+static constexpr char* ARENA_FILENAME = "gamedata\\models\\arena\\arena.obj";
+static constexpr char* ARENA_LM_FILENAME = "gamedata\\models\\arena\\arena_lm.obj";
+static constexpr char* SNAIL_FILENAME = "gamedata\\models\\snail_proofps\\snail.obj";
+static constexpr char* SNAIL_LM_FILENAME = "gamedata\\models\\snail_proofps\\snail_lm.obj";
+static constexpr char* PROJECTILE_FILENAME = "gamedata\\models\\snail_proofps\\wpn_rocket_ammo.obj";
+static constexpr char* ARENA_CHUNKS_PREFIX = "gamedata\\models\\arena\\arena_chunk";  /**< Chunk files and index file are generated next to the arena. */
+static const float fArenaScaling = 0.002f;
+static const float fArenaPosY = -1.5f;
+static const float fArenaPosZ = 2.f;
+
+static const unsigned int nProfileCheckIntervalMSecs = 1000;  /**< Profile is watched for CVar changes this often. */
+static const uint64_t nSendRateUpdateIntervalUSecs = 250000;  /**< Connection metrics of clients are sampled for their send rates this often. */
+static const float fProjectileScaling = 0.002f;               /**< Projectile model is about 30 units wide. */
+static const uint32_t nMaxRenderedProjectiles = 128;          /**< Objects are cloned in advance, projectiles beyond this are simulated but not drawn. */
+static const float fMaxProjectileExtrapolationSecs = 0.1f;    /**< Projectiles are drawn ahead of their last snapshot by at most this much. */
+static const float fRadToDeg = 57.2957795f;
+
+/**
+    Time for NetConditioner.
+*/
+static uint64_t getNowUSecs()
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+    Lines of CustomPGE::m_overlay, added in this order, from top to bottom.
+*/
+enum OverlayLine : elte_fail::TOverlayTextId
+{
+    OVERLAY_VT_BENCHMARK = 0,
+    OVERLAY_PING,
+    OVERLAY_QUALITY,
+    OVERLAY_TXRX_SPEED,
+    OVERLAY_INTERNAL_QUEUE_TIME,
+    OVERLAY_CULLING,
+    OVERLAY_ARENA_CHUNKS,
+    OVERLAY_LINE_COUNT
+};
 
 
 // ############################### PUBLIC ################################
@@ -42,7 +125,65 @@ CustomPGE* CustomPGE::createAndGetCustomPGEinstance()
     This is the only usable ctor, this is used by the static createAndGet().
 */
 CustomPGE::CustomPGE(const char* gameTitle) :
-    PGE(gameTitle)
+    PGE(gameTitle),
+    m_hCameraTarget(elte_fail::EntityStore::hInvalid),
+    m_nUserNameId(elte_fail::StringTable::nInvalidStringId),
+    m_connHandleServerSideMe(0),
+    m_matchRules(0, m_strings, m_log),
+    m_bReplaying(false),
+    m_nReplayMsgsSent(0),
+    m_bArenaHidden(false),
+    m_cvClServerIp(m_cvars.add<std::string>(CVAR_CL_SERVER_IP)),
+    m_cvClLanguage(m_cvars.add<std::string>(CVAR_CL_LANGUAGE)),
+    m_cvNetStatsDumpFile(m_cvars.add<std::string>(CVAR_NET_STATS_DUMP_FILE)),
+    m_cvNetStatsDumpIntervalSecs(m_cvars.add<int>(CVAR_NET_STATS_DUMP_INTERVAL_SECS)),
+    m_cvNetCaptureFile(m_cvars.add<std::string>(CVAR_NET_CAPTURE_FILE)),
+    m_cvNetReplayFile(m_cvars.add<std::string>(CVAR_NET_REPLAY_FILE)),
+    m_cvNetDecodeThread(m_cvars.add<bool>(CVAR_NET_DECODE_THREAD)),
+    m_cvNetCondLatencyMs(m_cvars.add<int>(CVAR_NET_COND_LATENCY_MS)),
+    m_cvNetCondJitterMs(m_cvars.add<int>(CVAR_NET_COND_JITTER_MS)),
+    m_cvNetCondLossPercent(m_cvars.add<float>(CVAR_NET_COND_LOSS_PERCENT)),
+    m_cvNetCondDuplicatePercent(m_cvars.add<float>(CVAR_NET_COND_DUPLICATE_PERCENT)),
+    m_cvNetCondReorderPercent(m_cvars.add<float>(CVAR_NET_COND_REORDER_PERCENT)),
+    m_cvNetCondSeed(m_cvars.add<int>(CVAR_NET_COND_SEED)),
+    m_cvLogAsyncFile(m_cvars.add<std::string>(CVAR_LOG_ASYNC_FILE)),
+    m_cvLogLevels(m_cvars.add<std::string>(CVAR_LOG_LEVELS)),
+    m_cvLogRateLimitPerSec(m_cvars.add<int>(CVAR_LOG_RATE_LIMIT_PER_SEC)),
+    m_cvBenchCollisionPlayers(m_cvars.add<int>(CVAR_BENCH_COLLISION_PLAYERS)),
+    m_cvBenchVtFrames(m_cvars.add<int>(CVAR_BENCH_VT_FRAMES)),
+    m_cvBenchOverlayFrames(m_cvars.add<int>(CVAR_BENCH_OVERLAY_FRAMES)),
+    m_cvBenchNetCondSecs(m_cvars.add<int>(CVAR_BENCH_NET_COND_SECS)),
+    m_cvBenchProjectiles(m_cvars.add<int>(CVAR_BENCH_PROJECTILES)),
+    m_cvGfxArenaStreaming(m_cvars.add<bool>(CVAR_GFX_ARENA_STREAMING)),
+    m_cvGfxArenaChunkSize(m_cvars.add<float>(CVAR_GFX_ARENA_CHUNK_SIZE)),
+    m_cvGfxArenaStreamRadius(m_cvars.add<float>(CVAR_GFX_ARENA_STREAM_RADIUS)),
+    m_cvGfxArenaStreamUnloadRadius(m_cvars.add<float>(CVAR_GFX_ARENA_STREAM_UNLOAD_RADIUS)),
+    m_cvGfxArenaStreamBudgetKb(m_cvars.add<int>(CVAR_GFX_ARENA_STREAM_BUDGET_KB)),
+    m_cvGfxMeshOptimize(m_cvars.add<bool>(CVAR_GFX_MESH_OPTIMIZE)),
+    m_cvGfxTextureCacheBudgetKb(m_cvars.add<int>(CVAR_GFX_TEXTURE_CACHE_BUDGET_KB)),
+    m_cvGfxVsync(m_cvars.add<bool>(CVAR_GFX_VSYNC)),
+    m_cvAssetPackFile(m_cvars.add<std::string>(CVAR_ASSET_PACK_FILE)),
+    m_cvAssetPackBuild(m_cvars.add<bool>(CVAR_ASSET_PACK_BUILD)),
+    m_cvAssetPackVerify(m_cvars.add<bool>(CVAR_ASSET_PACK_VERIFY)),
+    m_cvSvMatches(m_cvars.add<int>(CVAR_SV_MATCHES)),
+    m_cvSvMatchMaxPlayers(m_cvars.add<int>(CVAR_SV_MATCH_MAX_PLAYERS)),
+    m_cvSvMatchThreads(m_cvars.add<int>(CVAR_SV_MATCH_THREADS)),
+    m_cvSvSendRateMin(m_cvars.add<float>(CVAR_SV_SEND_RATE_MIN)),
+    m_cvSvSendRateMax(m_cvars.add<float>(CVAR_SV_SEND_RATE_MAX)),
+    m_cvSvSendRateMaxQueueMs(m_cvars.add<int>(CVAR_SV_SEND_RATE_MAX_QUEUE_MS)),
+    m_cvSvSendRateMinQuality(m_cvars.add<float>(CVAR_SV_SEND_RATE_MIN_QUALITY)),
+    m_cvSvProjectilesMax(m_cvars.add<int>(CVAR_SV_PROJECTILES_MAX)),
+    m_nLatestPktsVersion(0),
+    m_nLatestPktsVersionFlushed(0),
+    m_nLatestPktsSuperseded(0),
+    m_nLastSendRateUpdateUSecs(0),
+    m_nUserCmdMoveSeq(0),
+    m_dirLastHorizontal(elte_fail::HorizontalDirection::RIGHT),
+    m_dirLastVertical(elte_fail::VerticalDirection::NONE),
+    m_nLastFireUSecs(0),
+    m_nProjectileObjectsShown(0),
+    m_log(m_asyncLog, m_asyncLog.registerModule(getLoggerModuleName(), elte_fail::LogLevel::Info)),
+    m_logNet(m_asyncLog, m_asyncLog.registerModule(getNetLoggerModuleName(), elte_fail::LogLevel::Info))
 {
 
 } // CustomPGE(...)
@@ -66,6 +207,12 @@ const char* CustomPGE::getLoggerModuleName()
 } // getLoggerModuleName()
 
 
+const char* CustomPGE::getNetLoggerModuleName()
+{
+    return "ElteFailNet";
+} // getNetLoggerModuleName()
+
+
 /**
     Must-have minimal stuff before loading anything.
     Game engine calls this before even finishing its own initialization.
@@ -109,41 +256,136 @@ bool CustomPGE::onGameInitialized()
 {
     getConsole().OLnOI("CustomPGE::onGameInitialized()");
 
+    // CVars are looked up by name only here, later they are read through their handles
+    m_cvars.resolve(getConfigProfiles().getVars());
+    const std::string sProfileName = getConfigProfiles().getProfileName(getConfigProfiles().getProfileIndex());
+    if (m_cvars.watchProfile("gamedata\\profiles\\" + sProfileName + "\\" + sProfileName + ".cfg"))
+    {
+        getConsole().OLn("Watching profile for CVar changes: %s", m_cvars.getProfileFilename().c_str());
+    }
+    else
+    {
+        getConsole().EOLn("Failed to watch profile %s, CVar changes will need restart!", sProfileName.c_str());
+    }
+
+    openAssetPack();
+
+    // all languages are compiled and mapped now, so switching language later doesn't read any file
+    for (const auto& entry : std::filesystem::directory_iterator("gamedata/language/"))
+    {
+        if (entry.path().extension() != ".txt")
+        {
+            continue;
+        }
+        if (!m_localization.add(entry.path().stem().string(), entry.path().string()))
+        {
+            getConsole().EOLn("Failed to load language file: %s", entry.path().string().c_str());
+        }
+    }
+    const auto fnLanguageChanged = [this](const std::string& sLanguage)
+    {
+        if (!m_localization.select(sLanguage))
+        {
+            getConsole().EOLn("Unknown %s: %s, using: %s", CVAR_CL_LANGUAGE, sLanguage.c_str(), m_localization.getSelectedName().c_str());
+        }
+    };
+    fnLanguageChanged(m_cvClLanguage.get());
+    m_cvClLanguage.addChangeCallback(fnLanguageChanged);
+    m_sUiText.reserve(elte_fail::Localization::nMaxFormattedLength);
+    for (elte_fail::TOverlayTextId i = 0; i < OVERLAY_LINE_COUNT; i++)
+    {
+        m_overlay.add(10, 30 + static_cast<int>(i) * 20);
+    }
+
+    // Packet handlers and gameplay log into the async log, so heavy logging doesn't show up in frame time and packet latency
+    const std::string sAsyncLogFile = m_cvLogAsyncFile.get().empty() ?
+        "ELTE-FAIL_async.log" : m_cvLogAsyncFile.get();
+    // levels and rate limit can also be changed while running, by saving the profile
+    const auto fnLogLevelsChanged = [this](const std::string& sLevels)
+    {
+        if (!sLevels.empty() && !m_asyncLog.setLevels(sLevels))
+        {
+            getConsole().EOLn("Invalid module level(s) in %s: %s", CVAR_LOG_LEVELS, sLevels.c_str());
+        }
+    };
+    fnLogLevelsChanged(m_cvLogLevels.get());
+    m_cvLogLevels.addChangeCallback(fnLogLevelsChanged);
+    m_asyncLog.setRateLimit(static_cast<uint32_t>(m_cvLogRateLimitPerSec.get()));
+    m_cvLogRateLimitPerSec.addChangeCallback([this](const int& nLimit) { m_asyncLog.setRateLimit(static_cast<uint32_t>(nLimit)); });
+    if (m_asyncLog.start(sAsyncLogFile))
+    {
+        getConsole().OLn("Async log file: %s", sAsyncLogFile.c_str());
+    }
+    else
+    {
+        getConsole().EOLn("Failed to open async log file: %s", sAsyncLogFile.c_str());
+    }
+
     // Dont want to see logs of loading of resources cause I'm debugging network now
     getConsole().SetLoggingState("4LLM0DUL3S", false);
 
     getPure().getCamera().SetNearPlane(0.1f);
     getPure().getCamera().SetFarPlane(100.0f);
 
-    getPure().getScreen().setVSyncEnabled(true);
+    // projectiles and hosted matches are ticked on their own threads, so frame rate may follow the display or be unlimited,
+    // players of our match are still moved by the frame, as their handlers move their PURE objects, see syncProjectileSim()
+    getPure().getScreen().setVSyncEnabled(m_cvGfxVsync.get());
+    m_cvGfxVsync.addChangeCallback([this](const bool& bVsync)
+        {
+            // benchmarks turn it back when they finish
+            if (!m_vtBenchmark.isRunning() && !m_overlayBenchmark.isRunning())
+            {
+                getPure().getScreen().setVSyncEnabled(bVsync);
+            }
+        });
+
+    // budget can be changed while running, by saving the profile
+    const auto fnTextureCacheBudgetChanged = [this](const int& nBudgetKb)
+    {
+        m_textureCache.setBudget(static_cast<uint64_t>(std::max(0, nBudgetKb)) * 1024);
+    };
+    fnTextureCacheBudgetChanged(m_cvGfxTextureCacheBudgetKb.get());
+    m_cvGfxTextureCacheBudgetKb.addChangeCallback(fnTextureCacheBudgetChanged);
 
-    PureTexture* const tex1 = getPure().getTextureManager().createFromFile("gamedata\\proba128x128x24.bmp");
+    // shared by boxes, never released
+    PureTexture* const tex1 = m_textureCache.acquire(getPure().getTextureManager(), "gamedata\\proba128x128x24.bmp");
 
     {   // create box object internally
-        m_box1 = getPure().getObject3DManager().createBox(1, 1, 1);
-        m_box1->getPosVec().SetZ(2.0f);
-        m_box1->getPosVec().SetX(1.5f);
-        m_box1->SetOccluder(true);
-        m_box1->SetOcclusionTested(false);
+        PureObject3D* const box1 = getPure().getObject3DManager().createBox(1, 1, 1);
+        box1->getPosVec().SetZ(2.0f);
+        box1->getPosVec().SetX(1.5f);
+        box1->SetOccluder(true);
+        box1->SetOcclusionTested(false);
 
         // since a while this vertex coloring is not working
-        m_box1->getMaterial().getColors()[0].red = 1.0f;
-        m_box1->getMaterial().getColors()[0].green = 0.0f;
-        m_box1->getMaterial().getColors()[0].blue = 0.0f;
-        m_box1->getMaterial().getColors()[0].alpha = 0.0f;
-        m_box1->getMaterial().getColors()[9].red = 1.0f;
-        m_box1->getMaterial().getColors()[9].green = 0.0f;
-        m_box1->getMaterial().getColors()[9].blue = 0.0f;
-        m_box1->getMaterial().getColors()[9].alpha = 0.0f;
-
-        m_box1->getMaterial().setTexture(tex1);
-        m_box1->setVertexTransferMode(PURE_VT_DYN_IND_SVA_GEN);
+        box1->getMaterial().getColors()[0].red = 1.0f;
+        box1->getMaterial().getColors()[0].green = 0.0f;
+        box1->getMaterial().getColors()[0].blue = 0.0f;
+        box1->getMaterial().getColors()[0].alpha = 0.0f;
+        box1->getMaterial().getColors()[9].red = 1.0f;
+        box1->getMaterial().getColors()[9].green = 0.0f;
+        box1->getMaterial().getColors()[9].blue = 0.0f;
+        box1->getMaterial().getColors()[9].alpha = 0.0f;
+
+        box1->getMaterial().setTexture(tex1);
+        applyVertexTransferPolicy(*box1, "box1", elte_fail::MeshUsage::Static);
+        m_vtBenchmark.addMesh("box1", *box1);
+
+        const elte_fail::EntityHandle hBox1 = m_entities.create(*box1);
+        m_entities.setSpin(hBox1, { 0.2f });
+        m_entities.setToggle(hBox1, { static_cast<unsigned char>(VkKeyScan('1')) });
     }
     
     {   // load box object from file
-        m_box2 = getPure().getObject3DManager().createFromFile("gamedata\\models\\cube.obj");
-        m_box2->setVertexTransferMode(PURE_VT_DYN_DIR_1_BY_1);
-        m_box2->getPosVec().SetZ(4);
+        std::string sBoxFilename = "gamedata\\models\\cube.obj";
+        std::string sBoxLmFilename;
+        optimizeModel("box2", sBoxFilename, sBoxLmFilename);
+        PureObject3D* const box2 = getPure().getObject3DManager().createFromFile(sBoxFilename.c_str());
+        acquireMaterialTextures(*box2);
+        applyVertexTransferPolicy(*box2, "box2", elte_fail::MeshUsage::Static);
+        m_vtBenchmark.addMesh("box2", *box2);
+        box2->getPosVec().SetZ(4);
+        m_entities.create(*box2);
     }
     
     /*       
@@ -155,44 +397,31 @@ bool CustomPGE::onGameInitialized()
     */
 
     {   // snail
-        PureObject3D* const snail = getPure().getObject3DManager().createFromFile("gamedata\\models\\snail_proofps\\snail.obj");
+        std::string sSnailFilename = SNAIL_FILENAME;
+        std::string sSnailLmFilename = SNAIL_LM_FILENAME;
+        optimizeModel("snail", sSnailFilename, sSnailLmFilename);
+
+        PureObject3D* const snail = getPure().getObject3DManager().createFromFile(sSnailFilename.c_str());
         snail->SetScaling(0.02f);
         snail->getPosVec().SetX(-1.5f);
         snail->getPosVec().SetZ(2.7f);
 
-        PureObject3D* snail_lm = getPure().getObject3DManager().createFromFile("gamedata\\models\\snail_proofps\\snail_lm.obj");
+        PureObject3D* snail_lm = getPure().getObject3DManager().createFromFile(sSnailLmFilename.c_str());
         snail_lm->SetScaling(0.02f);
         snail_lm->Hide();
 
-        // dealing with lightmaps ...
-        if (snail->getCount() == snail_lm->getCount())
-        {
-            for (TPureInt i = 0; i < snail->getCount(); i++)
-            {
-                PureObject3D* const snailSub = (PureObject3D*)snail->getAttachedAt(i);
-                // assuming that snail_lm has the same subobjects and vertex count as snail
-                PureObject3D* const snailLMSub = (PureObject3D*)snail_lm->getAttachedAt(i);
-                if (snailSub && snailLMSub)
-                {
-                    // copying lightmap data into snail material's 2nd layer
-                    snailSub->getMaterial(false).copyFromMaterial(snailLMSub->getMaterial(false), 1, 0);
-                    snailSub->getMaterial(false).setBlendFuncs(PURE_SRC_ALPHA, PURE_ONE_MINUS_SRC_ALPHA, 1);
-                }
-            }
-        }
-        else
-        {
-            getConsole().EOLn("snail->getCount() != snail_lm->getCount(): %d != %d", snail->getCount(), snail_lm->getCount());
-        }
+        applyLightmap(*snail, *snail_lm);
 
-        snail->setVertexTransferMode(PURE_VT_DYN_IND_SVA_GEN);
+        applyVertexTransferPolicy(*snail, "snail", elte_fail::MeshUsage::Static);
+        m_vtBenchmark.addMesh("snail", *snail);
         snail->SetDoubleSided(true);
 
-        // at this point, we should be safe to delete snail_lm since object's dtor calls material's dtor which doesn't free up the textures
-        // however, a mechanism is needed to be implemented to correctly handle this situation.
-        // WA1: CopyFromMaterial() should hardcopy the textures also; deleting material should delete its textures too;
-        // WA2: (better) textures should maintain refcount. Material deletion would decrement refcount and would effectively delete textures when refcount reaches 0.
+        // at this point, we should be safe to delete snail_lm since object's dtor calls material's dtor which doesn't free up the textures,
+        // from now on the lightmap textures are referenced by snail only, through m_textureCache
         delete snail_lm;
+        acquireMaterialTextures(*snail);
+
+        m_entities.setToggle(m_entities.create(*snail), { static_cast<unsigned char>(VkKeyScan('2')) });
     }
 
     /*
@@ -204,52 +433,143 @@ bool CustomPGE::onGameInitialized()
     {   // arena
         getPure().getTextureManager().setDefaultIsoFilteringMode(PURE_ISO_LINEAR_MIPMAP_LINEAR, PURE_ISO_LINEAR);
 
-        PureObject3D* const arena = getPure().getObject3DManager().createFromFile("gamedata\\models\\arena\\arena.obj");
-        arena->SetScaling(0.002f);
-        arena->getPosVec().SetZ(2.f);
-        arena->getPosVec().SetY(-1.5f);
+        elte_fail::ObjFile arenaObj;
+        const bool bArenaObjLoaded = loadObj(arenaObj, ARENA_FILENAME);
+
+        if (!m_cvGfxArenaStreaming.get() || !bArenaObjLoaded || !startArenaStreaming(arenaObj))
+        {
+            // chunks and collision are made from the source model, optimization is only for rendering the whole arena
+            std::string sArenaFilename = ARENA_FILENAME;
+            std::string sArenaLmFilename = ARENA_LM_FILENAME;
+            optimizeModel("arena", sArenaFilename, sArenaLmFilename);
+
+            PureObject3D* const arena = getPure().getObject3DManager().createFromFile(sArenaFilename.c_str());
+            arena->SetScaling(fArenaScaling);
+            arena->getPosVec().SetZ(fArenaPosZ);
+            arena->getPosVec().SetY(fArenaPosY);
+
+            PureObject3D* arena_lm = getPure().getObject3DManager().createFromFile(sArenaLmFilename.c_str());
+            arena_lm->SetScaling(0.02f);
+            arena_lm->Hide();
+
+            applyLightmap(*arena, *arena_lm);
+
+            applyVertexTransferPolicy(*arena, "arena", elte_fail::MeshUsage::Static);
+            m_vtBenchmark.addMesh("arena", *arena);
+
+            delete arena_lm;
+            acquireMaterialTextures(*arena);
+
+            // chunks are toggled by the same key, but they are not entities since they come and go with streaming
+            m_entities.setToggle(m_entities.create(*arena), { static_cast<unsigned char>(VkKeyScan('3')) });
+        }
+
+        // collision world is built from the same file with the same transformation as the rendered arena
+        if (bArenaObjLoaded && m_collisionWorld.buildFromObj(arenaObj, fArenaScaling, 0.f, fArenaPosY, fArenaPosZ))
+        {
+            getConsole().OLn("Collision world: %u boxes, %u nodes, depth %u",
+                m_collisionWorld.getBoxCount(), m_collisionWorld.getNodeCount(), m_collisionWorld.getDepth());
+        }
+        else
+        {
+            getConsole().EOLn("Failed to build collision world from %s, player movement will not be clamped!", ARENA_FILENAME);
+        }
+
+        if (m_cvBenchCollisionPlayers.get() > 0)
+        {
+            runCollisionBenchmark(static_cast<uint32_t>(m_cvBenchCollisionPlayers.get()));
+        }
+    }
 
-        PureObject3D* arena_lm = getPure().getObject3DManager().createFromFile("gamedata\\models\\arena\\arena_lm.obj");
-        arena_lm->SetScaling(0.02f);
-        arena_lm->Hide();
+    {   // projectiles: the loaded object is only the source of the clones, it is never rendered
+        m_projectileSim.start(m_collisionWorld, static_cast<uint32_t>(std::max(0, m_cvSvProjectilesMax.get())), nMaxRenderedProjectiles);
+        if (m_cvBenchProjectiles.get() > 0)
+        {
+            runProjectileBenchmark(static_cast<uint32_t>(m_cvBenchProjectiles.get()));
+        }
 
-        // dealing with lightmaps ...
-        if (arena->getCount() == arena_lm->getCount())
+        PureObject3D* const projectile = getPure().getObject3DManager().createFromFile(PROJECTILE_FILENAME);
+        if (projectile)
         {
-            for (TPureInt i = 0; i < arena->getCount(); i++)
+            projectile->SetScaling(fProjectileScaling);
+            acquireMaterialTextures(*projectile);
+            m_frustumCuller.setHidden(*projectile, true);
+            m_vProjectileObjects.reserve(nMaxRenderedProjectiles);
+            for (uint32_t i = 0; i < nMaxRenderedProjectiles; i++)
             {
-                PureObject3D* const arenaSub = (PureObject3D*)arena->getAttachedAt(i);
-                // assuming that arena_lm has the same subobjects and vertex count as arena
-                PureObject3D* const arenaLMSub = (PureObject3D*)arena_lm->getAttachedAt(i);
-                if (arenaSub && arenaLMSub)
+                PureObject3D* const projectileClone = getPure().getObject3DManager().createCloned(*projectile);
+                if (!projectileClone)
                 {
-                    // copying lightmap data into snail material's 2nd layer
-                    arenaSub->getMaterial(false).copyFromMaterial(arenaLMSub->getMaterial(false), 1, 0);
-                    arenaSub->getMaterial(false).setBlendFuncs(PURE_SRC_ALPHA, PURE_ONE_MINUS_SRC_ALPHA, 1);
+                    break;
                 }
+                projectileClone->SetScaling(fProjectileScaling);
+                m_frustumCuller.setHidden(*projectileClone, true);
+                m_vProjectileObjects.push_back(projectileClone);
             }
+            getConsole().OLn("Projectile pool: %u projectiles, %u rendered", m_projectileSim.getProjectiles().getCapacity(), static_cast<uint32_t>(m_vProjectileObjects.size()));
         }
         else
         {
-            getConsole().EOLn("arena->getCount() != arenaLMSub->getCount(): %d != %d", arena->getCount(), arena_lm->getCount());
+            getConsole().EOLn("Failed to load %s, projectiles will not be rendered!", PROJECTILE_FILENAME);
         }
+    }
 
-        arena->setVertexTransferMode(PURE_VT_DYN_DIR_SVA_GEN);
+    if (m_cvBenchVtFrames.get() > 0)
+    {
+        // frame times are measured, they must not be limited by the refresh rate
+        if (m_vtBenchmark.start(static_cast<uint32_t>(m_cvBenchVtFrames.get())))
+        {
+            getPure().getScreen().setVSyncEnabled(false);
+            getConsole().OLn("Vertex transfer benchmark started, VSync is disabled until it finishes");
+        }
+    }
 
-        delete arena_lm;
+    if (m_cvBenchOverlayFrames.get() > 0)
+    {
+        // it waits for the vertex transfer benchmark to finish, its frame times would include mode switches
+        if (m_overlayBenchmark.start(m_overlay, static_cast<uint32_t>(m_cvBenchOverlayFrames.get())))
+        {
+            getPure().getScreen().setVSyncEnabled(false);
+            getConsole().OLn("Overlay text benchmark started, VSync is disabled until it finishes");
+        }
     }
 
     // Gather some trollface pictures for the players
     // Building this set up initially, each face is removed from the set when assigned to a player, so
     // all players will have unique face texture assigned.
+    std::vector<std::string> vTrollfaces;
     for (const auto& entry : std::filesystem::directory_iterator("gamedata/trollfaces/"))
     {
         if ((entry.path().extension().string() == ".bmp"))
         {
-            m_trollFaces.insert(entry.path().string());
+            if (m_matchRules.addTrollface(entry.path().string()))
+            {
+                vTrollfaces.push_back(entry.path().string());
+            }
+        }
+    }
+    getConsole().OLn("%s() Server parsed %d trollfaces", __func__, m_matchRules.getFreeTrollfaceCount());
+
+    // hosted matches have their own players, strings and projectiles, only the read-only collision world is shared with our match
+    if (getNetwork().isServer() && (m_cvSvMatches.get() > 0))
+    {
+        if (m_matches.start(
+            static_cast<uint32_t>(m_cvSvMatches.get()),
+            static_cast<uint32_t>(std::max(1, m_cvSvMatchMaxPlayers.get())),
+            static_cast<uint32_t>(std::max(0, m_cvSvMatchThreads.get())),
+            m_collisionWorld,
+            vTrollfaces,
+            static_cast<uint32_t>(std::max(0, m_cvSvProjectilesMax.get())),
+            m_log))
+        {
+            getConsole().OLn("Hosting max %d matches of max %d players besides ours, on %u threads",
+                m_cvSvMatches.get(), std::max(1, m_cvSvMatchMaxPlayers.get()), m_matches.getPool().getWorkerCount());
+        }
+        else
+        {
+            getConsole().EOLn("Failed to start hosting matches, all clients will join our match!");
         }
     }
-    getConsole().OLn("%s() Server parsed %d trollfaces", __func__, m_trollFaces.size());
     
     getPure().getUImanager().textPermanentLegacy("almafaALMAFA012345_+", 10, 10);
 
@@ -267,10 +587,84 @@ bool CustomPGE::onGameInitialized()
         );
     }
 
-    if (getNetwork().isServer())
+    // Allow-lists are generated from the MsgDirection of each message, see ElteFailPacket.h.
+    // MsgUserSetupFromServer and MsgUserUpdateFromServer are also processed by server, but it injects these pkts into its own queue when needed,
+    // so they MUST NOT be received by server over network, they are received only by clients over network!
+    TMsgAppDispatcher::fillAllowList(getNetwork().getServerClientInstance()->getAllowListedAppMessages(), getNetwork().isServer());
+
+    if (!m_cvNetStatsDumpFile.get().empty())
+    {
+        m_netStats.setPeriodicDump(
+            m_cvNetStatsDumpFile.get(),
+            static_cast<unsigned int>(m_cvNetStatsDumpIntervalSecs.get()));
+        getConsole().OLn("Net stats dump file from config: %s", m_cvNetStatsDumpFile.get().c_str());
+    }
+
+    // conditions can be changed while running, by saving the profile
+    applyNetConditions();
+    m_cvNetCondLatencyMs.addChangeCallback([this](const int&) { applyNetConditions(); });
+    m_cvNetCondJitterMs.addChangeCallback([this](const int&) { applyNetConditions(); });
+    m_cvNetCondLossPercent.addChangeCallback([this](const float&) { applyNetConditions(); });
+    m_cvNetCondDuplicatePercent.addChangeCallback([this](const float&) { applyNetConditions(); });
+    m_cvNetCondReorderPercent.addChangeCallback([this](const float&) { applyNetConditions(); });
+    m_cvNetCondSeed.addChangeCallback([this](const int&) { applyNetConditions(); });
+
+    const auto fnSendRateChanged = [this]()
+    {
+        for (auto& clientSendState : m_mapClientSendStates)
+        {
+            clientSendState.second.m_rate.configure(getSendRateConfig());
+        }
+    };
+    m_cvSvSendRateMin.addChangeCallback([fnSendRateChanged](const float&) { fnSendRateChanged(); });
+    m_cvSvSendRateMax.addChangeCallback([fnSendRateChanged](const float&) { fnSendRateChanged(); });
+    m_cvSvSendRateMaxQueueMs.addChangeCallback([fnSendRateChanged](const int&) { fnSendRateChanged(); });
+    m_cvSvSendRateMinQuality.addChangeCallback([fnSendRateChanged](const float&) { fnSendRateChanged(); });
+
+    if (m_cvBenchNetCondSecs.get() > 0)
+    {
+        runNetConditionerBenchmark(static_cast<uint32_t>(m_cvBenchNetCondSecs.get()));
+    }
+
+    if (!m_cvNetReplayFile.get().empty())
+    {
+        // Replay mode: networking is not started at all, captured packets are fed to the packet handlers instead
+        if (!runNetReplay(m_cvNetReplayFile.get()))
+        {
+            PGE::showErrorDialog("Replay of network capture has FAILED, see log for details!");
+        }
+        return true;
+    }
+
+    if (!m_cvNetCaptureFile.get().empty())
+    {
+        // seed of user name generation is captured, so the capture is replayable with same user names
+        const uint32_t nRandSeed = static_cast<uint32_t>(time(nullptr));
+        m_matchRules.seed(nRandSeed);
+        if (m_netCapture.open(m_cvNetCaptureFile.get(), getNetwork().isServer(), nRandSeed))
+        {
+            getConsole().OLn("Net capture file: %s", m_cvNetCaptureFile.get().c_str());
+        }
+        else
+        {
+            getConsole().EOLn("Failed to open net capture file: %s", m_cvNetCaptureFile.get().c_str());
+        }
+    }
+
+    if (m_cvNetDecodeThread.get())
     {
-        getNetwork().getServer().getAllowListedAppMessages().insert(static_cast<pge_network::MsgApp::TMsgId>(elte_fail::MsgUserCmdMoveFromClient::id));
+        if (m_pktPipeline.start([this](const pge_network::PgePacket& pkt) { return validatePkt(pkt); }))
+        {
+            getConsole().OLn("Received packets are decoded and validated on separate thread");
+        }
+        else
+        {
+            getConsole().EOLn("Failed to start packet decode thread, received packets will be handled on main thread");
+        }
+    }
 
+    if (getNetwork().isServer())
+    {
         if (!getNetwork().getServer().startListening())
         {
             PGE::showErrorDialog("Server has FAILED to start listening!");
@@ -279,20 +673,10 @@ bool CustomPGE::onGameInitialized()
     }
     else
     {
-        // MsgUserSetupFromServer is also processed by server, but it injects this pkt into its own queue when needed.
-        // MsgUserSetupFromServer MUST NOT be received by server over network!
-        // MsgUserSetupFromServer is received only by clients over network!
-        getNetwork().getClient().getAllowListedAppMessages().insert(static_cast<pge_network::MsgApp::TMsgId>(elte_fail::MsgUserSetupFromServer::id));
-
-        // MsgUserUpdateFromServer is also processed by server, but it injects this pkt into its own queue when needed.
-        // MsgUserUpdateFromServer MUST NOT be received by server over network!
-        // MsgUserUpdateFromServer is received only by clients over network!
-        getNetwork().getClient().getAllowListedAppMessages().insert(static_cast<pge_network::MsgApp::TMsgId>(elte_fail::MsgUserUpdateFromServer::id));
-
         std::string sIp = "127.0.0.1";
-        if (!getConfigProfiles().getVars()[CVAR_CL_SERVER_IP].getAsString().empty())
+        if (!m_cvClServerIp.get().empty())
         {
-            sIp = getConfigProfiles().getVars()[CVAR_CL_SERVER_IP].getAsString();
+            sIp = m_cvClServerIp.get();
             getConsole().OLn("IP from config: %s", sIp.c_str());
         }
         // TODO: log level override support: getConsole().SetLoggingState(sTrimmedLine.c_str(), true);
@@ -315,6 +699,41 @@ bool CustomPGE::onGameInitialized()
 */
 void CustomPGE::onGameRunning()
 {
+    // packets the server sent to itself since last frame, they don't need validation
+    m_loopback.receiveAll([this](const pge_network::PgePacket& pkt) { applyPkt(pkt); });
+    // packets received over network and already validated by decode thread
+    m_pktPipeline.drain([this](const pge_network::PgePacket& pkt) { applyPkt(pkt); });
+
+    if (m_matches.isStarted())
+    {
+        // hosted matches are ticked on their own thread, but sending is done on main thread, since PGE is not thread-safe
+        m_matches.flush([this](const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide)
+            { sendPktToClient(pkt, connHandleServerSide); });
+    }
+
+    syncProjectileSim();
+    flushLatestPkts();
+    m_netConditioner.release(getNowUSecs(), [this](const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide)
+        { transmitPktNow(pkt, connHandleServerSide); });
+
+    if (m_vtBenchmark.isRunning())
+    {
+        if (m_vtBenchmark.onFrame())
+        {
+            WriteVertexTransferBenchmark();
+            m_overlay.clear(OVERLAY_VT_BENCHMARK);
+            if (!m_overlayBenchmark.isRunning())
+            {
+                getPure().getScreen().setVSyncEnabled(m_cvGfxVsync.get());
+            }
+        }
+        else
+        {
+            m_sUiText = m_localization.get(elte_fail::TextId::UiVtBenchmarkRunning);
+            m_overlay.set(OVERLAY_VT_BENCHMARK, m_sUiText);
+        }
+    }
+
     PureWindow& window = getPure().getWindow();
 
     static bool bCameraLocked = true;
@@ -328,25 +747,37 @@ void CustomPGE::onGameRunning()
 
     if (!getNetwork().isServer())
     {
-        getPure().getUImanager().textTemporalLegacy(
-            "Ping: " + std::to_string(getNetwork().getClient().getPing(true)) + " ms",
-            10, 50);
-        getPure().getUImanager().textTemporalLegacy(
-            "Quality: local: " + std::to_string(getNetwork().getClient().getQualityLocal(false)) +
-            "; remote: " + std::to_string(getNetwork().getClient().getQualityRemote(false)),
-            10, 70);
-        getPure().getUImanager().textTemporalLegacy(
-            "Tx Speed: " + std::to_string(getNetwork().getClient().getTxByteRate(false)) +
-            " Bps; Rx Speed: " + std::to_string(getNetwork().getClient().getRxByteRate(false)) + " Bps",
-            10, 90);
-        getPure().getUImanager().textTemporalLegacy(
-            "Internal Queue Time: " + std::to_string(getNetwork().getClient().getInternalQueueTimeUSecs(false)) + " us",
-            10, 110);
+        m_localization.format(m_sUiText, elte_fail::TextId::UiPing, { getNetwork().getClient().getPing(true) });
+        m_overlay.set(OVERLAY_PING, m_sUiText);
+        m_localization.format(m_sUiText, elte_fail::TextId::UiQuality,
+            { getNetwork().getClient().getQualityLocal(false), getNetwork().getClient().getQualityRemote(false) });
+        m_overlay.set(OVERLAY_QUALITY, m_sUiText);
+        m_localization.format(m_sUiText, elte_fail::TextId::UiTxRxSpeed,
+            { getNetwork().getClient().getTxByteRate(false), getNetwork().getClient().getRxByteRate(false) });
+        m_overlay.set(OVERLAY_TXRX_SPEED, m_sUiText);
+        m_localization.format(m_sUiText, elte_fail::TextId::UiInternalQueueTime,
+            { getNetwork().getClient().getInternalQueueTimeUSecs(false) });
+        m_overlay.set(OVERLAY_INTERNAL_QUEUE_TIME, m_sUiText);
+    }
+
+    m_netStats.update(m_msgAppDispatcher.getStats());
+
+    const auto timeNow = std::chrono::steady_clock::now();
+    if (timeNow - m_timeLastProfileCheck >= std::chrono::milliseconds(nProfileCheckIntervalMSecs))
+    {
+        m_timeLastProfileCheck = timeNow;
+        const uint32_t nChanged = m_cvars.reloadProfileIfChanged();
+        if (nChanged > 0)
+        {
+            getConsole().OLn("Profile reloaded, %u CVar(s) changed", nChanged);
+        }
     }
 
-    if (m_box1 != NULL )
+    const elte_fail::ComponentArray<elte_fail::SpinComponent>& spins = m_entities.getSpins();
+    for (size_t i = 0; i < spins.size(); i++)
     {
-        m_box1->getAngleVec().SetY(m_box1->getAngleVec().getY() + 0.2f );
+        PureObject3D& obj = m_entities.getObjectByIndex(spins.getEntityIndex(i));
+        obj.getAngleVec().SetY(obj.getAngleVec().getY() + spins[i].m_fDegPerFrame);
     }
 
     if (window.isActive())
@@ -381,33 +812,33 @@ void CustomPGE::onGameRunning()
             getPure().getCamera().Elevate(-0.01f);
         }
 
-        if (getInput().getKeyboard().isKeyPressed((unsigned char)VkKeyScan('1')))
+        // 1, 2, 3 for toggling box1, snail, arena
+        bool bToggled = false;
+        const elte_fail::ComponentArray<elte_fail::ToggleComponent>& toggles = m_entities.getToggles();
+        for (size_t i = 0; i < toggles.size(); i++)
         {
-            if (m_box1 != NULL)
+            if (getInput().getKeyboard().isKeyPressed(toggles[i].m_nKey))
             {
-                m_box1->SetRenderingAllowed(!m_box1->isRenderingAllowed());
-                Sleep(200); /* to make sure key is released, avoid bouncing */
+                PureObject3D& obj = m_entities.getObjectByIndex(toggles.getEntityIndex(i));
+                m_frustumCuller.setHidden(obj, !m_frustumCuller.isHidden(obj));
+                bToggled = true;
             }
         }
-
-        if (getInput().getKeyboard().isKeyPressed((unsigned char)VkKeyScan('2')))
+        if (m_arenaStreamer.isStarted() && getInput().getKeyboard().isKeyPressed((unsigned char)VkKeyScan('3')))
         {
-            PureObject3D* snailobj = (PureObject3D*)getPure().getObject3DManager().getByFilename("gamedata\\models\\snail_proofps\\snail.obj");
-            if (snailobj != NULL)
+            m_bArenaHidden = !m_bArenaHidden;
+            for (PureObject3D* const chunkObj : m_vArenaChunkObjects)
             {
-                snailobj->SetRenderingAllowed(!snailobj->isRenderingAllowed());
-                Sleep(200);
+                if (chunkObj)
+                {
+                    m_frustumCuller.setHidden(*chunkObj, m_bArenaHidden);
+                }
             }
+            bToggled = true;
         }
-
-        if (getInput().getKeyboard().isKeyPressed((unsigned char)VkKeyScan('3')))
+        if (bToggled)
         {
-            PureObject3D* arenaobj = (PureObject3D*)getPure().getObject3DManager().getByFilename("gamedata\\models\\arena\\arena.obj");
-            if (arenaobj != NULL)
-            {
-                arenaobj->SetRenderingAllowed(!arenaobj->isRenderingAllowed());
-                Sleep(200);
-            }
+            Sleep(200); /* to make sure key is released, avoid bouncing */
         }
 
         elte_fail::HorizontalDirection horDir = elte_fail::HorizontalDirection::NONE;
@@ -431,16 +862,35 @@ void CustomPGE::onGameRunning()
 
         if ((horDir != elte_fail::HorizontalDirection::NONE) || (verDir != elte_fail::VerticalDirection::NONE))
         {
+            m_dirLastHorizontal = horDir;
+            m_dirLastVertical = verDir;
+
             pge_network::PgePacket pkt;
-            if (elte_fail::MsgUserCmdMoveFromClient::initPkt(pkt, horDir, verDir))
+            if (elte_fail::MsgUserCmdMoveFromClient::initPkt(pkt, ++m_nUserCmdMoveSeq, horDir, verDir))
             {
                 // instead of using sendToServer() of getClient() or getServer() instances, we use the sendToServer() of
                 // their common interface which always points to the initialized instance, which is either client or server.
-                getNetwork().getServerClientInstance()->send(pkt);
+                sendPkt(pkt);
+            }
+            else
+            {
+                m_logNet.EOLn("CustomPGE::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
+                assert(false);
+            }
+        }
+
+        // R for Rocket, fired in the direction of the last move, server limits the fire rate too
+        if (getInput().getKeyboard().isKeyPressed((unsigned char)VkKeyScan('r')) && (getNowUSecs() - m_nLastFireUSecs >= elte_fail::MatchRules::nFireIntervalUSecs))
+        {
+            m_nLastFireUSecs = getNowUSecs();
+            pge_network::PgePacket pkt;
+            if (elte_fail::MsgUserCmdFireFromClient::initPkt(pkt, m_dirLastHorizontal, m_dirLastVertical))
+            {
+                sendPkt(pkt);
             }
             else
             {
-                getConsole().EOLn("PRooFPSddPGE::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
+                m_logNet.EOLn("CustomPGE::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
                 assert(false);
             }
         }
@@ -451,20 +901,74 @@ void CustomPGE::onGameRunning()
             bCameraLocked = !bCameraLocked;
             Sleep(200);
         }
+
+        // F for Frustum culling on/off, to compare the counters
+        if (getInput().getKeyboard().isKeyPressed((unsigned char)VkKeyScan('f')))
+        {
+            m_frustumCuller.setEnabled(!m_frustumCuller.isEnabled());
+            Sleep(200);
+        }
+
+        // N for Network stats
+        if (getInput().getKeyboard().isKeyPressed((unsigned char)VkKeyScan('n')))
+        {
+            WriteNetStats();
+            Sleep(200);
+        }
+
+        // V for Verbose async logging: toggles debug level of our async log modules at runtime
+        if (getInput().getKeyboard().isKeyPressed((unsigned char)VkKeyScan('v')))
+        {
+            const elte_fail::LogLevel newLevel = m_log.isEnabled(elte_fail::LogLevel::Debug) ? elte_fail::LogLevel::Info : elte_fail::LogLevel::Debug;
+            m_asyncLog.setLevel(m_asyncLog.findModule(getLoggerModuleName()), newLevel);
+            m_asyncLog.setLevel(m_asyncLog.findModule(getNetLoggerModuleName()), newLevel);
+            getConsole().OLn("Async log level: %s", elte_fail::AsyncLog::getLevelName(newLevel));
+            Sleep(200);
+        }
     }
 
     if ( bCameraLocked )
     {
-        //getPure().getCamera().getTargetVec().Set( box1->getPosVec().getX(), box1->getPosVec().getY(), box1->getPosVec().getZ() );
+        // nullptr also after our player is deleted, since the handle becomes stale
+        PureObject3D* const pPlayerObj = m_entities.getObject(m_hCameraTarget);
+        if (pPlayerObj)
+        {
+            getPure().getCamera().getTargetVec().Set(pPlayerObj->getPosVec().getX(), pPlayerObj->getPosVec().getY(), pPlayerObj->getPosVec().getZ());
+        }
+    }
+
+    if (m_arenaStreamer.isStarted())
+    {
+        // camera target is our player while camera is locked
+        m_arenaStreamer.update(getPure().getCamera().getTargetVec().getX(), getPure().getCamera().getTargetVec().getY());
+        const elte_fail::ChunkStreamerStats streamStats = m_arenaStreamer.getStats();
+        m_localization.format(m_sUiText, elte_fail::TextId::UiArenaChunks,
+            { streamStats.m_nResident, streamStats.m_nChunks, streamStats.m_nPending,
+              streamStats.m_nResidentBytes / 1024, streamStats.m_nBudgetBytes / 1024,
+              streamStats.m_nLoads, streamStats.m_nEvictions });
+        m_overlay.set(OVERLAY_ARENA_CHUNKS, m_sUiText);
+    }
 
-        const auto it = m_mapPlayers.find(m_sUserName);
-        if (it != m_mapPlayers.end())
+    updateProjectileObjects();
+    m_frustumCuller.update(
+        getPure().getCamera(),
+        (window.getClientHeight() > 0) ? (static_cast<float>(window.getClientWidth()) / window.getClientHeight()) : 1.f,
+        getPure().getObject3DManager());
+    const elte_fail::FrustumCullerStats& cullStats = m_frustumCuller.getStats();
+    m_localization.format(m_sUiText, elte_fail::TextId::UiCulling,
+        { m_localization.get(m_frustumCuller.isEnabled() ? elte_fail::TextId::On : elte_fail::TextId::Off),
+          cullStats.m_nTested, cullStats.m_nCulled, cullStats.m_nDrawn, cullStats.m_nHidden });
+    m_overlay.set(OVERLAY_CULLING, m_sUiText);
+
+    const auto timeOverlayStart = std::chrono::steady_clock::now();
+    m_overlay.flush(getPure().getUImanager());
+    if (m_overlayBenchmark.isRunning() && !m_vtBenchmark.isRunning())
+    {
+        const auto nOverlayUSecs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - timeOverlayStart).count();
+        if (m_overlayBenchmark.onFrame(static_cast<uint32_t>(nOverlayUSecs)))
         {
-            PureObject3D* const pPlayerObj = it->second.m_pObject3D;
-            if (pPlayerObj)
-            {
-                getPure().getCamera().getTargetVec().Set(pPlayerObj->getPosVec().getX(), pPlayerObj->getPosVec().getY(), pPlayerObj->getPosVec().getZ());
-            }
+            WriteOverlayTextBenchmark();
+            getPure().getScreen().setVSyncEnabled(m_cvGfxVsync.get());
         }
     }
 
@@ -482,174 +986,1673 @@ void CustomPGE::onGameRunning()
     @return True on successful packet handling, false on serious error that should result in terminating the application.
 */
 bool CustomPGE::onPacketReceived(const pge_network::PgePacket& pkt)
+{
+    if (m_pktPipeline.isStarted())
+    {
+        // will be applied by onGameRunning() after validation
+        m_pktPipeline.submit(pkt, [this](const pge_network::PgePacket& pktDecoded) { applyPkt(pktDecoded); });
+        return true;
+    }
+
+    return validatePkt(pkt) && applyPkt(pkt);
+}
+
+/**
+    Stateless validation of a received packet. Invoked on the decode thread of m_pktPipeline, so it MUST NOT access game state!
+    Logging is allowed since async log is thread-safe.
+
+    @return False if packet should be dropped.
+*/
+bool CustomPGE::validatePkt(const pge_network::PgePacket& pkt)
 {
     const pge_network::PgePktId& pgePktId = pge_network::PgePacket::getPacketId(pkt);
     switch (pgePktId)
     {
     case pge_network::MsgUserConnectedServerSelf::id:
-        return handleUserConnected(pge_network::PgePacket::getServerSideConnectionHandle(pkt), pge_network::PgePacket::getMessageAsUserConnected(pkt));
     case pge_network::MsgUserDisconnectedFromServer::id:
-        return handleUserDisconnected(pge_network::PgePacket::getServerSideConnectionHandle(pkt), pge_network::PgePacket::getMessageAsUserDisconnected(pkt));
+        return true;
     case pge_network::MsgApp::id:
     {
-        // for now we support only 1 app msg per pkt
-        assert(pge_network::PgePacket::getMessageAppCount(pkt) == 1);
-        assert(pge_network::PgePacket::getMessageAppsTotalActualLengthBytes(pkt) > 0);  // for now we dont have empty messages
+        if ((pge_network::PgePacket::getMessageAppCount(pkt) != 1) || (pge_network::PgePacket::getMessageAppsTotalActualLengthBytes(pkt) == 0))
+        {
+            // for now we support only 1 app msg per pkt, and we dont have empty messages
+            m_logNet.EOLn("CustomPGE::%s(): connHandleServerSide %u sent invalid MsgAppArea!", __func__, pge_network::PgePacket::getServerSideConnectionHandle(pkt));
+            return false;
+        }
 
-        // TODO: here we will need to iterate over all app msg but for now there is only 1 inside!
+        const pge_network::MsgApp::TMsgId msgAppId = pge_network::PgePacket::getMsgAppIdFromPkt(pkt);
+        if (!TMsgAppDispatcher::isKnownMsgId(msgAppId))
+        {
+            m_logNet.EOLn("CustomPGE::%s(): unknown msgId %u in MsgAppArea!", __func__, msgAppId);
+            return false;
+        }
 
-        const elte_fail::ElteFailMsgId& eltefailAppMsgId = static_cast<elte_fail::ElteFailMsgId>(pge_network::PgePacket::getMsgAppIdFromPkt(pkt));
-
-        switch (eltefailAppMsgId)
-        {
-        case elte_fail::MsgUserSetupFromServer::id:
-            return handleUserSetup(
-                pge_network::PgePacket::getServerSideConnectionHandle(pkt),
-                pge_network::PgePacket::getMsgAppDataFromPkt<elte_fail::MsgUserSetupFromServer>(pkt));
-        case elte_fail::MsgUserCmdMoveFromClient::id:
-            return handleUserCmdMove(
-                pge_network::PgePacket::getServerSideConnectionHandle(pkt),
-                pge_network::PgePacket::getMsgAppDataFromPkt<elte_fail::MsgUserCmdMoveFromClient>(pkt));
-        case elte_fail::MsgUserUpdateFromServer::id:
-            return handleUserUpdate(
-                pge_network::PgePacket::getServerSideConnectionHandle(pkt),
-                pge_network::PgePacket::getMsgAppDataFromPkt<elte_fail::MsgUserUpdateFromServer>(pkt));
-        default:
-            getConsole().EOLn("CustomPGE::%s(): unknown msgId %u in MsgAppArea!", __func__, eltefailAppMsgId);
+        if (!TMsgAppDispatcher::validate(msgAppId, pkt))
+        {
+            m_logNet.EOLn("CustomPGE::%s(): connHandleServerSide %u sent invalid %s!",
+                __func__, pge_network::PgePacket::getServerSideConnectionHandle(pkt), elte_fail::MapMsgAppId2String[msgAppId].zstring);
+            return false;
         }
-        break;
+        return true;
     }
     default:
-        getConsole().EOLn("CustomPGE::%s(): unknown pktId %u!", __func__, pgePktId);
+        m_logNet.EOLn("CustomPGE::%s(): unknown pktId %u!", __func__, pgePktId);
     }
     return false;
 }
 
-
-/** 
-    Freeing up game content here.
-    Free up everything that has been allocated in onGameInitialized() and onGameRunning().
+/**
+    Applies a received packet to the game state by invoking its handler. Main thread only.
 */
-void CustomPGE::onGameDestroying()
+bool CustomPGE::applyPkt(const pge_network::PgePacket& pkt)
 {
-    m_mapPlayers.clear();
-
-    delete m_box1;
-    m_box1 = NULL;
-    delete m_box2;
-    m_box2 = NULL;
-    getPure().getObject3DManager().DeleteAll();
+    if (m_netCapture.isOpen())
+    {
+        m_netCapture.writePktReceived(pkt);
+    }
 
-    getConsole().Deinitialize();
-} // onGameRunning()
+    if (m_matches.isStarted() && routePktToMatch(pkt))
+    {
+        return true;
+    }
 
+    const auto itRejected = m_rejectedConnections.find(pge_network::PgePacket::getServerSideConnectionHandle(pkt));
+    if (itRejected != m_rejectedConnections.end())
+    {
+        // rejected connection has no player, nothing to handle until it disconnects
+        if (pge_network::PgePacket::getPacketId(pkt) == pge_network::MsgUserDisconnectedFromServer::id)
+        {
+            m_log.OLn("CustomPGE::%s(): rejected connHandleServerSide %u disconnected", __func__, *itRejected);
+            m_rejectedConnections.erase(itRejected);
+        }
+        return true;
+    }
 
-// ############################### PRIVATE ###############################
+    const pge_network::PgePktId& pgePktId = pge_network::PgePacket::getPacketId(pkt);
+    switch (pgePktId)
+    {
+    case pge_network::MsgUserConnectedServerSelf::id:
+        return handleUserConnected(pge_network::PgePacket::getServerSideConnectionHandle(pkt), pge_network::PgePacket::getMessageAsUserConnected(pkt));
+    case pge_network::MsgUserDisconnectedFromServer::id:
+        return handleUserDisconnected(pge_network::PgePacket::getServerSideConnectionHandle(pkt), pge_network::PgePacket::getMessageAsUserDisconnected(pkt));
+    case pge_network::MsgApp::id:
+    {
+        // for now we support only 1 app msg per pkt
+        assert(pge_network::PgePacket::getMessageAppCount(pkt) == 1);
+        assert(pge_network::PgePacket::getMessageAppsTotalActualLengthBytes(pkt) > 0);  // for now we dont have empty messages
 
+        // TODO: here we will need to iterate over all app msg but for now there is only 1 inside!
 
-void CustomPGE::genUniqueUserName(char szNewUserName[elte_fail::MsgUserSetupFromServer::nUserNameBufferLength]) const
-{
-    bool found = false;
-    do
-    {
-        sprintf_s(szNewUserName, elte_fail::MsgUserSetupFromServer::nUserNameBufferLength, "User%d", 10000 + (rand() % 100000));
-        for (const auto& client : m_mapPlayers)
+        const pge_network::MsgApp::TMsgId msgAppId = pge_network::PgePacket::getMsgAppIdFromPkt(pkt);
+        if (TMsgAppDispatcher::isKnownMsgId(msgAppId))
         {
-            found = (client.first == szNewUserName);
-            if (found)
+            m_netStats.onMsgAppReceived(msgAppId, pge_network::PgePacket::getMessageAppsTotalActualLengthBytes(pkt));
+            if ((TMsgAppDispatcher::getChannel(msgAppId) == elte_fail::MsgChannel::UnreliableSequenced) &&
+                !m_seqFilter.accept(
+                    static_cast<elte_fail::ElteFailMsgId>(msgAppId),
+                    pge_network::PgePacket::getServerSideConnectionHandle(pkt),
+                    TMsgAppDispatcher::getSeq(msgAppId, pkt)))
             {
-                break;
+                // a newer one has already been handled
+                return true;
             }
+            return m_msgAppDispatcher.dispatch(*this, msgAppId, pkt);
         }
-    } while (found);
+        m_logNet.EOLn("CustomPGE::%s(): unknown msgId %u in MsgAppArea!", __func__, msgAppId);
+        break;
+    }
+    default:
+        m_logNet.EOLn("CustomPGE::%s(): unknown pktId %u!", __func__, pgePktId);
+    }
+    return false;
 }
 
-void CustomPGE::WritePlayerList()
-{
+/**
+    Passes the packet to the hosted match of its connection. New connections are routed to a hosted match if our match is full.
+    Server only, main thread only.
+
+    @return True if the packet was passed to a hosted match, false if it is for our match.
+*/
+bool CustomPGE::routePktToMatch(const pge_network::PgePacket& pkt)
+{
+    const pge_network::PgeNetworkConnectionHandle connHandleServerSide = pge_network::PgePacket::getServerSideConnectionHandle(pkt);
+    switch (pge_network::PgePacket::getPacketId(pkt))
+    {
+    case pge_network::MsgUserConnectedServerSelf::id:
+    {
+        const pge_network::MsgUserConnectedServerSelf& msg = pge_network::PgePacket::getMessageAsUserConnected(pkt);
+        if (msg.m_bCurrentClient || (m_mapPlayers.size() < static_cast<size_t>(std::max(1, m_cvSvMatchMaxPlayers.get()))))
+        {
+            return false;
+        }
+        if (!m_matches.connect(connHandleServerSide, msg.m_szIpAddress))
+        {
+            m_log.WLn("CustomPGE::%s(): all matches are full, connHandleServerSide %u joins our match", __func__, connHandleServerSide);
+            return false;
+        }
+        m_log.OLn("CustomPGE::%s(): connHandleServerSide %u routed to a hosted match, %u connections in %u hosted matches",
+            __func__, connHandleServerSide, static_cast<uint32_t>(m_matches.getConnectionCount()), static_cast<uint32_t>(m_matches.getMatchCount()));
+        return true;
+    }
+    case pge_network::MsgUserDisconnectedFromServer::id:
+        return m_matches.disconnect(connHandleServerSide);
+    case pge_network::MsgApp::id:
+        if (!m_matches.receive(pkt))
+        {
+            return false;
+        }
+        m_netStats.onMsgAppReceived(pge_network::PgePacket::getMsgAppIdFromPkt(pkt), pge_network::PgePacket::getMessageAppsTotalActualLengthBytes(pkt));
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+/** 
+    Freeing up game content here.
+    Free up everything that has been allocated in onGameInitialized() and onGameRunning().
+*/
+void CustomPGE::onGameDestroying()
+{
+    WriteNetStats();
+
+    if (m_netCapture.isOpen())
+    {
+        std::vector<uint8_t> vFinalState;
+        serializeFinalState(vFinalState);
+        m_netCapture.writeFinalState(vFinalState);
+        const uint32_t nRecords = m_netCapture.getRecordCount();
+        if (m_netCapture.close())
+        {
+            getConsole().OLn("Net capture: %u records written", nRecords);
+        }
+        else
+        {
+            getConsole().EOLn("Net capture: failed to write some of the %u records!", nRecords);
+        }
+    }
+
+    m_pktPipeline.stop();
+
+    if (m_matches.isStarted())
+    {
+        // tick thread logs, so it is stopped before the async log, and matches can be inspected only after that
+        const uint32_t nMatchWorkers = m_matches.getPool().getWorkerCount();
+        m_matches.stop();
+        for (size_t iMatch = 0; iMatch < m_matches.getMatchCount(); iMatch++)
+        {
+            const elte_fail::Match& match = m_matches.getMatch(iMatch);
+            getConsole().OLn("Match %u: %u players, %u ticks, %u events, tick time: last: %u us, max: %u us",
+                match.getId(),
+                static_cast<uint32_t>(match.getPlayerCount()),
+                static_cast<uint32_t>(match.getStats().m_nTicks),
+                static_cast<uint32_t>(match.getStats().m_nEvents),
+                match.getStats().m_nLastTickUSecs,
+                match.getStats().m_nMaxTickUSecs);
+        }
+        const elte_fail::MatchHostStats& hostStats = m_matches.getStats();
+        getConsole().OLn("Match host: %u ticks, %u skipped, max tick time: %u us, event queue stalls: %u, outgoing queue stalls: %u",
+            static_cast<uint32_t>(hostStats.m_nTicks),
+            static_cast<uint32_t>(hostStats.m_nSkippedTicks),
+            hostStats.m_nMaxTickUSecs,
+            static_cast<uint32_t>(hostStats.m_nEventStalls),
+            static_cast<uint32_t>(hostStats.m_nOutStalls));
+        const elte_fail::JobPoolStats poolStats = m_matches.getPool().getStats();
+        getConsole().OLn("Match pool: %u workers, %u runs, %u jobs, %u stolen",
+            nMatchWorkers,
+            static_cast<uint32_t>(poolStats.m_nRuns),
+            static_cast<uint32_t>(poolStats.m_nJobs),
+            static_cast<uint32_t>(poolStats.m_nSteals));
+    }
+
+    getConsole().OLn("Loopback: %u packets sent, %u received, %u fell back to network due to full queue, max %u queued",
+        static_cast<uint32_t>(m_loopback.getSentCount()),
+        static_cast<uint32_t>(m_loopback.getReceivedCount()),
+        static_cast<uint32_t>(m_loopback.getFullCount()),
+        static_cast<uint32_t>(m_loopback.getMaxQueuedCount()));
+
+    m_asyncLog.stop();
+    getConsole().OLn("Async log: %u lines written, %u dropped, %u suppressed",
+        static_cast<uint32_t>(m_asyncLog.getWrittenCount()),
+        static_cast<uint32_t>(m_asyncLog.getDroppedCount()),
+        static_cast<uint32_t>(m_asyncLog.getSuppressedCount()));
+
+    m_mapPlayers.clear();
+    m_matchRules.clear();
+    m_rejectedConnections.clear();
+    m_strings.clear();
+    m_seqFilter.clear();
+    m_mapLatestPkts.clear();
+    m_mapLatestPktsByVersion.clear();
+    m_mapClientSendStates.clear();
+    m_netConditioner.clear();
+
+    m_assetPack.close();
+    m_projectileSim.stop();
+    const elte_fail::SimThreadStats& simStats = m_projectileSim.getStats();
+    getConsole().OLn("Sim thread: %u ticks, %u skipped, max tick: %u us, %u commands dropped, %u despawns dropped",
+        static_cast<uint32_t>(simStats.m_nTicks), static_cast<uint32_t>(simStats.m_nSkippedTicks), simStats.m_nMaxTickUSecs,
+        static_cast<uint32_t>(simStats.m_nCommandsDropped), static_cast<uint32_t>(simStats.m_nDespawnsDropped));
+    const elte_fail::ProjectileStats& projStats = m_projectileSim.getProjectiles().getStats();
+    getConsole().OLn("Projectiles: %u spawned, %u spawn failures, %u expired, %u hit world, %u hit player, max active: %u",
+        static_cast<uint32_t>(projStats.m_nSpawned), static_cast<uint32_t>(projStats.m_nSpawnFailures),
+        static_cast<uint32_t>(projStats.m_nExpired), static_cast<uint32_t>(projStats.m_nHitWorld),
+        static_cast<uint32_t>(projStats.m_nHitPlayer), projStats.m_nMaxActive);
+    m_vProjectileEvents.clear();
+    for (PureObject3D* const projectileObj : m_vProjectileObjects)
+    {
+        m_frustumCuller.forget(*projectileObj);
+    }
+    m_vProjectileObjects.clear();  // deleted by DeleteAll() below
+
+    if (m_arenaStreamer.isStarted())
+    {
+        const elte_fail::ChunkStreamerStats streamStats = m_arenaStreamer.getStats();
+        getConsole().OLn("Arena streaming: %u loads, %u unloads, %u evictions, %u failed chunks, %u KB prefetched",
+            static_cast<uint32_t>(streamStats.m_nLoads),
+            static_cast<uint32_t>(streamStats.m_nUnloads),
+            static_cast<uint32_t>(streamStats.m_nEvictions),
+            streamStats.m_nFailed,
+            static_cast<uint32_t>(streamStats.m_nBytesPrefetched / 1024));
+        m_arenaStreamer.stop();
+    }
+
+    const elte_fail::TextureCacheStats& texStats = m_textureCache.getStats();
+    getConsole().OLn("Texture cache: %u hits, %u loads, %u failed, %u duplicates deleted, %u evictions, max: %u KB",
+        static_cast<uint32_t>(texStats.m_nHits), static_cast<uint32_t>(texStats.m_nLoads), static_cast<uint32_t>(texStats.m_nLoadFailures),
+        static_cast<uint32_t>(texStats.m_nDuplicatesDeleted), static_cast<uint32_t>(texStats.m_nEvictions),
+        static_cast<uint32_t>(texStats.m_nMaxBytes / 1024));
+    // PURE deletes all its textures anyway
+    m_textureCache.clear();
+
+    getConsole().OLn("Entities: %u", m_entities.getCount());
+    m_entities.clear();  // objects are deleted by DeleteAll() below
+    getPure().getObject3DManager().DeleteAll();
+
+    getConsole().Deinitialize();
+} // onGameRunning()
+
+
+// ############################### PRIVATE ###############################
+
+
+void CustomPGE::WritePlayerList()
+{
+    m_log.OLn("CustomPGE::%s()", __func__);
+    for (const auto& player : m_mapPlayers)
+    {
+        m_log.OLn("  Username: %s; connHandleServerSide: %u; address: %s; trollFace: %s",
+            m_strings.getString(player.second.m_nUserNameId).c_str(),
+            player.first,
+            m_strings.getString(player.second.m_nIpAddressId).c_str(),
+            m_strings.getString(player.second.m_nTrollfaceId).c_str());
+    }
+}
+
+/**
+    Called on every join and leave. getNetwork().WriteList() writes synchronously to CConsole, so it is invoked only if
+    debug level is enabled for our async log module, otherwise only our player list is written to the async log.
+*/
+void CustomPGE::WriteListsOnJoinLeave()
+{
+    if (m_log.isEnabled(elte_fail::LogLevel::Debug))
+    {
+        getNetwork().WriteList();
+    }
+    WritePlayerList();
+
+    const elte_fail::TextureCacheStats& texStats = m_textureCache.getStats();
+    m_log.OLn("Texture cache: %u textures (%u referenced), %u KB (%u KB referenced, max: %u KB, budget: %u KB), %u loads, %u evictions",
+        texStats.m_nTextures, texStats.m_nReferenced,
+        static_cast<uint32_t>(texStats.m_nBytes / 1024), static_cast<uint32_t>(texStats.m_nReferencedBytes / 1024),
+        static_cast<uint32_t>(texStats.m_nMaxBytes / 1024), static_cast<uint32_t>(m_textureCache.getBudget() / 1024),
+        static_cast<uint32_t>(texStats.m_nLoads), static_cast<uint32_t>(texStats.m_nEvictions));
+}
+
+void CustomPGE::WriteNetStats() const
+{
     getConsole().OLnOI("CustomPGE::%s()", __func__);
+    for (const auto& msgAppId2StringPair : elte_fail::MapMsgAppId2String)
+    {
+        const elte_fail::MsgAppTrafficCounters& rx = m_netStats.getRx(msgAppId2StringPair.msgId);
+        const elte_fail::MsgAppTrafficCounters& tx = m_netStats.getTx(msgAppId2StringPair.msgId);
+        const elte_fail::MsgAppHandlerStats& stats = m_msgAppDispatcher.getStats(msgAppId2StringPair.msgId);
+        getConsole().OLnOI("%s:", msgAppId2StringPair.zstring);
+        getConsole().OLn("Rx: %u msgs, %u bytes; %f msg/s, %f Bps",
+            static_cast<uint32_t>(rx.m_nCount), static_cast<uint32_t>(rx.m_nBytes), rx.m_fCountPerSec, rx.m_fBytesPerSec);
+        getConsole().OLn("Tx: %u msgs, %u bytes; %f msg/s, %f Bps",
+            static_cast<uint32_t>(tx.m_nCount), static_cast<uint32_t>(tx.m_nBytes), tx.m_fCountPerSec, tx.m_fBytesPerSec);
+        getConsole().OLn("Handler: calls: %u; failed: %u; avg: %u ns; max: %u ns",
+            static_cast<uint32_t>(stats.m_nCalls),
+            static_cast<uint32_t>(stats.m_nFailedCalls),
+            static_cast<uint32_t>(stats.m_nCalls > 0 ? stats.m_nTotalTimeNSecs / stats.m_nCalls : 0),
+            static_cast<uint32_t>(stats.m_nMaxTimeNSecs));
+
+        std::string sHistogram;
+        for (const auto& nBucket : stats.m_nTimeHistogram)
+        {
+            sHistogram += std::to_string(nBucket) + " ";
+        }
+        getConsole().OLn("Handler time histogram (<1us, <2us, <4us, ...): %s", sHistogram.c_str());
+        if (TMsgAppDispatcher::getChannel(static_cast<pge_network::MsgApp::TMsgId>(msgAppId2StringPair.msgId)) == elte_fail::MsgChannel::UnreliableSequenced)
+        {
+            getConsole().OLn("Latest-wins: %u stale dropped", static_cast<uint32_t>(m_seqFilter.getDroppedCount(msgAppId2StringPair.msgId)));
+        }
+        getConsole().OO();
+    }
+    getConsole().OLn("Latest-wins messages superseded before sending: %u", static_cast<uint32_t>(m_nLatestPktsSuperseded));
+    for (const auto& clientSendState : m_mapClientSendStates)
+    {
+        const elte_fail::SendRateController& rate = clientSendState.second.m_rate;
+        getConsole().OLn("Send rate to connHandleServerSide %u: %f Hz, detail: %s, backoffs: %u; ping: %d ms, queue time: %d us, tx: %f Bps",
+            clientSendState.first, rate.getRate(), elte_fail::SendRateController::getDetailName(rate.getDetail()), rate.getBackoffCount(),
+            rate.getMetrics().m_nPingMSecs, static_cast<int>(rate.getMetrics().m_nQueueTimeUSecs), rate.getMetrics().m_fTxBytesPerSec);
+    }
+
+    if (m_netConditioner.getStats().m_nSubmitted > 0)
+    {
+        const elte_fail::NetConditionerStats& condStats = m_netConditioner.getStats();
+        getConsole().OLnOI("Network conditioner:");
+        getConsole().OLn("Packets: submitted: %u; delivered: %u; dropped: %u; retransmitted: %u; duplicated: %u; reordered: %u; queued: %u",
+            static_cast<uint32_t>(condStats.m_nSubmitted), static_cast<uint32_t>(condStats.m_nDelivered),
+            static_cast<uint32_t>(condStats.m_nDropped), static_cast<uint32_t>(condStats.m_nRetransmitted),
+            static_cast<uint32_t>(condStats.m_nDuplicated), static_cast<uint32_t>(condStats.m_nReordered),
+            static_cast<uint32_t>(m_netConditioner.getQueuedCount()));
+        getConsole().OLn("Added delay: avg: %u us; max: %u us",
+            static_cast<uint32_t>(condStats.m_nDelivered > 0 ? condStats.m_nSumDelayUSecs / condStats.m_nDelivered : 0),
+            static_cast<uint32_t>(condStats.m_nMaxDelayUSecs));
+        getConsole().OO();
+    }
+
+    if (m_pktPipeline.isStarted())
+    {
+        const elte_fail::PacketPipelineStats stats = m_pktPipeline.getStats();
+        getConsole().OLnOI("Receive pipeline:");
+        getConsole().OLn("Packets: submitted: %u; rejected: %u; applied: %u",
+            static_cast<uint32_t>(stats.m_nSubmitted), static_cast<uint32_t>(stats.m_nRejected), static_cast<uint32_t>(stats.m_nApplied));
+        getConsole().OLn("Backpressure: ingress full: %u; decoded full: %u; max queued: ingress: %u, decoded: %u (capacity: %u)",
+            static_cast<uint32_t>(stats.m_nIngressStalls), static_cast<uint32_t>(stats.m_nDecodedStalls),
+            stats.m_nMaxIngressQueued, stats.m_nMaxDecodedQueued, static_cast<uint32_t>(elte_fail::PacketPipeline::nQueueCapacity));
+        getConsole().OLn("Latency from receive to apply: avg: %u us; max: %u us",
+            static_cast<uint32_t>(stats.m_nApplied > 0 ? stats.m_nTotalLatencyUSecs / stats.m_nApplied : 0), stats.m_nMaxLatencyUSecs);
+        getConsole().OO();
+    }
+    getConsole().OO();
+}
+
+/**
+    Bookkeeping of every sent packet: stats, capture, replay.
+
+    @param connHandleServerSide The recipient client if the packet is sent to a single client, otherwise 0.
+*/
+void CustomPGE::onPktSent(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide, uint32_t nRecipients)
+{
+    if (m_netCapture.isOpen())
+    {
+        m_netCapture.writePktSent(pkt, connHandleServerSide, nRecipients);
+    }
+
+    if (m_bReplaying)
+    {
+        m_nReplayMsgsSent += nRecipients;
+    }
+
+    if (pge_network::PgePacket::getPacketId(pkt) != pge_network::MsgApp::id)
+    {
+        return;
+    }
+
+    const pge_network::MsgApp::TMsgId msgAppId = pge_network::PgePacket::getMsgAppIdFromPkt(pkt);
+    if (TMsgAppDispatcher::isKnownMsgId(msgAppId))
+    {
+        m_netStats.onMsgAppSent(msgAppId, pge_network::PgePacket::getMessageAppsTotalActualLengthBytes(pkt), nRecipients);
+    }
+}
+
+/**
+    Injects the packet to server itself through the loopback transport, to be processed in the next frame.
+    Falls back to injecting through PGE if the loopback queue is full. Server only.
+*/
+void CustomPGE::sendPktToSelf(const pge_network::PgePacket& pkt)
+{
+    if (!m_loopback.send(pkt))
+    {
+        getNetwork().getServer().send(pkt);
+    }
+}
+
+/**
+    Sends to server if we are client, injects to own queue if we are server.
+*/
+void CustomPGE::sendPkt(const pge_network::PgePacket& pkt)
+{
+    onPktSent(pkt, 0, 1);
+    if (m_bReplaying)
+    {
+        return;
+    }
+
+    if (getNetwork().isServer())
+    {
+        sendPktToSelf(pkt);
+    }
+    else
+    {
+        transmitPkt(pkt, 0);
+    }
+}
+
+void CustomPGE::sendPktToClient(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide)
+{
+    onPktSent(pkt, connHandleServerSide, 1);
+    if (m_bReplaying)
+    {
+        return;
+    }
+
+    if (connHandleServerSide == m_connHandleServerSideMe)
+    {
+        sendPktToSelf(pkt);
+    }
+    else
+    {
+        transmitPkt(pkt, connHandleServerSide);
+    }
+}
+
+/**
+    Sends to all clients of our match and injects to own queue too. Server only.
+    Messages of MsgChannel::UnreliableSequenced are only queued until flushLatestPkts(), replacing the queued older message
+    of the same type about the same connection, so less messages are waiting in the reliable send queues of PGE.
+    Each client gets them at its own rate, see ClientSendState_t.
+    They are still counted as sent here, so a capture and its replay count the same.
+*/
+void CustomPGE::sendPktToAll(const pge_network::PgePacket& pkt)
+{
+    onPktSent(pkt, 0, static_cast<uint32_t>(m_mapPlayers.size()));
+    if (m_bReplaying)
+    {
+        return;
+    }
+
+    if (pge_network::PgePacket::getPacketId(pkt) == pge_network::MsgApp::id)
+    {
+        const pge_network::MsgApp::TMsgId msgAppId = pge_network::PgePacket::getMsgAppIdFromPkt(pkt);
+        if (TMsgAppDispatcher::isKnownMsgId(msgAppId) && (TMsgAppDispatcher::getChannel(msgAppId) == elte_fail::MsgChannel::UnreliableSequenced))
+        {
+            const auto itLatest = m_mapLatestPkts.try_emplace(
+                TLatestPktKey(msgAppId, pge_network::PgePacket::getServerSideConnectionHandle(pkt))).first;
+            LatestPkt_t& latestPkt = itLatest->second;
+            if (latestPkt.m_nVersion > m_nLatestPktsVersionFlushed)
+            {
+                m_nLatestPktsSuperseded++;
+            }
+            m_mapLatestPktsByVersion.erase(latestPkt.m_nVersion);
+            latestPkt.m_pkt = pkt;
+            latestPkt.m_nVersion = ++m_nLatestPktsVersion;
+            m_mapLatestPktsByVersion.emplace_hint(m_mapLatestPktsByVersion.end(), latestPkt.m_nVersion, itLatest);
+            return;
+        }
+    }
+
+    sendPktToSelf(pkt);
+    sendPktToOurClientsExcept(pkt, 0);
+}
+
+void CustomPGE::sendPktToAllClientsExcept(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide)
+{
+    uint32_t nRecipients = 0;
+    for (const auto& player : m_mapPlayers)
+    {
+        if ((player.first != m_connHandleServerSideMe) && (player.first != connHandleServerSide))
+        {
+            nRecipients++;
+        }
+    }
+    onPktSent(pkt, 0, nRecipients);
+    if (!m_bReplaying)
+    {
+        sendPktToOurClientsExcept(pkt, connHandleServerSide);
+    }
+}
+
+/**
+    Broadcasts through PGE while all clients are in our match, otherwise clients of hosted matches must not get the packet,
+    so it is sent to our clients 1 by 1. Also sent 1 by 1 while the network conditioner is enabled, so every client
+    gets its own conditions. Doesn't do bookkeeping, server only.
+*/
+void CustomPGE::sendPktToOurClientsExcept(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide)
+{
+    if ((m_matches.getConnectionCount() == 0) && !m_netConditioner.isEnabled())
+    {
+        getNetwork().getServer().sendToAllClientsExcept(pkt, connHandleServerSide);
+        return;
+    }
+
+    for (const auto& player : m_mapPlayers)
+    {
+        if ((player.first != m_connHandleServerSideMe) && (player.first != connHandleServerSide))
+        {
+            transmitPkt(pkt, player.first);
+        }
+    }
+}
+
+/**
+    Every packet sent to another machine goes through here, so the network conditioner can delay, drop, duplicate or reorder it.
+    Doesn't do bookkeeping.
+
+    @param connHandleServerSide The recipient client if we are server, ignored by clients since they send to the server.
+*/
+void CustomPGE::transmitPkt(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide)
+{
+    if (!m_netConditioner.isEnabled())
+    {
+        transmitPktNow(pkt, connHandleServerSide);
+        return;
+    }
+
+    bool bReliable = true;
+    if (pge_network::PgePacket::getPacketId(pkt) == pge_network::MsgApp::id)
+    {
+        const pge_network::MsgApp::TMsgId msgAppId = pge_network::PgePacket::getMsgAppIdFromPkt(pkt);
+        bReliable = !TMsgAppDispatcher::isKnownMsgId(msgAppId) || (TMsgAppDispatcher::getChannel(msgAppId) != elte_fail::MsgChannel::UnreliableSequenced);
+    }
+    m_netConditioner.submit(pkt, connHandleServerSide, bReliable, getNowUSecs());
+}
+
+/**
+    Gives the packet to PGE, bypassing the network conditioner.
+*/
+void CustomPGE::transmitPktNow(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide)
+{
+    if (getNetwork().isServer())
+    {
+        getNetwork().getServer().send(pkt, connHandleServerSide);
+    }
+    else
+    {
+        getNetwork().getServerClientInstance()->send(pkt);
+    }
+}
+
+/**
+    Configures the network conditioner from the net_cond_* CVars, called also when any of them changes.
+*/
+void CustomPGE::applyNetConditions()
+{
+    elte_fail::NetConditions conditions;
+    conditions.m_nLatencyMSecs = static_cast<uint32_t>(std::max(0, m_cvNetCondLatencyMs.get()));
+    conditions.m_nJitterMSecs = static_cast<uint32_t>(std::max(0, m_cvNetCondJitterMs.get()));
+    conditions.m_fLossPercent = m_cvNetCondLossPercent.get();
+    conditions.m_fDuplicatePercent = m_cvNetCondDuplicatePercent.get();
+    conditions.m_fReorderPercent = m_cvNetCondReorderPercent.get();
+    conditions.m_nSeed = static_cast<uint32_t>(m_cvNetCondSeed.get());
+    m_netConditioner.configure(conditions);
+    if (conditions.isEnabled())
+    {
+        getConsole().OLn("Network conditioner: latency: %u ms, jitter: %u ms, loss: %f %%, duplicate: %f %%, reorder: %f %%, seed: %u",
+            conditions.m_nLatencyMSecs, conditions.m_nJitterMSecs,
+            conditions.m_fLossPercent, conditions.m_fDuplicatePercent, conditions.m_fReorderPercent, conditions.m_nSeed);
+    }
+}
+
+/**
+    Sends the latest-wins messages queued by sendPktToAll(). Called once per frame.
+    Own queue gets the new messages in every frame, but a client gets them only when its send rate makes it due, and then only
+    those newer than what it already got. Messages about the client's own player are sent at every due send, messages about
+    other players less often if the client's send detail is reduced.
+    Only messages queued since the last send are visited, found by their version.
+*/
+void CustomPGE::flushLatestPkts()
+{
+    for (auto it = m_mapLatestPktsByVersion.upper_bound(m_nLatestPktsVersionFlushed); it != m_mapLatestPktsByVersion.end(); ++it)
+    {
+        sendPktToSelf(it->second->second.m_pkt);
+    }
+    m_nLatestPktsVersionFlushed = m_nLatestPktsVersion;
+
+    const uint64_t nNowUSecs = getNowUSecs();
+    updateClientSendRates(nNowUSecs);
+    for (auto& clientSendState : m_mapClientSendStates)
+    {
+        ClientSendState_t& client = clientSendState.second;
+        if (!client.m_rate.isDue(nNowUSecs))
+        {
+            continue;
+        }
+
+        // messages about others between the 2 versions were skipped by earlier sends not due for others
+        const bool bOthersDue = client.m_rate.isOthersDue();
+        const uint64_t nVersionFrom = bOthersDue ? client.m_nVersionSentOthers : client.m_nVersionSentOwn;
+        for (auto it = m_mapLatestPktsByVersion.upper_bound(nVersionFrom); it != m_mapLatestPktsByVersion.end(); ++it)
+        {
+            const bool bOwn = (it->second->first.second == clientSendState.first);
+            if (bOwn ? (it->first > client.m_nVersionSentOwn) : bOthersDue)
+            {
+                transmitPkt(it->second->second.m_pkt, clientSendState.first);
+            }
+        }
+        client.m_nVersionSentOwn = m_nLatestPktsVersion;
+        if (bOthersDue)
+        {
+            client.m_nVersionSentOthers = m_nLatestPktsVersion;
+        }
+    }
+}
+
+/**
+    Feeds fresh connection metrics from PGE to the send rate of each remote client of our match, creating the send state of new clients.
+*/
+void CustomPGE::updateClientSendRates(uint64_t nNowUSecs)
+{
+    if (nNowUSecs - m_nLastSendRateUpdateUSecs < nSendRateUpdateIntervalUSecs)
+    {
+        return;
+    }
+    m_nLastSendRateUpdateUSecs = nNowUSecs;
+
     for (const auto& player : m_mapPlayers)
     {
-        getConsole().OLn("Username: %s; connHandleServerSide: %u; address: %s; trollFace: %s",
-            player.first.c_str(), player.second.m_connHandleServerSide, player.second.m_sIpAddress.c_str(), player.second.m_sTrollface.c_str());
+        if (player.first == m_connHandleServerSideMe)
+        {
+            continue;
+        }
+
+        auto it = m_mapClientSendStates.find(player.first);
+        if (it == m_mapClientSendStates.end())
+        {
+            it = m_mapClientSendStates.emplace(player.first, ClientSendState_t()).first;
+            it->second.m_rate.configure(getSendRateConfig());
+        }
+
+        elte_fail::SendRateController& rate = it->second.m_rate;
+        const elte_fail::SendDetail detailPrev = rate.getDetail();
+        rate.update(
+            {
+                getNetwork().getServer().getPing(player.first, true),
+                getNetwork().getServer().getQualityLocal(player.first, false),
+                getNetwork().getServer().getQualityRemote(player.first, false),
+                getNetwork().getServer().getTxByteRate(player.first, false),
+                getNetwork().getServer().getInternalQueueTimeUSecs(player.first, false)
+            },
+            nNowUSecs);
+        if (rate.getDetail() != detailPrev)
+        {
+            m_logNet.OLn("CustomPGE::%s(): connHandleServerSide: %u: send detail %s -> %s, rate: %f Hz, queue time: %d us, quality: %f / %f",
+                __func__, player.first,
+                elte_fail::SendRateController::getDetailName(detailPrev),
+                elte_fail::SendRateController::getDetailName(rate.getDetail()),
+                rate.getRate(),
+                static_cast<int>(rate.getMetrics().m_nQueueTimeUSecs),
+                rate.getMetrics().m_fQualityLocal, rate.getMetrics().m_fQualityRemote);
+        }
+    }
+}
+
+/**
+    Send rate limits from the sv_send_rate_* CVars.
+*/
+elte_fail::SendRateConfig CustomPGE::getSendRateConfig() const
+{
+    return {
+        m_cvSvSendRateMin.get(),
+        m_cvSvSendRateMax.get(),
+        static_cast<uint32_t>(std::max(0, m_cvSvSendRateMaxQueueMs.get())) * 1000,
+        m_cvSvSendRateMinQuality.get() };
+}
+
+void CustomPGE::getWorldStatePlayers(std::vector<elte_fail::WorldStatePlayer>& vPlayers) const
+{
+    vPlayers.reserve(vPlayers.size() + m_mapPlayers.size());
+    for (const auto& it : m_mapPlayers)
+    {
+        PureObject3D* const pObj = m_entities.getObject(it.second.m_hEntity);
+        vPlayers.push_back({
+            it.first,
+            it.second.m_nUserNameId, it.second.m_nTrollfaceId, it.second.m_nIpAddressId,
+            pObj ? pObj->getPosVec().getX() : 0.f,
+            pObj ? pObj->getPosVec().getY() : 0.f });
+    }
+}
+
+/**
+    Serializes all players with all their strings, as a world state snapshot. Used as the final state of a net capture.
+*/
+void CustomPGE::serializeFinalState(std::vector<uint8_t>& vSnapshot) const
+{
+    std::vector<elte_fail::WorldStatePlayer> vPlayers;
+    getWorldStatePlayers(vPlayers);
+
+    std::set<elte_fail::TStringId> stringIds;
+    for (const auto& player : vPlayers)
+    {
+        stringIds.insert({ player.m_nUserNameId, player.m_nTrollfaceId, player.m_nIpAddressId });
+    }
+
+    std::vector<elte_fail::WorldStateStringDef> vStringDefs;
+    for (const auto& nStringId : stringIds)
+    {
+        vStringDefs.push_back({ nStringId, m_strings.getString(nStringId) });
+    }
+
+    elte_fail::WorldState::serialize(vStringDefs, vPlayers, vSnapshot);
+}
+
+/**
+    Feeds all packets received in the given capture file to onPacketReceived() as fast as possible, without any networking.
+    Sent packets are not sent, only counted. Logs handler throughput, and compares the resulting players to the final state
+    stored in the capture.
+
+    @return True if all packets were handled successfully and the resulting players match the final state of the capture.
+*/
+bool CustomPGE::runNetReplay(const std::string& sFilename)
+{
+    getConsole().OLnOI("CustomPGE::%s(%s)", __func__, sFilename.c_str());
+
+    elte_fail::NetCaptureReader reader;
+    if (!reader.open(sFilename))
+    {
+        getConsole().EOLn("Failed to open capture file or invalid header!");
+        getConsole().OO();
+        return false;
+    }
+
+    if (reader.isServer() != getNetwork().isServer())
+    {
+        getConsole().EOLn("Capture was recorded by %s, it can be replayed only by %s!",
+            reader.isServer() ? "server" : "client", reader.isServer() ? "server" : "client");
+        getConsole().OO();
+        return false;
+    }
+
+    // decoding everything in advance, so only the packet handling is measured
+    std::vector<pge_network::PgePacket> vPkts;
+    std::vector<uint8_t> vFinalState;
+    uint32_t nCapturedMsgsSent = 0;
+    uint64_t nCaptureDurationUSecs = 0;
+    elte_fail::NetCaptureRecord record;
+    while (reader.readNext(record))
+    {
+        nCaptureDurationUSecs = record.m_nTimeUSecs;
+        switch (record.m_type)
+        {
+        case elte_fail::NetCaptureRecordType::PktReceived:
+            if (record.m_vData.size() != sizeof(pge_network::PgePacket))
+            {
+                getConsole().EOLn("Invalid packet length %u!", static_cast<uint32_t>(record.m_vData.size()));
+                getConsole().OO();
+                return false;
+            }
+            vPkts.emplace_back();
+            memcpy(&vPkts.back(), record.m_vData.data(), sizeof(pge_network::PgePacket));
+            break;
+        case elte_fail::NetCaptureRecordType::PktSent:
+            nCapturedMsgsSent += record.m_nRecipients;
+            break;
+        default: /* final state */
+            vFinalState = record.m_vData;
+            break;
+        }
+    }
+
+    if (reader.hasError())
+    {
+        getConsole().EOLn("Capture file is corrupt after %u received packets!", static_cast<uint32_t>(vPkts.size()));
+        getConsole().OO();
+        return false;
+    }
+
+    m_matchRules.seed(reader.getRandSeed());
+    m_msgAppDispatcher.resetStats();
+    m_bReplaying = true;
+    m_nReplayMsgsSent = 0;
+
+    uint32_t nFailedPkts = 0;
+    const auto timeStart = std::chrono::steady_clock::now();
+    for (const auto& pkt : vPkts)
+    {
+        if (!onPacketReceived(pkt))
+        {
+            nFailedPkts++;
+        }
+    }
+    const auto nReplayDurationUSecs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - timeStart).count();
+
+    getConsole().OLn("Replayed %u packets in %u usecs (captured in %u msecs): %f packets/s, %f usecs/packet, %u failed",
+        static_cast<uint32_t>(vPkts.size()),
+        static_cast<uint32_t>(nReplayDurationUSecs),
+        static_cast<uint32_t>(nCaptureDurationUSecs / 1000),
+        (nReplayDurationUSecs > 0) ? (vPkts.size() * 1000000.f / nReplayDurationUSecs) : 0.f,
+        vPkts.empty() ? 0.f : (static_cast<float>(nReplayDurationUSecs) / vPkts.size()),
+        nFailedPkts);
+    getConsole().OLn("Messages sent: %u in capture, %u in replay", nCapturedMsgsSent, m_nReplayMsgsSent);
+    WriteNetStats();
+
+    const bool bFinalStateMatches = verifyReplayFinalState(vFinalState);
+    getConsole().OLn("Final state %s", bFinalStateMatches ? "matches" : "DOES NOT match");
+
+    getConsole().OO();
+    return (nFailedPkts == 0) && bFinalStateMatches && (nCapturedMsgsSent == m_nReplayMsgsSent);
+}
+
+/**
+    Compares the current players to the given final state of a capture.
+
+    @return True if they are the same, false if they differ or final state is missing or invalid.
+*/
+bool CustomPGE::verifyReplayFinalState(const std::vector<uint8_t>& vFinalState) const
+{
+    std::vector<elte_fail::WorldStateStringDef> vStringDefs;
+    std::vector<elte_fail::WorldStatePlayer> vPlayers;
+    if (vFinalState.empty() || !elte_fail::WorldState::deserialize(vFinalState.data(), vFinalState.size(), vStringDefs, vPlayers))
+    {
+        getConsole().EOLn("CustomPGE::%s(): final state is missing or invalid!", __func__);
+        return false;
+    }
+
+    // string ids in the capture are ids of the recording instance, so strings are compared instead of ids
+    std::map<elte_fail::TStringId, std::string> mapCapturedStrings;
+    for (const auto& stringDef : vStringDefs)
+    {
+        mapCapturedStrings[stringDef.m_nStringId] = stringDef.m_sString;
+    }
+
+    bool bRet = (vPlayers.size() == m_mapPlayers.size());
+    if (!bRet)
+    {
+        getConsole().EOLn("CustomPGE::%s(): %u players in capture, %u after replay!",
+            __func__, static_cast<uint32_t>(vPlayers.size()), static_cast<uint32_t>(m_mapPlayers.size()));
+    }
+
+    for (const auto& capturedPlayer : vPlayers)
+    {
+        const auto it = m_mapPlayers.find(capturedPlayer.m_connHandleServerSide);
+        if (it == m_mapPlayers.end())
+        {
+            getConsole().EOLn("CustomPGE::%s(): player with connHandleServerSide %u is missing after replay!", __func__, capturedPlayer.m_connHandleServerSide);
+            bRet = false;
+            continue;
+        }
+
+        const Player_t& player = it->second;
+        PureObject3D* const pObj = m_entities.getObject(player.m_hEntity);
+        const bool bSame =
+            (mapCapturedStrings[capturedPlayer.m_nUserNameId] == m_strings.getString(player.m_nUserNameId)) &&
+            (mapCapturedStrings[capturedPlayer.m_nTrollfaceId] == m_strings.getString(player.m_nTrollfaceId)) &&
+            (mapCapturedStrings[capturedPlayer.m_nIpAddressId] == m_strings.getString(player.m_nIpAddressId)) &&
+            pObj &&
+            (capturedPlayer.m_fPosX == pObj->getPosVec().getX()) &&
+            (capturedPlayer.m_fPosY == pObj->getPosVec().getY());
+        if (!bSame)
+        {
+            getConsole().EOLn("CustomPGE::%s(): player %s (connHandleServerSide %u) differs after replay!",
+                __func__, mapCapturedStrings[capturedPlayer.m_nUserNameId].c_str(), capturedPlayer.m_connHandleServerSide);
+            bRet = false;
+        }
+    }
+
+    return bRet;
+}
+
+/**
+    Moves the given number of simulated players around in the collision world, the same way as handleUserCmdMove() does,
+    and logs the number of movement queries per second, with BVH and with brute force for comparison.
+    Simulated players are not related to real players in any way.
+*/
+void CustomPGE::runCollisionBenchmark(uint32_t nPlayers) const
+{
+    getConsole().OLnOI("CustomPGE::%s(%u)", __func__, nPlayers);
+
+    if (m_collisionWorld.isEmpty())
+    {
+        getConsole().EOLn("Collision world is empty!");
+        getConsole().OO();
+        return;
+    }
+
+    static const uint32_t nFrames = 1000;
+
+    // own generator with fixed seed, so the benchmark is repeatable and rand() sequence of the game is not disturbed
+    std::mt19937 rng(12345);
+    const elte_fail::Aabb& bounds = m_collisionWorld.getBounds();
+    std::uniform_real_distribution<float> distX(bounds.m_fMin[0], bounds.m_fMax[0]);
+    std::uniform_real_distribution<float> distY(bounds.m_fMin[1], bounds.m_fMax[1]);
+    std::uniform_int_distribution<int> distDir(-1, 1);
+
+    struct BenchPlayer
+    {
+        float m_fPosX;
+        float m_fPosY;
+    };
+    std::vector<BenchPlayer> vPlayersInitial(nPlayers);
+    for (auto& player : vPlayersInitial)
+    {
+        player.m_fPosX = distX(rng);
+        player.m_fPosY = distY(rng);
+    }
+    std::vector<int> vDirections(static_cast<size_t>(nPlayers) * nFrames * 2);
+    for (auto& nDir : vDirections)
+    {
+        nDir = distDir(rng);
+    }
+
+    std::vector<BenchPlayer> vPlayersFinal[2];
+    for (const auto mode : { elte_fail::CollisionQueryMode::Bvh, elte_fail::CollisionQueryMode::BruteForce })
+    {
+        std::vector<BenchPlayer> vPlayers = vPlayersInitial;
+        uint64_t nTested = 0;
+        uint32_t nBlocked = 0;
+        const auto timeStart = std::chrono::steady_clock::now();
+        for (uint32_t iFrame = 0; iFrame < nFrames; iFrame++)
+        {
+            for (uint32_t iPlayer = 0; iPlayer < nPlayers; iPlayer++)
+            {
+                BenchPlayer& player = vPlayers[iPlayer];
+                const size_t iDir = (static_cast<size_t>(iFrame) * nPlayers + iPlayer) * 2;
+                float fDx = vDirections[iDir] * elte_fail::MatchRules::fPlayerStep;
+                float fDy = vDirections[iDir + 1] * elte_fail::MatchRules::fPlayerStep;
+                const float fDxWanted = fDx;
+                const float fDyWanted = fDy;
+                nTested += m_collisionWorld.clampMove(elte_fail::MatchRules::getPlayerCollisionBox(player.m_fPosX, player.m_fPosY), fDx, fDy, mode);
+                if ((fDx != fDxWanted) || (fDy != fDyWanted))
+                {
+                    nBlocked++;
+                }
+                player.m_fPosX += fDx;
+                player.m_fPosY += fDy;
+            }
+        }
+        const auto nDurationUSecs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - timeStart).count();
+        const uint64_t nQueries = static_cast<uint64_t>(nPlayers) * nFrames;
+
+        getConsole().OLn("%s: %u queries in %u usecs: %f queries/s, %f usecs/frame, %f boxes tested/query, %u blocked",
+            (mode == elte_fail::CollisionQueryMode::Bvh) ? "BVH" : "Brute force",
+            static_cast<uint32_t>(nQueries),
+            static_cast<uint32_t>(nDurationUSecs),
+            (nDurationUSecs > 0) ? (nQueries * 1000000.f / nDurationUSecs) : 0.f,
+            static_cast<float>(nDurationUSecs) / nFrames,
+            static_cast<float>(nTested) / nQueries,
+            nBlocked);
+        vPlayersFinal[(mode == elte_fail::CollisionQueryMode::Bvh) ? 0 : 1] = vPlayers;
+    }
+
+    uint32_t nMismatches = 0;
+    for (uint32_t i = 0; i < nPlayers; i++)
+    {
+        if ((vPlayersFinal[0][i].m_fPosX != vPlayersFinal[1][i].m_fPosX) || (vPlayersFinal[0][i].m_fPosY != vPlayersFinal[1][i].m_fPosY))
+        {
+            nMismatches++;
+        }
+    }
+    if (nMismatches == 0)
+    {
+        getConsole().OLn("BVH and brute force results match");
+    }
+    else
+    {
+        getConsole().EOLn("BVH and brute force results DIFFER for %u players!", nMismatches);
+    }
+
+    getConsole().OO();
+}
+
+/**
+    Copies lightmap data of every subobject of objLightmap into the 2nd material layer of the same subobject of obj.
+    Assuming that objLightmap has the same subobjects with the same vertex count as obj.
+    objLightmap can be deleted afterwards.
+*/
+bool CustomPGE::applyLightmap(PureObject3D& obj, PureObject3D& objLightmap)
+{
+    if (obj.getCount() != objLightmap.getCount())
+    {
+        getConsole().EOLn("CustomPGE::%s(): obj.getCount() != objLightmap.getCount(): %d != %d", __func__, obj.getCount(), objLightmap.getCount());
+        return false;
+    }
+
+    for (TPureInt i = 0; i < obj.getCount(); i++)
+    {
+        PureObject3D* const objSub = (PureObject3D*)obj.getAttachedAt(i);
+        PureObject3D* const objLightmapSub = (PureObject3D*)objLightmap.getAttachedAt(i);
+        if (objSub && objLightmapSub)
+        {
+            // copying lightmap data into material's 2nd layer
+            objSub->getMaterial(false).copyFromMaterial(objLightmapSub->getMaterial(false), 1, 0);
+            objSub->getMaterial(false).setBlendFuncs(PURE_SRC_ALPHA, PURE_ONE_MINUS_SRC_ALPHA, 1);
+        }
+    }
+    return true;
+}
+
+/**
+    Invokes fnMaterial for the materials of the subobjects of the given object, or for its own material if it has no subobjects.
+*/
+template <class F>
+static void forEachMaterial(PureObject3D& obj, F&& fnMaterial)
+{
+    if (obj.getCount() == 0)
+    {
+        fnMaterial(obj.getMaterial(false));
+        return;
+    }
+    for (TPureInt i = 0; i < obj.getCount(); i++)
+    {
+        PureObject3D* const objSub = (PureObject3D*)obj.getAttachedAt(i);
+        if (objSub)
+        {
+            fnMaterial(objSub->getMaterial(false));
+        }
+    }
+}
+
+/**
+    Acquires all textures of the given object, loaded by the OBJ loader or copied from a lightmap object, from m_textureCache,
+    so they are freed when not used anymore. Textures already in the cache are used instead of the ones loaded again by the loader.
+    The object must be deleted by deleteObjectAndReleaseTextures().
+*/
+void CustomPGE::acquireMaterialTextures(PureObject3D& obj)
+{
+    // same texture can be in multiple materials, it must not be used after being deleted as a duplicate
+    std::map<PureTexture*, PureTexture*> mapReplaced;
+    forEachMaterial(obj, [this, &mapReplaced](PureMaterial& material)
+        {
+            for (TPureUInt iLayer = 0; iLayer < material.getLayerCount(); iLayer++)
+            {
+                PureTexture* const tex = material.getTexture(iLayer);
+                if (!tex)
+                {
+                    continue;
+                }
+                const auto itReplaced = mapReplaced.find(tex);
+                PureTexture* const texCached = m_textureCache.acquireLoaded((itReplaced == mapReplaced.end()) ? *tex : *itReplaced->second);
+                if (texCached != tex)
+                {
+                    mapReplaced[tex] = texCached;
+                    material.setTexture(texCached, iLayer);
+                }
+            }
+        });
+}
+
+/**
+    Deletes the given object, then releases its textures acquired from m_textureCache.
+*/
+void CustomPGE::deleteObjectAndReleaseTextures(PureObject3D* obj)
+{
+    std::vector<PureTexture*> vTextures;
+    forEachMaterial(*obj, [&vTextures](PureMaterial& material)
+        {
+            for (TPureUInt iLayer = 0; iLayer < material.getLayerCount(); iLayer++)
+            {
+                if (material.getTexture(iLayer))
+                {
+                    vTextures.push_back(material.getTexture(iLayer));
+                }
+            }
+        });
+
+    delete obj;  // yes, dtor will remove this from its Object3DManager too!
+
+    for (const auto& tex : vTextures)
+    {
+        m_textureCache.release(*tex);
+    }
+}
+
+/**
+    Optimizes the given model (and its lightmap model, if sLightmapFilename is not empty) by elte_fail::MeshOptimizer
+    if gfx_mesh_optimize is set, and logs vertex and draw call counts before and after.
+    On success the filenames are changed to the optimized files, otherwise they are left unchanged so the source files are loaded.
+*/
+void CustomPGE::optimizeModel(const std::string& sName, std::string& sFilename, std::string& sLightmapFilename)
+{
+    if (!m_cvGfxMeshOptimize.get())
+    {
+        return;
+    }
+
+    elte_fail::MeshOptimizerStats stats;
+    if (!elte_fail::MeshOptimizer::optimizeFile(sFilename, sLightmapFilename, stats))
+    {
+        getConsole().EOLn("Mesh optimizer: failed to optimize %s, loading source model: %s", sName.c_str(), sFilename.c_str());
+        return;
+    }
+
+    getConsole().OLn("Mesh optimizer: %s: %u triangles, vertices: %u -> %u, draw calls: %u -> %u, ACMR: %.3f -> %.3f%s",
+        sName.c_str(), stats.m_nTriangles,
+        stats.m_nVerticesBefore, stats.m_nVerticesAfter,
+        stats.m_nDrawCallsBefore, stats.m_nDrawCallsAfter,
+        stats.m_fAcmrBefore, stats.m_fAcmrAfter,
+        stats.m_bWritten ? " (written)" : "");
+
+    sFilename = elte_fail::MeshOptimizer::getOutputFilename(sFilename);
+    if (!sLightmapFilename.empty())
+    {
+        sLightmapFilename = elte_fail::MeshOptimizer::getOutputFilename(sLightmapFilename);
+    }
+}
+
+/**
+    Sets the vertex transfer mode selected by elte_fail::VertexTransferPolicy, and logs it.
+*/
+void CustomPGE::applyVertexTransferPolicy(PureObject3D& obj, const std::string& sName, elte_fail::MeshUsage usage)
+{
+    const TPURE_TRANSFER_MODE mode = elte_fail::VertexTransferPolicy::apply(obj, usage);
+    getConsole().OLn("Vertex transfer mode of %s (%u vertices): %s",
+        sName.c_str(), elte_fail::VertexTransferPolicy::getVertexCount(obj), elte_fail::VertexTransferPolicy::getModeName(mode));
+}
+
+/**
+    Simulates a server sending player updates to clients through the network conditioner, headless and on simulated time,
+    first without conditions and then with the conditions of the net_cond_* CVars, and logs the effect on update latency and bandwidth.
+*/
+void CustomPGE::runNetConditionerBenchmark(uint32_t nSecs) const
+{
+    static const uint32_t nClients = 8;
+    static const uint32_t nTickRate = 60;
+
+    getConsole().OLnOI("CustomPGE::%s(%u), %u clients, %u updates per sec", __func__, nSecs, nClients, nTickRate);
+    elte_fail::NetConditions noConditions{};
+    noConditions.m_nSeed = m_netConditioner.getConditions().m_nSeed;
+    for (const auto& conditions : { noConditions, m_netConditioner.getConditions() })
+    {
+        const auto timeStart = std::chrono::steady_clock::now();
+        const elte_fail::NetConditionerBenchmarkResult result = elte_fail::NetConditionerBenchmark::run(conditions, nSecs, nClients, nTickRate);
+        const auto durationMSecs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - timeStart).count();
+        getConsole().OLn("%s: updates per client: %u; accepted: %u; stale: %u; lost: %u",
+            conditions.isEnabled() ? "Conditioned" : "Unconditioned",
+            result.m_nUpdatesSent,
+            static_cast<uint32_t>(result.m_nUpdatesAccepted),
+            static_cast<uint32_t>(result.m_nUpdatesStale),
+            static_cast<uint32_t>(result.m_nUpdatesLost));
+        getConsole().OLn("  update latency: avg: %f ms, max: %f ms; state age: avg: %f ms; received: %f KB/s; simulated in %u ms",
+            result.m_fAvgLatencyMSecs, result.m_fMaxLatencyMSecs, result.m_fAvgStateAgeMSecs, result.m_fKBytesPerSec,
+            static_cast<uint32_t>(durationMSecs));
+    }
+    getConsole().OO();
+}
+
+void CustomPGE::runProjectileBenchmark(uint32_t nProjectiles) const
+{
+    static const uint32_t nTicks = 600;
+    static const uint32_t nTargets = 8;
+
+    getConsole().OLnOI("CustomPGE::%s(%u), %u ticks, %u players", __func__, nProjectiles, nTicks, nTargets);
+    if (m_collisionWorld.isEmpty())
+    {
+        getConsole().EOLn("Collision world is empty!");
+        getConsole().OO();
+        return;
+    }
+
+    const elte_fail::ProjectileBenchmarkResult result = elte_fail::ProjectileBenchmark::run(m_collisionWorld, nProjectiles, nTicks, nTargets);
+    const float fTickBudgetUSecs = elte_fail::ProjectilePool::fStepSecs * 1000000.f;
+    getConsole().OLn("Active: avg: %f; step: avg: %f us (%f %% of tick), max: %f us; world queries/tick: %f",
+        result.m_fAvgActive, result.m_fAvgStepUSecs, result.m_fAvgStepUSecs * 100.f / fTickBudgetUSecs, result.m_fMaxStepUSecs,
+        result.m_fAvgWorldQueries);
+    getConsole().OLn("Spawned: %u; expired: %u; hit world: %u; hit player: %u; replicated: %f bytes/tick",
+        static_cast<uint32_t>(result.m_nSpawned), static_cast<uint32_t>(result.m_nExpired),
+        static_cast<uint32_t>(result.m_nHitWorld), static_cast<uint32_t>(result.m_nHitPlayer),
+        result.m_fEventBytesPerTick);
+    if (result.m_fMaxStepUSecs > fTickBudgetUSecs)
+    {
+        getConsole().EOLn("Stepping %u projectiles does NOT fit into a tick!", nProjectiles);
+    }
+    getConsole().OO();
+}
+
+/**
+    Exchanges state with the projectile simulation thread, which runs at its own fixed rate regardless of the frame rate.
+    Server gives it the players as targets, and replicates the despawns to clients. Clients only simulate flight and world
+    hits until the server tells the rest, so they just drop the despawns.
+*/
+void CustomPGE::syncProjectileSim()
+{
+    const bool bServer = getNetwork().isServer();
+    if (bServer)
+    {
+        std::vector<elte_fail::ProjectileTarget>& vTargets = m_projectileSim.getTargets();
+        vTargets.clear();
+        for (const auto& player : m_mapPlayers)
+        {
+            PureObject3D* const pObj = m_entities.getObject(player.second.m_hEntity);
+            if (pObj)
+            {
+                vTargets.push_back({ player.first, pObj->getPosVec().getX(), pObj->getPosVec().getY() });
+            }
+        }
+        m_projectileSim.publishTargets();
+    }
+
+    elte_fail::ProjectileDespawn despawn;
+    while (m_projectileSim.popDespawn(despawn))
+    {
+        if (!bServer)
+        {
+            continue;
+        }
+        m_vProjectileEvents.push_back({ despawn.m_nId, despawn.m_reason, 0, 0, 0 });
+        if (despawn.m_reason == elte_fail::ProjectileEventType::HitPlayer)
+        {
+            m_log.DLn("CustomPGE::%s(): connHandleServerSide %u hit by projectile of connHandleServerSide %u",
+                __func__, despawn.m_connHandleHit, despawn.m_connHandleOwner);
+        }
+    }
+
+    flushProjectileEvents();
+}
+
+/**
+    Sends the projectile events collected since last call to clients of our match, as few messages as possible. Server only.
+*/
+void CustomPGE::flushProjectileEvents()
+{
+    for (size_t iFirst = 0; iFirst < m_vProjectileEvents.size(); iFirst += elte_fail::MsgProjectileEventsFromServer::nMaxEvents)
+    {
+        const uint8_t nEvents = static_cast<uint8_t>(
+            std::min<size_t>(m_vProjectileEvents.size() - iFirst, elte_fail::MsgProjectileEventsFromServer::nMaxEvents));
+        pge_network::PgePacket pkt;
+        if (elte_fail::MsgProjectileEventsFromServer::initPkt(pkt, &m_vProjectileEvents[iFirst], nEvents))
+        {
+            sendPktToAllClientsExcept(pkt, 0);
+        }
+        else
+        {
+            m_logNet.EOLn("CustomPGE::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
+            assert(false);
+        }
+    }
+    m_vProjectileEvents.clear();
+}
+
+/**
+    Places the cloned projectile objects at the first projectiles of the latest snapshot of the sim thread, and hides the rest.
+    Snapshot is older than the frame by up to a tick, so projectiles are moved ahead by the elapsed time. Since they fly
+    straight, this gives the same as interpolating between 2 snapshots, without drawing them a tick late.
+*/
+void CustomPGE::updateProjectileObjects()
+{
+    m_projectileSim.updateSnapshot();
+    const elte_fail::SimSnapshot& snapshot = m_projectileSim.getSnapshot();
+    const uint64_t nNowUSecs = getNowUSecs();
+    const float fAheadSecs = (snapshot.m_nTick == 0) || (nNowUSecs <= snapshot.m_nTimeUSecs) ?
+        0.f :
+        std::min(fMaxProjectileExtrapolationSecs, (nNowUSecs - snapshot.m_nTimeUSecs) / 1000000.f);
+
+    const uint32_t nShown = std::min(static_cast<uint32_t>(snapshot.m_vPosX.size()), static_cast<uint32_t>(m_vProjectileObjects.size()));
+    for (uint32_t i = 0; i < nShown; i++)
+    {
+        PureObject3D* const projectileObj = m_vProjectileObjects[i];
+        projectileObj->getPosVec().Set(
+            snapshot.m_vPosX[i] + snapshot.m_vVelX[i] * fAheadSecs,
+            snapshot.m_vPosY[i] + snapshot.m_vVelY[i] * fAheadSecs,
+            elte_fail::MatchRules::fPlayerPosZ);
+        projectileObj->getAngleVec().SetZ(std::atan2(snapshot.m_vVelY[i], snapshot.m_vVelX[i]) * fRadToDeg);
+        if (i >= m_nProjectileObjectsShown)
+        {
+            m_frustumCuller.setHidden(*projectileObj, false);
+        }
+    }
+    for (uint32_t i = nShown; i < m_nProjectileObjectsShown; i++)
+    {
+        m_frustumCuller.setHidden(*m_vProjectileObjects[i], true);
+    }
+    m_nProjectileObjectsShown = nShown;
+}
+
+/**
+    Logs average and minimum frame times measured with each vertex transfer mode, for each benchmarked mesh,
+    and whether the mode selected by the policy is the fastest one.
+*/
+void CustomPGE::WriteVertexTransferBenchmark() const
+{
+    getConsole().OLnOI("Vertex transfer benchmark, frame times in msecs:");
+    std::string sLastMesh;
+    for (const auto& result : m_vtBenchmark.getResults())
+    {
+        if (result.m_sMeshName != sLastMesh)
+        {
+            sLastMesh = result.m_sMeshName;
+            const elte_fail::VertexTransferResult* const pBest = m_vtBenchmark.getBestResult(result.m_sMeshName);
+            const TPURE_TRANSFER_MODE policyMode = elte_fail::VertexTransferPolicy::select(result.m_nVertices, elte_fail::MeshUsage::Static);
+            getConsole().OLn("%s (%u vertices): fastest: %s, policy: %s%s",
+                result.m_sMeshName.c_str(),
+                result.m_nVertices,
+                pBest ? elte_fail::VertexTransferPolicy::getModeName(pBest->m_mode) : "-",
+                elte_fail::VertexTransferPolicy::getModeName(policyMode),
+                (pBest && (pBest->m_mode != policyMode)) ? " (DIFFERENT)" : "");
+        }
+        if (result.m_bSupported)
+        {
+            getConsole().OLn("  %s: avg: %f, min: %f, frames: %u",
+                elte_fail::VertexTransferPolicy::getModeName(result.m_mode), result.m_fAvgFrameMSecs, result.m_fMinFrameMSecs, result.m_nFrames);
+        }
+        else
+        {
+            getConsole().OLn("  %s: not supported", elte_fail::VertexTransferPolicy::getModeName(result.m_mode));
+        }
+    }
+    getConsole().OO();
+}
+
+/**
+    Logs frame times and time spent on the overlay with temporal and retained overlay text lines.
+*/
+void CustomPGE::WriteOverlayTextBenchmark() const
+{
+    getConsole().OLnOI("Overlay text benchmark, frame times in msecs, overlay times in usecs:");
+    for (const auto& result : m_overlayBenchmark.getResults())
+    {
+        getConsole().OLn("%s: avg: %f, min: %f, overlay avg: %f, lines rebuilt: %u, frames: %u",
+            (result.m_mode == elte_fail::OverlayTextMode::Temporal) ? "textTemporalLegacy" : "retained",
+            result.m_fAvgFrameMSecs,
+            result.m_fMinFrameMSecs,
+            result.m_fAvgOverlayUSecs,
+            static_cast<uint32_t>(result.m_nRebuilds),
+            result.m_nFrames);
+    }
+    getConsole().OO();
+}
+
+/**
+    Filter of the asset pack: only models are packed, since only loadObj() reads the pack, PURE loads everything by filename.
+    Files generated into gamedata at runtime (arena chunks, optimized models, compiled languages) are not packed, otherwise
+    regenerating them would make the pack outdated.
+*/
+static bool isPackedAsset(const std::string& sPath)
+{
+    static const std::string sChunksPrefix = elte_fail::AssetPack::normalizePath(ARENA_CHUNKS_PREFIX);
+    const std::string sNormalized = elte_fail::AssetPack::normalizePath(sPath);
+    const std::filesystem::path path(sNormalized);
+    return (path.extension() == ".obj") &&
+        (sNormalized.compare(0, sChunksPrefix.size(), sChunksPrefix) != 0) &&
+        !elte_fail::MeshOptimizer::isOutputFilename(sNormalized);
+}
+
+/**
+    Rebuilds the asset pack given by asset_pack_file if asset_pack_build is set and any model of gamedata is newer than it,
+    then opens it. If asset_pack_file is empty or the pack cannot be used, models are read from separate files.
+*/
+void CustomPGE::openAssetPack()
+{
+    const std::string& sPackFilename = m_cvAssetPackFile.get();
+    if (sPackFilename.empty())
+    {
+        return;
+    }
+
+    if (m_cvAssetPackBuild.get() && !elte_fail::AssetPack::isUpToDate("gamedata", sPackFilename, isPackedAsset))
+    {
+        elte_fail::AssetPackBuildStats stats;
+        const auto timeStart = std::chrono::steady_clock::now();
+        if (elte_fail::AssetPack::build("gamedata", sPackFilename, isPackedAsset, stats))
+        {
+            getConsole().OLn("Asset pack: packed %u files (%u compressed), %u KB into %u KB in %d ms: %s",
+                stats.m_nFiles, stats.m_nCompressed, static_cast<uint32_t>(stats.m_nBytes / 1024), static_cast<uint32_t>(stats.m_nPackBytes / 1024),
+                static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - timeStart).count()),
+                sPackFilename.c_str());
+        }
+        else
+        {
+            getConsole().EOLn("CustomPGE::%s(): failed to build asset pack %s!", __func__, sPackFilename.c_str());
+        }
     }
-    getConsole().OO();
+
+    if (!m_assetPack.open(sPackFilename))
+    {
+        getConsole().EOLn("CustomPGE::%s(): failed to open asset pack %s, reading separate files!", __func__, sPackFilename.c_str());
+        return;
+    }
+
+    if (m_cvAssetPackVerify.get())
+    {
+        const uint32_t nCorrupt = m_assetPack.verify();
+        if (nCorrupt > 0)
+        {
+            getConsole().EOLn("CustomPGE::%s(): %u corrupt assets in %s, reading separate files!", __func__, nCorrupt, sPackFilename.c_str());
+            m_assetPack.close();
+            return;
+        }
+    }
+    getConsole().OLn("Asset pack: %u assets in %s", m_assetPack.getEntryCount(), sPackFilename.c_str());
 }
 
-bool CustomPGE::handleUserSetup(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const elte_fail::MsgUserSetupFromServer& msg)
+/**
+    Parses the given OBJ file from the asset pack if it is open and has it, otherwise from the file itself.
+*/
+bool CustomPGE::loadObj(elte_fail::ObjFile& obj, const char* szFilename) const
+{
+    std::vector<uint8_t> vBuffer;
+    elte_fail::AssetView view;
+    if (m_assetPack.read(szFilename, vBuffer, view))
+    {
+        return obj.parse(reinterpret_cast<const char*>(view.m_pData), view.m_nLength);
+    }
+    return obj.load(szFilename);
+}
+
+/**
+    Splits the arena into chunks if not yet done or if the arena model has changed since then, and starts streaming the chunks.
+    The whole arena is not loaded for rendering, however it is still needed for the collision world.
+
+    @return False if the arena should be loaded as a whole instead.
+*/
+bool CustomPGE::startArenaStreaming(const elte_fail::ObjFile& arenaObj)
+{
+    const std::string sIndexFilename = std::string(ARENA_CHUNKS_PREFIX) + elte_fail::ArenaChunker::getIndexFileExtension();
+    std::vector<elte_fail::ArenaChunkInfo> vChunks;
+    if (elte_fail::ArenaChunker::isIndexUpToDate(sIndexFilename, ARENA_FILENAME) &&
+        elte_fail::ArenaChunker::isIndexUpToDate(sIndexFilename, ARENA_LM_FILENAME) &&
+        elte_fail::ArenaChunker::loadIndex(sIndexFilename, vChunks))
+    {
+        getConsole().OLn("Arena chunks: %u chunks listed in %s", static_cast<uint32_t>(vChunks.size()), sIndexFilename.c_str());
+    }
+    else
+    {
+        elte_fail::ObjFile arenaLmObj;
+        const float fChunkSize = m_cvGfxArenaChunkSize.get();
+        if (!loadObj(arenaLmObj, ARENA_LM_FILENAME) ||
+            !elte_fail::ArenaChunker::split(
+                arenaObj, &arenaLmObj, fChunkSize, fArenaScaling, 0.f, fArenaPosY, fArenaPosZ, ARENA_CHUNKS_PREFIX, sIndexFilename, vChunks))
+        {
+            getConsole().EOLn("CustomPGE::%s(): failed to split arena with chunk size %f, loading it as a whole!", __func__, fChunkSize);
+            return false;
+        }
+        getConsole().OLn("Arena chunks: split into %u chunks of size %f, written to %s", static_cast<uint32_t>(vChunks.size()), fChunkSize, sIndexFilename.c_str());
+    }
+
+    m_vArenaChunkObjects.assign(vChunks.size(), nullptr);
+    const bool bRet = m_arenaStreamer.start(
+        vChunks,
+        static_cast<size_t>(m_cvGfxArenaStreamBudgetKb.get()) * 1024,
+        m_cvGfxArenaStreamRadius.get(),
+        m_cvGfxArenaStreamUnloadRadius.get(),
+        [this](uint32_t iChunk, const elte_fail::ArenaChunkInfo& chunk) { return loadArenaChunk(iChunk, chunk); },
+        [this](uint32_t iChunk, const elte_fail::ArenaChunkInfo&) { unloadArenaChunk(iChunk); });
+    if (!bRet)
+    {
+        getConsole().EOLn("CustomPGE::%s(): failed to start streaming, loading arena as a whole!", __func__);
+    }
+    return bRet;
+}
+
+/**
+    Invoked by m_arenaStreamer, at most once per frame, after the chunk files have been read by its I/O thread.
+*/
+bool CustomPGE::loadArenaChunk(uint32_t iChunk, const elte_fail::ArenaChunkInfo& chunk)
+{
+    PureObject3D* const chunkObj = getPure().getObject3DManager().createFromFile(chunk.m_sFilename.c_str());
+    if (!chunkObj)
+    {
+        getConsole().EOLn("CustomPGE::%s(): failed to load %s!", __func__, chunk.m_sFilename.c_str());
+        return false;
+    }
+    // chunk files have the same model space as the arena, so they are transformed the same way
+    chunkObj->SetScaling(fArenaScaling);
+    chunkObj->getPosVec().SetZ(fArenaPosZ);
+    chunkObj->getPosVec().SetY(fArenaPosY);
+
+    if (!chunk.m_sLightmapFilename.empty())
+    {
+        PureObject3D* const chunkLmObj = getPure().getObject3DManager().createFromFile(chunk.m_sLightmapFilename.c_str());
+        if (chunkLmObj)
+        {
+            chunkLmObj->Hide();
+            applyLightmap(*chunkObj, *chunkLmObj);
+            delete chunkLmObj;
+        }
+        else
+        {
+            getConsole().EOLn("CustomPGE::%s(): failed to load %s!", __func__, chunk.m_sLightmapFilename.c_str());
+        }
+    }
+
+    // lightmaps of chunks next to each other are often the same files, these are loaded only once this way
+    acquireMaterialTextures(*chunkObj);
+    elte_fail::VertexTransferPolicy::apply(*chunkObj, elte_fail::MeshUsage::Static);
+
+    // position of chunks is the origin of the arena, far from most of their geometry
+    m_frustumCuller.setBounds(*chunkObj, chunk.m_bounds);
+    if (m_bArenaHidden)
+    {
+        m_frustumCuller.setHidden(*chunkObj, true);
+    }
+
+    m_vArenaChunkObjects[iChunk] = chunkObj;
+    return true;
+}
+
+/**
+    Invoked by m_arenaStreamer when the chunk gets too far or its memory is needed for nearer chunks.
+*/
+void CustomPGE::unloadArenaChunk(uint32_t iChunk)
+{
+    PureObject3D* const chunkObj = m_vArenaChunkObjects[iChunk];
+    if (chunkObj)
+    {
+        m_frustumCuller.forget(*chunkObj);
+        deleteObjectAndReleaseTextures(chunkObj);
+        m_vArenaChunkObjects[iChunk] = nullptr;
+    }
+}
+
+/**
+    Adds a new player to the players list and allocates its resources.
+    Used by both server and clients, when processing MsgUserSetupFromServer or MsgWorldStateFromServer.
+    Doesn't write the players list to the log, caller should do that after adding all new players.
+*/
+bool CustomPGE::createPlayer(
+    pge_network::PgeNetworkConnectionHandle connHandleServerSide,
+    bool bCurrentClient,
+    elte_fail::TStringId nUserNameId,
+    elte_fail::TStringId nTrollfaceId,
+    elte_fail::TStringId nIpAddressId)
 {
-    if ((strnlen(msg.m_szUserName, elte_fail::MsgUserSetupFromServer::nUserNameBufferLength) > 0) && (m_mapPlayers.end() != m_mapPlayers.find(msg.m_szUserName)))
+    if (m_mapPlayers.end() != m_mapPlayers.find(connHandleServerSide))
     {
-        getConsole().EOLn("CustomPGE::%s(): cannot happen: user %s (connHandleServerSide: %u) is already present in players list!",
-            __func__, msg.m_szUserName, connHandleServerSide);
+        m_log.EOLn("CustomPGE::%s(): cannot happen: user %s (connHandleServerSide: %u) is already present in players list!",
+            __func__, m_strings.getString(nUserNameId).c_str(), connHandleServerSide);
         assert(false);
         return false;
     }
 
-    if (msg.m_bCurrentClient)
+    if (!m_strings.isDefined(nUserNameId) || !m_strings.isDefined(nTrollfaceId) || !m_strings.isDefined(nIpAddressId))
+    {
+        // server always sends the strings before referring to them
+        m_log.EOLn("CustomPGE::%s(): undefined string id(s) %u, %u, %u for connHandleServerSide: %u!",
+            __func__, nUserNameId, nTrollfaceId, nIpAddressId, connHandleServerSide);
+        assert(false);
+        return false;
+    }
+
+    const std::string& sUserName = m_strings.getString(nUserNameId);
+    const std::string& sTrollface = m_strings.getString(nTrollfaceId);
+    const std::string& sIpAddress = m_strings.getString(nIpAddressId);
+
+    if (bCurrentClient)
     {
-        getConsole().OLn("CustomPGE::%s(): this is me, my name is %s, connHandleServerSide: %u, my IP: %s",
-            __func__, msg.m_szUserName, connHandleServerSide, msg.m_szIpAddress);
+        m_log.OLn("CustomPGE::%s(): this is me, my name is %s, connHandleServerSide: %u, my IP: %s",
+            __func__, sUserName.c_str(), connHandleServerSide, sIpAddress.c_str());
         // store our username so we can refer to it anytime later
-        m_sUserName = msg.m_szUserName;
+        m_nUserNameId = nUserNameId;
+        m_connHandleServerSideMe = connHandleServerSide;
 
         if (getNetwork().isServer())
         {
-            getPure().getUImanager().textPermanentLegacy("Server, User name: " + m_sUserName, 10, 30);
+            m_localization.format(m_sUiText, elte_fail::TextId::UiServerUserName, { sUserName });
+            getPure().getUImanager().textPermanentLegacy(m_sUiText, 10, 30);
         }
         else
         {
-            getPure().getUImanager().textPermanentLegacy("Client, User name: " + m_sUserName + "; IP: " + msg.m_szIpAddress, 10, 30);
+            m_localization.format(m_sUiText, elte_fail::TextId::UiClientUserName, { sUserName, sIpAddress });
+            getPure().getUImanager().textPermanentLegacy(m_sUiText, 10, 30);
         }
     }
     else
     {
-        getConsole().OLn("CustomPGE::%s(): new user %s (connHandleServerSide: %u; IP: %s) connected",
-            __func__, msg.m_szUserName, connHandleServerSide, msg.m_szIpAddress);
+        m_log.OLn("CustomPGE::%s(): new user %s (connHandleServerSide: %u; IP: %s) connected",
+            __func__, sUserName.c_str(), connHandleServerSide, sIpAddress.c_str());
     }
 
-    // insert user into map using wacky syntax
-    m_mapPlayers[msg.m_szUserName];
-    m_mapPlayers[msg.m_szUserName].m_sTrollface = msg.m_szTrollfaceTex;
-    m_mapPlayers[msg.m_szUserName].m_connHandleServerSide = connHandleServerSide;
-    m_mapPlayers[msg.m_szUserName].m_sIpAddress = msg.m_szIpAddress;
+    Player_t& player = m_mapPlayers[connHandleServerSide];
+    player.m_connHandleServerSide = connHandleServerSide;
+    player.m_nUserNameId = nUserNameId;
+    player.m_nTrollfaceId = nTrollfaceId;
+    player.m_nIpAddressId = nIpAddressId;
+    player.m_hEntity = elte_fail::EntityStore::hInvalid;
+    player.m_nUserUpdateSeq = 0;
+    player.m_nLastFireUSecs = 0;
 
     PureObject3D* const plane = getPure().getObject3DManager().createPlane(0.5f, 0.5f);
     if (!plane)
     {
-        getConsole().EOLn("CustomPGE::%s(): failed to create object for user %s!", __func__, msg.m_szUserName);
+        m_log.EOLn("CustomPGE::%s(): failed to create object for user %s!", __func__, sUserName.c_str());
         return false;
     }
 
     plane->SetDoubleSided(true);
     plane->getPosVec().SetX(0);
-    plane->getPosVec().SetZ(2);
+    plane->getPosVec().SetZ(elte_fail::MatchRules::fPlayerPosZ);
 
-    if (!m_mapPlayers[msg.m_szUserName].m_sTrollface.empty())
+    if (!sTrollface.empty())
     {
-        PureTexture* const tex = getPure().getTextureManager().createFromFile(m_mapPlayers[msg.m_szUserName].m_sTrollface.c_str());
+        PureTexture* const tex = m_textureCache.acquire(getPure().getTextureManager(), sTrollface);
         if (tex)
         {
             plane->getMaterial().setTexture(tex);
         }
         else
         {
-            getConsole().EOLn("CustomPGE::%s(): failed to load trollface texture %s for user %s!",
-                __func__, m_mapPlayers[msg.m_szUserName].m_sTrollface.c_str(), msg.m_szUserName);
+            m_log.EOLn("CustomPGE::%s(): failed to load trollface texture %s for user %s!",
+                __func__, sTrollface.c_str(), sUserName.c_str());
         }
     }
     else
     {
-        getConsole().EOLn("CustomPGE::%s(): trollface texture name empty for user %s!",
-            __func__, msg.m_szUserName);
+        m_log.EOLn("CustomPGE::%s(): trollface texture name empty for user %s!",
+            __func__, sUserName.c_str());
     }
 
-    plane->setVertexModifyingHabit(PURE_VMOD_STATIC);
-    plane->setVertexReferencingMode(PURE_VREF_INDEXED);
+    elte_fail::VertexTransferPolicy::apply(*plane, elte_fail::MeshUsage::Static);
 
-    m_mapPlayers[msg.m_szUserName].m_pObject3D = plane;
+    player.m_hEntity = m_entities.create(*plane);
+    if (bCurrentClient)
+    {
+        m_hCameraTarget = player.m_hEntity;
+    }
 
-    getNetwork().WriteList();
-    WritePlayerList();
+    return true;
+}
+
+bool CustomPGE::handleUserSetup(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const elte_fail::MsgUserSetupFromServer& msg)
+{
+    if (!createPlayer(connHandleServerSide, msg.m_bCurrentClient, msg.m_nUserNameId, msg.m_nTrollfaceTexId, msg.m_nIpAddressId))
+    {
+        return false;
+    }
+
+    WriteListsOnJoinLeave();
 
     return true;
 }
@@ -658,169 +2661,223 @@ bool CustomPGE::handleUserConnected(pge_network::PgeNetworkConnectionHandle conn
 {
     if (!getNetwork().isServer())
     {
-        getConsole().EOLn("CustomPGE::%s(): client received MsgUserConnectedServerSelf, CANNOT HAPPEN!", __func__);
+        m_log.EOLn("CustomPGE::%s(): client received MsgUserConnectedServerSelf, CANNOT HAPPEN!", __func__);
         assert(false);
         return false;
     }
 
-    const char* szConnectedUserName = nullptr;
-    std::string sTrollface;
+    if (msg.m_bCurrentClient && !m_mapPlayers.empty())
+    {
+        // cannot happen
+        m_log.EOLn("CustomPGE::%s(): user (connHandleServerSide: %u) connected with bCurrentClient as true but it is not me, CANNOT HAPPEN!",
+            __func__, connHandleServerSide);
+        assert(false);
+        return false;
+    }
 
-    if (m_trollFaces.size() > 0)
+    if (!msg.m_bCurrentClient && m_mapPlayers.empty())
     {
-        sTrollface = *m_trollFaces.begin();
-        m_trollFaces.erase(m_trollFaces.begin());
+        // cannot happen because at least the user of the server should be in the map!
+        // this should happen only if we are dedicated server but currently only listen-server is supported!
+        m_log.EOLn("CustomPGE::%s(): non-server user (connHandleServerSide: %u) connected but map of players is still empty, CANNOT HAPPEN!",
+            __func__, connHandleServerSide);
+        assert(false);
+        return false;
     }
-    else
+
+    elte_fail::WorldStatePlayer player;
+    if (!m_matchRules.admit(connHandleServerSide, msg.m_szIpAddress, player))
     {
-        CConsole::getConsoleInstance("PgeGnsWrapper").EOLn("%s: SERVER No more trollfaces left for user with connHandle %u", __func__, connHandleServerSide);
+        if (msg.m_bCurrentClient)
+        {
+            // nothing else is interned before our own player, cannot run without it
+            return false;
+        }
+        // PGE cannot kick, the connection just doesn't get a player, and its packets are dropped until it disconnects
+        m_log.EOLn("CustomPGE::%s(): rejected user (connHandleServerSide: %u) connected from %s!", __func__, connHandleServerSide, msg.m_szIpAddress);
+        m_rejectedConnections.insert(connHandleServerSide);
+        return true;
     }
 
     if (msg.m_bCurrentClient)
     {
         // server is processing its own birth
-        if (m_mapPlayers.size() == 0)
-        {
-            char szNewUserName[elte_fail::MsgUserSetupFromServer::nUserNameBufferLength];
-            genUniqueUserName(szNewUserName);
-            getConsole().OLn("CustomPGE::%s(): first (local) user %s connected and I'm server, so this is me (connHandleServerSide: %u)",
-                __func__, szNewUserName, connHandleServerSide);
-
-            szConnectedUserName = szNewUserName;
+        m_log.OLn("CustomPGE::%s(): first (local) user %s connected and I'm server, so this is me (connHandleServerSide: %u)",
+            __func__, m_strings.getString(player.m_nUserNameId).c_str(), connHandleServerSide);
 
-            pge_network::PgePacket newPktSetup;
-            if (elte_fail::MsgUserSetupFromServer::initPkt(newPktSetup, connHandleServerSide, true, szConnectedUserName, sTrollface, msg.m_szIpAddress))
-            {
-                // server injects this msg to self so resources for player will be allocated
-                getNetwork().getServer().send(newPktSetup);
-            }
-            else
-            {
-                getConsole().EOLn("PRooFPSddPGE::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
-                assert(false);
-            }
-        }
-        else
+        pge_network::PgePacket newPktSetup;
+        if (!elte_fail::MsgUserSetupFromServer::initPkt(
+            newPktSetup, connHandleServerSide, true, player.m_nUserNameId, player.m_nTrollfaceId, player.m_nIpAddressId))
         {
-            // cannot happen
-            getConsole().EOLn("CustomPGE::%s(): user (connHandleServerSide: %u) connected with bCurrentClient as true but it is not me, CANNOT HAPPEN!", 
-               __func__, connHandleServerSide);
+            m_log.EOLn("CustomPGE::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
             assert(false);
             return false;
         }
+
+        // server injects this msg to self so resources for player will be allocated
+        sendPkt(newPktSetup);
+        return true;
     }
-    else
+
+    // server is processing another user's birth
+    m_log.OLn("CustomPGE::%s(): new remote user %s (connHandleServerSide: %u) connected (from %s) and I'm server",
+        __func__, m_strings.getString(player.m_nUserNameId).c_str(), connHandleServerSide, msg.m_szIpAddress);
+
+    pge_network::PgePacket newPktSetup;
+    if (!elte_fail::MsgUserSetupFromServer::initPkt(
+        newPktSetup, connHandleServerSide, false, player.m_nUserNameId, player.m_nTrollfaceId, player.m_nIpAddressId))
+    {
+        m_log.EOLn("CustomPGE::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
+        assert(false);
+        return false;
+    }
+
+    // server injects this msg to self so resources for player will be allocated
+    sendPkt(newPktSetup);
+
+    // other clients, the new client and its world state snapshot are handled the same way as in hosted matches,
+    // except that our own player is not sent anything since it is not remote
+    std::vector<elte_fail::WorldStatePlayer> vPlayers;
+    getWorldStatePlayers(vPlayers);
+    return m_matchRules.sendJoin(
+        player, vPlayers, m_connHandleServerSideMe,
+        [this](const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleRecipient) { sendPktToClient(pkt, connHandleRecipient); });
+}
+
+bool CustomPGE::handleWorldState(pge_network::PgeNetworkConnectionHandle, const elte_fail::MsgWorldStateFromServer& msg)
+{
+    if (getNetwork().isServer())
+    {
+        m_logNet.EOLn("CustomPGE::%s(): server received MsgWorldStateFromServer, CANNOT HAPPEN!", __func__);
+        assert(false);
+        return false;
+    }
+
+    switch (m_worldStateAssembler.addFragment(msg))
+    {
+    case elte_fail::WorldStateAssembler::Result::Incomplete:
+        return true;
+    case elte_fail::WorldStateAssembler::Result::Error:
+        m_logNet.EOLn("CustomPGE::%s(): invalid fragment %u/%u of snapshot %u!", __func__, msg.m_iFragment, msg.m_nFragmentCount, msg.m_nSnapshotId);
+        return false;
+    default: /* complete */
+        break;
+    }
+
+    std::vector<elte_fail::WorldStateStringDef> vStringDefs;
+    std::vector<elte_fail::WorldStatePlayer> vPlayers;
+    const std::vector<uint8_t>& vSnapshot = m_worldStateAssembler.getSnapshot();
+    if (!elte_fail::WorldState::deserialize(vSnapshot.data(), vSnapshot.size(), vStringDefs, vPlayers))
     {
-        // server is processing another user's birth
-        if (m_mapPlayers.empty())
+        m_logNet.EOLn("CustomPGE::%s(): failed to parse snapshot %u!", __func__, msg.m_nSnapshotId);
+        return false;
+    }
+
+    for (const auto& stringDef : vStringDefs)
+    {
+        if (!m_strings.define(stringDef.m_nStringId, stringDef.m_sString))
         {
-            // cannot happen because at least the user of the server should be in the map!
-            // this should happen only if we are dedicated server but currently only listen-server is supported!
-            getConsole().EOLn("CustomPGE::%s(): non-server user (connHandleServerSide: %u) connected but map of players is still empty, CANNOT HAPPEN!",
-                __func__, connHandleServerSide);
-            assert(false);
+            m_logNet.EOLn("CustomPGE::%s(): invalid definition of string id %u in snapshot %u!", __func__, stringDef.m_nStringId, msg.m_nSnapshotId);
             return false;
         }
+    }
 
-        char szNewUserName[elte_fail::MsgUserSetupFromServer::nUserNameBufferLength];
-        genUniqueUserName(szNewUserName);
-        szConnectedUserName = szNewUserName;
-        getConsole().OLn("CustomPGE::%s(): new remote user %s (connHandleServerSide: %u) connected (from %s) and I'm server",
-            __func__, szConnectedUserName, connHandleServerSide, msg.m_szIpAddress);
-
-        pge_network::PgePacket newPktSetup;
-        if (!elte_fail::MsgUserSetupFromServer::initPkt(newPktSetup, connHandleServerSide, false, szConnectedUserName, sTrollface, msg.m_szIpAddress))
+    for (const auto& player : vPlayers)
+    {
+        if (!createPlayer(player.m_connHandleServerSide, false, player.m_nUserNameId, player.m_nTrollfaceId, player.m_nIpAddressId))
         {
-            getConsole().EOLn("PRooFPSddPGE::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
-            assert(false);
             return false;
         }
 
-        // server injects this msg to self so resources for player will be allocated
-        getNetwork().getServer().send(newPktSetup);
-
-        // inform all other clients about this new user
-        getNetwork().getServer().sendToAllClientsExcept(newPktSetup, connHandleServerSide);
-
-        // now we send this msg to the client with this bool flag set so client will know it is their connect
-        elte_fail::MsgUserSetupFromServer& msgUserSetup = pge_network::PgePacket::getMsgAppDataFromPkt<elte_fail::MsgUserSetupFromServer>(newPktSetup);
-        msgUserSetup.m_bCurrentClient = true;
-        getNetwork().getServer().send(newPktSetup, connHandleServerSide);
-
-        // we also send as many MsgUserSetupFromServer pkts to the client as the number of already connected players,
-        // otherwise client won't know about them, so this way the client will detect them as newly connected users;
-        // we also send MsgUserUpdateFromServer about each player so new client will immediately have their positions updated.
-        pge_network::PgePacket newPktUserUpdate;
-        for (const auto& it : m_mapPlayers)
-        {
-            if (!elte_fail::MsgUserSetupFromServer::initPkt(
-                newPktSetup,
-                it.second.m_connHandleServerSide,
-                false,
-                it.first, it.second.m_sTrollface, it.second.m_sIpAddress))
-            {
-                getConsole().EOLn("PRooFPSddPGE::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
-                assert(false);
-                continue;
-            }
-            getNetwork().getServer().send(newPktSetup, connHandleServerSide);
-            
-            if (!elte_fail::MsgUserUpdateFromServer::initPkt(
-                newPktUserUpdate,
-                it.second.m_connHandleServerSide,
-                it.second.m_pObject3D->getPosVec().getX(), it.second.m_pObject3D->getPosVec().getY(), it.second.m_pObject3D->getPosVec().getZ()))
-            {
-                getConsole().EOLn("PRooFPSddPGE::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
-                assert(false);
-                continue;
-            }
-            getNetwork().getServer().send(newPktUserUpdate, connHandleServerSide);
-        }
+        PureObject3D* const obj = m_entities.getObject(m_mapPlayers[player.m_connHandleServerSide].m_hEntity);
+        obj->getPosVec().SetX(player.m_fPosX);
+        obj->getPosVec().SetY(player.m_fPosY);
     }
 
+    WriteListsOnJoinLeave();
+
     return true;
 }
 
-bool CustomPGE::handleUserDisconnected(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const pge_network::MsgUserDisconnectedFromServer&)
+bool CustomPGE::handleStringDef(pge_network::PgeNetworkConnectionHandle, const elte_fail::MsgStringDefFromServer& msg)
 {
-    auto it = m_mapPlayers.begin();
-    while (it != m_mapPlayers.end())
+    if (getNetwork().isServer())
     {
-        if (it->second.m_connHandleServerSide == connHandleServerSide)
-        {
-            break;
-        }
-        it++;
+        m_logNet.EOLn("CustomPGE::%s(): server received MsgStringDefFromServer, CANNOT HAPPEN!", __func__);
+        assert(false);
+        return false;
+    }
+
+    if (!m_strings.define(msg.m_nStringId, std::string(msg.m_szString, msg.m_nLength)))
+    {
+        m_logNet.EOLn("CustomPGE::%s(): invalid definition of string id %u!", __func__, msg.m_nStringId);
+        return false;
     }
 
+    return true;
+}
+
+bool CustomPGE::handleUserDisconnected(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const pge_network::MsgUserDisconnectedFromServer&)
+{
+    const auto it = m_mapPlayers.find(connHandleServerSide);
+
     if (m_mapPlayers.end() == it)
     {
-        getConsole().EOLn("CustomPGE::%s(): failed to find user with connHandleServerSide: %u!", __func__, connHandleServerSide);
+        if (!getNetwork().isServer())
+        {
+            // PGE informs all clients about every disconnect, including players of other matches hosted by the same server
+            m_log.DLn("CustomPGE::%s(): user with connHandleServerSide: %u is not in our match", __func__, connHandleServerSide);
+            return true;
+        }
+        m_log.EOLn("CustomPGE::%s(): failed to find user with connHandleServerSide: %u!", __func__, connHandleServerSide);
         assert(false); // in debug mode, try to understand this scenario
         return true; // in release mode, dont terminate
     }
 
-    const std::string& sClientUserName = it->first;
+    const std::string& sClientUserName = m_strings.getString(it->second.m_nUserNameId);
 
     if (getNetwork().isServer())
     {
-        getConsole().OLn("CustomPGE::%s(): user %s disconnected and I'm server", __func__, sClientUserName.c_str());
-        m_trollFaces.insert(it->second.m_sTrollface);  // re-insert the unneeded trollface texture into the set
+        m_log.OLn("CustomPGE::%s(): user %s disconnected and I'm server", __func__, sClientUserName.c_str());
     }
     else
     {
-        getConsole().OLn("CustomPGE::%s(): user %s disconnected and I'm client", __func__, sClientUserName.c_str());
+        m_log.OLn("CustomPGE::%s(): user %s disconnected and I'm client", __func__, sClientUserName.c_str());
+    }
+
+    // handle can be reused by a new connection, which starts its sequence numbers again
+    m_seqFilter.forget(connHandleServerSide);
+    m_netConditioner.forget(connHandleServerSide);
+    for (auto itLatest = m_mapLatestPkts.begin(); itLatest != m_mapLatestPkts.end(); )
+    {
+        if (itLatest->first.second == connHandleServerSide)
+        {
+            m_mapLatestPktsByVersion.erase(itLatest->second.m_nVersion);
+            itLatest = m_mapLatestPkts.erase(itLatest);
+        }
+        else
+        {
+            ++itLatest;
+        }
     }
+    m_mapClientSendStates.erase(connHandleServerSide);
 
-    if (it->second.m_pObject3D)
+    PureObject3D* const obj = m_entities.getObject(it->second.m_hEntity);
+    if (obj)
     {
-        delete it->second.m_pObject3D;  // yes, dtor will remove this from its Object3DManager too!
+        m_entities.destroy(it->second.m_hEntity);
+        m_frustumCuller.forget(*obj);
+        deleteObjectAndReleaseTextures(obj);
     }
 
+    if (getNetwork().isServer())
+    {
+        // strings of the player are not used after this, their ids can be reused
+        m_matchRules.release({ connHandleServerSide, it->second.m_nUserNameId, it->second.m_nTrollfaceId, it->second.m_nIpAddressId, 0.f, 0.f });
+    }
     m_mapPlayers.erase(it);
 
-    getNetwork().WriteList();
-    WritePlayerList();
+    WriteListsOnJoinLeave();
 
     return true;
 }
@@ -829,79 +2886,53 @@ bool CustomPGE::handleUserCmdMove(pge_network::PgeNetworkConnectionHandle connHa
 {
     if (!getNetwork().isServer())
     {
-        getConsole().EOLn("CustomPGE::%s(): client received MsgUserCmdMoveFromClient, CANNOT HAPPEN!", __func__);
+        m_log.EOLn("CustomPGE::%s(): client received MsgUserCmdMoveFromClient, CANNOT HAPPEN!", __func__);
         assert(false);
         return false;
     }
 
-    auto it = m_mapPlayers.begin();
-    while (it != m_mapPlayers.end())
-    {
-        if (it->second.m_connHandleServerSide == connHandleServerSide)
-        {
-            break;
-        }
-        it++;
-    }
+    const auto it = m_mapPlayers.find(connHandleServerSide);
     
     if (m_mapPlayers.end() == it)
     {
-        getConsole().EOLn("CustomPGE::%s(): failed to find user with connHandleServerSide: %u!", __func__, connHandleServerSide);
+        m_log.EOLn("CustomPGE::%s(): failed to find user with connHandleServerSide: %u!", __func__, connHandleServerSide);
         assert(false);  // in debug mode this terminates server
         return true;    // in release mode, we dont terminate the server, just silently ignore
     }
 
-    const std::string& sClientUserName = it->first;
+    const std::string& sClientUserName = m_strings.getString(it->second.m_nUserNameId);
 
-    PureObject3D* obj = it->second.m_pObject3D;
+    PureObject3D* obj = m_entities.getObject(it->second.m_hEntity);
     if (!obj)
     {
-        getConsole().EOLn("CustomPGE::%s(): user %s doesn't have associated Object3D!", __func__, sClientUserName.c_str());
+        m_log.EOLn("CustomPGE::%s(): user %s doesn't have associated Object3D!", __func__, sClientUserName.c_str());
         return false;
     }
 
-    if ((pktUserCmdMove.m_dirHorizontal == elte_fail::HorizontalDirection::NONE) &&
-        (pktUserCmdMove.m_dirVertical == elte_fail::VerticalDirection::NONE))
-    {
-        getConsole().EOLn("CustomPGE::%s(): user %s sent invalid cmdMove!", __func__, sClientUserName.c_str());
-        assert(false);  // in debug mode this terminates server
-        return false;   // in release mode, we dont terminate the server, just silently ignore
-        // TODO: I might disconnect this client!
-    }
+    // invalid cmdMove is already dropped by validatePkt()
+    // TODO: I might disconnect the client sending invalid cmdMove!
 
-    //getConsole().OLn("CustomPGE::%s(): user %s sent valid cmdMove", __func__, sClientUserName.c_str());
-    switch (pktUserCmdMove.m_dirHorizontal)
+    //m_log.OLn("CustomPGE::%s(): user %s sent valid cmdMove", __func__, sClientUserName.c_str());
+    float fPosX = obj->getPosVec().getX();
+    float fPosY = obj->getPosVec().getY();
+    if (!elte_fail::MatchRules::applyMove(m_collisionWorld, pktUserCmdMove.m_dirHorizontal, pktUserCmdMove.m_dirVertical, fPosX, fPosY))
     {
-    case elte_fail::HorizontalDirection::LEFT:
-        obj->getPosVec().SetX( obj->getPosVec().getX() - 0.01f );
-        break;
-    case elte_fail::HorizontalDirection::RIGHT:
-        obj->getPosVec().SetX(obj->getPosVec().getX() + 0.01f);
-        break;
-    default: /* no-op */
-        break;
+        // blocked by wall, no need to update anyone
+        return true;
     }
 
-    switch (pktUserCmdMove.m_dirVertical)
-    {
-    case elte_fail::VerticalDirection::DOWN:
-        obj->getPosVec().SetY(obj->getPosVec().getY() - 0.01f);
-        break;
-    case elte_fail::VerticalDirection::UP:
-        obj->getPosVec().SetY(obj->getPosVec().getY() + 0.01f);
-        break;
-    default: /* no-op */
-        break;
-    }
+    obj->getPosVec().SetX(fPosX);
+    obj->getPosVec().SetY(fPosY);
 
     pge_network::PgePacket pktOut;
-    if (elte_fail::MsgUserUpdateFromServer::initPkt(pktOut, connHandleServerSide, obj->getPosVec().getX(), obj->getPosVec().getY(), obj->getPosVec().getZ()))
+    if (elte_fail::MsgUserUpdateFromServer::initPkt(
+        pktOut, connHandleServerSide, ++it->second.m_nUserUpdateSeq, obj->getPosVec().getX(), obj->getPosVec().getY(), obj->getPosVec().getZ()))
     {
-        getNetwork().getServer().sendToAll(pktOut);
+        sendPktToAll(pktOut);
     }
     else
     {
-        getConsole().EOLn("PRooFPSddPGE::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
+        m_log.EOLn("CustomPGE::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
         return false;
     }
 
@@ -910,26 +2941,18 @@ bool CustomPGE::handleUserCmdMove(pge_network::PgeNetworkConnectionHandle connHa
 
 bool CustomPGE::handleUserUpdate(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const elte_fail::MsgUserUpdateFromServer& msg)
 {
-    auto it = m_mapPlayers.begin();
-    while (it != m_mapPlayers.end())
-    {
-        if (it->second.m_connHandleServerSide == connHandleServerSide)
-        {
-            break;
-        }
-        it++;
-    }
+    const auto it = m_mapPlayers.find(connHandleServerSide);
 
     if (m_mapPlayers.end() == it)
     {
-        getConsole().EOLn("CustomPGE::%s(): failed to find user with connHandleServerSide: %u!", __func__, connHandleServerSide);
+        m_log.EOLn("CustomPGE::%s(): failed to find user with connHandleServerSide: %u!", __func__, connHandleServerSide);
         return true;  // might NOT be fatal error in some circumstances, although I cannot think about any, but dont terminate the app for this ...
     }
 
-    PureObject3D* obj = it->second.m_pObject3D;
+    PureObject3D* obj = m_entities.getObject(it->second.m_hEntity);
     if (!obj)
     {
-        getConsole().EOLn("CustomPGE::%s(): user %s doesn't have associated Object3D!", __func__, it->first.c_str());
+        m_log.EOLn("CustomPGE::%s(): user %s doesn't have associated Object3D!", __func__, m_strings.getString(it->second.m_nUserNameId).c_str());
         return false;
     }
 
@@ -939,3 +2962,98 @@ bool CustomPGE::handleUserUpdate(pge_network::PgeNetworkConnectionHandle connHan
     return true;
 }
 
+bool CustomPGE::handleUserCmdFire(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const elte_fail::MsgUserCmdFireFromClient& msg)
+{
+    if (!getNetwork().isServer())
+    {
+        m_log.EOLn("CustomPGE::%s(): client received MsgUserCmdFireFromClient, CANNOT HAPPEN!", __func__);
+        assert(false);
+        return false;
+    }
+
+    const auto it = m_mapPlayers.find(connHandleServerSide);
+    if (m_mapPlayers.end() == it)
+    {
+        m_log.EOLn("CustomPGE::%s(): failed to find user with connHandleServerSide: %u!", __func__, connHandleServerSide);
+        assert(false);  // in debug mode this terminates server
+        return true;    // in release mode, we dont terminate the server, just silently ignore
+    }
+
+    PureObject3D* obj = m_entities.getObject(it->second.m_hEntity);
+    if (!obj)
+    {
+        m_log.EOLn("CustomPGE::%s(): user %s doesn't have associated Object3D!", __func__, m_strings.getString(it->second.m_nUserNameId).c_str());
+        return false;
+    }
+
+    // invalid cmdFire is already dropped by validatePkt()
+    elte_fail::ProjectileEvent event;
+    float fPosX = obj->getPosVec().getX();
+    float fPosY = obj->getPosVec().getY();
+    float fVelX;
+    float fVelY;
+    if (!m_matchRules.fire(msg, getNowUSecs(), it->second.m_nLastFireUSecs, event, fPosX, fPosY, fVelX, fVelY))
+    {
+        return true;
+    }
+
+    // if pool turns out to be full, sim thread despawns it
+    if (!m_projectileSim.push({ elte_fail::SimCommandType::Spawn, event.m_nId, connHandleServerSide, fPosX, fPosY, fVelX, fVelY }))
+    {
+        m_log.WLn("CustomPGE::%s(): projectile command queue is full!", __func__);
+        return true;
+    }
+    m_vProjectileEvents.push_back(event);
+
+    return true;
+}
+
+bool CustomPGE::handleProjectileEvents(pge_network::PgeNetworkConnectionHandle, const elte_fail::MsgProjectileEventsFromServer& msg)
+{
+    if (getNetwork().isServer())
+    {
+        m_log.EOLn("CustomPGE::%s(): server received MsgProjectileEventsFromServer, CANNOT HAPPEN!", __func__);
+        assert(false);
+        return false;
+    }
+
+    // invalid event count is already dropped by validatePkt()
+    for (uint8_t i = 0; i < msg.m_nEvents; i++)
+    {
+        const elte_fail::ProjectileEvent& event = msg.m_events[i];
+        if (event.m_type != elte_fail::ProjectileEventType::Spawn)
+        {
+            // might have already hit a wall on our side
+            if (!m_projectileSim.push({ elte_fail::SimCommandType::Despawn, event.m_nId, 0, 0.f, 0.f, 0.f, 0.f }))
+            {
+                m_logNet.EOLn("CustomPGE::%s(): projectile command queue is full!", __func__);
+            }
+            continue;
+        }
+
+        elte_fail::HorizontalDirection dirHorizontal;
+        elte_fail::VerticalDirection dirVertical;
+        if (!elte_fail::ProjectilePool::decodeDir(event.m_nDir, dirHorizontal, dirVertical))
+        {
+            m_logNet.EOLn("CustomPGE::%s(): invalid direction %u of projectile %u!", __func__, event.m_nDir, event.m_nId);
+            continue;
+        }
+        float fVelX;
+        float fVelY;
+        elte_fail::ProjectilePool::getVelocity(dirHorizontal, dirVertical, fVelX, fVelY);
+        if (!m_projectileSim.push({
+                elte_fail::SimCommandType::Spawn,
+                event.m_nId,
+                0,
+                elte_fail::ProjectileEvent::dequantizePos(event.m_nPosX),
+                elte_fail::ProjectileEvent::dequantizePos(event.m_nPosY),
+                fVelX,
+                fVelY }))
+        {
+            m_logNet.EOLn("CustomPGE::%s(): projectile command queue is full!", __func__);
+        }
+    }
+
+    return true;
+}
+
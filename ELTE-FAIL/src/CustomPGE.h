@@ -20,7 +20,35 @@
 #include "../../../PGE/PGE/Pure/include/external/Object3D/PureObject3DManager.h"
 
 #include "BaseConsts.h"    // Constants, macros.
+#include "ElteFailArenaChunker.h"
+#include "ElteFailAssetPack.h"
+#include "ElteFailAsyncLog.h"
+#include "ElteFailChunkStreamer.h"
+#include "ElteFailCollisionWorld.h"
+#include "ElteFailCVars.h"
+#include "ElteFailEntities.h"
+#include "ElteFailFrustumCuller.h"
+#include "ElteFailLanguage.h"
+#include "ElteFailLoopbackTransport.h"
+#include "ElteFailMatch.h"
+#include "ElteFailMatchRules.h"
+#include "ElteFailMeshOptimizer.h"
+#include "ElteFailMsgDispatcher.h"
+#include "ElteFailNetConditioner.h"
+#include "ElteFailNetCapture.h"
+#include "ElteFailNetStats.h"
+#include "ElteFailObjFile.h"
+#include "ElteFailOverlayText.h"
+#include "ElteFailPacketPipeline.h"
 #include "ElteFailPacket.h"
+#include "ElteFailProjectiles.h"
+#include "ElteFailSendRate.h"
+#include "ElteFailSequenceFilter.h"
+#include "ElteFailSimThread.h"
+#include "ElteFailStringTable.h"
+#include "ElteFailTextureCache.h"
+#include "ElteFailVertexTransfer.h"
+#include "ElteFailWorldState.h"
 
 
 struct Player_t
@@ -31,9 +59,30 @@ struct Player_t
                                                                            This is not the same handle as client have for the connection
                                                                            towards the server! Those connection handles are not related
                                                                            to each other! */
-    std::string m_sTrollface;
-    PureObject3D* m_pObject3D;
-    std::string m_sIpAddress;
+    elte_fail::TStringId m_nUserNameId;     /**< Id in the interned string table. */
+    elte_fail::TStringId m_nTrollfaceId;    /**< Id in the interned string table. */
+    elte_fail::EntityHandle m_hEntity;      /**< Invalid if creating the object failed. */
+    elte_fail::TStringId m_nIpAddressId;    /**< Id in the interned string table. */
+    uint16_t m_nUserUpdateSeq;              /**< Sequence number of the last MsgUserUpdateFromServer about this player. Used by server only. */
+    uint64_t m_nLastFireUSecs;              /**< When this player last fired a projectile, for limiting fire rate. Used by server only. */
+};
+
+/** Latest-wins message type and the connection the message is about. */
+using TLatestPktKey = std::pair<pge_network::MsgApp::TMsgId, pge_network::PgeNetworkConnectionHandle>;
+
+/** Latest-wins message queued by the server, kept until its connection disconnects. */
+struct LatestPkt_t
+{
+    pge_network::PgePacket m_pkt;
+    uint64_t m_nVersion;                    /**< Increasing with every message queued, of any type and connection. */
+};
+
+/** Server-side sending state of 1 remote client of our match. */
+struct ClientSendState_t
+{
+    elte_fail::SendRateController m_rate;
+    uint64_t m_nVersionSentOwn;             /**< Latest-wins messages about this client's own player are sent up to this version. */
+    uint64_t m_nVersionSentOthers;          /**< Latest-wins messages about other players are sent up to this version, never above m_nVersionSentOwn. */
 };
 
 
@@ -52,13 +101,16 @@ public:
 
     CConsole& getConsole() const;
     static const char* getLoggerModuleName();
+    static const char* getNetLoggerModuleName();  /**< Async log module of network message handling. */
    
 protected:
 
-    CustomPGE()
+    CustomPGE() :
+        CustomPGE(ELTEFAIL_NAME)
     {}
 
-    CustomPGE(const CustomPGE&)
+    CustomPGE(const CustomPGE&) :
+        CustomPGE(ELTEFAIL_NAME)
     {}
 
     CustomPGE& operator=(const CustomPGE&)
@@ -77,21 +129,172 @@ protected:
     virtual void onGameDestroying() override;    /**< Freeing up game content here. */
 
 private:
-    PureObject3D* m_box1;
-    PureObject3D* m_box2;
-    std::string m_sUserName;   /**< User name received from server in PgePktUserConnected (server instance also receives this from itself). */
-    std::map<std::string, Player_t> m_mapPlayers;  /**< Connected players. Used by both server and clients. Key is user name. */
-    // TODO: originally username was planned to be the key for above map, however if we see that we can always use connHandleServerSide to
-    // find proper player, then let's change the key to that instead of user name!
-    std::set<std::string> m_trollFaces;              /**< Trollface texture file names. Used by server only. */
+    elte_fail::EntityStore m_entities;    /**< Objects of the scene and players, except arena chunks and projectiles having their own arrays. */
+    elte_fail::EntityHandle m_hCameraTarget;  /**< Object of our own player, followed by camera while locked. */
+    elte_fail::TStringId m_nUserNameId;   /**< Id of user name received from server in MsgUserSetupFromServer (server instance also receives this from itself).
+                                               nInvalidStringId until then. */
+    pge_network::PgeNetworkConnectionHandle m_connHandleServerSideMe;  /**< Key of our own player in m_mapPlayers, valid only if m_nUserNameId is valid. */
+    std::map<pge_network::PgeNetworkConnectionHandle, Player_t> m_mapPlayers;  /**< Connected players. Used by both server and clients. Key is connHandleServerSide. */
+    elte_fail::StringTable m_strings;                /**< Interned strings. Server assigns the ids, clients receive the strings from server. */
+    elte_fail::MatchRules m_matchRules;              /**< Rules of our match, same as of hosted matches. Used by server only. */
+    std::set<pge_network::PgeNetworkConnectionHandle>
+        m_rejectedConnections;                       /**< Connected but not admitted to our match, ignored until they disconnect. Used by server only. */
+    elte_fail::WorldStateAssembler m_worldStateAssembler;  /**< Collects fragments of MsgWorldStateFromServer. Used by clients only. */
+    elte_fail::NetCaptureWriter m_netCapture;        /**< Records received and sent packets if net_capture_file is set. */
+    bool m_bReplaying;                               /**< True in replay mode (net_replay_file is set): packets are not sent, only counted. */
+    uint32_t m_nReplayMsgsSent;                      /**< Messages that would have been sent during replay, per recipient. */
+    elte_fail::CollisionWorld m_collisionWorld;      /**< Built from the arena, player movement is clamped against it by server, projectiles hit it on both sides. */
+    elte_fail::FrustumCuller m_frustumCuller;        /**< Decides which objects are rendered, objects must be hidden through this instead of directly. */
+    elte_fail::LoopbackTransport m_loopback;         /**< Packets injected by server to itself, drained at the beginning of every frame. Used by server only. */
+    elte_fail::ChunkStreamer m_arenaStreamer;        /**< Keeps arena chunks around the camera target loaded, started only if gfx_arena_streaming is set. */
+    std::vector<PureObject3D*> m_vArenaChunkObjects; /**< Indexed by chunk, nullptr if chunk is not loaded. */
+    bool m_bArenaHidden;                             /**< Arena toggled hidden by the user, applied also to chunks loaded later. */
+    elte_fail::VertexTransferBenchmark m_vtBenchmark;  /**< Run in the first frames if bench_vt_frames is set. */
+    elte_fail::TextureCache m_textureCache;          /**< Textures must be acquired from here and released when their object is deleted. */
+    elte_fail::OverlayText m_overlay;                /**< Stats lines drawn over the scene, PURE rebuilds a line only when its text changes. */
+    elte_fail::OverlayTextBenchmark m_overlayBenchmark;  /**< Run after m_vtBenchmark if bench_overlay_frames is set. */
+    elte_fail::MatchHost m_matches;                  /**< Matches hosted besides ours, started only if sv_matches is set. Used by server only. */
+    elte_fail::Localization m_localization;          /**< All language files of gamedata/language, selected by cl_language. */
+    elte_fail::AssetPack m_assetPack;                /**< Pack of the models of gamedata given by asset_pack_file, read by loadObj() instead of separate files if open. */
+    std::string m_sUiText;                           /**< Reused for formatting UI text every frame, so its capacity is allocated only once. */
+    elte_fail::CVarRegistry m_cvars;                 /**< Resolved at the beginning of onGameInitialized(), CVars must be read through the handles below. */
+    std::chrono::steady_clock::time_point m_timeLastProfileCheck;
+    elte_fail::CVar<std::string>& m_cvClServerIp;
+    elte_fail::CVar<std::string>& m_cvClLanguage;
+    elte_fail::CVar<std::string>& m_cvNetStatsDumpFile;
+    elte_fail::CVar<int>& m_cvNetStatsDumpIntervalSecs;
+    elte_fail::CVar<std::string>& m_cvNetCaptureFile;
+    elte_fail::CVar<std::string>& m_cvNetReplayFile;
+    elte_fail::CVar<bool>& m_cvNetDecodeThread;
+    elte_fail::CVar<int>& m_cvNetCondLatencyMs;
+    elte_fail::CVar<int>& m_cvNetCondJitterMs;
+    elte_fail::CVar<float>& m_cvNetCondLossPercent;
+    elte_fail::CVar<float>& m_cvNetCondDuplicatePercent;
+    elte_fail::CVar<float>& m_cvNetCondReorderPercent;
+    elte_fail::CVar<int>& m_cvNetCondSeed;
+    elte_fail::CVar<std::string>& m_cvLogAsyncFile;
+    elte_fail::CVar<std::string>& m_cvLogLevels;
+    elte_fail::CVar<int>& m_cvLogRateLimitPerSec;
+    elte_fail::CVar<int>& m_cvBenchCollisionPlayers;
+    elte_fail::CVar<int>& m_cvBenchVtFrames;
+    elte_fail::CVar<int>& m_cvBenchOverlayFrames;
+    elte_fail::CVar<int>& m_cvBenchNetCondSecs;
+    elte_fail::CVar<int>& m_cvBenchProjectiles;
+    elte_fail::CVar<bool>& m_cvGfxArenaStreaming;
+    elte_fail::CVar<float>& m_cvGfxArenaChunkSize;
+    elte_fail::CVar<float>& m_cvGfxArenaStreamRadius;
+    elte_fail::CVar<float>& m_cvGfxArenaStreamUnloadRadius;
+    elte_fail::CVar<int>& m_cvGfxArenaStreamBudgetKb;
+    elte_fail::CVar<bool>& m_cvGfxMeshOptimize;
+    elte_fail::CVar<int>& m_cvGfxTextureCacheBudgetKb;
+    elte_fail::CVar<bool>& m_cvGfxVsync;
+    elte_fail::CVar<std::string>& m_cvAssetPackFile;
+    elte_fail::CVar<bool>& m_cvAssetPackBuild;
+    elte_fail::CVar<bool>& m_cvAssetPackVerify;
+    elte_fail::CVar<int>& m_cvSvMatches;
+    elte_fail::CVar<int>& m_cvSvMatchMaxPlayers;
+    elte_fail::CVar<int>& m_cvSvMatchThreads;
+    elte_fail::CVar<float>& m_cvSvSendRateMin;
+    elte_fail::CVar<float>& m_cvSvSendRateMax;
+    elte_fail::CVar<int>& m_cvSvSendRateMaxQueueMs;
+    elte_fail::CVar<float>& m_cvSvSendRateMinQuality;
+    elte_fail::CVar<int>& m_cvSvProjectilesMax;
 
     // ---------------------------------------------------------------------------
 
-    void genUniqueUserName(char szNewUserName[elte_fail::MsgUserSetupFromServer::nUserNameBufferLength]) const;
     void WritePlayerList();
+    void WriteListsOnJoinLeave();
+    void WriteNetStats() const;
+    void onPktSent(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide, uint32_t nRecipients);
+    bool validatePkt(const pge_network::PgePacket& pkt);
+    bool applyPkt(const pge_network::PgePacket& pkt);
+    bool routePktToMatch(const pge_network::PgePacket& pkt);
+    void sendPktToSelf(const pge_network::PgePacket& pkt);
+    void sendPkt(const pge_network::PgePacket& pkt);
+    void sendPktToClient(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide);
+    void sendPktToAll(const pge_network::PgePacket& pkt);
+    void sendPktToAllClientsExcept(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide);
+    void sendPktToOurClientsExcept(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide);
+    void transmitPkt(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide);
+    void transmitPktNow(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide);
+    void applyNetConditions();
+    void flushLatestPkts();
+    void updateClientSendRates(uint64_t nNowUSecs);
+    elte_fail::SendRateConfig getSendRateConfig() const;
+    void getWorldStatePlayers(std::vector<elte_fail::WorldStatePlayer>& vPlayers) const;
+    void serializeFinalState(std::vector<uint8_t>& vSnapshot) const;
+    bool runNetReplay(const std::string& sFilename);
+    bool verifyReplayFinalState(const std::vector<uint8_t>& vFinalState) const;
+    void runCollisionBenchmark(uint32_t nPlayers) const;
+    void runNetConditionerBenchmark(uint32_t nSecs) const;
+    void runProjectileBenchmark(uint32_t nProjectiles) const;
+    void syncProjectileSim();
+    void flushProjectileEvents();
+    void updateProjectileObjects();
+    bool applyLightmap(PureObject3D& obj, PureObject3D& objLightmap);
+    void acquireMaterialTextures(PureObject3D& obj);
+    void deleteObjectAndReleaseTextures(PureObject3D* obj);
+    void optimizeModel(const std::string& sName, std::string& sFilename, std::string& sLightmapFilename);
+    void applyVertexTransferPolicy(PureObject3D& obj, const std::string& sName, elte_fail::MeshUsage usage);
+    void WriteVertexTransferBenchmark() const;
+    void WriteOverlayTextBenchmark() const;
+    void openAssetPack();
+    bool loadObj(elte_fail::ObjFile& obj, const char* szFilename) const;
+    bool startArenaStreaming(const elte_fail::ObjFile& arenaObj);
+    bool loadArenaChunk(uint32_t iChunk, const elte_fail::ArenaChunkInfo& chunk);
+    void unloadArenaChunk(uint32_t iChunk);
+    bool createPlayer(
+        pge_network::PgeNetworkConnectionHandle connHandleServerSide,
+        bool bCurrentClient,
+        elte_fail::TStringId nUserNameId,
+        elte_fail::TStringId nTrollfaceId,
+        elte_fail::TStringId nIpAddressId);
     bool handleUserSetup(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const elte_fail::MsgUserSetupFromServer& msg);
     bool handleUserConnected(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const pge_network::MsgUserConnectedServerSelf& msg);
     bool handleUserDisconnected(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const pge_network::MsgUserDisconnectedFromServer& msg);
     bool handleUserCmdMove(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const elte_fail::MsgUserCmdMoveFromClient& msg);
     bool handleUserUpdate(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const elte_fail::MsgUserUpdateFromServer& msg);
+    bool handleWorldState(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const elte_fail::MsgWorldStateFromServer& msg);
+    bool handleStringDef(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const elte_fail::MsgStringDefFromServer& msg);
+    bool handleUserCmdFire(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const elte_fail::MsgUserCmdFireFromClient& msg);
+    bool handleProjectileEvents(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const elte_fail::MsgProjectileEventsFromServer& msg);
+
+    /** App message handlers, order does not matter, the table is indexed by ElteFailMsgId at compile-time. */
+    using TMsgAppDispatcher = elte_fail::MsgAppDispatcher<
+        CustomPGE,
+        &CustomPGE::handleUserSetup,
+        &CustomPGE::handleUserCmdMove,
+        &CustomPGE::handleUserUpdate,
+        &CustomPGE::handleWorldState,
+        &CustomPGE::handleStringDef,
+        &CustomPGE::handleUserCmdFire,
+        &CustomPGE::handleProjectileEvents>;
+
+    TMsgAppDispatcher m_msgAppDispatcher;  /**< Used by both server and clients to invoke the handler of received app messages. */
+    elte_fail::NetStats m_netStats;        /**< Per-message-type traffic stats. Used by both server and clients. */
+    elte_fail::NetConditioner m_netConditioner;  /**< Simulates bad network on our sending side if any net_cond_* CVar is set. Used by both server and clients. */
+    elte_fail::SequenceFilter m_seqFilter; /**< Drops received latest-wins messages older than already handled ones. Used by both server and clients. */
+    std::map<TLatestPktKey, LatestPkt_t>
+        m_mapLatestPkts;                   /**< Latest-wins messages to be sent to all by flushLatestPkts(), per message type and connection. Used by server only. */
+    std::map<uint64_t, std::map<TLatestPktKey, LatestPkt_t>::iterator>
+        m_mapLatestPktsByVersion;          /**< Entries of m_mapLatestPkts by their current version, so messages newer than a version are found without scanning all. */
+    uint64_t m_nLatestPktsVersion;         /**< Version of the last message queued into m_mapLatestPkts. */
+    uint64_t m_nLatestPktsVersionFlushed;  /**< Messages up to this version are already injected to own queue. */
+    uint64_t m_nLatestPktsSuperseded;      /**< Latest-wins messages replaced in m_mapLatestPkts by a newer one before being sent. */
+    std::map<pge_network::PgeNetworkConnectionHandle, ClientSendState_t>
+        m_mapClientSendStates;             /**< Send rate and latest-wins messages sent, per remote client of our match. Used by server only. */
+    uint64_t m_nLastSendRateUpdateUSecs;   /**< Connection metrics are sampled for the send rates not in every frame. */
+    uint16_t m_nUserCmdMoveSeq;            /**< Sequence number of the last sent MsgUserCmdMoveFromClient. */
+    elte_fail::HorizontalDirection m_dirLastHorizontal;  /**< Of the last move, projectiles are fired in this direction when not moving. */
+    elte_fail::VerticalDirection m_dirLastVertical;
+    uint64_t m_nLastFireUSecs;             /**< When we last sent MsgUserCmdFireFromClient. */
+    elte_fail::SimThread m_projectileSim;  /**< Projectiles simulated by server and clients on its own thread in fixed steps, hits are decided by server. */
+    std::vector<elte_fail::ProjectileEvent> m_vProjectileEvents;    /**< To be sent to clients by flushProjectileEvents(). Used by server only. */
+    std::vector<PureObject3D*> m_vProjectileObjects;  /**< Clones of the projectile model, the first ones are placed at the active projectiles. */
+    uint32_t m_nProjectileObjectsShown;
+    elte_fail::AsyncLog m_asyncLog;        /**< Non-blocking log for packet handlers and gameplay, must be declared before its loggers. */
+    elte_fail::AsyncLogger m_log;          /**< Async log module getLoggerModuleName(): gameplay, players. */
+    elte_fail::AsyncLogger m_logNet;       /**< Async log module getNetLoggerModuleName(): network message handling. */
+    elte_fail::PacketPipeline m_pktPipeline;  /**< Decodes and validates received packets on separate thread if net_decode_thread is set.
+                                                   Declared after loggers because decode thread logs. */
 }; // class CustomPGE
\ No newline at end of file
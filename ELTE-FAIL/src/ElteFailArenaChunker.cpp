@@ -0,0 +1,245 @@
+/*
+    ###################################################################################
+    ElteFailArenaChunker.cpp
+    Offline splitting of arena geometry into spatial chunks for streaming.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailArenaChunker.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <utility>
+
+#include "ElteFailFileUtils.h"
+#include "ElteFailObjFile.h"
+
+static const char* const szIndexHeader = "# ELTE-FAIL arena chunk index v1";
+static const size_t nMaxLineLength = 1024;
+static const size_t nEstimatedBytesPerCorner = 40;   /**< Position, normal, texcoord, lightmap texcoord, index. */
+
+/**
+    Triangles of a chunk within 1 group of the source model.
+*/
+struct ChunkGroup
+{
+    size_t m_iGroup;
+    std::vector<size_t> m_vTriangles;   /**< Index of first corner of each triangle in the group. */
+};
+
+struct Chunk
+{
+    std::vector<ChunkGroup> m_vGroups;
+    elte_fail::Aabb m_bounds;
+    uint32_t m_nTriangles;
+};
+
+/**
+    Writes the given triangles of the model, keeping the groups of the model in the same order.
+*/
+static bool writeChunkObj(const elte_fail::ObjFile& obj, const Chunk& chunk, const std::string& sFilename)
+{
+    std::vector<elte_fail::ObjGroup> vGroups;
+    vGroups.reserve(chunk.m_vGroups.size());
+    for (const auto& chunkGroup : chunk.m_vGroups)
+    {
+        const elte_fail::ObjGroup& group = obj.getGroups()[chunkGroup.m_iGroup];
+        vGroups.push_back({ group.m_sName, {} });
+        vGroups.back().m_vCorners.reserve(chunkGroup.m_vTriangles.size() * 3);
+        for (const auto iFirstCorner : chunkGroup.m_vTriangles)
+        {
+            vGroups.back().m_vCorners.insert(
+                vGroups.back().m_vCorners.end(), group.m_vCorners.begin() + iFirstCorner, group.m_vCorners.begin() + iFirstCorner + 3);
+        }
+    }
+
+    // vertex arrays are copied as they are, only vertices used by the chunk are written
+    elte_fail::ObjFile objChunk;
+    objChunk.assign(obj.getPositions(), obj.getTexCoords(), obj.getNormals(), std::move(vGroups));
+    return objChunk.save(sFilename, "ELTE-FAIL arena chunk, generated from the arena model, do not edit");
+}
+
+// ############################### PUBLIC ################################
+
+
+size_t elte_fail::ArenaChunkInfo::getEstimatedBytes() const
+{
+    return static_cast<size_t>(m_nTriangles) * 3 * nEstimatedBytesPerCorner;
+} // getEstimatedBytes()
+
+
+const char* elte_fail::ArenaChunker::getIndexFileExtension()
+{
+    return ".chunks";
+} // getIndexFileExtension()
+
+
+bool elte_fail::ArenaChunker::isIndexUpToDate(const std::string& sIndexFilename, const std::string& sSourceFilename)
+{
+    return FileUtils::isUpToDate(sIndexFilename, sSourceFilename);
+} // isIndexUpToDate()
+
+
+bool elte_fail::ArenaChunker::split(
+    const ObjFile& obj,
+    const ObjFile* pObjLightmap,
+    float fChunkSize,
+    float fScaling, float fPosX, float fPosY, float fPosZ,
+    const std::string& sOutPrefix,
+    const std::string& sIndexFilename,
+    std::vector<ArenaChunkInfo>& vChunks)
+{
+    vChunks.clear();
+    if ((fChunkSize <= 0.f) || (pObjLightmap && !obj.hasSameFaces(*pObjLightmap)))
+    {
+        return false;
+    }
+
+    // ordered by cell, so chunk files and index are always generated in the same order
+    std::map<std::pair<int32_t, int32_t>, Chunk> cells;
+    for (size_t iGroup = 0; iGroup < obj.getGroups().size(); iGroup++)
+    {
+        const ObjGroup& group = obj.getGroups()[iGroup];
+        for (size_t i = 0; i + 2 < group.m_vCorners.size(); i += 3)
+        {
+            Aabb triBounds = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+            for (size_t j = i; j < i + 3; j++)
+            {
+                const ObjVertex& v = obj.getPositions()[group.m_vCorners[j].m_iPosition];
+                const float fWorld[3] = { v.m_fX * fScaling + fPosX, v.m_fY * fScaling + fPosY, v.m_fZ * fScaling + fPosZ };
+                for (int k = 0; k < 3; k++)
+                {
+                    triBounds.m_fMin[k] = std::min(triBounds.m_fMin[k], fWorld[k]);
+                    triBounds.m_fMax[k] = std::max(triBounds.m_fMax[k], fWorld[k]);
+                }
+            }
+
+            const float fCenterX = (triBounds.m_fMin[0] + triBounds.m_fMax[0]) / 2.f;
+            const float fCenterY = (triBounds.m_fMin[1] + triBounds.m_fMax[1]) / 2.f;
+            const auto cell = std::make_pair(
+                static_cast<int32_t>(std::floor(fCenterX / fChunkSize)),
+                static_cast<int32_t>(std::floor(fCenterY / fChunkSize)));
+
+            auto it = cells.find(cell);
+            if (it == cells.end())
+            {
+                it = cells.emplace(cell, Chunk{ {}, triBounds, 0 }).first;
+            }
+            Chunk& chunk = it->second;
+            if (chunk.m_vGroups.empty() || (chunk.m_vGroups.back().m_iGroup != iGroup))
+            {
+                chunk.m_vGroups.push_back({ iGroup, {} });
+            }
+            chunk.m_vGroups.back().m_vTriangles.push_back(i);
+            chunk.m_nTriangles++;
+            for (int k = 0; k < 3; k++)
+            {
+                chunk.m_bounds.m_fMin[k] = std::min(chunk.m_bounds.m_fMin[k], triBounds.m_fMin[k]);
+                chunk.m_bounds.m_fMax[k] = std::max(chunk.m_bounds.m_fMax[k], triBounds.m_fMax[k]);
+            }
+        }
+    }
+
+    for (const auto& cell : cells)
+    {
+        ArenaChunkInfo info;
+        info.m_nCellX = cell.first.first;
+        info.m_nCellY = cell.first.second;
+        info.m_bounds = cell.second.m_bounds;
+        info.m_nTriangles = cell.second.m_nTriangles;
+        info.m_sFilename = sOutPrefix + "_" + std::to_string(info.m_nCellX) + "_" + std::to_string(info.m_nCellY) + ".obj";
+        if (!writeChunkObj(obj, cell.second, info.m_sFilename))
+        {
+            vChunks.clear();
+            return false;
+        }
+        if (pObjLightmap)
+        {
+            info.m_sLightmapFilename = sOutPrefix + "_" + std::to_string(info.m_nCellX) + "_" + std::to_string(info.m_nCellY) + "_lm.obj";
+            if (!writeChunkObj(*pObjLightmap, cell.second, info.m_sLightmapFilename))
+            {
+                vChunks.clear();
+                return false;
+            }
+        }
+        vChunks.push_back(info);
+    }
+
+    // index is written last, so an interrupted split is redone next time
+    FILE* f = nullptr;
+    if ((fopen_s(&f, sIndexFilename.c_str(), "wt") != 0) || !f)
+    {
+        vChunks.clear();
+        return false;
+    }
+    fprintf(f, "%s\n", szIndexHeader);
+    fprintf(f, "# chunk cellX cellY minX minY minZ maxX maxY maxZ triangles file lightmapFile\n");
+    for (const auto& info : vChunks)
+    {
+        fprintf(f, "chunk %d %d %.9g %.9g %.9g %.9g %.9g %.9g %u %s %s\n",
+            info.m_nCellX, info.m_nCellY,
+            info.m_bounds.m_fMin[0], info.m_bounds.m_fMin[1], info.m_bounds.m_fMin[2],
+            info.m_bounds.m_fMax[0], info.m_bounds.m_fMax[1], info.m_bounds.m_fMax[2],
+            info.m_nTriangles,
+            info.m_sFilename.c_str(),
+            info.m_sLightmapFilename.empty() ? "-" : info.m_sLightmapFilename.c_str());
+    }
+    const bool bRet = (ferror(f) == 0);
+    fclose(f);
+    if (!bRet)
+    {
+        vChunks.clear();
+    }
+    return bRet;
+} // split()
+
+
+bool elte_fail::ArenaChunker::loadIndex(const std::string& sIndexFilename, std::vector<ArenaChunkInfo>& vChunks)
+{
+    vChunks.clear();
+
+    FILE* f = nullptr;
+    if ((fopen_s(&f, sIndexFilename.c_str(), "rt") != 0) || !f)
+    {
+        return false;
+    }
+
+    char szLine[nMaxLineLength];
+    bool bRet = (fgets(szLine, sizeof(szLine), f) != nullptr) && (strncmp(szLine, szIndexHeader, strlen(szIndexHeader)) == 0);
+    while (bRet && fgets(szLine, sizeof(szLine), f))
+    {
+        if (strncmp(szLine, "chunk ", 6) != 0)
+        {
+            continue;
+        }
+
+        ArenaChunkInfo info;
+        char szFilename[nMaxLineLength];
+        char szLightmapFilename[nMaxLineLength];
+        bRet = sscanf_s(szLine, "chunk %d %d %f %f %f %f %f %f %u %s %s",
+            &info.m_nCellX, &info.m_nCellY,
+            &info.m_bounds.m_fMin[0], &info.m_bounds.m_fMin[1], &info.m_bounds.m_fMin[2],
+            &info.m_bounds.m_fMax[0], &info.m_bounds.m_fMax[1], &info.m_bounds.m_fMax[2],
+            &info.m_nTriangles,
+            szFilename, static_cast<unsigned>(sizeof(szFilename)),
+            szLightmapFilename, static_cast<unsigned>(sizeof(szLightmapFilename))) == 11;
+        if (bRet)
+        {
+            info.m_sFilename = szFilename;
+            info.m_sLightmapFilename = (strcmp(szLightmapFilename, "-") == 0) ? "" : szLightmapFilename;
+            vChunks.push_back(info);
+        }
+    }
+
+    fclose(f);
+    if (!bRet)
+    {
+        vChunks.clear();
+    }
+    return bRet;
+} // loadIndex()
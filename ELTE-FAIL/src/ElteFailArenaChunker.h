@@ -0,0 +1,82 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailArenaChunker.h
+    Offline splitting of arena geometry into spatial chunks for streaming.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ElteFailCollisionWorld.h"
+
+namespace elte_fail
+{
+
+    class ObjFile;
+
+    /**
+        1 chunk of the arena: a cell of a regular grid in the XY plane of the world, in which players move.
+    */
+    struct ArenaChunkInfo
+    {
+        int32_t m_nCellX;
+        int32_t m_nCellY;
+        Aabb m_bounds;                       /**< World-space bounds of the geometry of the chunk. */
+        uint32_t m_nTriangles;
+        std::string m_sFilename;             /**< OBJ with model-space geometry, to be transformed the same way as the whole arena. */
+        std::string m_sLightmapFilename;     /**< OBJ with the same subobjects as m_sFilename but with lightmap materials, empty if none. */
+
+        /**
+            Rough memory cost of the chunk geometry when loaded, used for the streaming budget.
+            Textures are shared by chunks, so they are not counted.
+        */
+        size_t getEstimatedBytes() const;
+    };
+
+    /**
+        Splits the arena model (and optionally its lightmap model) into chunk OBJ files and writes an index file listing them.
+        Every triangle goes into the chunk containing its center. Chunk files keep the groups of the source in the same order,
+        only with the triangles of the chunk, so subobjects of a chunk and its lightmap chunk still correspond to each other.
+        Splitting is done once, then the index and the chunk files are reused until the source model changes.
+    */
+    class ArenaChunker
+    {
+    public:
+        static const char* getIndexFileExtension();
+
+        /**
+            @return True if the index file exists and is newer than the given source model.
+        */
+        static bool isIndexUpToDate(const std::string& sIndexFilename, const std::string& sSourceFilename);
+
+        /**
+            @param obj               Arena model.
+            @param pObjLightmap      Lightmap model with the same faces as obj, or nullptr.
+            @param fChunkSize        Edge length of a grid cell, in world units.
+            @param fScaling, fPosX, fPosY, fPosZ  Transformation of the rendered arena, to calculate world-space bounds.
+            @param sOutPrefix        Chunk files are named as <prefix>_<x>_<y>.obj and <prefix>_<x>_<y>_lm.obj.
+                                     Should be in the directory of the source model so textures are found the same way.
+            @param sIndexFilename    Index file to be written.
+            @param vChunks           Receives the chunks.
+        */
+        static bool split(
+            const ObjFile& obj,
+            const ObjFile* pObjLightmap,
+            float fChunkSize,
+            float fScaling, float fPosX, float fPosY, float fPosZ,
+            const std::string& sOutPrefix,
+            const std::string& sIndexFilename,
+            std::vector<ArenaChunkInfo>& vChunks);
+
+        static bool loadIndex(const std::string& sIndexFilename, std::vector<ArenaChunkInfo>& vChunks);
+
+    private:
+        ArenaChunker();
+    }; // class ArenaChunker
+
+} // namespace elte_fail
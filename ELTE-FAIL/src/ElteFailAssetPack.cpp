@@ -0,0 +1,397 @@
+/*
+    ###################################################################################
+    ElteFailAssetPack.cpp
+    Packed asset archive of ELTE-FAIL, read through a single memory mapping.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailAssetPack.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#include "ElteFailCompression.h"
+
+static const char szPackMagic[4] = { 'E', 'F', 'P', 'K' };
+static const uint32_t nPackVersion = 1;
+static const uint64_t nFnvOffsetBasis = 14695981039346656037ull;
+static const uint64_t nFnvPrime = 1099511628211ull;
+
+/**
+    Beginning of a pack, followed by nEntries AssetPackEntry, then the paths block, then the aligned content of the files.
+*/
+struct PackHeader
+{
+    char m_szMagic[4];
+    uint32_t m_nVersion;
+    uint32_t m_nEntries;
+    uint32_t m_nPathsLength;
+};
+
+/**
+    File to be packed.
+*/
+struct PackSource
+{
+    std::string m_sPath;         /**< As found under the root directory, with '/' separators. */
+    uint64_t m_nPathHash;
+};
+
+static bool writePadding(FILE* f, uint64_t& nOffset)
+{
+    static const uint8_t padding[elte_fail::AssetPack::nDataAlignment] = {};
+    const size_t nPadding = static_cast<size_t>((elte_fail::AssetPack::nDataAlignment - nOffset % elte_fail::AssetPack::nDataAlignment) % elte_fail::AssetPack::nDataAlignment);
+    nOffset += nPadding;
+    return (nPadding == 0) || (fwrite(padding, 1, nPadding, f) == nPadding);
+}
+
+
+// ############################### PUBLIC ################################
+
+
+uint64_t elte_fail::AssetPack::hash(const uint8_t* pData, size_t nLength)
+{
+    uint64_t nHash = nFnvOffsetBasis;
+    for (size_t i = 0; i < nLength; i++)
+    {
+        nHash = (nHash ^ pData[i]) * nFnvPrime;
+    }
+    return nHash;
+} // hash()
+
+
+std::string elte_fail::AssetPack::normalizePath(const std::string& sPath)
+{
+    std::string sNormalized = sPath;
+    for (char& c : sNormalized)
+    {
+        c = (c == '\\') ? '/' : static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    return sNormalized;
+} // normalizePath()
+
+
+bool elte_fail::AssetPack::isUpToDate(const std::string& sRootDir, const std::string& sPackFilename, const TFilterFn& fnFilter)
+{
+    time_t timePack;
+    if (!FileUtils::getModificationTime(sPackFilename, timePack))
+    {
+        return false;
+    }
+
+    std::error_code ec;
+    for (std::filesystem::recursive_directory_iterator it(sRootDir, ec), itEnd; !ec && (it != itEnd); it.increment(ec))
+    {
+        time_t timeFile;
+        if (it->is_regular_file(ec) && fnFilter(it->path().generic_string()) &&
+            (!FileUtils::getModificationTime(it->path().string(), timeFile) || (timeFile > timePack)))
+        {
+            return false;
+        }
+    }
+    return !ec;
+} // isUpToDate()
+
+
+bool elte_fail::AssetPack::build(const std::string& sRootDir, const std::string& sPackFilename, const TFilterFn& fnFilter, AssetPackBuildStats& stats)
+{
+    stats = { 0, 0, 0, 0 };
+
+    std::vector<PackSource> vSources;
+    const std::string sPackNormalized = normalizePath(sPackFilename);
+    std::error_code ec;
+    for (std::filesystem::recursive_directory_iterator it(sRootDir, ec), itEnd; !ec && (it != itEnd); it.increment(ec))
+    {
+        if (!it->is_regular_file(ec))
+        {
+            continue;
+        }
+        std::string sPath = it->path().generic_string();
+        const std::string sNormalized = normalizePath(sPath);
+        if ((sNormalized == sPackNormalized) || !fnFilter(sPath))
+        {
+            continue;
+        }
+        vSources.push_back({ std::move(sPath), hash(reinterpret_cast<const uint8_t*>(sNormalized.data()), sNormalized.size()) });
+    }
+    if (ec)
+    {
+        return false;
+    }
+    // same order every time, so an unchanged tree gives the same pack
+    std::sort(vSources.begin(), vSources.end(), [](const PackSource& a, const PackSource& b)
+        {
+            return (a.m_nPathHash != b.m_nPathHash) ? (a.m_nPathHash < b.m_nPathHash) : (a.m_sPath < b.m_sPath);
+        });
+
+    std::vector<AssetPackEntry> vEntries(vSources.size());
+    std::string sPaths;
+    for (size_t i = 0; i < vSources.size(); i++)
+    {
+        vEntries[i] = { vSources[i].m_nPathHash, 0, 0, 0, 0, static_cast<uint32_t>(sPaths.size()), 0 };
+        sPaths.append(vSources[i].m_sPath);
+        sPaths.push_back('\0');
+    }
+
+    FILE* f = nullptr;
+    if ((fopen_s(&f, sPackFilename.c_str(), "wb") != 0) || !f)
+    {
+        return false;
+    }
+
+    // index is written once more at the end, when offsets and lengths are known
+    PackHeader header;
+    memcpy(header.m_szMagic, szPackMagic, sizeof(header.m_szMagic));
+    header.m_nVersion = nPackVersion;
+    header.m_nEntries = static_cast<uint32_t>(vEntries.size());
+    header.m_nPathsLength = static_cast<uint32_t>(sPaths.size());
+    uint64_t nOffset = sizeof(header) + vEntries.size() * sizeof(AssetPackEntry) + sPaths.size();
+    bool bRet = (fwrite(&header, sizeof(header), 1, f) == 1) &&
+        (vEntries.empty() || (fwrite(vEntries.data(), sizeof(AssetPackEntry), vEntries.size(), f) == vEntries.size())) &&
+        (fwrite(sPaths.data(), 1, sPaths.size(), f) == sPaths.size()) &&
+        writePadding(f, nOffset);
+
+    std::vector<uint8_t> vCompressed;
+    for (size_t i = 0; bRet && (i < vSources.size()); i++)
+    {
+        // empty files cannot be mapped
+        MappedFile file;
+        const bool bEmpty = (std::filesystem::file_size(vSources[i].m_sPath, ec) == 0) && !ec;
+        if (!bEmpty && !file.open(vSources[i].m_sPath))
+        {
+            bRet = false;
+            break;
+        }
+        const uint8_t* pData = file.getData();
+        const size_t nLength = file.getSize();
+        if (nLength > UINT32_MAX)
+        {
+            bRet = false;
+            break;
+        }
+
+        AssetPackEntry& entry = vEntries[i];
+        entry.m_nContentHash = hash(pData, nLength);
+        entry.m_nOffset = nOffset;
+        entry.m_nLength = static_cast<uint32_t>(nLength);
+
+        vCompressed.clear();
+        if ((nLength > 0) && (Compression::compress(pData, nLength, vCompressed) <= nLength - nLength / 8))
+        {
+            entry.m_nFlags = nFlagCompressed;
+            pData = vCompressed.data();
+            stats.m_nCompressed++;
+        }
+        entry.m_nStoredLength = static_cast<uint32_t>((entry.m_nFlags & nFlagCompressed) ? vCompressed.size() : nLength);
+
+        nOffset += entry.m_nStoredLength;
+        bRet = (fwrite(pData, 1, entry.m_nStoredLength, f) == entry.m_nStoredLength) && writePadding(f, nOffset);
+        stats.m_nFiles++;
+        stats.m_nBytes += nLength;
+    }
+
+    bRet = bRet &&
+        (fseek(f, sizeof(header), SEEK_SET) == 0) &&
+        (vEntries.empty() || (fwrite(vEntries.data(), sizeof(AssetPackEntry), vEntries.size(), f) == vEntries.size()));
+    bRet = (fclose(f) == 0) && bRet;
+    if (!bRet)
+    {
+        // incomplete pack would be taken as up to date next time
+        remove(sPackFilename.c_str());
+        return false;
+    }
+    stats.m_nPackBytes = nOffset;
+    return true;
+} // build()
+
+
+elte_fail::AssetPack::AssetPack() :
+    m_pEntries(nullptr),
+    m_pPaths(nullptr),
+    m_nEntries(0)
+{
+
+} // AssetPack()
+
+
+bool elte_fail::AssetPack::open(const std::string& sPackFilename)
+{
+    close();
+    if (!m_file.open(sPackFilename))
+    {
+        return false;
+    }
+
+    const uint8_t* const pData = m_file.getData();
+    const uint64_t nSize = m_file.getSize();
+    PackHeader header;
+    bool bValid = (nSize >= sizeof(header));
+    if (bValid)
+    {
+        memcpy(&header, pData, sizeof(header));
+        bValid = (memcmp(header.m_szMagic, szPackMagic, sizeof(header.m_szMagic)) == 0) && (header.m_nVersion == nPackVersion);
+    }
+    const uint64_t nPathsBegin = sizeof(header) + static_cast<uint64_t>(bValid ? header.m_nEntries : 0) * sizeof(AssetPackEntry);
+    const uint64_t nPathsEnd = nPathsBegin + (bValid ? header.m_nPathsLength : 0);
+    bValid = bValid && (nPathsEnd <= nSize) && ((header.m_nEntries == 0) || ((header.m_nPathsLength > 0) && (pData[nPathsEnd - 1] == '\0')));
+
+    // mapping is page-aligned and header size is a multiple of 8, so entries are aligned
+    m_pEntries = reinterpret_cast<const AssetPackEntry*>(pData + sizeof(header));
+    m_pPaths = reinterpret_cast<const char*>(pData + nPathsBegin);
+    for (uint32_t i = 0; bValid && (i < header.m_nEntries); i++)
+    {
+        // no entry can run off the mapping, and binary search needs the order
+        const AssetPackEntry& entry = m_pEntries[i];
+        bValid = (entry.m_nPathOffset < header.m_nPathsLength) &&
+            (entry.m_nOffset >= nPathsEnd) && (entry.m_nOffset <= nSize) && (entry.m_nStoredLength <= nSize - entry.m_nOffset) &&
+            (((entry.m_nFlags & nFlagCompressed) != 0) || (entry.m_nStoredLength == entry.m_nLength)) &&
+            ((i == 0) || (m_pEntries[i - 1].m_nPathHash <= entry.m_nPathHash));
+    }
+
+    if (!bValid)
+    {
+        close();
+        return false;
+    }
+    m_nEntries = header.m_nEntries;
+    return true;
+} // open()
+
+
+void elte_fail::AssetPack::close()
+{
+    m_file.close();
+    m_pEntries = nullptr;
+    m_pPaths = nullptr;
+    m_nEntries = 0;
+} // close()
+
+
+bool elte_fail::AssetPack::isOpen() const
+{
+    return m_file.isOpen();
+} // isOpen()
+
+
+uint32_t elte_fail::AssetPack::getEntryCount() const
+{
+    return m_nEntries;
+} // getEntryCount()
+
+
+bool elte_fail::AssetPack::contains(const std::string& sPath) const
+{
+    return find(sPath) != nullptr;
+} // contains()
+
+
+bool elte_fail::AssetPack::getView(const std::string& sPath, AssetView& view) const
+{
+    const AssetPackEntry* const pEntry = find(sPath);
+    if (!pEntry || ((pEntry->m_nFlags & nFlagCompressed) != 0))
+    {
+        return false;
+    }
+    view = { m_file.getData() + pEntry->m_nOffset, pEntry->m_nLength };
+    return true;
+} // getView()
+
+
+bool elte_fail::AssetPack::read(const std::string& sPath, std::vector<uint8_t>& vBuffer, AssetView& view) const
+{
+    const AssetPackEntry* const pEntry = find(sPath);
+    return pEntry && readEntry(*pEntry, vBuffer, view);
+} // read()
+
+
+uint32_t elte_fail::AssetPack::verify() const
+{
+    uint32_t nCorrupt = 0;
+    std::vector<uint8_t> vBuffer;
+    for (uint32_t i = 0; i < m_nEntries; i++)
+    {
+        AssetView view;
+        if (!readEntry(m_pEntries[i], vBuffer, view) || (hash(view.m_pData, view.m_nLength) != m_pEntries[i].m_nContentHash))
+        {
+            nCorrupt++;
+        }
+    }
+    return nCorrupt;
+} // verify()
+
+
+void elte_fail::AssetPack::list(const std::string& sDir, const std::string& sExtension, std::vector<std::string>& vPaths) const
+{
+    std::string sPrefix = normalizePath(sDir);
+    if (!sPrefix.empty() && (sPrefix.back() != '/'))
+    {
+        sPrefix.push_back('/');
+    }
+    const std::string sSuffix = normalizePath(sExtension);
+
+    for (uint32_t i = 0; i < m_nEntries; i++)
+    {
+        const char* const szPath = m_pPaths + m_pEntries[i].m_nPathOffset;
+        const std::string sNormalized = normalizePath(szPath);
+        if ((sNormalized.size() > sPrefix.size() + sSuffix.size()) &&
+            (sNormalized.compare(0, sPrefix.size(), sPrefix) == 0) &&
+            (sNormalized.compare(sNormalized.size() - sSuffix.size(), sSuffix.size(), sSuffix) == 0) &&
+            (sNormalized.find('/', sPrefix.size()) == std::string::npos))
+        {
+            vPaths.push_back(szPath);
+        }
+    }
+} // list()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+const elte_fail::AssetPackEntry* elte_fail::AssetPack::find(const std::string& sPath) const
+{
+    if (!isOpen())
+    {
+        return nullptr;
+    }
+
+    const std::string sNormalized = normalizePath(sPath);
+    const uint64_t nPathHash = hash(reinterpret_cast<const uint8_t*>(sNormalized.data()), sNormalized.size());
+    const AssetPackEntry* const pEnd = m_pEntries + m_nEntries;
+    const AssetPackEntry* pEntry = std::lower_bound(m_pEntries, pEnd, nPathHash,
+        [](const AssetPackEntry& entry, uint64_t nHash) { return entry.m_nPathHash < nHash; });
+    // colliding hashes are next to each other
+    for (; (pEntry != pEnd) && (pEntry->m_nPathHash == nPathHash); pEntry++)
+    {
+        if (normalizePath(m_pPaths + pEntry->m_nPathOffset) == sNormalized)
+        {
+            return pEntry;
+        }
+    }
+    return nullptr;
+} // find()
+
+
+bool elte_fail::AssetPack::readEntry(const AssetPackEntry& entry, std::vector<uint8_t>& vBuffer, AssetView& view) const
+{
+    const uint8_t* const pStored = m_file.getData() + entry.m_nOffset;
+    if ((entry.m_nFlags & nFlagCompressed) == 0)
+    {
+        view = { pStored, entry.m_nLength };
+        return true;
+    }
+
+    vBuffer.resize(entry.m_nLength);
+    if (!Compression::decompress(pStored, entry.m_nStoredLength, vBuffer.data(), vBuffer.size()))
+    {
+        return false;
+    }
+    view = { vBuffer.data(), vBuffer.size() };
+    return true;
+} // readEntry()
@@ -0,0 +1,150 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailAssetPack.h
+    Packed asset archive of ELTE-FAIL, read through a single memory mapping.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ElteFailFileUtils.h"
+
+namespace elte_fail
+{
+
+    /**
+        Entry of the index of a pack. Index is sorted by m_nPathHash, so an entry is found by binary search.
+    */
+    struct AssetPackEntry
+    {
+        uint64_t m_nPathHash;        /**< AssetPack::hash() of the normalized path. */
+        uint64_t m_nContentHash;     /**< AssetPack::hash() of the uncompressed content. */
+        uint64_t m_nOffset;          /**< From the beginning of the pack, multiple of AssetPack::nDataAlignment. */
+        uint32_t m_nStoredLength;    /**< Length in the pack, compressed if m_nFlags has nFlagCompressed. */
+        uint32_t m_nLength;          /**< Uncompressed length. */
+        uint32_t m_nPathOffset;      /**< Of the NUL-terminated path, from the beginning of the paths block. */
+        uint32_t m_nFlags;
+    };
+
+    struct AssetView
+    {
+        const uint8_t* m_pData;
+        size_t m_nLength;
+    };
+
+    struct AssetPackBuildStats
+    {
+        uint32_t m_nFiles;
+        uint32_t m_nCompressed;      /**< Files stored compressed. */
+        uint64_t m_nBytes;           /**< Uncompressed content of all files. */
+        uint64_t m_nPackBytes;       /**< Size of the whole pack. */
+    };
+
+    /**
+        Assets of a directory tree in 1 file: header, index of entries, paths, then the content of the files, each aligned.
+        Pack is mapped once, and finding an asset is a binary search in the mapped index, so reading assets doesn't open,
+        seek or read any file.
+        Files are compressed by Compression if that saves at least 1/8 of their size, others are stored as they are, so they
+        can be used directly from the mapping by getView().
+        Paths are looked up case-insensitively with either separator, e.g. "gamedata\\models\\cube.obj" and
+        "gamedata/Models/cube.obj" are the same asset.
+    */
+    class AssetPack
+    {
+    public:
+        static const uint32_t nFlagCompressed = 1;
+        static const uint32_t nDataAlignment = 16;
+
+        /**
+            Tells whether the file of the given path, as found under the root directory, is to be packed.
+        */
+        using TFilterFn = std::function<bool(const std::string& sPath)>;
+
+        /**
+            @return FNV-1a 64-bit hash.
+        */
+        static uint64_t hash(const uint8_t* pData, size_t nLength);
+
+        /**
+            @return Path with '/' separators, lowercase.
+        */
+        static std::string normalizePath(const std::string& sPath);
+
+        /**
+            @return True if the pack exists and it is not older than any file under the given directory accepted by the filter.
+        */
+        static bool isUpToDate(const std::string& sRootDir, const std::string& sPackFilename, const TFilterFn& fnFilter);
+
+        /**
+            Packs all files under the given directory accepted by the filter, except the pack itself if it is also there.
+            Files generated into the directory at runtime should be rejected by the filter, otherwise regenerating them
+            makes the pack outdated. Paths in the pack start with the given directory as given, e.g. "gamedata/models/cube.obj"
+            for "gamedata".
+
+            @return False if any file cannot be read or the pack cannot be written, in that case no pack is left behind.
+        */
+        static bool build(const std::string& sRootDir, const std::string& sPackFilename, const TFilterFn& fnFilter, AssetPackBuildStats& stats);
+
+        AssetPack();
+
+        /**
+            @return False if the pack cannot be mapped or its index is not valid, e.g. an entry runs off the pack.
+        */
+        bool open(const std::string& sPackFilename);
+
+        void close();
+        bool isOpen() const;
+        uint32_t getEntryCount() const;
+
+        bool contains(const std::string& sPath) const;
+
+        /**
+            Zero-copy access, the view points into the mapping until close().
+
+            @return False if there is no such asset, or it is compressed.
+        */
+        bool getView(const std::string& sPath, AssetView& view) const;
+
+        /**
+            Same as getView() for uncompressed assets, compressed ones are decompressed into the given buffer and the view
+            points into that.
+
+            @return False if there is no such asset, or it cannot be decompressed.
+        */
+        bool read(const std::string& sPath, std::vector<uint8_t>& vBuffer, AssetView& view) const;
+
+        /**
+            Reads every asset and compares its content to its hash, so it touches every page of the pack.
+
+            @return Number of assets not matching their hash.
+        */
+        uint32_t verify() const;
+
+        /**
+            Appends paths of assets directly in the given directory having the given extension, as they were packed.
+        */
+        void list(const std::string& sDir, const std::string& sExtension, std::vector<std::string>& vPaths) const;
+
+    private:
+        MappedFile m_file;
+        const AssetPackEntry* m_pEntries;   /**< Inside m_file. */
+        const char* m_pPaths;               /**< Inside m_file. */
+        uint32_t m_nEntries;
+
+        // ---------------------------------------------------------------------------
+
+        AssetPack(const AssetPack&);
+        AssetPack& operator=(const AssetPack&);
+
+        const AssetPackEntry* find(const std::string& sPath) const;
+        bool readEntry(const AssetPackEntry& entry, std::vector<uint8_t>& vBuffer, AssetView& view) const;
+    }; // class AssetPack
+
+} // namespace elte_fail
@@ -0,0 +1,441 @@
+/*
+    ###################################################################################
+    ElteFailAsyncLog.cpp
+    Asynchronous, non-blocking logging for ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailAsyncLog.h"
+
+#include <cstring>
+
+static_assert((elte_fail::AsyncLog::nRingCapacity & (elte_fail::AsyncLog::nRingCapacity - 1)) == 0, "ring capacity must be power of 2");
+static_assert((elte_fail::AsyncLog::nRateLimitSlots & (elte_fail::AsyncLog::nRateLimitSlots - 1)) == 0, "rate limit slots must be power of 2");
+
+static const unsigned int nWriterIdleSleepMSecs = 2;
+
+
+// ############################### PUBLIC ################################
+
+
+const char* elte_fail::AsyncLog::getLevelName(LogLevel level)
+{
+    switch (level)
+    {
+    case LogLevel::Debug:
+        return "debug";
+    case LogLevel::Info:
+        return "info";
+    case LogLevel::Warning:
+        return "warning";
+    case LogLevel::Error:
+        return "error";
+    default:
+        return "off";
+    }
+} // getLevelName()
+
+
+bool elte_fail::AsyncLog::parseLevel(const std::string& sLevel, LogLevel& level)
+{
+    for (uint8_t i = static_cast<uint8_t>(LogLevel::Debug); i <= static_cast<uint8_t>(LogLevel::Off); i++)
+    {
+        if (_stricmp(sLevel.c_str(), getLevelName(static_cast<LogLevel>(i))) == 0)
+        {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+} // parseLevel()
+
+
+elte_fail::AsyncLog::AsyncLog() :
+    m_slots(new Slot[nRingCapacity]),
+    m_nEnqueuePos(0),
+    m_nDequeuePos(0),
+    m_rateLimitSlots(new RateLimitSlot[nRateLimitSlots]),
+    m_nRateLimit(0),
+    m_nModules(0),
+    m_nDropped(0),
+    m_nSuppressed(0),
+    m_nWritten(0),
+    m_timeStart(std::chrono::steady_clock::now()),
+    m_file(nullptr),
+    m_bRunning(false)
+{
+    for (size_t i = 0; i < nRingCapacity; i++)
+    {
+        m_slots[i].m_nSequence.store(i, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < nRateLimitSlots; i++)
+    {
+        m_rateLimitSlots[i].m_fmt.store(nullptr, std::memory_order_relaxed);
+        m_rateLimitSlots[i].m_nWindowSecs.store(0, std::memory_order_relaxed);
+        m_rateLimitSlots[i].m_nLinesInWindow.store(0, std::memory_order_relaxed);
+        m_rateLimitSlots[i].m_nSuppressed.store(0, std::memory_order_relaxed);
+    }
+} // AsyncLog()
+
+
+elte_fail::AsyncLog::~AsyncLog()
+{
+    stop();
+} // ~AsyncLog()
+
+
+bool elte_fail::AsyncLog::start(const std::string& sFilename)
+{
+    if (isStarted())
+    {
+        return false;
+    }
+
+    if ((fopen_s(&m_file, sFilename.c_str(), "a") != 0) || !m_file)
+    {
+        m_file = nullptr;
+        return false;
+    }
+
+    m_bRunning = true;
+    m_writerThread = std::thread(&AsyncLog::runWriter, this);
+    return true;
+} // start()
+
+
+void elte_fail::AsyncLog::stop()
+{
+    if (!isStarted())
+    {
+        return;
+    }
+
+    m_bRunning = false;
+    m_writerThread.join();
+
+    // writer thread is gone, whatever producers managed to put into the ring until now is written here
+    while (writeNextLine())
+    {
+    }
+
+    fclose(m_file);
+    m_file = nullptr;
+} // stop()
+
+
+bool elte_fail::AsyncLog::isStarted() const
+{
+    return m_writerThread.joinable();
+} // isStarted()
+
+
+elte_fail::TLogModuleId elte_fail::AsyncLog::registerModule(const char* szName, LogLevel level)
+{
+    const TLogModuleId nExistingModuleId = findModule(szName);
+    if (nExistingModuleId != nInvalidModuleId)
+    {
+        return nExistingModuleId;
+    }
+
+    if (m_nModules >= nMaxModules)
+    {
+        return nInvalidModuleId;
+    }
+
+    Module& module = m_modules[m_nModules];
+    strncpy_s(module.m_szName, sizeof(module.m_szName), szName, strlen(szName));
+    module.m_level.store(level);
+    return static_cast<TLogModuleId>(m_nModules++);
+} // registerModule()
+
+
+elte_fail::TLogModuleId elte_fail::AsyncLog::findModule(const std::string& sName) const
+{
+    for (size_t i = 0; i < m_nModules; i++)
+    {
+        if (sName == m_modules[i].m_szName)
+        {
+            return static_cast<TLogModuleId>(i);
+        }
+    }
+    return nInvalidModuleId;
+} // findModule()
+
+
+const char* elte_fail::AsyncLog::getModuleName(TLogModuleId nModuleId) const
+{
+    return (nModuleId < m_nModules) ? m_modules[nModuleId].m_szName : "";
+} // getModuleName()
+
+
+void elte_fail::AsyncLog::setLevel(TLogModuleId nModuleId, LogLevel level)
+{
+    if (nModuleId < m_nModules)
+    {
+        m_modules[nModuleId].m_level.store(level, std::memory_order_relaxed);
+    }
+} // setLevel()
+
+
+elte_fail::LogLevel elte_fail::AsyncLog::getLevel(TLogModuleId nModuleId) const
+{
+    return (nModuleId < m_nModules) ? m_modules[nModuleId].m_level.load(std::memory_order_relaxed) : LogLevel::Off;
+} // getLevel()
+
+
+bool elte_fail::AsyncLog::setLevels(const std::string& sModuleLevels)
+{
+    bool bRet = true;
+    size_t iStart = 0;
+    while (iStart < sModuleLevels.length())
+    {
+        size_t iEnd = sModuleLevels.find(',', iStart);
+        if (iEnd == std::string::npos)
+        {
+            iEnd = sModuleLevels.length();
+        }
+
+        const std::string sPair = sModuleLevels.substr(iStart, iEnd - iStart);
+        const size_t iSep = sPair.find(':');
+        LogLevel level;
+        const TLogModuleId nModuleId = (iSep == std::string::npos) ? nInvalidModuleId : findModule(sPair.substr(0, iSep));
+        if ((nModuleId != nInvalidModuleId) && parseLevel(sPair.substr(iSep + 1), level))
+        {
+            setLevel(nModuleId, level);
+        }
+        else
+        {
+            bRet = false;
+        }
+
+        iStart = iEnd + 1;
+    }
+    return bRet;
+} // setLevels()
+
+
+bool elte_fail::AsyncLog::isEnabled(TLogModuleId nModuleId, LogLevel level) const
+{
+    return (level != LogLevel::Off) && (level >= getLevel(nModuleId));
+} // isEnabled()
+
+
+void elte_fail::AsyncLog::setRateLimit(uint32_t nMaxLinesPerSecPerCallSite)
+{
+    m_nRateLimit.store(nMaxLinesPerSecPerCallSite, std::memory_order_relaxed);
+} // setRateLimit()
+
+
+void elte_fail::AsyncLog::log(TLogModuleId nModuleId, LogLevel level, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    logV(nModuleId, level, fmt, args);
+    va_end(args);
+} // log()
+
+
+void elte_fail::AsyncLog::logV(TLogModuleId nModuleId, LogLevel level, const char* fmt, va_list args)
+{
+    uint32_t nSuppressedBefore = 0;
+    if (!isEnabled(nModuleId, level) || !passRateLimit(fmt, nSuppressedBefore))
+    {
+        return;
+    }
+
+    // bounded MPMC queue by Dmitry Vyukov, used here with a single consumer: each slot's sequence number tells
+    // if it is free for the producer claiming a given position, so producers never wait for each other or for the writer
+    size_t nPos = m_nEnqueuePos.load(std::memory_order_relaxed);
+    Slot* pSlot = nullptr;
+    for (;;)
+    {
+        pSlot = &m_slots[nPos & (nRingCapacity - 1)];
+        const size_t nSequence = pSlot->m_nSequence.load(std::memory_order_acquire);
+        const intptr_t nDiff = static_cast<intptr_t>(nSequence) - static_cast<intptr_t>(nPos);
+        if (nDiff == 0)
+        {
+            if (m_nEnqueuePos.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (nDiff < 0)
+        {
+            // ring is full, writer cannot keep up
+            m_nDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            nPos = m_nEnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    pSlot->m_nTimeUSecs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_timeStart).count());
+    pSlot->m_nSuppressedBefore = nSuppressedBefore;
+    pSlot->m_nModuleId = nModuleId;
+    pSlot->m_level = level;
+    vsnprintf_s(pSlot->m_szText, nMaxLineLength, _TRUNCATE, fmt, args);
+
+    pSlot->m_nSequence.store(nPos + 1, std::memory_order_release);
+} // logV()
+
+
+uint64_t elte_fail::AsyncLog::getDroppedCount() const
+{
+    return m_nDropped.load(std::memory_order_relaxed);
+} // getDroppedCount()
+
+
+uint64_t elte_fail::AsyncLog::getSuppressedCount() const
+{
+    return m_nSuppressed.load(std::memory_order_relaxed);
+} // getSuppressedCount()
+
+
+uint64_t elte_fail::AsyncLog::getWrittenCount() const
+{
+    return m_nWritten.load(std::memory_order_relaxed);
+} // getWrittenCount()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+/**
+    Counts the lines of the call site identified by the given format string in 1 second windows.
+
+    @return False if the line should be suppressed. If true, nSuppressedBefore is set to the number of lines suppressed since the last passed line.
+*/
+bool elte_fail::AsyncLog::passRateLimit(const char* fmt, uint32_t& nSuppressedBefore)
+{
+    const uint32_t nRateLimit = m_nRateLimit.load(std::memory_order_relaxed);
+    if (nRateLimit == 0)
+    {
+        return true;
+    }
+
+    const size_t iSlot = ((reinterpret_cast<uintptr_t>(fmt) >> 3) * 2654435761u) & (nRateLimitSlots - 1);
+    RateLimitSlot& slot = m_rateLimitSlots[iSlot];
+
+    const char* fmtInSlot = slot.m_fmt.load(std::memory_order_acquire);
+    if ((fmtInSlot != fmt) && !((fmtInSlot == nullptr) && slot.m_fmt.compare_exchange_strong(fmtInSlot, fmt)))
+    {
+        // slot is taken by another call site, dont limit this one
+        return true;
+    }
+
+    const uint32_t nNowSecs = static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - m_timeStart).count());
+    uint32_t nWindowSecs = slot.m_nWindowSecs.load(std::memory_order_relaxed);
+    if ((nWindowSecs != nNowSecs) && slot.m_nWindowSecs.compare_exchange_strong(nWindowSecs, nNowSecs))
+    {
+        // only approximate when multiple threads log from the same call site at the turn of a second, that is fine
+        slot.m_nLinesInWindow.store(0, std::memory_order_relaxed);
+    }
+
+    if (slot.m_nLinesInWindow.fetch_add(1, std::memory_order_relaxed) >= nRateLimit)
+    {
+        slot.m_nSuppressed.fetch_add(1, std::memory_order_relaxed);
+        m_nSuppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    nSuppressedBefore = slot.m_nSuppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+} // passRateLimit()
+
+
+bool elte_fail::AsyncLog::writeNextLine()
+{
+    Slot& slot = m_slots[m_nDequeuePos & (nRingCapacity - 1)];
+    if (slot.m_nSequence.load(std::memory_order_acquire) != m_nDequeuePos + 1)
+    {
+        return false;
+    }
+
+    fprintf(m_file, "%10.3f %-7s %-12s %s",
+        slot.m_nTimeUSecs / 1000000.0, getLevelName(slot.m_level), getModuleName(slot.m_nModuleId), slot.m_szText);
+    if (slot.m_nSuppressedBefore > 0)
+    {
+        fprintf(m_file, " (%u similar lines suppressed before)", slot.m_nSuppressedBefore);
+    }
+    fprintf(m_file, "\n");
+
+    // slot can be reused by the producer coming 1 full round later
+    slot.m_nSequence.store(m_nDequeuePos + nRingCapacity, std::memory_order_release);
+    m_nDequeuePos++;
+    m_nWritten.fetch_add(1, std::memory_order_relaxed);
+    return true;
+} // writeNextLine()
+
+
+void elte_fail::AsyncLog::runWriter()
+{
+    while (m_bRunning)
+    {
+        if (!writeNextLine())
+        {
+            fflush(m_file);
+            std::this_thread::sleep_for(std::chrono::milliseconds(nWriterIdleSleepMSecs));
+        }
+    }
+} // runWriter()
+
+
+// #############################################################################
+
+
+elte_fail::AsyncLogger::AsyncLogger(AsyncLog& log, TLogModuleId nModuleId) :
+    m_log(log),
+    m_nModuleId(nModuleId)
+{
+
+} // AsyncLogger()
+
+
+bool elte_fail::AsyncLogger::isEnabled(LogLevel level) const
+{
+    return m_log.isEnabled(m_nModuleId, level);
+} // isEnabled()
+
+
+void elte_fail::AsyncLogger::DLn(const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    m_log.logV(m_nModuleId, LogLevel::Debug, fmt, args);
+    va_end(args);
+} // DLn()
+
+
+void elte_fail::AsyncLogger::OLn(const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    m_log.logV(m_nModuleId, LogLevel::Info, fmt, args);
+    va_end(args);
+} // OLn()
+
+
+void elte_fail::AsyncLogger::WLn(const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    m_log.logV(m_nModuleId, LogLevel::Warning, fmt, args);
+    va_end(args);
+} // WLn()
+
+
+void elte_fail::AsyncLogger::EOLn(const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    m_log.logV(m_nModuleId, LogLevel::Error, fmt, args);
+    va_end(args);
+} // EOLn()
@@ -0,0 +1,183 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailAsyncLog.h
+    Asynchronous, non-blocking logging for ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace elte_fail
+{
+
+    enum class LogLevel : uint8_t
+    {
+        Debug = 0,
+        Info,
+        Warning,
+        Error,
+        Off
+    };
+
+    using TLogModuleId = uint8_t;
+
+    /**
+        Logger for the hot paths (packet handlers, gameplay), where synchronous CConsole output would show up in frame time and packet latency.
+        Producers only format the line into a slot of a lock-free bounded ring buffer, a background writer thread drains the ring into
+        the log file. If the ring is full, the line is dropped and counted, producers never block.
+        Every module has its own level which can be changed anytime from any thread.
+        Repeated messages are rate limited per call site (format string): above the limit in the same second, lines are suppressed and counted,
+        and the next line of the same call site tells how many were suppressed.
+        CConsole is not thread-safe, so the writer thread has its own file instead of writing into the CConsole log.
+    */
+    class AsyncLog
+    {
+    public:
+        static const size_t nRingCapacity = 4096;         /**< Must be power of 2. */
+        static const size_t nMaxLineLength = 240;         /**< Longer lines are truncated. */
+        static const size_t nMaxModules = 16;
+        static const size_t nRateLimitSlots = 256;        /**< Must be power of 2. Call sites colliding in the same slot are not rate limited. */
+        static const TLogModuleId nInvalidModuleId = UINT8_MAX;
+
+        static const char* getLevelName(LogLevel level);
+        static bool parseLevel(const std::string& sLevel, LogLevel& level);  /**< Accepts the names returned by getLevelName(), case-insensitive. */
+
+        AsyncLog();
+        ~AsyncLog();
+
+        /**
+            Opens the given file for appending and starts the writer thread.
+            Lines logged before start() stay in the ring and are written once the writer is started.
+        */
+        bool start(const std::string& sFilename);
+
+        /**
+            Writes out all lines still in the ring, then stops the writer thread and closes the file.
+        */
+        void stop();
+
+        bool isStarted() const;
+
+        /**
+            Registers a new module. Not thread-safe, should be called during initialization only.
+
+            @return Id of the module, same id if the module is already registered, nInvalidModuleId if there are too many modules.
+        */
+        TLogModuleId registerModule(const char* szName, LogLevel level);
+
+        TLogModuleId findModule(const std::string& sName) const;  /**< @return nInvalidModuleId if no such module. */
+        const char* getModuleName(TLogModuleId nModuleId) const;
+
+        void setLevel(TLogModuleId nModuleId, LogLevel level);
+        LogLevel getLevel(TLogModuleId nModuleId) const;
+
+        /**
+            Sets module levels from a comma-separated list of module:level pairs, e.g. "CustomPGE:info,ElteFailNet:warning".
+
+            @return False if any of the pairs is invalid, valid pairs are applied anyway.
+        */
+        bool setLevels(const std::string& sModuleLevels);
+
+        bool isEnabled(TLogModuleId nModuleId, LogLevel level) const;
+
+        void setRateLimit(uint32_t nMaxLinesPerSecPerCallSite);  /**< 0 disables rate limiting. */
+
+        void log(TLogModuleId nModuleId, LogLevel level, const char* fmt, ...);
+        void logV(TLogModuleId nModuleId, LogLevel level, const char* fmt, va_list args);
+
+        uint64_t getDroppedCount() const;      /**< Lines lost because the ring was full. */
+        uint64_t getSuppressedCount() const;   /**< Lines suppressed by rate limiting. */
+        uint64_t getWrittenCount() const;      /**< Lines written to the file. */
+
+    private:
+
+        struct Slot
+        {
+            std::atomic<size_t> m_nSequence;   /**< Tells whether the slot is free for the producer of a given position or ready for the consumer. */
+            uint64_t m_nTimeUSecs;
+            uint32_t m_nSuppressedBefore;      /**< Number of lines of the same call site suppressed before this line. */
+            TLogModuleId m_nModuleId;
+            LogLevel m_level;
+            char m_szText[nMaxLineLength];
+        };
+
+        struct RateLimitSlot
+        {
+            std::atomic<const char*> m_fmt;
+            std::atomic<uint32_t> m_nWindowSecs;
+            std::atomic<uint32_t> m_nLinesInWindow;
+            std::atomic<uint32_t> m_nSuppressed;
+        };
+
+        struct Module
+        {
+            char m_szName[32];
+            std::atomic<LogLevel> m_level;
+        };
+
+        std::unique_ptr<Slot[]> m_slots;
+        std::atomic<size_t> m_nEnqueuePos;
+        size_t m_nDequeuePos;                   /**< Used only by the writer thread, or by stop() after the writer thread is joined. */
+
+        std::unique_ptr<RateLimitSlot[]> m_rateLimitSlots;
+        std::atomic<uint32_t> m_nRateLimit;
+
+        Module m_modules[nMaxModules];
+        size_t m_nModules;
+
+        std::atomic<uint64_t> m_nDropped;
+        std::atomic<uint64_t> m_nSuppressed;
+        std::atomic<uint64_t> m_nWritten;
+
+        const std::chrono::steady_clock::time_point m_timeStart;
+
+        FILE* m_file;
+        std::thread m_writerThread;
+        std::atomic<bool> m_bRunning;
+
+        // ---------------------------------------------------------------------------
+
+        AsyncLog(const AsyncLog&);
+        AsyncLog& operator=(const AsyncLog&);
+
+        bool passRateLimit(const char* fmt, uint32_t& nSuppressedBefore);
+        bool writeNextLine();                  /**< @return False if the ring is empty. */
+        void runWriter();
+    }; // class AsyncLog
+
+    /**
+        Module-bound convenience front-end of AsyncLog, with CConsole-like function names so call sites look the same as with getConsole().
+    */
+    class AsyncLogger
+    {
+    public:
+        AsyncLogger(AsyncLog& log, TLogModuleId nModuleId);
+
+        bool isEnabled(LogLevel level) const;
+
+        void DLn(const char* fmt, ...);   /**< Debug. */
+        void OLn(const char* fmt, ...);   /**< Info. */
+        void WLn(const char* fmt, ...);   /**< Warning. */
+        void EOLn(const char* fmt, ...);  /**< Error. */
+
+    private:
+        AsyncLog& m_log;
+        const TLogModuleId m_nModuleId;
+
+        // ---------------------------------------------------------------------------
+
+        AsyncLogger(const AsyncLogger&);
+        AsyncLogger& operator=(const AsyncLogger&);
+    }; // class AsyncLogger
+
+} // namespace elte_fail
@@ -0,0 +1,161 @@
+/*
+    ###################################################################################
+    ElteFailCVars.cpp
+    Typed handles for ELTE-FAIL CVars, with change callbacks and profile reloading.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailCVars.h"
+
+#include <cstdio>
+
+#include "ElteFailFileUtils.h"
+
+static const size_t nMaxLineLength = 1024;
+
+static std::string trim(const std::string& s)
+{
+    const size_t iFirst = s.find_first_not_of(" \t\r\n");
+    if (iFirst == std::string::npos)
+    {
+        return "";
+    }
+    return s.substr(iFirst, s.find_last_not_of(" \t\r\n") - iFirst + 1);
+}
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::CVarRegistry::CVarRegistry() :
+    m_pVars(nullptr),
+    m_timeProfile(0)
+{
+
+} // CVarRegistry()
+
+
+void elte_fail::CVarRegistry::resolve(TVars& vars)
+{
+    m_pVars = &vars;
+    for (const auto& pCVar : m_vCVars)
+    {
+        // std::map never moves its elements, so the pointer stays valid
+        pCVar->m_pVar = &vars[pCVar->getName()];
+        pCVar->update();
+    }
+} // resolve()
+
+
+bool elte_fail::CVarRegistry::isResolved() const
+{
+    return m_pVars != nullptr;
+} // isResolved()
+
+
+uint32_t elte_fail::CVarRegistry::refresh()
+{
+    uint32_t nChanged = 0;
+    for (const auto& pCVar : m_vCVars)
+    {
+        if (pCVar->isResolved() && pCVar->update())
+        {
+            nChanged++;
+            pCVar->notify();
+        }
+    }
+    return nChanged;
+} // refresh()
+
+
+bool elte_fail::CVarRegistry::watchProfile(const std::string& sFilename)
+{
+    if (!FileUtils::getModificationTime(sFilename, m_timeProfile))
+    {
+        return false;
+    }
+    m_sProfileFilename = sFilename;
+    return true;
+} // watchProfile()
+
+
+const std::string& elte_fail::CVarRegistry::getProfileFilename() const
+{
+    return m_sProfileFilename;
+} // getProfileFilename()
+
+
+uint32_t elte_fail::CVarRegistry::reloadProfileIfChanged()
+{
+    time_t timeProfile;
+    if (!isResolved() || m_sProfileFilename.empty() || !FileUtils::getModificationTime(m_sProfileFilename, timeProfile) ||
+        (timeProfile == m_timeProfile))
+    {
+        return 0;
+    }
+
+    std::map<std::string, std::string> values;
+    if (!parseProfile(m_sProfileFilename, values))
+    {
+        // maybe the editor is just writing it, next call tries again
+        return 0;
+    }
+    m_timeProfile = timeProfile;
+
+    // CVars missing from the file keep their values
+    for (const auto& pCVar : m_vCVars)
+    {
+        const auto it = values.find(pCVar->getName());
+        if (pCVar->isResolved() && (it != values.end()))
+        {
+            *(pCVar->m_pVar) = it->second;
+        }
+    }
+    return refresh();
+} // reloadProfileIfChanged()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+bool elte_fail::CVarRegistry::parseProfile(const std::string& sFilename, std::map<std::string, std::string>& values)
+{
+    FILE* f = nullptr;
+    if ((fopen_s(&f, sFilename.c_str(), "rt") != 0) || !f)
+    {
+        return false;
+    }
+
+    char szLine[nMaxLineLength];
+    while (fgets(szLine, sizeof(szLine), f))
+    {
+        // first line is the file signature, comment lines start with #
+        const std::string sLine = trim(szLine);
+        if (sLine.empty() || (sLine[0] == '#') || (sLine[0] == '!'))
+        {
+            continue;
+        }
+
+        const size_t iAssign = sLine.find('=');
+        if (iAssign == std::string::npos)
+        {
+            continue;
+        }
+
+        std::string sValue = sLine.substr(iAssign + 1);
+        const size_t iComment = sValue.find(" #");
+        if (iComment != std::string::npos)
+        {
+            sValue.erase(iComment);
+        }
+        values[trim(sLine.substr(0, iAssign))] = trim(sValue);
+    }
+
+    const bool bRet = (ferror(f) == 0);
+    fclose(f);
+    return bRet;
+} // parseProfile()
@@ -0,0 +1,254 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailCVars.h
+    Typed handles for ELTE-FAIL CVars, with change callbacks and profile reloading.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <ctime>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../../PGE/PGE/Config/PGEcfgVariable.h"
+
+namespace elte_fail
+{
+
+    /**
+        Type independent part of CVar, so CVarRegistry can handle CVars of all types together.
+    */
+    class CVarBase
+    {
+    public:
+        virtual ~CVarBase() {}
+
+        const std::string& getName() const
+        {
+            return m_sName;
+        }
+
+        bool isResolved() const
+        {
+            return m_pVar != nullptr;
+        }
+
+    protected:
+        std::string m_sName;
+        PGEcfgVariable* m_pVar;    /**< Variable in the config profile, nullptr until CVarRegistry::resolve(). */
+
+        explicit CVarBase(const std::string& sName) :
+            m_sName(sName),
+            m_pVar(nullptr)
+        {}
+
+    private:
+        friend class CVarRegistry;
+
+        /**
+            Reads the value from the config profile variable, must be resolved.
+
+            @return True if the value changed.
+        */
+        virtual bool update() = 0;
+
+        virtual void notify() = 0;   /**< Calls change callbacks. */
+
+        // ---------------------------------------------------------------------------
+
+        CVarBase(const CVarBase&);
+        CVarBase& operator=(const CVarBase&);
+    }; // class CVarBase
+
+    /**
+        Handle of a CVar of the config profile, keeping its value already converted to T.
+        get() doesn't look up or convert anything, so it is cheap enough to be called every frame.
+        Value is changed only by set() and CVarRegistry, both calling the change callbacks if the value really changed.
+        Not thread-safe, must be used by the thread of the game loop only.
+    */
+    template <class T>
+    class CVar : public CVarBase
+    {
+    public:
+        using TChangeFn = std::function<void(const T& value)>;
+
+        explicit CVar(const std::string& sName) :
+            CVarBase(sName),
+            m_value()
+        {}
+
+        const T& get() const
+        {
+            return m_value;
+        }
+
+        void addChangeCallback(const TChangeFn& fnChanged)
+        {
+            m_vCallbacks.push_back(fnChanged);
+        }
+
+        /**
+            Sets the value also in the config profile, so the engine sees the same value.
+        */
+        void set(const T& value)
+        {
+            if (m_pVar)
+            {
+                *m_pVar = toString(value);
+            }
+            if (!(value == m_value))
+            {
+                m_value = value;
+                notify();
+            }
+        }
+
+    private:
+        T m_value;
+        std::vector<TChangeFn> m_vCallbacks;
+
+        // ---------------------------------------------------------------------------
+
+        static void read(const PGEcfgVariable& var, bool& value)
+        {
+            value = var.getAsBool();
+        }
+
+        static void read(const PGEcfgVariable& var, int& value)
+        {
+            value = var.getAsInt();
+        }
+
+        static void read(const PGEcfgVariable& var, float& value)
+        {
+            value = var.getAsFloat();
+        }
+
+        static void read(const PGEcfgVariable& var, std::string& value)
+        {
+            value = var.getAsString();
+        }
+
+        static std::string toString(bool value)
+        {
+            return value ? "true" : "false";
+        }
+
+        static std::string toString(int value)
+        {
+            return std::to_string(value);
+        }
+
+        static std::string toString(float value)
+        {
+            return std::to_string(value);
+        }
+
+        static std::string toString(const std::string& value)
+        {
+            return value;
+        }
+
+        bool update() override
+        {
+            T value;
+            read(*m_pVar, value);
+            if (value == m_value)
+            {
+                return false;
+            }
+            m_value = value;
+            return true;
+        }
+
+        void notify() override
+        {
+            for (const auto& fnChanged : m_vCallbacks)
+            {
+                fnChanged(m_value);
+            }
+        }
+    }; // class CVar
+
+    /**
+        Owns the CVar handles of the game. Handles are created before the config profile is available, then resolve()
+        looks up every one of them once. After that the game reads the handles instead of looking up variables by name.
+        The profile file can be watched: when it is saved, it is parsed again and the changed CVars call their change callbacks,
+        so settings handled by callbacks can be changed without restarting the game.
+    */
+    class CVarRegistry
+    {
+    public:
+        using TVars = std::map<std::string, PGEcfgVariable>;
+
+        CVarRegistry();
+
+        /**
+            References to handles stay valid as long as the registry exists.
+        */
+        template <class T>
+        CVar<T>& add(const std::string& sName)
+        {
+            m_vCVars.push_back(std::make_unique<CVar<T>>(sName));
+            return static_cast<CVar<T>&>(*m_vCVars.back());
+        }
+
+        /**
+            Resolves all handles to variables of the given config profile, creating missing variables as empty.
+            Handles take the values of the variables without calling change callbacks.
+            Variables are referred by pointers, so vars must outlive the registry.
+        */
+        void resolve(TVars& vars);
+
+        bool isResolved() const;
+
+        /**
+            Reads all resolved handles again from their variables, calling change callbacks of changed ones.
+
+            @return Number of changed CVars.
+        */
+        uint32_t refresh();
+
+        /**
+            Remembers the modification time of the given profile file for reloadProfileIfChanged().
+
+            @return False if the file doesn't exist.
+        */
+        bool watchProfile(const std::string& sFilename);
+
+        const std::string& getProfileFilename() const;
+
+        /**
+            Parses the watched profile file again if it has been modified since the last time, and updates the CVars
+            of this registry from it. Other variables of the profile are left unchanged, since the engine reads them only at startup.
+            Costs only a stat() if the file didn't change.
+
+            @return Number of changed CVars.
+        */
+        uint32_t reloadProfileIfChanged();
+
+    private:
+        std::vector<std::unique_ptr<CVarBase>> m_vCVars;
+        TVars* m_pVars;
+        std::string m_sProfileFilename;
+        time_t m_timeProfile;    /**< Modification time of the profile file when it was last read. */
+
+        // ---------------------------------------------------------------------------
+
+        CVarRegistry(const CVarRegistry&);
+        CVarRegistry& operator=(const CVarRegistry&);
+
+        /**
+            Reads "name = value" lines of a profile file, ignoring comments.
+
+            @return False if the file cannot be opened.
+        */
+        static bool parseProfile(const std::string& sFilename, std::map<std::string, std::string>& values);
+    }; // class CVarRegistry
+
+} // namespace elte_fail
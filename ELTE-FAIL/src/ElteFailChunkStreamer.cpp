@@ -0,0 +1,322 @@
+/*
+    ###################################################################################
+    ElteFailChunkStreamer.cpp
+    Streaming arena chunks in and out around a focus point, within a memory budget.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailChunkStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+static const unsigned int nIoIdleYields = 64;       /**< I/O thread yields this many times in a row before going to sleep. */
+static const unsigned int nIoIdleSleepMSecs = 1;
+static const size_t nIoBlockSize = 64 * 1024;
+
+/**
+    Reads the whole file, so later it can be opened by the renderer without touching the disk.
+
+    @return False if the file cannot be read.
+*/
+static bool prefetchFile(const std::string& sFilename, std::vector<char>& vBuffer, uint64_t& nBytesRead)
+{
+    FILE* f = nullptr;
+    if ((fopen_s(&f, sFilename.c_str(), "rb") != 0) || !f)
+    {
+        return false;
+    }
+
+    size_t nRead;
+    while ((nRead = fread(vBuffer.data(), 1, vBuffer.size(), f)) > 0)
+    {
+        nBytesRead += nRead;
+    }
+    const bool bRet = (ferror(f) == 0);
+    fclose(f);
+    return bRet;
+}
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::ChunkStreamer::ChunkStreamer() :
+    m_fLoadRadius(0.f),
+    m_fUnloadRadius(0.f),
+    m_stats{},
+    m_bRunning(false),
+    m_nBytesPrefetched(0)
+{
+
+} // ChunkStreamer()
+
+
+elte_fail::ChunkStreamer::~ChunkStreamer()
+{
+    stop();
+} // ~ChunkStreamer()
+
+
+bool elte_fail::ChunkStreamer::start(
+    const std::vector<ArenaChunkInfo>& vChunks,
+    size_t nBudgetBytes,
+    float fLoadRadius,
+    float fUnloadRadius,
+    const TLoadFn& fnLoad,
+    const TUnloadFn& fnUnload)
+{
+    if (isStarted() || !fnLoad || !fnUnload || (fLoadRadius < 0.f))
+    {
+        return false;
+    }
+
+    m_vChunks = vChunks;
+    m_vStates.assign(m_vChunks.size(), ChunkState::Unloaded);
+    m_vDistances.assign(m_vChunks.size(), 0.f);
+    m_fnLoad = fnLoad;
+    m_fnUnload = fnUnload;
+    m_fLoadRadius = fLoadRadius;
+    m_fUnloadRadius = std::max(fLoadRadius, fUnloadRadius);
+    m_stats = {};
+    m_stats.m_nChunks = static_cast<uint32_t>(m_vChunks.size());
+    m_stats.m_nBudgetBytes = nBudgetBytes;
+    m_nBytesPrefetched = 0;
+
+    m_bRunning = true;
+    m_ioThread = std::thread(&ChunkStreamer::runIo, this);
+    return true;
+} // start()
+
+
+void elte_fail::ChunkStreamer::stop()
+{
+    if (!isStarted())
+    {
+        return;
+    }
+
+    m_bRunning = false;
+    m_ioThread.join();
+
+    // requests and completions left in the queues are dropped, their chunks are not resident anyway
+    uint32_t iRequest;
+    while (m_qRequests.tryPop(iRequest))
+    {
+    }
+    Completion completion;
+    while (m_qCompletions.tryPop(completion))
+    {
+    }
+
+    for (uint32_t i = 0; i < m_vStates.size(); i++)
+    {
+        if (m_vStates[i] == ChunkState::Resident)
+        {
+            unload(i);
+        }
+    }
+    m_vStates.assign(m_vChunks.size(), ChunkState::Unloaded);
+} // stop()
+
+
+bool elte_fail::ChunkStreamer::isStarted() const
+{
+    return m_ioThread.joinable();
+} // isStarted()
+
+
+void elte_fail::ChunkStreamer::update(float fFocusX, float fFocusY)
+{
+    if (!isStarted())
+    {
+        return;
+    }
+
+    Completion completion;
+    while (m_qCompletions.tryPop(completion))
+    {
+        if (m_vStates[completion.m_iChunk] == ChunkState::Requested)
+        {
+            m_vStates[completion.m_iChunk] = completion.m_bSuccess ? ChunkState::Prefetched : ChunkState::Failed;
+        }
+    }
+
+    // chunks far away are unloaded regardless of budget
+    std::vector<uint32_t> vCandidates;
+    for (uint32_t i = 0; i < m_vChunks.size(); i++)
+    {
+        m_vDistances[i] = getDistance(m_vChunks[i].m_bounds, fFocusX, fFocusY);
+        if ((m_vStates[i] == ChunkState::Resident) && (m_vDistances[i] > m_fUnloadRadius))
+        {
+            unload(i);
+            m_stats.m_nUnloads++;
+        }
+        if ((m_vStates[i] != ChunkState::Failed) && (m_vDistances[i] <= m_fLoadRadius))
+        {
+            vCandidates.push_back(i);
+        }
+    }
+
+    // wanted set: nearest candidates fitting the budget
+    std::sort(vCandidates.begin(), vCandidates.end(), [this](uint32_t a, uint32_t b) { return m_vDistances[a] < m_vDistances[b]; });
+    std::vector<bool> vWanted(m_vChunks.size(), false);
+    size_t nWantedBytes = 0;
+    for (const auto i : vCandidates)
+    {
+        if (nWantedBytes + m_vChunks[i].getEstimatedBytes() <= m_stats.m_nBudgetBytes)
+        {
+            nWantedBytes += m_vChunks[i].getEstimatedBytes();
+            vWanted[i] = true;
+        }
+    }
+
+    // resident chunks not wanted are eviction candidates, farthest first
+    std::vector<uint32_t> vEvictable;
+    for (uint32_t i = 0; i < m_vChunks.size(); i++)
+    {
+        if ((m_vStates[i] == ChunkState::Resident) && !vWanted[i])
+        {
+            vEvictable.push_back(i);
+        }
+    }
+    std::sort(vEvictable.begin(), vEvictable.end(), [this](uint32_t a, uint32_t b) { return m_vDistances[a] < m_vDistances[b]; });
+
+    uint32_t nLoads = 0;
+    for (const auto i : vCandidates)
+    {
+        if (!vWanted[i])
+        {
+            continue;
+        }
+
+        if (m_vStates[i] == ChunkState::Unloaded)
+        {
+            if (m_qRequests.tryPush(i))
+            {
+                m_vStates[i] = ChunkState::Requested;
+            }
+        }
+        else if ((m_vStates[i] == ChunkState::Prefetched) && (nLoads < nMaxLoadsPerUpdate))
+        {
+            // wanted chunks fit the budget together, so evicting the not wanted ones always makes enough room
+            while (!vEvictable.empty() && (m_stats.m_nResidentBytes + m_vChunks[i].getEstimatedBytes() > m_stats.m_nBudgetBytes))
+            {
+                unload(vEvictable.back());
+                vEvictable.pop_back();
+                m_stats.m_nEvictions++;
+            }
+
+            nLoads++;
+            if (m_fnLoad(i, m_vChunks[i]))
+            {
+                m_vStates[i] = ChunkState::Resident;
+                m_stats.m_nResidentBytes += m_vChunks[i].getEstimatedBytes();
+                m_stats.m_nLoads++;
+            }
+            else
+            {
+                m_vStates[i] = ChunkState::Failed;
+            }
+        }
+    }
+
+    m_stats.m_nResident = 0;
+    m_stats.m_nPending = 0;
+    m_stats.m_nFailed = 0;
+    for (const auto state : m_vStates)
+    {
+        switch (state)
+        {
+        case ChunkState::Resident:
+            m_stats.m_nResident++;
+            break;
+        case ChunkState::Requested:
+        case ChunkState::Prefetched:
+            m_stats.m_nPending++;
+            break;
+        case ChunkState::Failed:
+            m_stats.m_nFailed++;
+            break;
+        default:
+            break;
+        }
+    }
+} // update()
+
+
+elte_fail::ChunkState elte_fail::ChunkStreamer::getState(uint32_t iChunk) const
+{
+    return (iChunk < m_vStates.size()) ? m_vStates[iChunk] : ChunkState::Unloaded;
+} // getState()
+
+
+elte_fail::ChunkStreamerStats elte_fail::ChunkStreamer::getStats() const
+{
+    ChunkStreamerStats stats = m_stats;
+    stats.m_nBytesPrefetched = m_nBytesPrefetched.load(std::memory_order_relaxed);
+    return stats;
+} // getStats()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+float elte_fail::ChunkStreamer::getDistance(const Aabb& bounds, float fX, float fY)
+{
+    const float fDx = std::max(0.f, std::max(bounds.m_fMin[0] - fX, fX - bounds.m_fMax[0]));
+    const float fDy = std::max(0.f, std::max(bounds.m_fMin[1] - fY, fY - bounds.m_fMax[1]));
+    return std::sqrt(fDx * fDx + fDy * fDy);
+} // getDistance()
+
+
+void elte_fail::ChunkStreamer::unload(uint32_t iChunk)
+{
+    m_fnUnload(iChunk, m_vChunks[iChunk]);
+    m_vStates[iChunk] = ChunkState::Unloaded;
+    m_stats.m_nResidentBytes -= m_vChunks[iChunk].getEstimatedBytes();
+} // unload()
+
+
+void elte_fail::ChunkStreamer::runIo()
+{
+    std::vector<char> vBuffer(nIoBlockSize);
+    unsigned int nIdleRounds = 0;
+    uint32_t iChunk;
+    while (m_bRunning)
+    {
+        if (!m_qRequests.tryPop(iChunk))
+        {
+            if (++nIdleRounds < nIoIdleYields)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(nIoIdleSleepMSecs));
+            }
+            continue;
+        }
+        nIdleRounds = 0;
+
+        // m_vChunks is not modified while the thread is running
+        const ArenaChunkInfo& chunk = m_vChunks[iChunk];
+        uint64_t nBytesRead = 0;
+        const bool bSuccess = prefetchFile(chunk.m_sFilename, vBuffer, nBytesRead) &&
+            (chunk.m_sLightmapFilename.empty() || prefetchFile(chunk.m_sLightmapFilename, vBuffer, nBytesRead));
+        m_nBytesPrefetched.fetch_add(nBytesRead, std::memory_order_relaxed);
+
+        // completions are drained by every update(), so this waits at most for a frame
+        const Completion completion = { iChunk, bSuccess };
+        while (m_bRunning && !m_qCompletions.tryPush(completion))
+        {
+            std::this_thread::yield();
+        }
+    }
+} // runIo()
@@ -0,0 +1,135 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailChunkStreamer.h
+    Streaming arena chunks in and out around a focus point, within a memory budget.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "ElteFailArenaChunker.h"
+#include "ElteFailSpscQueue.h"
+
+namespace elte_fail
+{
+
+    enum class ChunkState
+    {
+        Unloaded,
+        Requested,    /**< Waiting for the I/O thread. */
+        Prefetched,   /**< Files have been read by the I/O thread, chunk can be loaded without waiting for the disk. */
+        Resident,     /**< Loaded by the load function. */
+        Failed        /**< Reading or loading failed, not retried. */
+    };
+
+    /**
+        Counters of ChunkStreamer, updated by ChunkStreamer::update().
+    */
+    struct ChunkStreamerStats
+    {
+        uint32_t m_nChunks;
+        uint32_t m_nResident;
+        uint32_t m_nPending;           /**< Chunks requested from or prefetched by the I/O thread, but not yet resident. */
+        uint32_t m_nFailed;
+        size_t m_nResidentBytes;       /**< Estimated memory of resident chunks, never more than m_nBudgetBytes. */
+        size_t m_nBudgetBytes;
+        uint64_t m_nLoads;
+        uint64_t m_nUnloads;           /**< Chunks unloaded because they got farther than the unload radius. */
+        uint64_t m_nEvictions;         /**< Chunks unloaded within the unload radius to make room for nearer chunks. */
+        uint64_t m_nBytesPrefetched;   /**< Bytes read by the I/O thread. */
+    };
+
+    /**
+        Keeps the chunks around a focus point resident, calling the given load and unload functions on the thread calling update().
+        Chunks are wanted if their bounds are within the load radius of the focus point in the XY plane, nearest first, as long as
+        their estimated memory fits the budget. A resident chunk is unloaded when it gets farther than the unload radius, or when
+        a nearer wanted chunk needs its memory. Unload radius should be bigger than load radius, so chunks on the border don't keep
+        getting loaded and unloaded.
+        Reading chunk files is done by a background I/O thread, so the load function finds the files in the OS file cache instead
+        of waiting for the disk. At most nMaxLoadsPerUpdate chunks are loaded by an update(), to keep frame times even.
+    */
+    class ChunkStreamer
+    {
+    public:
+        static const size_t nQueueCapacity = 256;       /**< Requests per queue, must be power of 2. */
+        static const uint32_t nMaxLoadsPerUpdate = 1;
+
+        /**
+            @return False if the chunk could not be loaded, in that case it won't be tried again.
+        */
+        using TLoadFn = std::function<bool(uint32_t iChunk, const ArenaChunkInfo& chunk)>;
+        using TUnloadFn = std::function<void(uint32_t iChunk, const ArenaChunkInfo& chunk)>;
+
+        ChunkStreamer();
+        ~ChunkStreamer();
+
+        /**
+            Starts the I/O thread. Nothing is loaded until the first update().
+        */
+        bool start(
+            const std::vector<ArenaChunkInfo>& vChunks,
+            size_t nBudgetBytes,
+            float fLoadRadius,
+            float fUnloadRadius,
+            const TLoadFn& fnLoad,
+            const TUnloadFn& fnUnload);
+
+        /**
+            Stops the I/O thread and unloads all resident chunks.
+        */
+        void stop();
+
+        bool isStarted() const;
+
+        /**
+            Processes finished prefetches, then unloads and loads chunks according to the given focus point.
+            Must be called from the same thread as start() and stop().
+        */
+        void update(float fFocusX, float fFocusY);
+
+        ChunkState getState(uint32_t iChunk) const;
+        ChunkStreamerStats getStats() const;
+
+    private:
+
+        struct Completion
+        {
+            uint32_t m_iChunk;
+            bool m_bSuccess;
+        };
+
+        static float getDistance(const Aabb& bounds, float fX, float fY);  /**< Distance of the point from the bounds in the XY plane. */
+
+        SpscQueue<uint32_t, nQueueCapacity> m_qRequests;
+        SpscQueue<Completion, nQueueCapacity> m_qCompletions;
+
+        std::vector<ArenaChunkInfo> m_vChunks;
+        std::vector<ChunkState> m_vStates;
+        std::vector<float> m_vDistances;      /**< Distance of chunks from the last focus point. */
+        TLoadFn m_fnLoad;
+        TUnloadFn m_fnUnload;
+        float m_fLoadRadius;
+        float m_fUnloadRadius;
+        ChunkStreamerStats m_stats;
+
+        std::thread m_ioThread;
+        std::atomic<bool> m_bRunning;
+        std::atomic<uint64_t> m_nBytesPrefetched;
+
+        // ---------------------------------------------------------------------------
+
+        ChunkStreamer(const ChunkStreamer&);
+        ChunkStreamer& operator=(const ChunkStreamer&);
+
+        void unload(uint32_t iChunk);
+        void runIo();
+    }; // class ChunkStreamer
+
+} // namespace elte_fail
@@ -0,0 +1,364 @@
+/*
+    ###################################################################################
+    ElteFailCollisionWorld.cpp
+    Static collision geometry of ELTE-FAIL, for clamping player movement.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailCollisionWorld.h"
+
+#include <algorithm>
+#include <cfloat>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define ELTE_FAIL_COLLISION_SSE
+#include <xmmintrin.h>
+#endif
+
+#include "ElteFailObjFile.h"
+
+static const size_t nMaxTraversalDepth = 64;  /**< Median split keeps depth around log2(boxes / nBoxesPerLeaf), this is plenty. */
+
+static elte_fail::Aabb getEmptyAabb()
+{
+    return { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+}
+
+static void extendAabb(elte_fail::Aabb& box, const elte_fail::Aabb& other)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        box.m_fMin[i] = std::min(box.m_fMin[i], other.m_fMin[i]);
+        box.m_fMax[i] = std::max(box.m_fMax[i], other.m_fMax[i]);
+    }
+}
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::CollisionWorld::CollisionWorld() :
+    m_nDepth(0)
+{
+
+} // CollisionWorld()
+
+
+bool elte_fail::CollisionWorld::buildFromObj(const ObjFile& obj, float fScaling, float fPosX, float fPosY, float fPosZ)
+{
+    std::vector<Aabb> vBoxes;
+    for (const auto& group : obj.getGroups())
+    {
+        if (group.m_sName.find('|') == std::string::npos)
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i + 2 < group.m_vCorners.size(); i += 3)
+        {
+            Aabb box = getEmptyAabb();
+            for (size_t j = i; j < i + 3; j++)
+            {
+                const ObjVertex& v = obj.getPositions()[group.m_vCorners[j].m_iPosition];
+                const Aabb point = {
+                    { v.m_fX * fScaling + fPosX, v.m_fY * fScaling + fPosY, v.m_fZ * fScaling + fPosZ },
+                    { v.m_fX * fScaling + fPosX, v.m_fY * fScaling + fPosY, v.m_fZ * fScaling + fPosZ } };
+                extendAabb(box, point);
+            }
+            vBoxes.push_back(box);
+        }
+    }
+
+    build(vBoxes);
+    return !isEmpty();
+} // buildFromObj()
+
+
+void elte_fail::CollisionWorld::build(const std::vector<Aabb>& vBoxes)
+{
+    clear();
+    if (vBoxes.empty())
+    {
+        return;
+    }
+
+    m_vBoxes = vBoxes;
+    m_vNodes.reserve(2 * (vBoxes.size() / nBoxesPerLeaf + 1));
+    m_vLeaves.reserve(vBoxes.size() / nBoxesPerLeaf + 1);
+
+    std::vector<uint32_t> vBoxIndices(vBoxes.size());
+    for (size_t i = 0; i < vBoxIndices.size(); i++)
+    {
+        vBoxIndices[i] = static_cast<uint32_t>(i);
+    }
+    buildNode(vBoxIndices, 0, vBoxIndices.size(), 1);
+} // build()
+
+
+void elte_fail::CollisionWorld::clear()
+{
+    m_vBoxes.clear();
+    m_vNodes.clear();
+    m_vLeaves.clear();
+    m_nDepth = 0;
+} // clear()
+
+
+bool elte_fail::CollisionWorld::isEmpty() const
+{
+    return m_vBoxes.empty();
+} // isEmpty()
+
+
+size_t elte_fail::CollisionWorld::getBoxCount() const
+{
+    return m_vBoxes.size();
+} // getBoxCount()
+
+
+size_t elte_fail::CollisionWorld::getNodeCount() const
+{
+    return m_vNodes.size();
+} // getNodeCount()
+
+
+size_t elte_fail::CollisionWorld::getDepth() const
+{
+    return m_nDepth;
+} // getDepth()
+
+
+const elte_fail::Aabb& elte_fail::CollisionWorld::getBounds() const
+{
+    return m_vNodes[0].m_bounds;
+} // getBounds()
+
+
+bool elte_fail::CollisionWorld::intersects(const Aabb& box, CollisionQueryMode mode) const
+{
+    bool bRet = false;
+    query(box, mode, [&bRet](const Aabb&) { bRet = true; });
+    return bRet;
+} // intersects()
+
+
+uint32_t elte_fail::CollisionWorld::clampMove(const Aabb& box, float& fDx, float& fDy, CollisionQueryMode mode) const
+{
+    uint32_t nTested = 0;
+    fDx = clampAxis(box, 0, fDx, mode, nTested);
+
+    Aabb boxMovedX = box;
+    boxMovedX.m_fMin[0] += fDx;
+    boxMovedX.m_fMax[0] += fDx;
+    fDy = clampAxis(boxMovedX, 1, fDy, mode, nTested);
+
+    return nTested;
+} // clampMove()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+unsigned int elte_fail::CollisionWorld::testLeaf(const Leaf& leaf, const Aabb& box)
+{
+#ifdef ELTE_FAIL_COLLISION_SSE
+    const __m128 x = _mm_and_ps(
+        _mm_cmplt_ps(_mm_load_ps(leaf.m_fMinX), _mm_set1_ps(box.m_fMax[0])),
+        _mm_cmpgt_ps(_mm_load_ps(leaf.m_fMaxX), _mm_set1_ps(box.m_fMin[0])));
+    const __m128 y = _mm_and_ps(
+        _mm_cmplt_ps(_mm_load_ps(leaf.m_fMinY), _mm_set1_ps(box.m_fMax[1])),
+        _mm_cmpgt_ps(_mm_load_ps(leaf.m_fMaxY), _mm_set1_ps(box.m_fMin[1])));
+    const __m128 z = _mm_and_ps(
+        _mm_cmplt_ps(_mm_load_ps(leaf.m_fMinZ), _mm_set1_ps(box.m_fMax[2])),
+        _mm_cmpgt_ps(_mm_load_ps(leaf.m_fMaxZ), _mm_set1_ps(box.m_fMin[2])));
+    return static_cast<unsigned int>(_mm_movemask_ps(_mm_and_ps(_mm_and_ps(x, y), z)));
+#else
+    unsigned int nMask = 0;
+    for (size_t i = 0; i < nBoxesPerLeaf; i++)
+    {
+        if ((leaf.m_fMinX[i] < box.m_fMax[0]) && (leaf.m_fMaxX[i] > box.m_fMin[0]) &&
+            (leaf.m_fMinY[i] < box.m_fMax[1]) && (leaf.m_fMaxY[i] > box.m_fMin[1]) &&
+            (leaf.m_fMinZ[i] < box.m_fMax[2]) && (leaf.m_fMaxZ[i] > box.m_fMin[2]))
+        {
+            nMask |= (1u << i);
+        }
+    }
+    return nMask;
+#endif
+} // testLeaf()
+
+
+uint32_t elte_fail::CollisionWorld::buildNode(std::vector<uint32_t>& vBoxIndices, size_t iFirst, size_t nCount, size_t nDepth)
+{
+    m_nDepth = std::max(m_nDepth, nDepth);
+
+    const uint32_t iNode = static_cast<uint32_t>(m_vNodes.size());
+    m_vNodes.push_back(Node());
+
+    Aabb bounds = getEmptyAabb();
+    Aabb centroidBounds = getEmptyAabb();
+    for (size_t i = iFirst; i < iFirst + nCount; i++)
+    {
+        const Aabb& box = m_vBoxes[vBoxIndices[i]];
+        extendAabb(bounds, box);
+        const Aabb centroid = {
+            { (box.m_fMin[0] + box.m_fMax[0]) / 2, (box.m_fMin[1] + box.m_fMax[1]) / 2, (box.m_fMin[2] + box.m_fMax[2]) / 2 },
+            { (box.m_fMin[0] + box.m_fMax[0]) / 2, (box.m_fMin[1] + box.m_fMax[1]) / 2, (box.m_fMin[2] + box.m_fMax[2]) / 2 } };
+        extendAabb(centroidBounds, centroid);
+    }
+    m_vNodes[iNode].m_bounds = bounds;
+
+    if (nCount <= nBoxesPerLeaf)
+    {
+        Leaf leaf;
+        for (size_t i = 0; i < nBoxesPerLeaf; i++)
+        {
+            const Aabb box = (i < nCount) ? m_vBoxes[vBoxIndices[iFirst + i]] : getEmptyAabb();
+            leaf.m_fMinX[i] = box.m_fMin[0];
+            leaf.m_fMinY[i] = box.m_fMin[1];
+            leaf.m_fMinZ[i] = box.m_fMin[2];
+            leaf.m_fMaxX[i] = box.m_fMax[0];
+            leaf.m_fMaxY[i] = box.m_fMax[1];
+            leaf.m_fMaxZ[i] = box.m_fMax[2];
+            leaf.m_iBox[i] = (i < nCount) ? vBoxIndices[iFirst + i] : 0;
+        }
+        m_vNodes[iNode].m_bLeaf = true;
+        m_vNodes[iNode].m_iRightOrLeaf = static_cast<uint32_t>(m_vLeaves.size());
+        m_vLeaves.push_back(leaf);
+        return iNode;
+    }
+
+    // median split along the longest axis of box centers
+    int iAxis = 0;
+    for (int i = 1; i < 3; i++)
+    {
+        if (centroidBounds.m_fMax[i] - centroidBounds.m_fMin[i] > centroidBounds.m_fMax[iAxis] - centroidBounds.m_fMin[iAxis])
+        {
+            iAxis = i;
+        }
+    }
+
+    const size_t nLeftCount = nCount / 2;
+    std::nth_element(
+        vBoxIndices.begin() + iFirst,
+        vBoxIndices.begin() + iFirst + nLeftCount,
+        vBoxIndices.begin() + iFirst + nCount,
+        [this, iAxis](uint32_t a, uint32_t b)
+        {
+            return (m_vBoxes[a].m_fMin[iAxis] + m_vBoxes[a].m_fMax[iAxis]) < (m_vBoxes[b].m_fMin[iAxis] + m_vBoxes[b].m_fMax[iAxis]);
+        });
+
+    buildNode(vBoxIndices, iFirst, nLeftCount, nDepth + 1);  // left child is always the next node
+    const uint32_t iRight = buildNode(vBoxIndices, iFirst + nLeftCount, nCount - nLeftCount, nDepth + 1);
+    m_vNodes[iNode].m_bLeaf = false;
+    m_vNodes[iNode].m_iRightOrLeaf = iRight;
+    return iNode;
+} // buildNode()
+
+
+template <class F>
+uint32_t elte_fail::CollisionWorld::query(const Aabb& box, CollisionQueryMode mode, F&& fnOnOverlap) const
+{
+    uint32_t nTested = 0;
+    if (isEmpty())
+    {
+        return nTested;
+    }
+
+    if (mode == CollisionQueryMode::BruteForce)
+    {
+        for (const auto& other : m_vBoxes)
+        {
+            if (other.overlaps(box))
+            {
+                fnOnOverlap(other);
+            }
+        }
+        return static_cast<uint32_t>(m_vBoxes.size());
+    }
+
+    uint32_t stack[nMaxTraversalDepth];
+    size_t nStack = 0;
+    stack[nStack++] = 0;
+    while (nStack > 0)
+    {
+        const Node& node = m_vNodes[stack[--nStack]];
+        if (!node.m_bounds.overlaps(box))
+        {
+            continue;
+        }
+
+        if (node.m_bLeaf)
+        {
+            const Leaf& leaf = m_vLeaves[node.m_iRightOrLeaf];
+            nTested += nBoxesPerLeaf;
+            for (unsigned int nMask = testLeaf(leaf, box); nMask != 0; nMask &= nMask - 1)
+            {
+                unsigned int i = 0;
+                while (((nMask >> i) & 1u) == 0)
+                {
+                    i++;
+                }
+                fnOnOverlap(m_vBoxes[leaf.m_iBox[i]]);
+            }
+        }
+        else
+        {
+            const uint32_t iNode = static_cast<uint32_t>(&node - m_vNodes.data());
+            stack[nStack++] = node.m_iRightOrLeaf;
+            stack[nStack++] = iNode + 1;
+        }
+    }
+    return nTested;
+} // query()
+
+
+float elte_fail::CollisionWorld::clampAxis(const Aabb& box, int iAxis, float fDelta, CollisionQueryMode mode, uint32_t& nTested) const
+{
+    if (fDelta == 0.f)
+    {
+        return fDelta;
+    }
+
+    Aabb boxSwept = box;
+    if (fDelta > 0.f)
+    {
+        boxSwept.m_fMax[iAxis] += fDelta;
+    }
+    else
+    {
+        boxSwept.m_fMin[iAxis] += fDelta;
+    }
+
+    nTested += query(boxSwept, mode, [&](const Aabb& other)
+        {
+            if (other.overlaps(box))
+            {
+                // already inside, let it move out
+                return;
+            }
+
+            if (fDelta > 0.f)
+            {
+                const float fDistance = other.m_fMin[iAxis] - box.m_fMax[iAxis];
+                if ((fDistance >= 0.f) && (fDistance < fDelta))
+                {
+                    fDelta = fDistance;
+                }
+            }
+            else
+            {
+                const float fDistance = other.m_fMax[iAxis] - box.m_fMin[iAxis];
+                if ((fDistance <= 0.f) && (fDistance > fDelta))
+                {
+                    fDelta = fDistance;
+                }
+            }
+        });
+
+    return fDelta;
+} // clampAxis()
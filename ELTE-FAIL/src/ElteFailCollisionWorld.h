@@ -0,0 +1,121 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailCollisionWorld.h
+    Static collision geometry of ELTE-FAIL, for clamping player movement.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace elte_fail
+{
+
+    class ObjFile;
+
+    struct Aabb
+    {
+        float m_fMin[3];
+        float m_fMax[3];
+
+        /**
+            Touching boxes do not overlap, so a box resting on a floor can still slide along it.
+        */
+        bool overlaps(const Aabb& other) const
+        {
+            return (m_fMin[0] < other.m_fMax[0]) && (m_fMax[0] > other.m_fMin[0]) &&
+                (m_fMin[1] < other.m_fMax[1]) && (m_fMax[1] > other.m_fMin[1]) &&
+                (m_fMin[2] < other.m_fMax[2]) && (m_fMax[2] > other.m_fMin[2]);
+        }
+    };
+
+    enum class CollisionQueryMode
+    {
+        Bvh,          /**< Normal mode: traversing the BVH, cost is logarithmic in world size. */
+        BruteForce    /**< Testing against every box, only for verification and benchmarking. */
+    };
+
+    /**
+        Static world of axis-aligned boxes in a bounding volume hierarchy, built once after loading the map.
+        Leaves hold up to 4 boxes in SoA layout, so a leaf is tested against the query box with a single SIMD comparison per axis.
+    */
+    class CollisionWorld
+    {
+    public:
+        static const size_t nBoxesPerLeaf = 4;
+
+        CollisionWorld();
+
+        /**
+            Builds the world from the triangles of the solid groups of the given model, each triangle becoming a box.
+            Solid groups are map brushes, named as "<name>|<texture>", e.g. "b_fal01|brick02.bmp";
+            other groups (items, spawnpoints, etc.) are just markers.
+            Vertices are transformed the same way as Pure transforms the rendered object: scaled first, then translated.
+        */
+        bool buildFromObj(const ObjFile& obj, float fScaling, float fPosX, float fPosY, float fPosZ);
+
+        void build(const std::vector<Aabb>& vBoxes);
+        void clear();
+
+        bool isEmpty() const;
+        size_t getBoxCount() const;
+        size_t getNodeCount() const;
+        size_t getDepth() const;
+        const Aabb& getBounds() const;  /**< Bounds of all boxes, valid only if not empty. */
+
+        /**
+            @return True if the given box overlaps any box of the world.
+        */
+        bool intersects(const Aabb& box, CollisionQueryMode mode = CollisionQueryMode::Bvh) const;
+
+        /**
+            Moves the given box by (fDx, fDy) in the XY plane, first along X then along Y, stopping at the first box in the way.
+            Boxes already overlapping the moved box don't block, so a box stuck in a wall can get out.
+
+            @return Number of candidate boxes tested by the query.
+        */
+        uint32_t clampMove(const Aabb& box, float& fDx, float& fDy, CollisionQueryMode mode = CollisionQueryMode::Bvh) const;
+
+    private:
+
+        struct Node
+        {
+            Aabb m_bounds;
+            uint32_t m_iRightOrLeaf;   /**< Inner node: index of right child (left child is the next node). Leaf: index into m_vLeaves. */
+            bool m_bLeaf;
+        };
+
+        /** Up to 4 boxes, unused slots are empty (inverted) boxes which never overlap anything. */
+        struct alignas(16) Leaf
+        {
+            float m_fMinX[nBoxesPerLeaf];
+            float m_fMinY[nBoxesPerLeaf];
+            float m_fMinZ[nBoxesPerLeaf];
+            float m_fMaxX[nBoxesPerLeaf];
+            float m_fMaxY[nBoxesPerLeaf];
+            float m_fMaxZ[nBoxesPerLeaf];
+            uint32_t m_iBox[nBoxesPerLeaf];
+        };
+
+        std::vector<Aabb> m_vBoxes;
+        std::vector<Node> m_vNodes;
+        std::vector<Leaf> m_vLeaves;
+        size_t m_nDepth;
+
+        // ---------------------------------------------------------------------------
+
+        static unsigned int testLeaf(const Leaf& leaf, const Aabb& box);  /**< @return Bitmask of the leaf boxes overlapping the given box. */
+
+        uint32_t buildNode(std::vector<uint32_t>& vBoxIndices, size_t iFirst, size_t nCount, size_t nDepth);
+
+        template <class F>
+        uint32_t query(const Aabb& box, CollisionQueryMode mode, F&& fnOnOverlap) const;
+
+        float clampAxis(const Aabb& box, int iAxis, float fDelta, CollisionQueryMode mode, uint32_t& nTested) const;
+    }; // class CollisionWorld
+
+} // namespace elte_fail
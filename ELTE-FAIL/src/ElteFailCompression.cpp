@@ -0,0 +1,183 @@
+/*
+    ###################################################################################
+    ElteFailCompression.cpp
+    Lightweight LZ77-style compression for network payloads and files of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailCompression.h"
+
+#include <array>
+#include <cstring>
+
+
+static const size_t   nMinMatchLength    = 4;
+static const size_t   nLastLiterals      = 5;       /**< Last bytes are always literals, as in LZ4 block format. */
+static const size_t   nMatchSearchLimit  = 12;      /**< No match can start this close to the end, as in LZ4 block format. */
+static const size_t   nMaxMatchOffset    = 65535;
+static const unsigned nHashTableLog2     = 12;
+static const int32_t  nInvalidPos        = -1;
+
+static uint32_t read32(const uint8_t* p)
+{
+    uint32_t n;
+    memcpy(&n, p, sizeof(n));
+    return n;
+}
+
+static void writeLength(std::vector<uint8_t>& vDst, size_t nLength)
+{
+    // only the part above 15 which didn't fit into the token
+    while (nLength >= 255)
+    {
+        vDst.push_back(255);
+        nLength -= 255;
+    }
+    vDst.push_back(static_cast<uint8_t>(nLength));
+}
+
+static bool readLength(const uint8_t* pSrc, size_t nSrcLength, size_t& iSrc, size_t& nLength)
+{
+    uint8_t nByte;
+    do
+    {
+        if (iSrc >= nSrcLength)
+        {
+            return false;
+        }
+        nByte = pSrc[iSrc++];
+        nLength += nByte;
+    } while (nByte == 255);
+    return true;
+}
+
+static void writeSequence(std::vector<uint8_t>& vDst, const uint8_t* pLiterals, size_t nLiteralLength, size_t nMatchOffset, size_t nMatchLength)
+{
+    const size_t nMatchLengthCode = (nMatchLength >= nMinMatchLength) ? (nMatchLength - nMinMatchLength) : 0;
+    const uint8_t token = static_cast<uint8_t>(
+        ((nLiteralLength >= 15 ? 15 : nLiteralLength) << 4) |
+        (nMatchLengthCode >= 15 ? 15 : nMatchLengthCode));
+    vDst.push_back(token);
+    if (nLiteralLength >= 15)
+    {
+        writeLength(vDst, nLiteralLength - 15);
+    }
+    vDst.insert(vDst.end(), pLiterals, pLiterals + nLiteralLength);
+
+    if (nMatchLength == 0)
+    {
+        // last sequence has only literals
+        return;
+    }
+
+    vDst.push_back(static_cast<uint8_t>(nMatchOffset & 0xFF));
+    vDst.push_back(static_cast<uint8_t>((nMatchOffset >> 8) & 0xFF));
+    if (nMatchLengthCode >= 15)
+    {
+        writeLength(vDst, nMatchLengthCode - 15);
+    }
+}
+
+
+// ############################### PUBLIC ################################
+
+
+size_t elte_fail::Compression::compress(const uint8_t* pSrc, size_t nSrcLength, std::vector<uint8_t>& vDst)
+{
+    const size_t nDstStartLength = vDst.size();
+
+    std::array<int32_t, 1 << nHashTableLog2> hashTable;
+    hashTable.fill(nInvalidPos);
+
+    size_t iAnchor = 0;
+    size_t iSrc = 0;
+    while (iSrc + nMatchSearchLimit < nSrcLength)
+    {
+        const uint32_t nSeq = read32(pSrc + iSrc);
+        const uint32_t iHash = (nSeq * 2654435761u) >> (32 - nHashTableLog2);
+        const int32_t iRef = hashTable[iHash];
+        hashTable[iHash] = static_cast<int32_t>(iSrc);
+
+        if ((iRef == nInvalidPos) || (iSrc - static_cast<size_t>(iRef) > nMaxMatchOffset) || (read32(pSrc + iRef) != nSeq))
+        {
+            iSrc++;
+            continue;
+        }
+
+        size_t nMatchLength = nMinMatchLength;
+        const size_t nMaxMatchLength = nSrcLength - nLastLiterals - iSrc;
+        while ((nMatchLength < nMaxMatchLength) && (pSrc[iRef + nMatchLength] == pSrc[iSrc + nMatchLength]))
+        {
+            nMatchLength++;
+        }
+
+        writeSequence(vDst, pSrc + iAnchor, iSrc - iAnchor, iSrc - iRef, nMatchLength);
+        iSrc += nMatchLength;
+        iAnchor = iSrc;
+    }
+
+    writeSequence(vDst, pSrc + iAnchor, nSrcLength - iAnchor, 0, 0);
+
+    return vDst.size() - nDstStartLength;
+} // compress()
+
+
+bool elte_fail::Compression::decompress(const uint8_t* pSrc, size_t nSrcLength, uint8_t* pDst, size_t nDstLength)
+{
+    size_t iSrc = 0;
+    size_t iDst = 0;
+    while (iSrc < nSrcLength)
+    {
+        const uint8_t token = pSrc[iSrc++];
+
+        size_t nLiteralLength = token >> 4;
+        if ((nLiteralLength == 15) && !readLength(pSrc, nSrcLength, iSrc, nLiteralLength))
+        {
+            return false;
+        }
+        if ((nLiteralLength > nSrcLength - iSrc) || (nLiteralLength > nDstLength - iDst))
+        {
+            return false;
+        }
+        memcpy(pDst + iDst, pSrc + iSrc, nLiteralLength);
+        iSrc += nLiteralLength;
+        iDst += nLiteralLength;
+
+        if (iSrc == nSrcLength)
+        {
+            // last sequence has only literals
+            break;
+        }
+
+        if (nSrcLength - iSrc < 2)
+        {
+            return false;
+        }
+        const size_t nMatchOffset = pSrc[iSrc] | (pSrc[iSrc + 1] << 8);
+        iSrc += 2;
+        if ((nMatchOffset == 0) || (nMatchOffset > iDst))
+        {
+            return false;
+        }
+
+        size_t nMatchLength = token & 0x0F;
+        if ((nMatchLength == 15) && !readLength(pSrc, nSrcLength, iSrc, nMatchLength))
+        {
+            return false;
+        }
+        nMatchLength += nMinMatchLength;
+        if (nMatchLength > nDstLength - iDst)
+        {
+            return false;
+        }
+
+        // byte by byte since source and destination might overlap
+        for (size_t i = 0; i < nMatchLength; i++, iDst++)
+        {
+            pDst[iDst] = pDst[iDst - nMatchOffset];
+        }
+    }
+
+    return iDst == nDstLength;
+} // decompress()
@@ -0,0 +1,47 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailCompression.h
+    Lightweight LZ77-style compression for network payloads and files of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace elte_fail
+{
+
+    /**
+        Byte-oriented LZ77 compressor using the LZ4 block format: sequences of literals followed by a match (2-byte offset, min length 4).
+        No entropy coding, so it is fast enough to be used in packet handlers, but it still removes zero padding and repeated
+        substrings like common path prefixes.
+        Compressed data doesn't store the uncompressed length, caller should transfer it separately.
+    */
+    class Compression
+    {
+    public:
+        /**
+            Appends the compressed form of the given data to the given vector.
+
+            @return Number of bytes appended.
+        */
+        static size_t compress(const uint8_t* pSrc, size_t nSrcLength, std::vector<uint8_t>& vDst);
+
+        /**
+            Decompresses data compressed by compress().
+
+            @param pDst       Output buffer, must be exactly as big as the uncompressed data.
+            @param nDstLength Length of the uncompressed data.
+            @return True if the whole output buffer got filled without reading or writing out of bounds, false on corrupt input.
+        */
+        static bool decompress(const uint8_t* pSrc, size_t nSrcLength, uint8_t* pDst, size_t nDstLength);
+
+    private:
+        Compression();
+    }; // class Compression
+
+} // namespace elte_fail
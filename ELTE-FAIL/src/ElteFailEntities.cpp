@@ -0,0 +1,155 @@
+/*
+    ###################################################################################
+    ElteFailEntities.cpp
+    Entity store of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailEntities.h"
+
+#include <cassert>
+
+
+// ############################### PUBLIC ################################
+
+
+const elte_fail::EntityHandle elte_fail::EntityStore::hInvalid = { 0, 0 };
+
+
+elte_fail::EntityStore::EntityStore() :
+    m_nCount(0)
+{
+
+} // EntityStore()
+
+
+elte_fail::EntityHandle elte_fail::EntityStore::create(PureObject3D& obj)
+{
+    uint32_t nIndex;
+    if (m_vFreeIndices.empty())
+    {
+        nIndex = static_cast<uint32_t>(m_vObjects.size());
+        m_vObjects.push_back(nullptr);
+        m_vGenerations.push_back(0);
+    }
+    else
+    {
+        nIndex = m_vFreeIndices.back();
+        m_vFreeIndices.pop_back();
+    }
+
+    // generation 0 is left for invalid handles
+    m_vGenerations[nIndex]++;
+    if (m_vGenerations[nIndex] == 0)
+    {
+        m_vGenerations[nIndex]++;
+    }
+    m_vObjects[nIndex] = &obj;
+    m_nCount++;
+    return { nIndex, m_vGenerations[nIndex] };
+} // create()
+
+
+bool elte_fail::EntityStore::destroy(const EntityHandle& h)
+{
+    if (!isValid(h))
+    {
+        return false;
+    }
+
+    m_spins.remove(h.m_nIndex);
+    m_toggles.remove(h.m_nIndex);
+    m_vObjects[h.m_nIndex] = nullptr;
+    // handles given out so far become stale, even before the index is reused
+    m_vGenerations[h.m_nIndex]++;
+    m_vFreeIndices.push_back(h.m_nIndex);
+    m_nCount--;
+    return true;
+} // destroy()
+
+
+void elte_fail::EntityStore::clear()
+{
+    // generations are kept, so handles given out so far stay stale
+    for (uint32_t i = 0; i < m_vObjects.size(); i++)
+    {
+        if (m_vObjects[i])
+        {
+            m_vObjects[i] = nullptr;
+            m_vGenerations[i]++;
+            m_vFreeIndices.push_back(i);
+        }
+    }
+    m_nCount = 0;
+    m_spins.clear();
+    m_toggles.clear();
+} // clear()
+
+
+bool elte_fail::EntityStore::isValid(const EntityHandle& h) const
+{
+    return (h.m_nGeneration != 0) &&
+        (h.m_nIndex < m_vObjects.size()) &&
+        (m_vGenerations[h.m_nIndex] == h.m_nGeneration) &&
+        (m_vObjects[h.m_nIndex] != nullptr);
+} // isValid()
+
+
+PureObject3D* elte_fail::EntityStore::getObject(const EntityHandle& h) const
+{
+    return isValid(h) ? m_vObjects[h.m_nIndex] : nullptr;
+} // getObject()
+
+
+PureObject3D& elte_fail::EntityStore::getObjectByIndex(uint32_t nIndex) const
+{
+    assert(m_vObjects[nIndex]);
+    return *m_vObjects[nIndex];
+} // getObjectByIndex()
+
+
+uint32_t elte_fail::EntityStore::getCount() const
+{
+    return m_nCount;
+} // getCount()
+
+
+bool elte_fail::EntityStore::setSpin(const EntityHandle& h, const SpinComponent& spin)
+{
+    if (!isValid(h))
+    {
+        return false;
+    }
+    m_spins.set(h.m_nIndex, spin);
+    return true;
+} // setSpin()
+
+
+bool elte_fail::EntityStore::setToggle(const EntityHandle& h, const ToggleComponent& toggle)
+{
+    if (!isValid(h))
+    {
+        return false;
+    }
+    m_toggles.set(h.m_nIndex, toggle);
+    return true;
+} // setToggle()
+
+
+const elte_fail::ComponentArray<elte_fail::SpinComponent>& elte_fail::EntityStore::getSpins() const
+{
+    return m_spins;
+} // getSpins()
+
+
+const elte_fail::ComponentArray<elte_fail::ToggleComponent>& elte_fail::EntityStore::getToggles() const
+{
+    return m_toggles;
+} // getToggles()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
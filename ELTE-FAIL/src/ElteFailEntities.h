@@ -0,0 +1,200 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailEntities.h
+    Entity store of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <cstdint>
+#include <vector>
+
+#include "../../../PGE/PGE/Pure/include/external/Object3D/PureObject3DManager.h"
+
+namespace elte_fail
+{
+
+    /**
+        Refers to an entity of EntityStore. A handle of a destroyed entity never becomes valid again, even if its index is
+        reused by a new entity, since the generation of the index is increased at every destroy.
+        Zero-initialized handle is invalid.
+    */
+    struct EntityHandle
+    {
+        uint32_t m_nIndex;
+        uint32_t m_nGeneration;   /**< 0 is never used by a live entity. */
+    };
+
+    /** Rotates the object around its Y axis in every frame. */
+    struct SpinComponent
+    {
+        float m_fDegPerFrame;
+    };
+
+    /** Visibility of the object is toggled by a key. */
+    struct ToggleComponent
+    {
+        unsigned char m_nKey;     /**< Virtual-key code. */
+    };
+
+    /**
+        Components of type T stored contiguously, so systems iterate over them without touching entities not having them.
+        Removed component is replaced by the last one, thus order is not kept.
+        Indexed by entity index, which must be validated by EntityStore before.
+    */
+    template <class T>
+    class ComponentArray
+    {
+    public:
+        static const uint32_t nInvalidPos = UINT32_MAX;
+
+        size_t size() const
+        {
+            return m_vComponents.size();
+        }
+
+        T& operator[](size_t i)
+        {
+            return m_vComponents[i];
+        }
+
+        const T& operator[](size_t i) const
+        {
+            return m_vComponents[i];
+        }
+
+        /**
+            @return Index of the entity owning the i-th component.
+        */
+        uint32_t getEntityIndex(size_t i) const
+        {
+            return m_vEntityIndices[i];
+        }
+
+        /**
+            @return Nullptr if the entity doesn't have this component.
+        */
+        T* find(uint32_t nEntityIndex)
+        {
+            return (nEntityIndex < m_vPosByEntity.size()) && (m_vPosByEntity[nEntityIndex] != nInvalidPos) ?
+                &m_vComponents[m_vPosByEntity[nEntityIndex]] :
+                nullptr;
+        }
+
+        /**
+            Adds the component to the entity, or overwrites it if the entity already has one.
+        */
+        void set(uint32_t nEntityIndex, const T& component)
+        {
+            T* const pExisting = find(nEntityIndex);
+            if (pExisting)
+            {
+                *pExisting = component;
+                return;
+            }
+            if (nEntityIndex >= m_vPosByEntity.size())
+            {
+                m_vPosByEntity.resize(nEntityIndex + 1, nInvalidPos);
+            }
+            m_vPosByEntity[nEntityIndex] = static_cast<uint32_t>(m_vComponents.size());
+            m_vComponents.push_back(component);
+            m_vEntityIndices.push_back(nEntityIndex);
+        }
+
+        bool remove(uint32_t nEntityIndex)
+        {
+            if ((nEntityIndex >= m_vPosByEntity.size()) || (m_vPosByEntity[nEntityIndex] == nInvalidPos))
+            {
+                return false;
+            }
+            const uint32_t iPos = m_vPosByEntity[nEntityIndex];
+            const uint32_t iLast = static_cast<uint32_t>(m_vComponents.size() - 1);
+            if (iPos != iLast)
+            {
+                m_vComponents[iPos] = m_vComponents[iLast];
+                m_vEntityIndices[iPos] = m_vEntityIndices[iLast];
+                m_vPosByEntity[m_vEntityIndices[iPos]] = iPos;
+            }
+            m_vComponents.pop_back();
+            m_vEntityIndices.pop_back();
+            m_vPosByEntity[nEntityIndex] = nInvalidPos;
+            return true;
+        }
+
+        void clear()
+        {
+            m_vComponents.clear();
+            m_vEntityIndices.clear();
+            m_vPosByEntity.clear();
+        }
+
+    private:
+        std::vector<T> m_vComponents;
+        std::vector<uint32_t> m_vEntityIndices;   /**< Same order as m_vComponents. */
+        std::vector<uint32_t> m_vPosByEntity;     /**< Index into m_vComponents by entity index, nInvalidPos if not having the component. */
+    }; // class ComponentArray
+
+    /**
+        Game entities referred to by generational handles instead of pointers or file names, so a stale handle is detected
+        instead of accessing a deleted object.
+        Every entity has an object, which is not owned by the store: destroy() doesn't delete it.
+        Other components are optional, stored in ComponentArrays, so per-frame logic iterates over the entities having them
+        in batches. Destroying an entity removes its components too.
+        Not thread-safe, must be used by the thread of the game loop only.
+    */
+    class EntityStore
+    {
+    public:
+        static const EntityHandle hInvalid;
+
+        EntityStore();
+
+        EntityHandle create(PureObject3D& obj);
+
+        /**
+            @return False if the handle is invalid or stale.
+        */
+        bool destroy(const EntityHandle& h);
+
+        void clear();
+
+        bool isValid(const EntityHandle& h) const;
+
+        /**
+            @return Nullptr if the handle is invalid or stale.
+        */
+        PureObject3D* getObject(const EntityHandle& h) const;
+
+        /**
+            For iterating over components, index must be given by ComponentArray::getEntityIndex().
+        */
+        PureObject3D& getObjectByIndex(uint32_t nIndex) const;
+
+        uint32_t getCount() const;   /**< Live entities. */
+
+        /**
+            @return False if the handle is invalid or stale.
+        */
+        bool setSpin(const EntityHandle& h, const SpinComponent& spin);
+        bool setToggle(const EntityHandle& h, const ToggleComponent& toggle);
+
+        const ComponentArray<SpinComponent>& getSpins() const;
+        const ComponentArray<ToggleComponent>& getToggles() const;
+
+    private:
+        std::vector<PureObject3D*> m_vObjects;      /**< By entity index, nullptr if index is free. */
+        std::vector<uint32_t> m_vGenerations;       /**< By entity index, generation of the live or the last destroyed entity. */
+        std::vector<uint32_t> m_vFreeIndices;
+        uint32_t m_nCount;
+        ComponentArray<SpinComponent> m_spins;
+        ComponentArray<ToggleComponent> m_toggles;
+
+        // ---------------------------------------------------------------------------
+
+        EntityStore(const EntityStore&);
+        EntityStore& operator=(const EntityStore&);
+    }; // class EntityStore
+
+} // namespace elte_fail
@@ -0,0 +1,132 @@
+/*
+    ###################################################################################
+    ElteFailFileUtils.cpp
+    File helpers for ELTE-FAIL: modification times and read-only memory mapping.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailFileUtils.h"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "../../../PFL/PFL/winproof88.h"
+
+
+// ############################### PUBLIC ################################
+
+
+bool elte_fail::FileUtils::getModificationTime(const std::string& sFilename, time_t& time)
+{
+    struct stat fileStat;
+    if (stat(sFilename.c_str(), &fileStat) != 0)
+    {
+        return false;
+    }
+    time = fileStat.st_mtime;
+    return true;
+} // getModificationTime()
+
+
+bool elte_fail::FileUtils::isUpToDate(const std::string& sGeneratedFilename, const std::string& sSourceFilename)
+{
+    time_t timeGenerated;
+    time_t timeSource;
+    if (!getModificationTime(sGeneratedFilename, timeGenerated) || !getModificationTime(sSourceFilename, timeSource))
+    {
+        return false;
+    }
+    return timeGenerated >= timeSource;
+} // isUpToDate()
+
+
+elte_fail::MappedFile::MappedFile() :
+    m_hFile(INVALID_HANDLE_VALUE),
+    m_hMapping(NULL),
+    m_pData(nullptr),
+    m_nSize(0)
+{
+
+} // MappedFile()
+
+
+elte_fail::MappedFile::~MappedFile()
+{
+    close();
+} // ~MappedFile()
+
+
+bool elte_fail::MappedFile::open(const std::string& sFilename)
+{
+    close();
+
+    m_hFile = CreateFileA(sFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_hFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER nFileSize;
+    if (!GetFileSizeEx(m_hFile, &nFileSize) || (nFileSize.QuadPart <= 0))
+    {
+        // empty file cannot be mapped
+        close();
+        return false;
+    }
+
+    m_hMapping = CreateFileMappingA(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_hMapping == NULL)
+    {
+        close();
+        return false;
+    }
+
+    m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_pData)
+    {
+        close();
+        return false;
+    }
+    m_nSize = static_cast<size_t>(nFileSize.QuadPart);
+    return true;
+} // open()
+
+
+void elte_fail::MappedFile::close()
+{
+    if (m_pData)
+    {
+        UnmapViewOfFile(m_pData);
+        m_pData = nullptr;
+    }
+    if (m_hMapping != NULL)
+    {
+        CloseHandle(m_hMapping);
+        m_hMapping = NULL;
+    }
+    if (m_hFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_hFile);
+        m_hFile = INVALID_HANDLE_VALUE;
+    }
+    m_nSize = 0;
+} // close()
+
+
+bool elte_fail::MappedFile::isOpen() const
+{
+    return m_pData != nullptr;
+} // isOpen()
+
+
+const uint8_t* elte_fail::MappedFile::getData() const
+{
+    return m_pData;
+} // getData()
+
+
+size_t elte_fail::MappedFile::getSize() const
+{
+    return m_nSize;
+} // getSize()
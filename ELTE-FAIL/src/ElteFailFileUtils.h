@@ -0,0 +1,69 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailFileUtils.h
+    File helpers for ELTE-FAIL: modification times and read-only memory mapping.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+namespace elte_fail
+{
+
+    class FileUtils
+    {
+    public:
+        /**
+            @return False if the file doesn't exist.
+        */
+        static bool getModificationTime(const std::string& sFilename, time_t& time);
+
+        /**
+            @return True if the generated file exists and is not older than the source file it was generated from.
+        */
+        static bool isUpToDate(const std::string& sGeneratedFilename, const std::string& sSourceFilename);
+
+    private:
+        FileUtils();
+    }; // class FileUtils
+
+    /**
+        Whole file mapped read-only into memory. Pages are read by the OS on first access and shared by all processes
+        mapping the same file, so big read-only data doesn't need to be read and copied into the heap.
+    */
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        /**
+            @return False if the file cannot be opened or is empty.
+        */
+        bool open(const std::string& sFilename);
+
+        void close();
+
+        bool isOpen() const;
+        const uint8_t* getData() const;   /**< Valid until close(). */
+        size_t getSize() const;
+
+    private:
+        void* m_hFile;
+        void* m_hMapping;
+        const uint8_t* m_pData;
+        size_t m_nSize;
+
+        // ---------------------------------------------------------------------------
+
+        MappedFile(const MappedFile&);
+        MappedFile& operator=(const MappedFile&);
+    }; // class MappedFile
+
+} // namespace elte_fail
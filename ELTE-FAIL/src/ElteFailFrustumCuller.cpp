@@ -0,0 +1,215 @@
+/*
+    ###################################################################################
+    ElteFailFrustumCuller.cpp
+    View frustum culling of the top-level objects of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailFrustumCuller.h"
+
+#include <cmath>
+
+struct Vec3
+{
+    float x;
+    float y;
+    float z;
+};
+
+static Vec3 add(const Vec3& a, const Vec3& b, float fScaleB)
+{
+    return { a.x + b.x * fScaleB, a.y + b.y * fScaleB, a.z + b.z * fScaleB };
+}
+
+static float dot(const Vec3& a, const Vec3& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static Vec3 cross(const Vec3& a, const Vec3& b)
+{
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+static Vec3 normalize(const Vec3& v)
+{
+    const float fLength = std::sqrt(dot(v, v));
+    return (fLength > 0.f) ? Vec3{ v.x / fLength, v.y / fLength, v.z / fLength } : v;
+}
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::FrustumCuller::FrustumCuller() :
+    m_planes{},
+    m_stats{},
+    m_bEnabled(true)
+{
+
+} // FrustumCuller()
+
+
+void elte_fail::FrustumCuller::setEnabled(bool bEnabled)
+{
+    m_bEnabled = bEnabled;
+} // setEnabled()
+
+
+bool elte_fail::FrustumCuller::isEnabled() const
+{
+    return m_bEnabled;
+} // isEnabled()
+
+
+void elte_fail::FrustumCuller::setHidden(PureObject3D& obj, bool bHidden)
+{
+    if (bHidden)
+    {
+        m_hiddenObjects.insert(&obj);
+        obj.SetRenderingAllowed(false);
+    }
+    else
+    {
+        // rendering flag will be set by next update()
+        m_hiddenObjects.erase(&obj);
+    }
+} // setHidden()
+
+
+bool elte_fail::FrustumCuller::isHidden(const PureObject3D& obj) const
+{
+    return m_hiddenObjects.find(&obj) != m_hiddenObjects.end();
+} // isHidden()
+
+
+void elte_fail::FrustumCuller::forget(const PureObject3D& obj)
+{
+    m_hiddenObjects.erase(&obj);
+    m_bounds.erase(&obj);
+} // forget()
+
+
+void elte_fail::FrustumCuller::setBounds(const PureObject3D& obj, const Aabb& bounds)
+{
+    m_bounds[&obj] = bounds;
+} // setBounds()
+
+
+void elte_fail::FrustumCuller::update(PureCamera& camera, float fAspectRatio, PureObject3DManager& objectManager)
+{
+    m_stats = {};
+    buildFrustum(camera, fAspectRatio);
+
+    for (TPureInt i = 0; i < objectManager.getSize(); i++)
+    {
+        PureObject3D* const obj = (PureObject3D*)objectManager.getAttachedAt(i);
+        if (!obj)
+        {
+            continue;
+        }
+
+        if (isHidden(*obj))
+        {
+            m_stats.m_nHidden++;
+            continue;
+        }
+
+        bool bVisible = true;
+        if (m_bEnabled)
+        {
+            m_stats.m_nTested++;
+            const auto itBounds = m_bounds.find(obj);
+            if (itBounds != m_bounds.end())
+            {
+                const Aabb& box = itBounds->second;
+                const Vec3 halfSize = {
+                    (box.m_fMax[0] - box.m_fMin[0]) / 2.f, (box.m_fMax[1] - box.m_fMin[1]) / 2.f, (box.m_fMax[2] - box.m_fMin[2]) / 2.f };
+                bVisible = isSphereInFrustum(
+                    box.m_fMin[0] + halfSize.x, box.m_fMin[1] + halfSize.y, box.m_fMin[2] + halfSize.z, std::sqrt(dot(halfSize, halfSize)));
+            }
+            else
+            {
+                // Models are not necessarily centered around their origin, so the whole diagonal is used as radius instead of
+                // half of it: this way the sphere contains the object even if the origin is at a corner of the bounding box.
+                const PureVector& size = obj->getScaledSizeVec();
+                const float fRadius = std::sqrt(size.getX() * size.getX() + size.getY() * size.getY() + size.getZ() * size.getZ());
+                bVisible = isSphereInFrustum(obj->getPosVec().getX(), obj->getPosVec().getY(), obj->getPosVec().getZ(), fRadius);
+            }
+        }
+
+        if (bVisible)
+        {
+            m_stats.m_nDrawn++;
+        }
+        else
+        {
+            m_stats.m_nCulled++;
+        }
+        if (obj->isRenderingAllowed() != bVisible)
+        {
+            obj->SetRenderingAllowed(bVisible);
+        }
+    }
+} // update()
+
+
+const elte_fail::FrustumCullerStats& elte_fail::FrustumCuller::getStats() const
+{
+    return m_stats;
+} // getStats()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+void elte_fail::FrustumCuller::buildFrustum(PureCamera& camera, float fAspectRatio)
+{
+    const Vec3 pos = { camera.getPosVec().getX(), camera.getPosVec().getY(), camera.getPosVec().getZ() };
+    const Vec3 target = { camera.getTargetVec().getX(), camera.getTargetVec().getY(), camera.getTargetVec().getZ() };
+    const Vec3 upHint = { camera.getUpVec().getX(), camera.getUpVec().getY(), camera.getUpVec().getZ() };
+
+    const Vec3 forward = normalize(add(target, pos, -1.f));
+    const Vec3 right = normalize(cross(forward, upHint));
+    const Vec3 up = cross(right, forward);
+
+    // field of view is vertical, in degrees
+    const float fHalfV = std::tan(camera.getFieldOfView() * 3.14159265f / 360.f);
+    const float fHalfH = fHalfV * fAspectRatio;
+
+    // side planes go through the camera position, their normals point inside
+    const Vec3 left = { -right.x, -right.y, -right.z };
+    const Vec3 down = { -up.x, -up.y, -up.z };
+    const Vec3 normals[4] = {
+        normalize(add(right, forward, fHalfH)),   // left plane
+        normalize(add(left, forward, fHalfH)),    // right plane
+        normalize(add(up, forward, fHalfV)),      // bottom plane
+        normalize(add(down, forward, fHalfV))     // top plane
+    };
+    for (size_t i = 0; i < 4; i++)
+    {
+        m_planes[i] = { normals[i].x, normals[i].y, normals[i].z, -dot(normals[i], pos) };
+    }
+
+    const Vec3 nearPoint = add(pos, forward, camera.getNearPlane());
+    const Vec3 farPoint = add(pos, forward, camera.getFarPlane());
+    m_planes[4] = { forward.x, forward.y, forward.z, -dot(forward, nearPoint) };
+    m_planes[5] = { -forward.x, -forward.y, -forward.z, dot(forward, farPoint) };
+} // buildFrustum()
+
+
+bool elte_fail::FrustumCuller::isSphereInFrustum(float fX, float fY, float fZ, float fRadius) const
+{
+    for (const auto& plane : m_planes)
+    {
+        if (plane.m_fA * fX + plane.m_fB * fY + plane.m_fC * fZ + plane.m_fD < -fRadius)
+        {
+            return false;
+        }
+    }
+    return true;
+} // isSphereInFrustum()
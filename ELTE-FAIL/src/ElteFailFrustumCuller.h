@@ -0,0 +1,92 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailFrustumCuller.h
+    View frustum culling of the top-level objects of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <set>
+
+#include "../../../PGE/PGE/Pure/include/external/PureCamera.h"
+#include "../../../PGE/PGE/Pure/include/external/Object3D/PureObject3DManager.h"
+
+#include "ElteFailCollisionWorld.h"
+
+namespace elte_fail
+{
+
+    /**
+        Counters of the last FrustumCuller::update().
+    */
+    struct FrustumCullerStats
+    {
+        uint32_t m_nTested;   /**< Objects tested against the frustum. */
+        uint32_t m_nCulled;   /**< Objects outside the frustum, not rendered. */
+        uint32_t m_nDrawn;    /**< Objects inside the frustum, rendered. */
+        uint32_t m_nHidden;   /**< Objects hidden by the game, not tested. */
+    };
+
+    /**
+        Decides every frame which top-level objects of the object manager are rendered, by testing their bounding spheres against
+        the view frustum built from camera position, target, up vector, field of view and near/far planes.
+        Since culling is done by the rendering allowed flag of the objects, the game must not set that flag directly, instead it
+        should use setHidden(), otherwise the next update() would overwrite it.
+    */
+    class FrustumCuller
+    {
+    public:
+        FrustumCuller();
+
+        void setEnabled(bool bEnabled);   /**< If disabled, every object not hidden is rendered. */
+        bool isEnabled() const;
+
+        void setHidden(PureObject3D& obj, bool bHidden);
+        bool isHidden(const PureObject3D& obj) const;
+        void forget(const PureObject3D& obj);   /**< Must be called before the object is deleted. */
+
+        /**
+            By default an object is tested by a sphere around its position, which is fine only if the position is inside the geometry.
+            Objects having their origin far from their geometry (e.g. arena chunks sharing the origin of the whole arena) should have
+            their world-space bounds set, then those are tested instead.
+        */
+        void setBounds(const PureObject3D& obj, const Aabb& bounds);
+
+        /**
+            Culls top-level objects of the given manager against the current view frustum of the given camera.
+
+            @param fAspectRatio Width / height of the viewport.
+        */
+        void update(PureCamera& camera, float fAspectRatio, PureObject3DManager& objectManager);
+
+        const FrustumCullerStats& getStats() const;
+
+    private:
+
+        /** Normal points inside the frustum: points with a*x + b*y + c*z + d >= 0 are on the inner side. */
+        struct Plane
+        {
+            float m_fA;
+            float m_fB;
+            float m_fC;
+            float m_fD;
+        };
+
+        std::array<Plane, 6> m_planes;
+        std::set<const PureObject3D*> m_hiddenObjects;
+        std::map<const PureObject3D*, Aabb> m_bounds;
+        FrustumCullerStats m_stats;
+        bool m_bEnabled;
+
+        // ---------------------------------------------------------------------------
+
+        void buildFrustum(PureCamera& camera, float fAspectRatio);
+        bool isSphereInFrustum(float fX, float fY, float fZ, float fRadius) const;
+    }; // class FrustumCuller
+
+} // namespace elte_fail
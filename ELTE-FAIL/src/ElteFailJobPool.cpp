@@ -0,0 +1,231 @@
+/*
+    ###################################################################################
+    ElteFailJobPool.cpp
+    Work-stealing thread pool of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailJobPool.h"
+
+#include <algorithm>
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::JobPool::JobPool() :
+    m_pFnJob(nullptr),
+    m_nRemaining(0),
+    m_nBatch(0),
+    m_bRunning(false),
+    m_nRuns(0),
+    m_nJobs(0),
+    m_nSteals(0)
+{
+
+} // JobPool()
+
+
+elte_fail::JobPool::~JobPool()
+{
+    stop();
+} // ~JobPool()
+
+
+bool elte_fail::JobPool::start(uint32_t nWorkers)
+{
+    if (isStarted())
+    {
+        return false;
+    }
+
+    if (nWorkers == 0)
+    {
+        nWorkers = std::max(1u, std::thread::hardware_concurrency() - 1);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mtxWake);
+        m_bRunning = true;
+    }
+    for (uint32_t i = 0; i < nWorkers; i++)
+    {
+        m_vWorkers.push_back(std::make_unique<Worker>());
+    }
+    // all workers must exist before any of them tries to steal
+    for (size_t i = 0; i < m_vWorkers.size(); i++)
+    {
+        m_vWorkers[i]->m_thread = std::thread(&JobPool::runWorker, this, i);
+    }
+    return true;
+} // start()
+
+
+void elte_fail::JobPool::stop()
+{
+    if (!isStarted())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mtxWake);
+        m_bRunning = false;
+    }
+    m_cvWake.notify_all();
+    for (auto& pWorker : m_vWorkers)
+    {
+        pWorker->m_thread.join();
+    }
+    m_vWorkers.clear();
+} // stop()
+
+
+bool elte_fail::JobPool::isStarted() const
+{
+    return !m_vWorkers.empty();
+} // isStarted()
+
+
+uint32_t elte_fail::JobPool::getWorkerCount() const
+{
+    return static_cast<uint32_t>(m_vWorkers.size());
+} // getWorkerCount()
+
+
+void elte_fail::JobPool::run(size_t nJobs, const TJobFn& fnJob)
+{
+    if (nJobs == 0)
+    {
+        return;
+    }
+    m_nRuns.fetch_add(1, std::memory_order_relaxed);
+
+    if (!isStarted())
+    {
+        for (size_t i = 0; i < nJobs; i++)
+        {
+            fnJob(i);
+        }
+        m_nJobs.fetch_add(nJobs, std::memory_order_relaxed);
+        return;
+    }
+
+    // workers can see these only after taking a job, i.e. after locking a queue filled below
+    m_pFnJob = &fnJob;
+    m_nRemaining.store(nJobs, std::memory_order_relaxed);
+
+    // contiguous ranges, so without stealing every worker would get jobs next to each other
+    const size_t nWorkers = m_vWorkers.size();
+    for (size_t iWorker = 0; iWorker < nWorkers; iWorker++)
+    {
+        const size_t iFirst = nJobs * iWorker / nWorkers;
+        const size_t iEnd = nJobs * (iWorker + 1) / nWorkers;
+        std::lock_guard<std::mutex> lock(m_vWorkers[iWorker]->m_mtx);
+        for (size_t i = iFirst; i < iEnd; i++)
+        {
+            m_vWorkers[iWorker]->m_dqJobs.push_back(i);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mtxWake);
+        m_nBatch++;
+    }
+    m_cvWake.notify_all();
+
+    runJobs(nWorkers);
+
+    std::unique_lock<std::mutex> lock(m_mtxWake);
+    m_cvDone.wait(lock, [this]() { return m_nRemaining.load(std::memory_order_acquire) == 0; });
+} // run()
+
+
+elte_fail::JobPoolStats elte_fail::JobPool::getStats() const
+{
+    JobPoolStats stats;
+    stats.m_nRuns = m_nRuns.load(std::memory_order_relaxed);
+    stats.m_nJobs = m_nJobs.load(std::memory_order_relaxed);
+    stats.m_nSteals = m_nSteals.load(std::memory_order_relaxed);
+    return stats;
+} // getStats()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+bool elte_fail::JobPool::takeJob(size_t iWorker, size_t& iJob)
+{
+    const size_t nWorkers = m_vWorkers.size();
+    if (iWorker < nWorkers)
+    {
+        // own queue from the back: most recently queued jobs are next to each other
+        Worker& worker = *m_vWorkers[iWorker];
+        std::lock_guard<std::mutex> lock(worker.m_mtx);
+        if (!worker.m_dqJobs.empty())
+        {
+            iJob = worker.m_dqJobs.back();
+            worker.m_dqJobs.pop_back();
+            return true;
+        }
+    }
+
+    // victims from the front, starting with the next worker so thieves don't all go for the same queue
+    for (size_t i = 1; i <= nWorkers; i++)
+    {
+        const size_t iVictim = (iWorker + i) % nWorkers;
+        if (iVictim == iWorker)
+        {
+            continue;
+        }
+        Worker& victim = *m_vWorkers[iVictim];
+        std::lock_guard<std::mutex> lock(victim.m_mtx);
+        if (!victim.m_dqJobs.empty())
+        {
+            iJob = victim.m_dqJobs.front();
+            victim.m_dqJobs.pop_front();
+            m_nSteals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+} // takeJob()
+
+
+void elte_fail::JobPool::runJobs(size_t iWorker)
+{
+    size_t iJob;
+    while (takeJob(iWorker, iJob))
+    {
+        (*m_pFnJob)(iJob);
+        m_nJobs.fetch_add(1, std::memory_order_relaxed);
+        if (m_nRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            std::lock_guard<std::mutex> lock(m_mtxWake);
+            m_cvDone.notify_all();
+        }
+    }
+} // runJobs()
+
+
+void elte_fail::JobPool::runWorker(size_t iWorker)
+{
+    uint64_t nBatchSeen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mtxWake);
+            m_cvWake.wait(lock, [this, nBatchSeen]() { return !m_bRunning || (m_nBatch != nBatchSeen); });
+            if (!m_bRunning)
+            {
+                return;
+            }
+            nBatchSeen = m_nBatch;
+        }
+        runJobs(iWorker);
+    }
+} // runWorker()
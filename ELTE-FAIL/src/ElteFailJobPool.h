@@ -0,0 +1,108 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailJobPool.h
+    Work-stealing thread pool of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace elte_fail
+{
+
+    /**
+        Counters of JobPool, can be read from any thread.
+    */
+    struct JobPoolStats
+    {
+        uint64_t m_nRuns;       /**< Calls to run(). */
+        uint64_t m_nJobs;       /**< Jobs executed, by workers and by the thread calling run(). */
+        uint64_t m_nSteals;     /**< Jobs taken from the queue of another worker. */
+    };
+
+    /**
+        Fixed set of worker threads executing batches of jobs. Every worker has its own queue: run() splits the batch
+        evenly among the queues, workers take jobs from the back of their own queue, and when that is empty they steal
+        from the front of the other queues. So a worker stuck with an expensive job doesn't hold back the cheap jobs queued behind it.
+        The thread calling run() also steals jobs instead of just waiting.
+        Workers sleep between batches.
+    */
+    class JobPool
+    {
+    public:
+        using TJobFn = std::function<void(size_t iJob)>;
+
+        JobPool();
+        ~JobPool();
+
+        /**
+            @param nWorkers Number of worker threads, 0 means 1 less than the number of hardware threads (at least 1),
+                            since the thread calling run() also executes jobs.
+        */
+        bool start(uint32_t nWorkers);
+
+        void stop();   /**< Must not be called while run() is in progress. */
+
+        bool isStarted() const;
+
+        uint32_t getWorkerCount() const;
+
+        /**
+            Executes fnJob(0) .. fnJob(nJobs - 1) in any order and on any thread, and returns when all of them finished.
+            If not started, the jobs are executed by the calling thread.
+            Must not be called by multiple threads at the same time, nor from within a job.
+        */
+        void run(size_t nJobs, const TJobFn& fnJob);
+
+        JobPoolStats getStats() const;
+
+    private:
+
+        struct Worker
+        {
+            std::mutex m_mtx;
+            std::deque<size_t> m_dqJobs;
+            std::thread m_thread;
+        };
+
+        std::vector<std::unique_ptr<Worker>> m_vWorkers;
+        const TJobFn* m_pFnJob;               /**< Job function of the batch in progress. */
+        std::atomic<size_t> m_nRemaining;     /**< Jobs of the batch in progress not yet finished. */
+
+        std::mutex m_mtxWake;
+        std::condition_variable m_cvWake;     /**< Signaled when a batch is started or the pool is stopped. */
+        std::condition_variable m_cvDone;     /**< Signaled when the last job of the batch is finished. */
+        uint64_t m_nBatch;                    /**< Incremented for every batch, guarded by m_mtxWake. */
+        bool m_bRunning;                      /**< Guarded by m_mtxWake. */
+
+        std::atomic<uint64_t> m_nRuns;
+        std::atomic<uint64_t> m_nJobs;
+        std::atomic<uint64_t> m_nSteals;
+
+        // ---------------------------------------------------------------------------
+
+        JobPool(const JobPool&);
+        JobPool& operator=(const JobPool&);
+
+        /**
+            @param iWorker Index of the worker taking the job, or number of workers for the thread calling run().
+            @return False if all queues are empty.
+        */
+        bool takeJob(size_t iWorker, size_t& iJob);
+
+        void runJobs(size_t iWorker);   /**< Executes jobs until all queues are empty. */
+        void runWorker(size_t iWorker);
+    }; // class JobPool
+
+} // namespace elte_fail
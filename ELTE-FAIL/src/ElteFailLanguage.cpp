@@ -0,0 +1,285 @@
+/*
+    ###################################################################################
+    ElteFailLanguage.cpp
+    Localized texts of ELTE-FAIL, compiled into memory-mapped blobs.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailLanguage.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const char szBlobMagic[4] = { 'E', 'F', 'L', 'B' };
+static const uint32_t nBlobVersion = 1;
+static const size_t nMaxLineLength = 1024;
+static const size_t nTextCount = static_cast<size_t>(elte_fail::TextId::Count);
+
+/**
+    Beginning of a blob, followed by nTexts offsets and then the texts.
+*/
+struct BlobHeader
+{
+    char m_szMagic[4];
+    uint32_t m_nVersion;
+    uint32_t m_nTexts;
+};
+
+static const char* const szEmpty = "";
+
+
+// ############################### PUBLIC ################################
+
+
+const char* elte_fail::Language::getBlobExtension()
+{
+    return ".lang";
+} // getBlobExtension()
+
+
+std::string elte_fail::Language::getBlobFilename(const std::string& sTextFilename)
+{
+    const size_t iDot = sTextFilename.find_last_of('.');
+    const size_t iSeparator = sTextFilename.find_last_of("\\/");
+    if ((iDot == std::string::npos) || ((iSeparator != std::string::npos) && (iDot < iSeparator)))
+    {
+        return sTextFilename + getBlobExtension();
+    }
+    return sTextFilename.substr(0, iDot) + getBlobExtension();
+} // getBlobFilename()
+
+
+bool elte_fail::Language::compile(const std::string& sTextFilename, const std::string& sBlobFilename)
+{
+    FILE* f = nullptr;
+    if ((fopen_s(&f, sTextFilename.c_str(), "rt") != 0) || !f)
+    {
+        return false;
+    }
+
+    std::string sTexts;
+    std::vector<uint32_t> vOffsets;
+    const uint32_t nTextsBegin = static_cast<uint32_t>(sizeof(BlobHeader) + nTextCount * sizeof(uint32_t));
+    char szLine[nMaxLineLength];
+    while (fgets(szLine, sizeof(szLine), f))
+    {
+        szLine[strcspn(szLine, "\r\n")] = '\0';
+        if ((szLine[0] == '\0') || (szLine[0] == '#'))
+        {
+            continue;
+        }
+        vOffsets.push_back(nTextsBegin + static_cast<uint32_t>(sTexts.size()));
+        sTexts.append(szLine);
+        sTexts.push_back('\0');
+    }
+    bool bRet = (ferror(f) == 0);
+    fclose(f);
+    if (!bRet || (vOffsets.size() != nTextCount))
+    {
+        return false;
+    }
+
+    if ((fopen_s(&f, sBlobFilename.c_str(), "wb") != 0) || !f)
+    {
+        return false;
+    }
+    BlobHeader header;
+    memcpy(header.m_szMagic, szBlobMagic, sizeof(header.m_szMagic));
+    header.m_nVersion = nBlobVersion;
+    header.m_nTexts = static_cast<uint32_t>(nTextCount);
+    bRet = (fwrite(&header, sizeof(header), 1, f) == 1) &&
+        (fwrite(vOffsets.data(), sizeof(uint32_t), vOffsets.size(), f) == vOffsets.size()) &&
+        (fwrite(sTexts.data(), 1, sTexts.size(), f) == sTexts.size());
+    fclose(f);
+    if (!bRet)
+    {
+        // incomplete blob would be taken as up to date next time
+        remove(sBlobFilename.c_str());
+    }
+    return bRet;
+} // compile()
+
+
+elte_fail::Language::Language() :
+    m_pOffsets(nullptr)
+{
+
+} // Language()
+
+
+bool elte_fail::Language::open(const std::string& sBlobFilename)
+{
+    close();
+    if (!m_file.open(sBlobFilename))
+    {
+        return false;
+    }
+
+    // every offset must point into the texts, and the last text must be terminated, so no text can run off the mapping
+    const uint8_t* const pData = m_file.getData();
+    const size_t nTextsBegin = sizeof(BlobHeader) + nTextCount * sizeof(uint32_t);
+    BlobHeader header;
+    bool bValid = (m_file.getSize() > nTextsBegin) && (pData[m_file.getSize() - 1] == '\0');
+    if (bValid)
+    {
+        memcpy(&header, pData, sizeof(header));
+        bValid = (memcmp(header.m_szMagic, szBlobMagic, sizeof(header.m_szMagic)) == 0) &&
+            (header.m_nVersion == nBlobVersion) && (header.m_nTexts == nTextCount);
+    }
+    // mapping is page-aligned and header size is a multiple of 4, so offsets are aligned
+    m_pOffsets = reinterpret_cast<const uint32_t*>(pData + sizeof(BlobHeader));
+    for (size_t i = 0; bValid && (i < nTextCount); i++)
+    {
+        bValid = (m_pOffsets[i] >= nTextsBegin) && (m_pOffsets[i] < m_file.getSize());
+    }
+
+    if (!bValid)
+    {
+        close();
+    }
+    return bValid;
+} // open()
+
+
+void elte_fail::Language::close()
+{
+    m_file.close();
+    m_pOffsets = nullptr;
+} // close()
+
+
+bool elte_fail::Language::isOpen() const
+{
+    return m_file.isOpen();
+} // isOpen()
+
+
+const char* elte_fail::Language::get(TextId id) const
+{
+    const size_t i = static_cast<size_t>(id);
+    if (!isOpen() || (i >= nTextCount))
+    {
+        return szEmpty;
+    }
+    return reinterpret_cast<const char*>(m_file.getData() + m_pOffsets[i]);
+} // get()
+
+
+elte_fail::Localization::Localization() :
+    m_iSelected(0)
+{
+
+} // Localization()
+
+
+bool elte_fail::Localization::add(const std::string& sName, const std::string& sTextFilename)
+{
+    const std::string sBlobFilename = Language::getBlobFilename(sTextFilename);
+    if (!FileUtils::isUpToDate(sBlobFilename, sTextFilename) && !Language::compile(sTextFilename, sBlobFilename))
+    {
+        return false;
+    }
+
+    std::unique_ptr<Language> pLanguage(new Language());
+    if (!pLanguage->open(sBlobFilename))
+    {
+        // blob of an older TextId set, compiling it again
+        if (!Language::compile(sTextFilename, sBlobFilename) || !pLanguage->open(sBlobFilename))
+        {
+            return false;
+        }
+    }
+    m_vLanguages.emplace_back(sName, std::move(pLanguage));
+    return true;
+} // add()
+
+
+bool elte_fail::Localization::select(const std::string& sName)
+{
+    for (size_t i = 0; i < m_vLanguages.size(); i++)
+    {
+        if (m_vLanguages[i].first == sName)
+        {
+            m_iSelected = i;
+            return true;
+        }
+    }
+    return false;
+} // select()
+
+
+const std::string& elte_fail::Localization::getSelectedName() const
+{
+    static const std::string sNone;
+    return m_vLanguages.empty() ? sNone : m_vLanguages[m_iSelected].first;
+} // getSelectedName()
+
+
+const char* elte_fail::Localization::get(TextId id) const
+{
+    return m_vLanguages.empty() ? szEmpty : m_vLanguages[m_iSelected].second->get(id);
+} // get()
+
+
+size_t elte_fail::Localization::format(char* szOut, size_t nOutSize, TextId id, std::initializer_list<TextArg> args) const
+{
+    if (nOutSize == 0)
+    {
+        return 0;
+    }
+
+    size_t nLength = 0;
+    const auto fnAppend = [&](const char* sz, size_t nChars)
+    {
+        const size_t nCopy = std::min(nChars, nOutSize - 1 - nLength);
+        memcpy(szOut + nLength, sz, nCopy);
+        nLength += nCopy;
+    };
+
+    const char* szText = get(id);
+    while (*szText && (nLength < nOutSize - 1))
+    {
+        // {N}, where N is a single digit
+        if ((szText[0] == '{') && (szText[1] >= '0') && (szText[1] <= '9') && (szText[2] == '}') &&
+            (static_cast<size_t>(szText[1] - '0') < args.size()))
+        {
+            const TextArg& arg = *(args.begin() + (szText[1] - '0'));
+            char szNumber[32];
+            switch (arg.m_type)
+            {
+            case TextArg::Type::Int:
+                fnAppend(szNumber, static_cast<size_t>(std::max(0, sprintf_s(szNumber, sizeof(szNumber), "%lld", arg.m_nInt))));
+                break;
+            case TextArg::Type::UInt:
+                fnAppend(szNumber, static_cast<size_t>(std::max(0, sprintf_s(szNumber, sizeof(szNumber), "%llu", arg.m_nUInt))));
+                break;
+            case TextArg::Type::Float:
+                fnAppend(szNumber, static_cast<size_t>(std::max(0, sprintf_s(szNumber, sizeof(szNumber), "%.2f", arg.m_fFloat))));
+                break;
+            default:
+                if (arg.m_szString)
+                {
+                    fnAppend(arg.m_szString, strlen(arg.m_szString));
+                }
+                break;
+            }
+            szText += 3;
+        }
+        else
+        {
+            szOut[nLength++] = *szText++;
+        }
+    }
+    szOut[nLength] = '\0';
+    return nLength;
+} // format()
+
+
+void elte_fail::Localization::format(std::string& sOut, TextId id, std::initializer_list<TextArg> args) const
+{
+    char szOut[nMaxFormattedLength];
+    const size_t nLength = format(szOut, sizeof(szOut), id, args);
+    sOut.assign(szOut, nLength);
+} // format()
@@ -0,0 +1,182 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailLanguage.h
+    Localized texts of ELTE-FAIL, compiled into memory-mapped blobs.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ElteFailFileUtils.h"
+
+namespace elte_fail
+{
+
+    /**
+        Texts in the order of the language files: non-comment, non-empty lines, 1 text per line.
+        First texts are the engine's messages, game texts come after them.
+        Texts may contain format slots {0} .. {9}, filled by Localization::format().
+    */
+    enum class TextId : uint32_t
+    {
+        ErrorInCode,
+        ErrorInitGfx,
+        ErrorInitSfx,
+        ErrorInitNet,
+        ErrorExitGfx,
+        ErrorExitSfx,
+        ErrorExitNet,
+        Error,
+        Warning,
+        Info,
+        On,
+        Off,
+        UiVtBenchmarkRunning,
+        UiPing,                      /**< {0}: ping in msecs. */
+        UiQuality,                   /**< {0}, {1}: local and remote quality. */
+        UiTxRxSpeed,                 /**< {0}, {1}: tx and rx bytes per sec. */
+        UiInternalQueueTime,         /**< {0}: usecs. */
+        UiArenaChunks,               /**< {0}..{6}: resident, chunks, pending, resident KB, budget KB, loads, evictions. */
+        UiCulling,                   /**< {0}: On or Off, {1}..{4}: tested, culled, drawn, hidden. */
+        UiServerUserName,            /**< {0}: user name. */
+        UiClientUserName,            /**< {0}: user name, {1}: IP address. */
+        Count
+    };
+
+    /**
+        Value of a format slot. Only refers to strings, so it must not outlive the formatting call.
+    */
+    struct TextArg
+    {
+        enum class Type
+        {
+            Int,
+            UInt,
+            Float,
+            String
+        };
+
+        Type m_type;
+        union
+        {
+            long long m_nInt;
+            unsigned long long m_nUInt;
+            double m_fFloat;
+            const char* m_szString;
+        };
+
+        TextArg(int n) : m_type(Type::Int), m_nInt(n) {}
+        TextArg(long n) : m_type(Type::Int), m_nInt(n) {}
+        TextArg(long long n) : m_type(Type::Int), m_nInt(n) {}
+        TextArg(unsigned int n) : m_type(Type::UInt), m_nUInt(n) {}
+        TextArg(unsigned long n) : m_type(Type::UInt), m_nUInt(n) {}
+        TextArg(unsigned long long n) : m_type(Type::UInt), m_nUInt(n) {}
+        TextArg(double f) : m_type(Type::Float), m_fFloat(f) {}
+        TextArg(const char* sz) : m_type(Type::String), m_szString(sz) {}
+        TextArg(const std::string& s) : m_type(Type::String), m_szString(s.c_str()) {}
+    };
+
+    /**
+        Texts of 1 language, read from a memory-mapped blob compiled from the language file:
+        header, then offsets of all texts, then the NUL-terminated texts themselves. Getting a text is an array lookup
+        returning a pointer into the mapped file, nothing is parsed or copied.
+    */
+    class Language
+    {
+    public:
+        static const char* getBlobExtension();
+
+        /**
+            @return Blob file compiled from the given language file, e.g. "english.lang" for "english.txt".
+        */
+        static std::string getBlobFilename(const std::string& sTextFilename);
+
+        /**
+            Compiles the given language file into a blob.
+
+            @return False if the file cannot be read, it doesn't have exactly TextId::Count texts, or blob cannot be written.
+        */
+        static bool compile(const std::string& sTextFilename, const std::string& sBlobFilename);
+
+        Language();
+
+        /**
+            @return False if the blob cannot be mapped or it is not a valid blob of the current TextId set.
+        */
+        bool open(const std::string& sBlobFilename);
+
+        void close();
+        bool isOpen() const;
+
+        const char* get(TextId id) const;   /**< Empty string if not open. */
+
+    private:
+        MappedFile m_file;
+        const uint32_t* m_pOffsets;   /**< Offsets of texts from the beginning of the file, inside m_file. */
+
+        // ---------------------------------------------------------------------------
+
+        Language(const Language&);
+        Language& operator=(const Language&);
+    }; // class Language
+
+    /**
+        All languages are compiled (if needed) and mapped once, so switching language is only selecting another mapped blob.
+        Formatting writes into a caller-provided buffer, so building UI text doesn't need heap allocations.
+    */
+    class Localization
+    {
+    public:
+        static const size_t nMaxFormattedLength = 512;   /**< Longer formatted texts are truncated. */
+
+        Localization();
+
+        /**
+            Compiles the given language file if its blob is missing or older, then maps the blob.
+            First added language is selected.
+
+            @return False if the language could not be compiled or mapped.
+        */
+        bool add(const std::string& sName, const std::string& sTextFilename);
+
+        /**
+            @return False if there is no such language, in that case selection is not changed.
+        */
+        bool select(const std::string& sName);
+
+        const std::string& getSelectedName() const;   /**< Empty string if no language is added. */
+
+        const char* get(TextId id) const;   /**< Text of the selected language, empty string if there is none. */
+
+        /**
+            Writes the text of the selected language into szOut, replacing {N} by the Nth argument.
+            Slots without argument are written as they are.
+
+            @return Length of the formatted text, without terminating NUL.
+        */
+        size_t format(char* szOut, size_t nOutSize, TextId id, std::initializer_list<TextArg> args) const;
+
+        /**
+            Same as above, but into the given string, which allocates only if its capacity is not yet enough.
+        */
+        void format(std::string& sOut, TextId id, std::initializer_list<TextArg> args) const;
+
+    private:
+        std::vector<std::pair<std::string, std::unique_ptr<Language>>> m_vLanguages;
+        size_t m_iSelected;
+
+        // ---------------------------------------------------------------------------
+
+        Localization(const Localization&);
+        Localization& operator=(const Localization&);
+    }; // class Localization
+
+} // namespace elte_fail
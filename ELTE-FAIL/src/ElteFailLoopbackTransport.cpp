@@ -0,0 +1,88 @@
+/*
+    ###################################################################################
+    ElteFailLoopbackTransport.cpp
+    In-process packet transport for ELTE-FAIL, without serialization and sockets.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailLoopbackTransport.h"
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::LoopbackTransport::LoopbackTransport() :
+    m_nSent(0),
+    m_nFull(0),
+    m_nMaxQueued(0),
+    m_nReceived(0)
+{
+
+} // LoopbackTransport()
+
+
+bool elte_fail::LoopbackTransport::send(const pge_network::PgePacket& pkt)
+{
+    if (!m_queue.tryPush(pkt))
+    {
+        m_nFull++;
+        return false;
+    }
+
+    m_nSent++;
+    const size_t nQueued = m_queue.size();
+    if (nQueued > m_nMaxQueued)
+    {
+        m_nMaxQueued = nQueued;
+    }
+    return true;
+} // send()
+
+
+bool elte_fail::LoopbackTransport::receive(pge_network::PgePacket& pkt)
+{
+    if (!m_queue.tryPop(pkt))
+    {
+        return false;
+    }
+
+    m_nReceived++;
+    return true;
+} // receive()
+
+
+size_t elte_fail::LoopbackTransport::getQueuedCount() const
+{
+    return m_queue.size();
+} // getQueuedCount()
+
+
+uint64_t elte_fail::LoopbackTransport::getSentCount() const
+{
+    return m_nSent;
+} // getSentCount()
+
+
+uint64_t elte_fail::LoopbackTransport::getReceivedCount() const
+{
+    return m_nReceived;
+} // getReceivedCount()
+
+
+uint64_t elte_fail::LoopbackTransport::getFullCount() const
+{
+    return m_nFull;
+} // getFullCount()
+
+
+size_t elte_fail::LoopbackTransport::getMaxQueuedCount() const
+{
+    return m_nMaxQueued;
+} // getMaxQueuedCount()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
@@ -0,0 +1,85 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailLoopbackTransport.h
+    In-process packet transport for ELTE-FAIL, without serialization and sockets.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <cstdint>
+
+#include "../../../PGE/PGE/Network/PgePacket.h"
+
+#include "ElteFailSpscQueue.h"
+
+namespace elte_fail
+{
+
+    /**
+        One direction of an in-process connection: packets are copied into a lock-free SPSC queue by the sender
+        and popped by the receiver, nothing goes through the socket layer.
+        Listen-server uses one for injecting packets to itself, 2 of them make a full connection between
+        instances living in the same process.
+    */
+    class LoopbackTransport
+    {
+    public:
+        static const size_t nCapacity = 1024;   /**< Packets, must be power of 2. */
+
+        LoopbackTransport();
+
+        /**
+            Producer side.
+
+            @return False if the queue is full, in that case caller should fall back to the regular network path.
+        */
+        bool send(const pge_network::PgePacket& pkt);
+
+        /**
+            Consumer side.
+
+            @return False if there is no packet.
+        */
+        bool receive(pge_network::PgePacket& pkt);
+
+        /**
+            Consumer side. Invokes fnOnPacket for the packets queued at the time of the call, packets sent meanwhile
+            (e.g. by fnOnPacket itself) are left for the next call, so this always terminates.
+
+            @return Number of packets processed.
+        */
+        template <class F>
+        uint32_t receiveAll(F&& fnOnPacket)
+        {
+            uint32_t nProcessed = 0;
+            pge_network::PgePacket pkt;
+            for (size_t nQueued = m_queue.size(); (nQueued > 0) && receive(pkt); nQueued--)
+            {
+                fnOnPacket(pkt);
+                nProcessed++;
+            }
+            return nProcessed;
+        }
+
+        size_t getQueuedCount() const;
+        uint64_t getSentCount() const;        /**< Packets successfully queued. */
+        uint64_t getReceivedCount() const;
+        uint64_t getFullCount() const;        /**< Failed sends because queue was full. */
+        size_t getMaxQueuedCount() const;     /**< High-water mark of the queue. */
+
+    private:
+        SpscQueue<pge_network::PgePacket, nCapacity> m_queue;
+        uint64_t m_nSent;                     /**< Written by producer only. */
+        uint64_t m_nFull;                     /**< Written by producer only. */
+        size_t m_nMaxQueued;                  /**< Written by producer only. */
+        uint64_t m_nReceived;                 /**< Written by consumer only. */
+
+        // ---------------------------------------------------------------------------
+
+        LoopbackTransport(const LoopbackTransport&);
+        LoopbackTransport& operator=(const LoopbackTransport&);
+    }; // class LoopbackTransport
+
+} // namespace elte_fail
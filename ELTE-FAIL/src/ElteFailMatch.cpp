@@ -0,0 +1,693 @@
+/*
+    ###################################################################################
+    ElteFailMatch.cpp
+    Headless match instances of ELTE-FAIL, hosted by the server next to its own match.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailMatch.h"
+
+#include <algorithm>
+
+
+static const uint32_t nMaxProjectileStepsPerTick = 10;  /**< Steps beyond this are skipped, so a late tick doesn't make the next one late too. */
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::Match::Match(
+    uint32_t nId,
+    const CollisionWorld& collisionWorld,
+    const std::vector<std::string>& vTrollfaces,
+    uint32_t nMaxProjectiles,
+    AsyncLogger& log) :
+    m_nId(nId),
+    m_collisionWorld(collisionWorld),
+    m_log(log),
+    m_rules(nId, m_strings, log),
+    m_timeNextProjectileStep(std::chrono::steady_clock::now()),
+    m_stats()
+{
+    for (const auto& sTrollface : vTrollfaces)
+    {
+        m_rules.addTrollface(sTrollface);
+    }
+    m_projectiles.reset(nMaxProjectiles);
+} // Match()
+
+
+uint32_t elte_fail::Match::getId() const
+{
+    return m_nId;
+} // getId()
+
+
+size_t elte_fail::Match::getPlayerCount() const
+{
+    return m_mapPlayers.size();
+} // getPlayerCount()
+
+
+void elte_fail::Match::connect(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const char* szIpAddress)
+{
+    m_vInbox.emplace_back();
+    m_vInbox.back().m_type = EventType::Connect;
+    m_vInbox.back().m_connHandleServerSide = connHandleServerSide;
+    m_vInbox.back().m_sIpAddress = szIpAddress;
+} // connect()
+
+
+void elte_fail::Match::disconnect(pge_network::PgeNetworkConnectionHandle connHandleServerSide)
+{
+    m_vInbox.emplace_back();
+    m_vInbox.back().m_type = EventType::Disconnect;
+    m_vInbox.back().m_connHandleServerSide = connHandleServerSide;
+} // disconnect()
+
+
+void elte_fail::Match::receive(const pge_network::PgePacket& pkt)
+{
+    m_vInbox.emplace_back();
+    m_vInbox.back().m_type = EventType::Packet;
+    m_vInbox.back().m_connHandleServerSide = pge_network::PgePacket::getServerSideConnectionHandle(pkt);
+    m_vInbox.back().m_pkt = pkt;
+} // receive()
+
+
+void elte_fail::Match::tick()
+{
+    const auto timeStart = std::chrono::steady_clock::now();
+
+    for (const auto& event : m_vInbox)
+    {
+        switch (event.m_type)
+        {
+        case EventType::Connect:
+            handleConnect(event.m_connHandleServerSide, event.m_sIpAddress);
+            break;
+        case EventType::Disconnect:
+            handleDisconnect(event.m_connHandleServerSide);
+            break;
+        default: /* packet */
+            handlePkt(event.m_pkt);
+            break;
+        }
+    }
+    m_stats.m_nEvents += m_vInbox.size();
+    m_vInbox.clear();
+    stepProjectiles(timeStart);
+    sendUserUpdates();
+    sendProjectileEvents();
+
+    m_stats.m_nTicks++;
+    m_stats.m_nLastTickUSecs = static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - timeStart).count());
+    if (m_stats.m_nLastTickUSecs > m_stats.m_nMaxTickUSecs)
+    {
+        m_stats.m_nMaxTickUSecs = m_stats.m_nLastTickUSecs;
+    }
+} // tick()
+
+
+void elte_fail::Match::getPlayers(std::vector<WorldStatePlayer>& vPlayers) const
+{
+    vPlayers.reserve(vPlayers.size() + m_mapPlayers.size());
+    for (const auto& it : m_mapPlayers)
+    {
+        vPlayers.push_back(it.second);
+    }
+} // getPlayers()
+
+
+const elte_fail::StringTable& elte_fail::Match::getStrings() const
+{
+    return m_strings;
+} // getStrings()
+
+
+const elte_fail::ProjectilePool& elte_fail::Match::getProjectiles() const
+{
+    return m_projectiles;
+} // getProjectiles()
+
+
+const elte_fail::MatchStats& elte_fail::Match::getStats() const
+{
+    return m_stats;
+} // getStats()
+
+
+elte_fail::MatchHost::MatchHost() :
+    m_nMaxMatches(0),
+    m_nMaxPlayersPerMatch(0),
+    m_pCollisionWorld(nullptr),
+    m_nMaxProjectiles(0),
+    m_pLog(nullptr),
+    m_stats{ 0, 0, 0, 0, 0 },
+    m_bRunning(false)
+{
+
+} // MatchHost()
+
+
+elte_fail::MatchHost::~MatchHost()
+{
+    stop();
+} // ~MatchHost()
+
+
+bool elte_fail::MatchHost::start(
+    uint32_t nMaxMatches,
+    uint32_t nMaxPlayersPerMatch,
+    uint32_t nWorkers,
+    const CollisionWorld& collisionWorld,
+    const std::vector<std::string>& vTrollfaces,
+    uint32_t nMaxProjectiles,
+    AsyncLogger& log)
+{
+    if (isStarted() || (nMaxMatches == 0) || (nMaxPlayersPerMatch == 0) || !m_pool.start(nWorkers))
+    {
+        return false;
+    }
+
+    m_vMatches.clear();
+    m_vConnectionCounts.clear();
+    m_mapRoutes.clear();
+    m_vOutPending.clear();
+    m_nMaxMatches = nMaxMatches;
+    m_nMaxPlayersPerMatch = nMaxPlayersPerMatch;
+    m_pCollisionWorld = &collisionWorld;
+    m_vTrollfaces = vTrollfaces;
+    m_nMaxProjectiles = nMaxProjectiles;
+    m_pLog = &log;
+    m_stats = { 0, 0, 0, 0, 0 };
+    m_bRunning = true;
+    m_thread = std::thread(&MatchHost::run, this);
+    return true;
+} // start()
+
+
+void elte_fail::MatchHost::stop()
+{
+    if (!isStarted())
+    {
+        return;
+    }
+
+    m_bRunning = false;
+    m_thread.join();
+    m_pool.stop();
+
+    // so getMatch() is valid for all matches counted by getMatchCount()
+    dispatchEvents();
+    OutPkt pktOut;
+    while (m_qOut.tryPop(pktOut))
+    {
+    }
+} // stop()
+
+
+bool elte_fail::MatchHost::isStarted() const
+{
+    return m_thread.joinable();
+} // isStarted()
+
+
+bool elte_fail::MatchHost::connect(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const char* szIpAddress)
+{
+    if (!isStarted() || isRouted(connHandleServerSide))
+    {
+        return false;
+    }
+
+    // filling up existing matches first, so players meet each other
+    size_t iMatch = 0;
+    while ((iMatch < m_vConnectionCounts.size()) && (m_vConnectionCounts[iMatch] >= m_nMaxPlayersPerMatch))
+    {
+        iMatch++;
+    }
+    if (iMatch == m_vConnectionCounts.size())
+    {
+        if (m_vConnectionCounts.size() >= m_nMaxMatches)
+        {
+            return false;
+        }
+        // match is created by the tick thread when it gets the connection
+        m_vConnectionCounts.push_back(0);
+        m_pLog->OLn("MatchHost::%s(): creating match %u", __func__, static_cast<uint32_t>(iMatch + 1));
+    }
+
+    m_mapRoutes[connHandleServerSide] = iMatch;
+    m_vConnectionCounts[iMatch]++;
+
+    Event event;
+    event.m_type = EventType::Connect;
+    event.m_iMatch = iMatch;
+    event.m_connHandleServerSide = connHandleServerSide;
+    event.m_sIpAddress = szIpAddress;
+    pushEvent(event);
+    return true;
+} // connect()
+
+
+bool elte_fail::MatchHost::disconnect(pge_network::PgeNetworkConnectionHandle connHandleServerSide)
+{
+    const auto it = m_mapRoutes.find(connHandleServerSide);
+    if (it == m_mapRoutes.end())
+    {
+        return false;
+    }
+
+    Event event;
+    event.m_type = EventType::Disconnect;
+    event.m_iMatch = it->second;
+    event.m_connHandleServerSide = connHandleServerSide;
+    pushEvent(event);
+
+    m_vConnectionCounts[it->second]--;
+    m_mapRoutes.erase(it);
+    return true;
+} // disconnect()
+
+
+bool elte_fail::MatchHost::receive(const pge_network::PgePacket& pkt)
+{
+    const auto it = m_mapRoutes.find(pge_network::PgePacket::getServerSideConnectionHandle(pkt));
+    if (it == m_mapRoutes.end())
+    {
+        return false;
+    }
+
+    Event event;
+    event.m_type = EventType::Packet;
+    event.m_iMatch = it->second;
+    event.m_connHandleServerSide = it->first;
+    event.m_pkt = pkt;
+    pushEvent(event);
+    return true;
+} // receive()
+
+
+bool elte_fail::MatchHost::isRouted(pge_network::PgeNetworkConnectionHandle connHandleServerSide) const
+{
+    return m_mapRoutes.find(connHandleServerSide) != m_mapRoutes.end();
+} // isRouted()
+
+
+size_t elte_fail::MatchHost::getConnectionCount() const
+{
+    return m_mapRoutes.size();
+} // getConnectionCount()
+
+
+size_t elte_fail::MatchHost::getMatchCount() const
+{
+    return m_vConnectionCounts.size();
+} // getMatchCount()
+
+
+const elte_fail::Match& elte_fail::MatchHost::getMatch(size_t iMatch) const
+{
+    return *m_vMatches[iMatch];
+} // getMatch()
+
+
+const elte_fail::JobPool& elte_fail::MatchHost::getPool() const
+{
+    return m_pool;
+} // getPool()
+
+
+const elte_fail::MatchHostStats& elte_fail::MatchHost::getStats() const
+{
+    return m_stats;
+} // getStats()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+/**
+    Main thread only. Nothing is dropped: if the queue is full, waits for the tick thread, which empties it on every tick.
+*/
+void elte_fail::MatchHost::pushEvent(const Event& event)
+{
+    if (m_qEvents.tryPush(event))
+    {
+        return;
+    }
+
+    m_stats.m_nEventStalls++;
+    do
+    {
+        std::this_thread::yield();
+    } while (!m_qEvents.tryPush(event));
+} // pushEvent()
+
+
+/**
+    Tick thread only while running. Passes the queued events to their matches, creating the matches routed to but not yet existing.
+*/
+void elte_fail::MatchHost::dispatchEvents()
+{
+    Event event;
+    while (m_qEvents.tryPop(event))
+    {
+        // main thread routes to new matches in order, so the match of an event is either an existing one or the next one
+        if (event.m_iMatch == m_vMatches.size())
+        {
+            m_vMatches.push_back(std::make_unique<Match>(
+                static_cast<uint32_t>(m_vMatches.size() + 1), *m_pCollisionWorld, m_vTrollfaces, m_nMaxProjectiles, *m_pLog));
+        }
+
+        Match& match = *m_vMatches[event.m_iMatch];
+        switch (event.m_type)
+        {
+        case EventType::Connect:
+            match.connect(event.m_connHandleServerSide, event.m_sIpAddress.c_str());
+            break;
+        case EventType::Disconnect:
+            match.disconnect(event.m_connHandleServerSide);
+            break;
+        default: /* packet */
+            match.receive(event.m_pkt);
+            break;
+        }
+    }
+} // dispatchEvents()
+
+
+/**
+    Tick thread only. Tick thread never waits for the main thread: packets not fitting into the queue are kept for the next tick,
+    and newer packets are queued behind them, so order is kept.
+*/
+void elte_fail::MatchHost::queueOut(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide)
+{
+    const OutPkt pktOut = { pkt, connHandleServerSide };
+    if (m_vOutPending.empty() && m_qOut.tryPush(pktOut))
+    {
+        return;
+    }
+
+    m_stats.m_nOutStalls++;
+    m_vOutPending.push_back(pktOut);
+} // queueOut()
+
+
+void elte_fail::MatchHost::run()
+{
+    const std::chrono::microseconds tickDuration(static_cast<int64_t>(ProjectilePool::fStepSecs * 1000000.f));
+    std::chrono::steady_clock::time_point timeNextTick = std::chrono::steady_clock::now();
+
+    while (m_bRunning)
+    {
+        const std::chrono::steady_clock::time_point timeNow = std::chrono::steady_clock::now();
+        if (timeNow < timeNextTick)
+        {
+            std::this_thread::sleep_until(timeNextTick);
+            continue;
+        }
+
+        // matches process all events queued since their last tick and step projectiles by the elapsed time,
+        // so after a stall 1 tick catches up, running the missed ones would only repeat work
+        const auto nSkipped = (timeNow - timeNextTick) / tickDuration;
+        m_stats.m_nSkippedTicks += static_cast<uint64_t>(nSkipped);
+        timeNextTick += tickDuration * (nSkipped + 1);
+        tick();
+    }
+} // run()
+
+
+void elte_fail::MatchHost::tick()
+{
+    const auto timeStart = std::chrono::steady_clock::now();
+
+    size_t nPendingSent = 0;
+    while ((nPendingSent < m_vOutPending.size()) && m_qOut.tryPush(m_vOutPending[nPendingSent]))
+    {
+        nPendingSent++;
+    }
+    m_vOutPending.erase(m_vOutPending.begin(), m_vOutPending.begin() + nPendingSent);
+
+    dispatchEvents();
+    m_pool.run(m_vMatches.size(), [this](size_t iMatch) { m_vMatches[iMatch]->tick(); });
+    for (auto& pMatch : m_vMatches)
+    {
+        pMatch->flush([this](const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide)
+            { queueOut(pkt, connHandleServerSide); });
+    }
+
+    m_stats.m_nTicks++;
+    m_stats.m_nMaxTickUSecs = std::max(m_stats.m_nMaxTickUSecs, static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - timeStart).count()));
+} // tick()
+
+
+void elte_fail::Match::send(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide)
+{
+    m_vOutbox.push_back({ pkt, connHandleServerSide });
+} // send()
+
+
+bool elte_fail::Match::handleConnect(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const std::string& sIpAddress)
+{
+    WorldStatePlayer player;
+    if (!m_rules.admit(connHandleServerSide, sIpAddress, player))
+    {
+        // same as in our match, see CustomPGE::handleUserConnected()
+        m_log.EOLn("Match::%s(): match %u: rejected user (connHandleServerSide: %u) connected from %s!",
+            __func__, m_nId, connHandleServerSide, sIpAddress.c_str());
+        m_rejectedConnections.insert(connHandleServerSide);
+        return true;
+    }
+    m_log.OLn("Match::%s(): match %u: new user %s (connHandleServerSide: %u) connected (from %s)",
+        __func__, m_nId, m_strings.getString(player.m_nUserNameId).c_str(), connHandleServerSide, sIpAddress.c_str());
+
+    // all players are remote here, none of them is served locally
+    std::vector<WorldStatePlayer> vPlayers;
+    getPlayers(vPlayers);
+    if (!m_rules.sendJoin(
+        player, vPlayers, 0,
+        [this](const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleRecipient) { send(pkt, connHandleRecipient); }))
+    {
+        return false;
+    }
+
+    m_mapPlayers[connHandleServerSide] = player;
+    m_mapUserUpdateSeqs[connHandleServerSide] = 0;
+    m_mapLastFireUSecs[connHandleServerSide] = 0;
+    return true;
+} // handleConnect()
+
+
+/**
+    Clients are informed by PGE itself, by MsgUserDisconnectedFromServer.
+*/
+void elte_fail::Match::handleDisconnect(pge_network::PgeNetworkConnectionHandle connHandleServerSide)
+{
+    if (m_rejectedConnections.erase(connHandleServerSide) > 0)
+    {
+        return;
+    }
+
+    const auto it = m_mapPlayers.find(connHandleServerSide);
+    if (it == m_mapPlayers.end())
+    {
+        m_log.EOLn("Match::%s(): match %u: failed to find user with connHandleServerSide: %u!", __func__, m_nId, connHandleServerSide);
+        return;
+    }
+
+    m_log.OLn("Match::%s(): match %u: user %s disconnected", __func__, m_nId, m_strings.getString(it->second.m_nUserNameId).c_str());
+    m_rules.release(it->second);
+    m_mapUserUpdateSeqs.erase(connHandleServerSide);
+    m_mapLastFireUSecs.erase(connHandleServerSide);
+    m_movedPlayers.erase(connHandleServerSide);
+    m_seqFilter.forget(connHandleServerSide);
+    m_mapPlayers.erase(it);
+} // handleDisconnect()
+
+
+/**
+    Packet must be already validated, see receive().
+*/
+bool elte_fail::Match::handlePkt(const pge_network::PgePacket& pkt)
+{
+    if (m_rejectedConnections.find(pge_network::PgePacket::getServerSideConnectionHandle(pkt)) != m_rejectedConnections.end())
+    {
+        // rejected connection has no player, nothing to handle until it disconnects
+        return true;
+    }
+
+    const pge_network::MsgApp::TMsgId msgAppId = pge_network::PgePacket::getMsgAppIdFromPkt(pkt);
+    if ((TMsgAppDispatcher::getChannel(msgAppId) == MsgChannel::UnreliableSequenced) &&
+        !m_seqFilter.accept(
+            static_cast<ElteFailMsgId>(msgAppId),
+            pge_network::PgePacket::getServerSideConnectionHandle(pkt),
+            TMsgAppDispatcher::getSeq(msgAppId, pkt)))
+    {
+        // a newer one has already been handled
+        return true;
+    }
+    return m_msgAppDispatcher.dispatch(*this, msgAppId, pkt);
+} // handlePkt()
+
+
+/**
+    Same as CustomPGE::handleUserCmdMove(), but the update is sent only to players of this match, by sendUserUpdates().
+*/
+bool elte_fail::Match::handleUserCmdMove(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const MsgUserCmdMoveFromClient& msg)
+{
+    const auto it = m_mapPlayers.find(connHandleServerSide);
+    if (it == m_mapPlayers.end())
+    {
+        m_log.EOLn("Match::%s(): match %u: failed to find user with connHandleServerSide: %u!", __func__, m_nId, connHandleServerSide);
+        return true;
+    }
+
+    if (!MatchRules::applyMove(m_collisionWorld, msg.m_dirHorizontal, msg.m_dirVertical, it->second.m_fPosX, it->second.m_fPosY))
+    {
+        // blocked by wall, no need to update anyone
+        return true;
+    }
+    m_movedPlayers.insert(connHandleServerSide);
+    return true;
+} // handleUserCmdMove()
+
+
+/**
+    Same as CustomPGE::handleUserCmdFire(), but the projectile is spawned by this thread, and the spawn is sent only to
+    players of this match, by sendProjectileEvents().
+*/
+bool elte_fail::Match::handleUserCmdFire(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const MsgUserCmdFireFromClient& msg)
+{
+    const auto it = m_mapPlayers.find(connHandleServerSide);
+    if (it == m_mapPlayers.end())
+    {
+        m_log.EOLn("Match::%s(): match %u: failed to find user with connHandleServerSide: %u!", __func__, m_nId, connHandleServerSide);
+        return true;
+    }
+
+    ProjectileEvent event;
+    float fPosX = it->second.m_fPosX;
+    float fPosY = it->second.m_fPosY;
+    float fVelX;
+    float fVelY;
+    const uint64_t nNowUSecs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    if (!m_rules.fire(msg, nNowUSecs, m_mapLastFireUSecs[connHandleServerSide], event, fPosX, fPosY, fVelX, fVelY))
+    {
+        return true;
+    }
+
+    // spawn is not sent at all if pool is full, so clients don't need to be told to despawn it
+    if (!m_projectiles.spawnWithId(event.m_nId, connHandleServerSide, fPosX, fPosY, fVelX, fVelY))
+    {
+        m_log.WLn("Match::%s(): match %u: projectile pool is full!", __func__, m_nId);
+        return true;
+    }
+    m_vProjectileEvents.push_back(event);
+    return true;
+} // handleUserCmdFire()
+
+
+/**
+    MsgUserUpdateFromServer is latest-wins, so only the last position of the tick is sent about every moved player.
+*/
+bool elte_fail::Match::sendUserUpdates()
+{
+    bool bRet = true;
+    for (const auto& connHandleServerSide : m_movedPlayers)
+    {
+        const WorldStatePlayer& player = m_mapPlayers[connHandleServerSide];
+        pge_network::PgePacket pktOut;
+        if (!MsgUserUpdateFromServer::initPkt(
+            pktOut, connHandleServerSide, ++m_mapUserUpdateSeqs[connHandleServerSide], player.m_fPosX, player.m_fPosY, MatchRules::fPlayerPosZ))
+        {
+            m_log.EOLn("Match::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
+            bRet = false;
+            continue;
+        }
+        for (const auto& otherPlayer : m_mapPlayers)
+        {
+            send(pktOut, otherPlayer.first);
+        }
+    }
+    m_movedPlayers.clear();
+    return bRet;
+} // sendUserUpdates()
+
+
+/**
+    Runs the fixed steps of ProjectilePool::fStepSecs due since the previous tick, with the players as targets.
+    Players don't move between the steps of the same tick, since their commands are processed before.
+*/
+void elte_fail::Match::stepProjectiles(const std::chrono::steady_clock::time_point& timeNow)
+{
+    if (m_projectiles.getCount() == 0)
+    {
+        // nothing to step, so no steps are owed when the next projectile is fired
+        m_timeNextProjectileStep = timeNow;
+        return;
+    }
+
+    m_vProjectileTargets.clear();
+    for (const auto& player : m_mapPlayers)
+    {
+        m_vProjectileTargets.push_back({ player.first, player.second.m_fPosX, player.second.m_fPosY });
+    }
+
+    const std::chrono::microseconds stepDuration(static_cast<int64_t>(ProjectilePool::fStepSecs * 1000000.f));
+    uint32_t nSteps = 0;
+    while (timeNow >= m_timeNextProjectileStep)
+    {
+        if (++nSteps > nMaxProjectileStepsPerTick)
+        {
+            m_timeNextProjectileStep = timeNow + stepDuration;
+            break;
+        }
+
+        m_projectiles.step(ProjectilePool::fStepSecs, m_collisionWorld, m_vProjectileTargets.data(), m_vProjectileTargets.size());
+        for (const auto& despawn : m_projectiles.getDespawned())
+        {
+            m_vProjectileEvents.push_back({ despawn.m_nId, despawn.m_reason, 0, 0, 0 });
+            if (despawn.m_reason == ProjectileEventType::HitPlayer)
+            {
+                m_log.DLn("Match::%s(): match %u: connHandleServerSide %u hit by projectile of connHandleServerSide %u",
+                    __func__, m_nId, despawn.m_connHandleHit, despawn.m_connHandleOwner);
+            }
+        }
+        m_timeNextProjectileStep += stepDuration;
+    }
+} // stepProjectiles()
+
+
+/**
+    Same as CustomPGE::flushProjectileEvents(), but to players of this match.
+*/
+bool elte_fail::Match::sendProjectileEvents()
+{
+    bool bRet = true;
+    for (size_t iFirst = 0; iFirst < m_vProjectileEvents.size(); iFirst += MsgProjectileEventsFromServer::nMaxEvents)
+    {
+        const uint8_t nEvents = static_cast<uint8_t>(
+            std::min<size_t>(m_vProjectileEvents.size() - iFirst, MsgProjectileEventsFromServer::nMaxEvents));
+        pge_network::PgePacket pktOut;
+        if (!MsgProjectileEventsFromServer::initPkt(pktOut, &m_vProjectileEvents[iFirst], nEvents))
+        {
+            m_log.EOLn("Match::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
+            bRet = false;
+            continue;
+        }
+        for (const auto& player : m_mapPlayers)
+        {
+            send(pktOut, player.first);
+        }
+    }
+    m_vProjectileEvents.clear();
+    return bRet;
+} // sendProjectileEvents()
@@ -0,0 +1,343 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailMatch.h
+    Headless match instances of ELTE-FAIL, hosted by the server next to its own match.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../../../PGE/PGE/Network/PgePacket.h"
+
+#include "ElteFailAsyncLog.h"
+#include "ElteFailCollisionWorld.h"
+#include "ElteFailJobPool.h"
+#include "ElteFailMatchRules.h"
+#include "ElteFailMsgDispatcher.h"
+#include "ElteFailPacket.h"
+#include "ElteFailProjectiles.h"
+#include "ElteFailSequenceFilter.h"
+#include "ElteFailSpscQueue.h"
+#include "ElteFailStringTable.h"
+#include "ElteFailWorldState.h"
+
+namespace elte_fail
+{
+
+    struct MatchStats
+    {
+        uint64_t m_nTicks;
+        uint64_t m_nEvents;           /**< Connections, disconnections and packets processed. */
+        uint32_t m_nLastTickUSecs;
+        uint32_t m_nMaxTickUSecs;
+    };
+
+    struct MatchHostStats
+    {
+        uint64_t m_nTicks;
+        uint64_t m_nSkippedTicks;     /**< Ticks not run because the tick thread was late by more than a whole tick. */
+        uint64_t m_nEventStalls;      /**< Times the main thread found the event queue full and had to wait for the tick thread. */
+        uint64_t m_nOutStalls;        /**< Packets kept back by the tick thread for a later tick because the outgoing queue was full. */
+        uint32_t m_nMaxTickUSecs;
+    };
+
+    /**
+        Simulation state of 1 match without any rendering: its own players, interned strings and projectiles.
+        Players are handled by the same MatchRules as the players of the server's own match, so clients don't know which one they are in.
+        Projectiles are stepped by tick() in the same fixed steps as by the sim thread of the server's own match.
+        Connections, disconnections and packets are queued by MatchHost and processed by tick(), which can run on any thread.
+        Packets to be sent are collected by tick() and handed over to MatchHost in flush().
+        Not thread-safe: tick() must not overlap with any other call on the same match.
+    */
+    class Match
+    {
+    public:
+        /**
+            @param collisionWorld  Shared by all matches, only read.
+            @param vTrollfaces     Texture files of trollfaces, each player of the match gets a different one while there are enough.
+            @param nMaxProjectiles Firing fails while this many projectiles of the match are flying.
+        */
+        Match(
+            uint32_t nId,
+            const CollisionWorld& collisionWorld,
+            const std::vector<std::string>& vTrollfaces,
+            uint32_t nMaxProjectiles,
+            AsyncLogger& log);
+
+        uint32_t getId() const;
+        size_t getPlayerCount() const;   /**< Players already set up by tick(). */
+
+        void connect(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const char* szIpAddress);
+        void disconnect(pge_network::PgeNetworkConnectionHandle connHandleServerSide);
+        void receive(const pge_network::PgePacket& pkt);   /**< Packet must be already validated. */
+
+        /**
+            Processes the queued connections, disconnections and packets, in the order they were queued.
+        */
+        void tick();
+
+        /**
+            Invokes fnSend(pkt, connHandleServerSide) for every packet collected by tick(), in order.
+        */
+        template <class F>
+        void flush(F&& fnSend)
+        {
+            for (const auto& pktOut : m_vOutbox)
+            {
+                fnSend(pktOut.m_pkt, pktOut.m_connHandleServerSide);
+            }
+            m_vOutbox.clear();
+        }
+
+        void getPlayers(std::vector<WorldStatePlayer>& vPlayers) const;
+
+        const StringTable& getStrings() const;
+        const ProjectilePool& getProjectiles() const;
+
+        const MatchStats& getStats() const;
+
+    private:
+
+        enum class EventType
+        {
+            Connect,
+            Disconnect,
+            Packet
+        };
+
+        struct Event
+        {
+            EventType m_type;
+            pge_network::PgeNetworkConnectionHandle m_connHandleServerSide;
+            std::string m_sIpAddress;         /**< Connect only. */
+            pge_network::PgePacket m_pkt;     /**< Packet only. */
+        };
+
+        struct OutPkt
+        {
+            pge_network::PgePacket m_pkt;
+            pge_network::PgeNetworkConnectionHandle m_connHandleServerSide;   /**< Recipient. */
+        };
+
+        const uint32_t m_nId;
+        const CollisionWorld& m_collisionWorld;
+        AsyncLogger& m_log;
+        StringTable m_strings;
+        MatchRules m_rules;
+        std::map<pge_network::PgeNetworkConnectionHandle, WorldStatePlayer> m_mapPlayers;
+        std::set<pge_network::PgeNetworkConnectionHandle>
+            m_rejectedConnections;          /**< Not admitted by m_rules, ignored until they disconnect. */
+        std::map<pge_network::PgeNetworkConnectionHandle, uint16_t>
+            m_mapUserUpdateSeqs;            /**< Per player, sequence number of the last MsgUserUpdateFromServer about them. */
+        std::map<pge_network::PgeNetworkConnectionHandle, uint64_t>
+            m_mapLastFireUSecs;             /**< Per player, when they last fired a projectile, for limiting fire rate. */
+        std::set<pge_network::PgeNetworkConnectionHandle>
+            m_movedPlayers;                 /**< Players moved during the current tick, their latest position is sent at the end of tick(). */
+        SequenceFilter m_seqFilter;
+        ProjectilePool m_projectiles;
+        std::vector<ProjectileTarget> m_vProjectileTargets;
+        std::vector<ProjectileEvent> m_vProjectileEvents;   /**< Spawns and despawns of the current tick, sent at the end of tick(). */
+        std::chrono::steady_clock::time_point m_timeNextProjectileStep;
+        std::vector<Event> m_vInbox;
+        std::vector<OutPkt> m_vOutbox;
+        MatchStats m_stats;
+
+        // ---------------------------------------------------------------------------
+
+        Match(const Match&);
+        Match& operator=(const Match&);
+
+        void send(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide);
+        bool handleConnect(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const std::string& sIpAddress);
+        void handleDisconnect(pge_network::PgeNetworkConnectionHandle connHandleServerSide);
+        bool handlePkt(const pge_network::PgePacket& pkt);
+        bool handleUserCmdMove(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const MsgUserCmdMoveFromClient& msg);
+        bool handleUserCmdFire(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const MsgUserCmdFireFromClient& msg);
+        bool sendUserUpdates();
+        void stepProjectiles(const std::chrono::steady_clock::time_point& timeNow);
+        bool sendProjectileEvents();
+
+        /**
+            Messages of MsgDirection::ServerToClient are not accepted from clients, see MsgAppDispatcher::fillAllowList().
+        */
+        template <class TMsg>
+        bool handleMsgFromServer(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const TMsg&)
+        {
+            m_log.EOLn("Match::%s(): match %u: received %s from connHandleServerSide %u, CANNOT HAPPEN!", __func__, m_nId, TMsg::zstring, connHandleServerSide);
+            return false;
+        }
+
+        /** App message handlers, same as the handlers of the server's own match, see CustomPGE::TMsgAppDispatcher. */
+        using TMsgAppDispatcher = MsgAppDispatcher<
+            Match,
+            &Match::handleMsgFromServer<MsgUserSetupFromServer>,
+            &Match::handleUserCmdMove,
+            &Match::handleMsgFromServer<MsgUserUpdateFromServer>,
+            &Match::handleMsgFromServer<MsgWorldStateFromServer>,
+            &Match::handleMsgFromServer<MsgStringDefFromServer>,
+            &Match::handleUserCmdFire,
+            &Match::handleMsgFromServer<MsgProjectileEventsFromServer>>;
+
+        TMsgAppDispatcher m_msgAppDispatcher;
+    }; // class Match
+
+    /**
+        Hosts match instances next to the server's own match, routing every connection to 1 of them by its handle.
+        Matches are ticked on the own thread of the host at the fixed rate of ProjectilePool::fStepSecs, so they don't depend on
+        the frame rate and stalls of the main thread calling PGE and PURE.
+        On every tick, all matches run in parallel on a work-stealing JobPool, so the number of matches a server process can host
+        scales with the number of cores instead of running 1 process per match.
+        Main thread talks to the tick thread only through lock-free queues:
+         - connections, disconnections and packets go in through connect(), disconnect() and receive(),
+         - packets to be sent come out through flush().
+        Routing is done by the main thread when the connection is queued, matches are created by the tick thread when needed,
+        up to the configured max, and are kept when they become empty.
+        All functions must be called by the main thread.
+    */
+    class MatchHost
+    {
+    public:
+        static const size_t nEventQueueSize = 1024;   /**< Connections, disconnections and packets, must be power of 2. */
+        static const size_t nOutQueueSize = 1024;     /**< Packets to be sent, must be power of 2. */
+
+        MatchHost();
+        ~MatchHost();
+
+        /**
+            @param nMaxMatches          Max number of hosted matches, not including the server's own match.
+            @param nMaxPlayersPerMatch  A new match is created when all matches have this many connections.
+            @param nWorkers             Worker threads of the pool, see JobPool::start().
+            @param collisionWorld       Must outlive the host, it is shared by all matches.
+            @param nMaxProjectiles      Per match, see Match().
+        */
+        bool start(
+            uint32_t nMaxMatches,
+            uint32_t nMaxPlayersPerMatch,
+            uint32_t nWorkers,
+            const CollisionWorld& collisionWorld,
+            const std::vector<std::string>& vTrollfaces,
+            uint32_t nMaxProjectiles,
+            AsyncLogger& log);
+
+        /**
+            Stops the tick thread and the pool. Queued connections, disconnections and packets are passed to their matches
+            without ticking them, and matches are kept for getMatch() until the next start().
+        */
+        void stop();
+
+        bool isStarted() const;
+
+        /**
+            Routes the given new connection to a match having room for it, creating a new match if needed.
+
+            @return False if not started or all matches are full, then the connection is not routed.
+        */
+        bool connect(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const char* szIpAddress);
+
+        /**
+            @return False if the connection is not routed to any match.
+        */
+        bool disconnect(pge_network::PgeNetworkConnectionHandle connHandleServerSide);
+
+        /**
+            Forwards the given packet to the match of its connection.
+
+            @return False if the connection is not routed to any match.
+        */
+        bool receive(const pge_network::PgePacket& pkt);
+
+        bool isRouted(pge_network::PgeNetworkConnectionHandle connHandleServerSide) const;
+        size_t getConnectionCount() const;
+        size_t getMatchCount() const;   /**< Including matches not yet created by the tick thread. */
+
+        /**
+            Valid only while stopped.
+        */
+        const Match& getMatch(size_t iMatch) const;
+
+        const JobPool& getPool() const;
+
+        /**
+            Invokes fnSend(pkt, connHandleServerSide) for the packets collected by the matches since the last call, in order.
+        */
+        template <class F>
+        void flush(F&& fnSend)
+        {
+            OutPkt pktOut;
+            while (m_qOut.tryPop(pktOut))
+            {
+                fnSend(pktOut.m_pkt, pktOut.m_connHandleServerSide);
+            }
+        }
+
+        /**
+            Valid only while stopped.
+        */
+        const MatchHostStats& getStats() const;
+
+    private:
+
+        enum class EventType
+        {
+            Connect,
+            Disconnect,
+            Packet
+        };
+
+        struct Event
+        {
+            EventType m_type;
+            size_t m_iMatch;                  /**< Might be the next match to be created. */
+            pge_network::PgeNetworkConnectionHandle m_connHandleServerSide;
+            std::string m_sIpAddress;         /**< Connect only. */
+            pge_network::PgePacket m_pkt;     /**< Packet only. */
+        };
+
+        struct OutPkt
+        {
+            pge_network::PgePacket m_pkt;
+            pge_network::PgeNetworkConnectionHandle m_connHandleServerSide;   /**< Recipient. */
+        };
+
+        JobPool m_pool;
+        std::vector<std::unique_ptr<Match>> m_vMatches;   /**< Owned by the tick thread while running. */
+        std::vector<uint32_t> m_vConnectionCounts;   /**< Per match, including connections not yet processed by the tick thread. */
+        std::unordered_map<pge_network::PgeNetworkConnectionHandle, size_t> m_mapRoutes;   /**< Connection -> index of its match. */
+        uint32_t m_nMaxMatches;
+        uint32_t m_nMaxPlayersPerMatch;
+        const CollisionWorld* m_pCollisionWorld;
+        std::vector<std::string> m_vTrollfaces;
+        uint32_t m_nMaxProjectiles;
+        AsyncLogger* m_pLog;
+        SpscQueue<Event, nEventQueueSize> m_qEvents;
+        SpscQueue<OutPkt, nOutQueueSize> m_qOut;
+        std::vector<OutPkt> m_vOutPending;   /**< Tick thread only, packets not fitting into m_qOut, sent before any newer packet. */
+        MatchHostStats m_stats;              /**< Written by tick thread, except m_nEventStalls. */
+        std::thread m_thread;
+        std::atomic<bool> m_bRunning;
+
+        // ---------------------------------------------------------------------------
+
+        MatchHost(const MatchHost&);
+        MatchHost& operator=(const MatchHost&);
+
+        void pushEvent(const Event& event);
+        void dispatchEvents();
+        void queueOut(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide);
+        void run();
+        void tick();
+    }; // class MatchHost
+
+} // namespace elte_fail
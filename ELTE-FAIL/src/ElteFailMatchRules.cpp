@@ -0,0 +1,261 @@
+/*
+    ###################################################################################
+    ElteFailMatchRules.cpp
+    Server-side rules of ELTE-FAIL matches, shared by the server's own match and hosted matches.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailMatchRules.h"
+
+#include <cstdio>
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::Aabb elte_fail::MatchRules::getPlayerCollisionBox(float fPosX, float fPosY)
+{
+    return {
+        { fPosX - fPlayerCollisionHalfWidth, fPosY - fPlayerCollisionHalfWidth, fPlayerPosZ - fPlayerCollisionHalfDepth },
+        { fPosX + fPlayerCollisionHalfWidth, fPosY + fPlayerCollisionHalfWidth, fPlayerPosZ + fPlayerCollisionHalfDepth } };
+} // getPlayerCollisionBox()
+
+
+void elte_fail::MatchRules::getMoveDelta(HorizontalDirection dirHorizontal, VerticalDirection dirVertical, float& fDx, float& fDy)
+{
+    fDx = 0.f;
+    switch (dirHorizontal)
+    {
+    case HorizontalDirection::LEFT:
+        fDx = -fPlayerStep;
+        break;
+    case HorizontalDirection::RIGHT:
+        fDx = fPlayerStep;
+        break;
+    default: /* no-op */
+        break;
+    }
+
+    fDy = 0.f;
+    switch (dirVertical)
+    {
+    case VerticalDirection::DOWN:
+        fDy = -fPlayerStep;
+        break;
+    case VerticalDirection::UP:
+        fDy = fPlayerStep;
+        break;
+    default: /* no-op */
+        break;
+    }
+} // getMoveDelta()
+
+
+bool elte_fail::MatchRules::applyMove(
+    const CollisionWorld& collisionWorld, HorizontalDirection dirHorizontal, VerticalDirection dirVertical, float& fPosX, float& fPosY)
+{
+    float fDx;
+    float fDy;
+    getMoveDelta(dirHorizontal, dirVertical, fDx, fDy);
+    collisionWorld.clampMove(getPlayerCollisionBox(fPosX, fPosY), fDx, fDy);
+    if ((fDx == 0.f) && (fDy == 0.f))
+    {
+        return false;
+    }
+    fPosX += fDx;
+    fPosY += fDy;
+    return true;
+} // applyMove()
+
+
+elte_fail::MatchRules::MatchRules(uint32_t nMatchId, StringTable& strings, AsyncLogger& log) :
+    m_nMatchId(nMatchId),
+    m_strings(strings),
+    m_log(log),
+    m_nWorldStateSnapshotId(0),
+    m_nLastProjectileId(ProjectilePool::nInvalidId),
+    m_rng(nMatchId + 1)
+{
+
+} // MatchRules()
+
+
+void elte_fail::MatchRules::seed(uint32_t nSeed)
+{
+    m_rng.seed(nSeed);
+} // seed()
+
+
+bool elte_fail::MatchRules::addTrollface(const std::string& sFilename)
+{
+    const TStringId nTrollfaceId = m_strings.intern(sFilename);
+    if (nTrollfaceId == StringTable::nInvalidStringId)
+    {
+        return false;
+    }
+    m_trollFaces.insert(nTrollfaceId);
+    return true;
+} // addTrollface()
+
+
+size_t elte_fail::MatchRules::getFreeTrollfaceCount() const
+{
+    return m_trollFaces.size();
+} // getFreeTrollfaceCount()
+
+
+bool elte_fail::MatchRules::admit(
+    pge_network::PgeNetworkConnectionHandle connHandleServerSide, const std::string& sIpAddress, WorldStatePlayer& player)
+{
+    TStringId nTrollfaceId = StringTable::nInvalidStringId;
+    if (!m_trollFaces.empty())
+    {
+        // the free trollfaces keep their own reference, the player takes another one
+        nTrollfaceId = *m_trollFaces.begin();
+        m_strings.addRef(nTrollfaceId);
+    }
+    else
+    {
+        m_log.WLn("MatchRules::%s(): match %u: no more trollfaces left for user with connHandle %u", __func__, m_nMatchId, connHandleServerSide);
+        nTrollfaceId = m_strings.intern("");
+    }
+    const TStringId nUserNameId = m_strings.intern(genUniqueUserName());
+    const TStringId nIpAddressId = m_strings.intern(sIpAddress);
+
+    if ((nTrollfaceId == StringTable::nInvalidStringId) ||
+        (nUserNameId == StringTable::nInvalidStringId) ||
+        (nIpAddressId == StringTable::nInvalidStringId))
+    {
+        m_log.EOLn("MatchRules::%s(): match %u: string table is full, cannot admit user with connHandle %u!",
+            __func__, m_nMatchId, connHandleServerSide);
+        for (const auto& nStringId : { nTrollfaceId, nUserNameId, nIpAddressId })
+        {
+            if (nStringId != StringTable::nInvalidStringId)
+            {
+                releaseString(nStringId);
+            }
+        }
+        return false;
+    }
+
+    m_trollFaces.erase(nTrollfaceId);
+    player.m_connHandleServerSide = connHandleServerSide;
+    player.m_nUserNameId = nUserNameId;
+    player.m_nTrollfaceId = nTrollfaceId;
+    player.m_nIpAddressId = nIpAddressId;
+    player.m_fPosX = 0.f;
+    player.m_fPosY = 0.f;
+    return true;
+} // admit()
+
+
+void elte_fail::MatchRules::release(const WorldStatePlayer& player)
+{
+    if (!m_strings.getString(player.m_nTrollfaceId).empty())
+    {
+        m_trollFaces.insert(player.m_nTrollfaceId);  // re-insert the unneeded trollface texture into the set
+    }
+    m_mapStringIdsSentToClient.erase(player.m_connHandleServerSide);
+    for (const auto& nStringId : { player.m_nUserNameId, player.m_nTrollfaceId, player.m_nIpAddressId })
+    {
+        releaseString(nStringId);
+    }
+} // release()
+
+
+bool elte_fail::MatchRules::fire(
+    const MsgUserCmdFireFromClient& msg,
+    uint64_t nNowUSecs,
+    uint64_t& nLastFireUSecs,
+    ProjectileEvent& event,
+    float& fPosX,
+    float& fPosY,
+    float& fVelX,
+    float& fVelY)
+{
+    if (nNowUSecs - nLastFireUSecs < nFireIntervalUSecs)
+    {
+        return false;
+    }
+    nLastFireUSecs = nNowUSecs;
+
+    event.m_type = ProjectileEventType::Spawn;
+    event.m_nDir = ProjectilePool::encodeDir(msg.m_dirHorizontal, msg.m_dirVertical);
+    event.m_nPosX = ProjectileEvent::quantizePos(fPosX);
+    event.m_nPosY = ProjectileEvent::quantizePos(fPosY);
+    fPosX = ProjectileEvent::dequantizePos(event.m_nPosX);
+    fPosY = ProjectileEvent::dequantizePos(event.m_nPosY);
+    ProjectilePool::getVelocity(msg.m_dirHorizontal, msg.m_dirVertical, fVelX, fVelY);
+    // ids wrap around long after the projectiles using them expired
+    if (++m_nLastProjectileId == ProjectilePool::nInvalidId)
+    {
+        ++m_nLastProjectileId;
+    }
+    event.m_nId = m_nLastProjectileId;
+    return true;
+} // fire()
+
+
+void elte_fail::MatchRules::clear()
+{
+    m_trollFaces.clear();
+    m_mapStringIdsSentToClient.clear();
+} // clear()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+std::string elte_fail::MatchRules::genUniqueUserName()
+{
+    char szNewUserName[32];
+    do
+    {
+        sprintf_s(szNewUserName, sizeof(szNewUserName), "User%d", 10000 + static_cast<int>(m_rng() % 100000));
+        // strings of leaving players are removed from the table, so a name in the table belongs to a player
+    } while (m_strings.find(szNewUserName) != StringTable::nInvalidStringId);
+    return szNewUserName;
+} // genUniqueUserName()
+
+
+/**
+    Clients keep the string under its id until the id is defined again, so the new string of a reused id must be sent to them.
+*/
+void elte_fail::MatchRules::releaseString(TStringId nStringId)
+{
+    if (!m_strings.release(nStringId))
+    {
+        return;
+    }
+
+    for (auto& it : m_mapStringIdsSentToClient)
+    {
+        if (nStringId < it.second.size())
+        {
+            it.second[nStringId] = false;
+        }
+    }
+} // releaseString()
+
+
+/**
+    @return True if the string was not yet sent to the client, i.e. the caller should send it now.
+*/
+bool elte_fail::MatchRules::markStringSent(pge_network::PgeNetworkConnectionHandle connHandleServerSide, TStringId nStringId)
+{
+    std::vector<bool>& vSent = m_mapStringIdsSentToClient[connHandleServerSide];
+    if (nStringId >= vSent.size())
+    {
+        vSent.resize(static_cast<size_t>(nStringId) + 1, false);
+    }
+    if (vSent[nStringId])
+    {
+        return false;
+    }
+    vSent[nStringId] = true;
+    return true;
+} // markStringSent()
@@ -0,0 +1,256 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailMatchRules.h
+    Server-side rules of ELTE-FAIL matches, shared by the server's own match and hosted matches.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <cassert>
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../../../PGE/PGE/Network/PgePacket.h"
+
+#include "ElteFailAsyncLog.h"
+#include "ElteFailCollisionWorld.h"
+#include "ElteFailPacket.h"
+#include "ElteFailProjectiles.h"
+#include "ElteFailStringTable.h"
+#include "ElteFailWorldState.h"
+
+namespace elte_fail
+{
+
+    /**
+        What happens to the players of a match on server side, regardless of where the players are stored and how packets are sent:
+        the server's own match (CustomPGE) and the matches hosted by MatchHost both set up, inform and move players by this,
+        so clients cannot tell which kind of match they are in.
+        Keeps the trollfaces not yet assigned, the strings already sent to each client and the id of the last world state snapshot.
+        Strings are interned into the table given by the owner, so the owner can use the same ids, e.g. for rendering.
+        Every admitted player holds a reference to its strings until it is released, so ids of strings no longer used are reused.
+        Packets are sent by invoking fnSend(pkt, connHandleServerSide) of the caller, for 1 recipient at a time.
+        Not thread-safe.
+    */
+    class MatchRules
+    {
+    public:
+        static constexpr float fPlayerPosZ = 2.f;
+        static constexpr float fPlayerStep = 0.01f;                /**< Distance moved by 1 MsgUserCmdMoveFromClient. */
+        static constexpr float fPlayerCollisionHalfWidth = 0.25f;  /**< Player plane is 0.5 x 0.5. */
+        static constexpr float fPlayerCollisionHalfDepth = 0.05f;  /**< Player plane is flat, but should not slip through thin walls. */
+        static const uint64_t nFireIntervalUSecs = 200000;         /**< Min time between 2 projectiles fired by the same player. */
+
+        static Aabb getPlayerCollisionBox(float fPosX, float fPosY);
+
+        /**
+            @return Movement wanted by the given directions, before collision.
+        */
+        static void getMoveDelta(HorizontalDirection dirHorizontal, VerticalDirection dirVertical, float& fDx, float& fDy);
+
+        /**
+            Moves the player at the given position by the given directions, as far as the walls of the world let it.
+
+            @return False if the player didn't move, e.g. blocked by wall, so no one needs to be updated.
+        */
+        static bool applyMove(
+            const CollisionWorld& collisionWorld, HorizontalDirection dirHorizontal, VerticalDirection dirVertical, float& fPosX, float& fPosY);
+
+        /**
+            @param nMatchId  Used for logging and as initial seed of user name generation.
+        */
+        MatchRules(uint32_t nMatchId, StringTable& strings, AsyncLogger& log);
+
+        /**
+            Restarts user name generation from the given seed, so a replayed net capture gets the same user names.
+        */
+        void seed(uint32_t nSeed);
+
+        /**
+            Interns the given texture file as a trollface, players get different trollfaces while there are enough.
+        */
+        bool addTrollface(const std::string& sFilename);
+
+        size_t getFreeTrollfaceCount() const;
+
+        /**
+            Gives identity to a new player: unique user name, a free trollface and the given IP address, all interned.
+
+            @param player  Its connection handle and string ids are set, position is zeroed.
+            @return False if the string table is full, then nothing is kept and the connection should be rejected.
+        */
+        bool admit(pge_network::PgeNetworkConnectionHandle connHandleServerSide, const std::string& sIpAddress, WorldStatePlayer& player);
+
+        /**
+            Takes back the trollface of the leaving player, releases its strings and forgets which strings its client knows.
+            Strings removed from the table are forgotten by the other clients too, since their ids might be reused.
+        */
+        void release(const WorldStatePlayer& player);
+
+        /**
+            Lets the player at the given position fire in the direction of the given command, unless it fired too recently.
+            Projectile is spawned at the replicated position, so server and clients simulate the same flight.
+
+            @param nLastFireUSecs  When the player fired last time, updated if it can fire now.
+            @param event           Spawn event to be sent to the clients, with a new projectile id.
+            @param fPosX, fPosY    Position of the player, replaced by the position of the new projectile.
+            @param fVelX, fVelY    Velocity of the new projectile.
+            @return False if the player cannot fire yet.
+        */
+        bool fire(
+            const MsgUserCmdFireFromClient& msg,
+            uint64_t nNowUSecs,
+            uint64_t& nLastFireUSecs,
+            ProjectileEvent& event,
+            float& fPosX,
+            float& fPosY,
+            float& fVelX,
+            float& fVelY);
+
+        /**
+            Informs the other players about the new admitted player and the new player about itself by MsgUserSetupFromServer,
+            then sends the other players to the new player in a single world state snapshot.
+            Every recipient gets the definitions of strings not yet known by it before any message referring to them.
+
+            @param vPlayers         Players already in the match, without the new player.
+            @param connHandleLocal  Player in vPlayers which is not to be sent anything because it is served locally, 0 if none.
+        */
+        template <class F>
+        bool sendJoin(
+            const WorldStatePlayer& player,
+            const std::vector<WorldStatePlayer>& vPlayers,
+            pge_network::PgeNetworkConnectionHandle connHandleLocal,
+            F&& fnSend)
+        {
+            pge_network::PgePacket pktSetup;
+            if (!MsgUserSetupFromServer::initPkt(
+                pktSetup, player.m_connHandleServerSide, false, player.m_nUserNameId, player.m_nTrollfaceId, player.m_nIpAddressId))
+            {
+                m_log.EOLn("MatchRules::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
+                assert(false);
+                return false;
+            }
+
+            // inform all other players about this new user, they need the strings of the new user first
+            for (const auto& otherPlayer : vPlayers)
+            {
+                if (otherPlayer.m_connHandleServerSide == connHandleLocal)
+                {
+                    continue;
+                }
+                if (!sendStrings(otherPlayer.m_connHandleServerSide, { player.m_nUserNameId, player.m_nTrollfaceId, player.m_nIpAddressId }, fnSend))
+                {
+                    return false;
+                }
+                fnSend(pktSetup, otherPlayer.m_connHandleServerSide);
+            }
+
+            // now we send this msg to the client with this bool flag set so client will know it is their connect
+            if (!sendStrings(player.m_connHandleServerSide, { player.m_nUserNameId, player.m_nTrollfaceId, player.m_nIpAddressId }, fnSend))
+            {
+                return false;
+            }
+            pge_network::PgePacket::getMsgAppDataFromPkt<MsgUserSetupFromServer>(pktSetup).m_bCurrentClient = true;
+            fnSend(pktSetup, player.m_connHandleServerSide);
+
+            if (vPlayers.empty())
+            {
+                return true;
+            }
+
+            // already connected players in a single world state snapshot, otherwise client won't know about them,
+            // strings not yet known by the client are defined in the snapshot itself
+            std::vector<WorldStateStringDef> vStringDefs;
+            for (const auto& otherPlayer : vPlayers)
+            {
+                for (const auto& nStringId : { otherPlayer.m_nUserNameId, otherPlayer.m_nTrollfaceId, otherPlayer.m_nIpAddressId })
+                {
+                    if (markStringSent(player.m_connHandleServerSide, nStringId))
+                    {
+                        vStringDefs.push_back({ nStringId, m_strings.getString(nStringId) });
+                    }
+                }
+            }
+
+            std::vector<uint8_t> vSnapshot;
+            WorldState::serialize(vStringDefs, vPlayers, vSnapshot);
+
+            std::vector<pge_network::PgePacket> vPktsWorldState;
+            if (!WorldState::initPkts(vPktsWorldState, ++m_nWorldStateSnapshotId, vSnapshot, true))
+            {
+                m_log.EOLn("MatchRules::%s(): initPkts() FAILED at line %d!", __func__, __LINE__);
+                assert(false);
+                return false;
+            }
+            for (const auto& pktWorldState : vPktsWorldState)
+            {
+                fnSend(pktWorldState, player.m_connHandleServerSide);
+            }
+            m_log.OLn("MatchRules::%s(): match %u: sent world state of %u players and %u new strings in %u bytes (%u fragments) to user %s",
+                __func__,
+                m_nMatchId,
+                static_cast<uint32_t>(vPlayers.size()),
+                static_cast<uint32_t>(vStringDefs.size()),
+                static_cast<uint32_t>(vSnapshot.size()),
+                static_cast<uint32_t>(vPktsWorldState.size()),
+                m_strings.getString(player.m_nUserNameId).c_str());
+            return true;
+        }
+
+        void clear();  /**< Forgets trollfaces and clients, string table is cleared by its owner. */
+
+    private:
+        const uint32_t m_nMatchId;
+        StringTable& m_strings;
+        AsyncLogger& m_log;
+        std::set<TStringId> m_trollFaces;   /**< Ids of trollface texture file names not yet assigned to any player. */
+        std::map<pge_network::PgeNetworkConnectionHandle, std::vector<bool>>
+            m_mapStringIdsSentToClient;     /**< Per client, which strings have been already sent by MsgStringDefFromServer or world state. */
+        uint16_t m_nWorldStateSnapshotId;   /**< Id of the last world state snapshot sent. */
+        TProjectileId m_nLastProjectileId;
+        std::minstd_rand m_rng;             /**< For user names, not rand(), since matches can run on multiple threads. */
+
+        // ---------------------------------------------------------------------------
+
+        MatchRules(const MatchRules&);
+        MatchRules& operator=(const MatchRules&);
+
+        std::string genUniqueUserName();
+        void releaseString(TStringId nStringId);
+        bool markStringSent(pge_network::PgeNetworkConnectionHandle connHandleServerSide, TStringId nStringId);
+
+        /**
+            Sends the definitions of those given strings to the given client which have not yet been sent to it.
+            Must be called before sending any message referring to these strings.
+        */
+        template <class F>
+        bool sendStrings(pge_network::PgeNetworkConnectionHandle connHandleServerSide, std::initializer_list<TStringId> stringIds, F& fnSend)
+        {
+            for (const auto& nStringId : stringIds)
+            {
+                if ((nStringId == StringTable::nInvalidStringId) || !markStringSent(connHandleServerSide, nStringId))
+                {
+                    continue;
+                }
+
+                pge_network::PgePacket pktStringDef;
+                if (!MsgStringDefFromServer::initPkt(pktStringDef, nStringId, m_strings.getString(nStringId)))
+                {
+                    m_log.EOLn("MatchRules::%s(): initPkt() FAILED at line %d!", __func__, __LINE__);
+                    assert(false);
+                    return false;
+                }
+                fnSend(pktStringDef, connHandleServerSide);
+            }
+            return true;
+        }
+    }; // class MatchRules
+
+} // namespace elte_fail
@@ -0,0 +1,512 @@
+/*
+    ###################################################################################
+    ElteFailMeshOptimizer.cpp
+    Import-time optimization of ELTE-FAIL models: welding, vertex cache ordering, material merging.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailMeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <tuple>
+#include <utility>
+
+#include "ElteFailFileUtils.h"
+#include "ElteFailObjFile.h"
+
+// vertex scoring of the reordering, values suggested by Forsyth
+static const float fCacheDecayPower = 1.5f;
+static const float fLastTriangleScore = 0.75f;
+static const float fValenceBoostScale = 2.0f;
+static const float fValenceBoostPower = 0.5f;
+
+static const size_t nJointKeySize = 18;   /**< Bits of position, texcoord and normal of a corner in both the model and the lightmap model. */
+
+using TJointKey = std::array<uint32_t, nJointKeySize>;
+using TIndexTriplet = std::tuple<int32_t, int32_t, int32_t>;
+
+/**
+    Corners of the model and the lightmap model making up 1 welded vertex.
+*/
+struct JointVertex
+{
+    elte_fail::ObjFaceCorner m_corner;
+    elte_fail::ObjFaceCorner m_cornerLightmap;
+};
+
+/**
+    Source groups drawn by 1 call after optimization.
+*/
+struct MergedGroup
+{
+    std::string m_sName;
+    std::string m_sLightmapName;
+    std::vector<size_t> m_vSourceGroups;
+};
+
+static TIndexTriplet getIndexTriplet(const elte_fail::ObjFaceCorner& corner)
+{
+    return std::make_tuple(corner.m_iPosition, corner.m_iTexCoord, corner.m_iNormal);
+}
+
+/**
+    @return Texture name after '|' in the group name written by Max2Obj, empty string if there is no texture.
+*/
+static std::string getMaterialName(const std::string& sGroupName)
+{
+    const size_t iSeparator = sGroupName.find('|');
+    return (iSeparator == std::string::npos) ? "" : sGroupName.substr(iSeparator + 1);
+}
+
+static void appendKey(TJointKey& key, size_t& iKey, const std::vector<elte_fail::ObjVertex>& vVertices, int32_t iVertex)
+{
+    if (iVertex < 0)
+    {
+        // NaN pattern not produced by parsing, so missing attribute never equals to any present one
+        key[iKey++] = 0xFFFFFFFFu;
+        key[iKey++] = 0xFFFFFFFFu;
+        key[iKey++] = 0xFFFFFFFFu;
+        return;
+    }
+    const elte_fail::ObjVertex& v = vVertices[iVertex];
+    memcpy(&key[iKey++], &v.m_fX, sizeof(uint32_t));
+    memcpy(&key[iKey++], &v.m_fY, sizeof(uint32_t));
+    memcpy(&key[iKey++], &v.m_fZ, sizeof(uint32_t));
+}
+
+static void appendKey(TJointKey& key, size_t& iKey, const elte_fail::ObjFile& obj, const elte_fail::ObjFaceCorner& corner)
+{
+    appendKey(key, iKey, obj.getPositions(), corner.m_iPosition);
+    appendKey(key, iKey, obj.getTexCoords(), corner.m_iTexCoord);
+    appendKey(key, iKey, obj.getNormals(), corner.m_iNormal);
+}
+
+/**
+    Appends the attributes of the given corner to the output arrays, all arrays get an element so they can be indexed by the same index.
+*/
+static void appendVertex(
+    const elte_fail::ObjFile& obj,
+    const elte_fail::ObjFaceCorner& corner,
+    std::vector<elte_fail::ObjVertex>& vPositions,
+    std::vector<elte_fail::ObjVertex>& vTexCoords,
+    std::vector<elte_fail::ObjVertex>& vNormals)
+{
+    static const elte_fail::ObjVertex vZero = { 0.f, 0.f, 0.f };
+    vPositions.push_back(obj.getPositions()[corner.m_iPosition]);
+    vTexCoords.push_back((corner.m_iTexCoord >= 0) ? obj.getTexCoords()[corner.m_iTexCoord] : vZero);
+    vNormals.push_back((corner.m_iNormal >= 0) ? obj.getNormals()[corner.m_iNormal] : vZero);
+}
+
+/**
+    @return Number of vertices transformed for the given triangle list with a FIFO post-transform cache of the given size.
+*/
+static uint32_t getCacheMisses(const std::vector<uint32_t>& vIndices, uint32_t nCacheSize)
+{
+    if (vIndices.empty())
+    {
+        return 0;
+    }
+
+    // a vertex is in the cache if it was put there within the last nCacheSize misses
+    std::vector<uint32_t> vPutAt(*std::max_element(vIndices.begin(), vIndices.end()) + 1, 0);
+    uint32_t nMisses = 0;
+    for (const auto i : vIndices)
+    {
+        if ((vPutAt[i] == 0) || (nMisses - vPutAt[i] + 1 > nCacheSize))
+        {
+            vPutAt[i] = ++nMisses;
+        }
+    }
+    return nMisses;
+}
+
+static float getVertexScore(int32_t iCachePos, uint32_t nRemainingTriangles)
+{
+    if (nRemainingTriangles == 0)
+    {
+        return -1.f;
+    }
+
+    float fScore = 0.f;
+    if (iCachePos >= 0)
+    {
+        if (iCachePos < 3)
+        {
+            // vertices of the last triangle get a fixed score, otherwise the same triangle would be picked again
+            fScore = fLastTriangleScore;
+        }
+        else
+        {
+            const float fScaler = 1.f / (elte_fail::MeshOptimizer::nReorderCacheSize - 3);
+            fScore = std::pow(1.f - (iCachePos - 3) * fScaler, fCacheDecayPower);
+        }
+    }
+    // vertices with few triangles left are preferred, to finish them and not leave lone triangles behind
+    fScore += fValenceBoostScale * std::pow(static_cast<float>(nRemainingTriangles), -fValenceBoostPower);
+    return fScore;
+}
+
+
+// ############################### PUBLIC ################################
+
+
+std::string elte_fail::MeshOptimizer::getOutputFilename(const std::string& sFilename)
+{
+    const size_t iDot = sFilename.find_last_of('.');
+    const size_t iSeparator = sFilename.find_last_of("\\/");
+    if ((iDot == std::string::npos) || ((iSeparator != std::string::npos) && (iDot < iSeparator)))
+    {
+        return sFilename + "_opt";
+    }
+    return sFilename.substr(0, iDot) + "_opt" + sFilename.substr(iDot);
+} // getOutputFilename()
+
+
+bool elte_fail::MeshOptimizer::isOutputFilename(const std::string& sFilename)
+{
+    static const std::string sSuffix = "_opt";
+    const size_t iDot = sFilename.find_last_of('.');
+    const size_t iSeparator = sFilename.find_last_of("\\/");
+    const size_t iStemEnd = ((iDot == std::string::npos) || ((iSeparator != std::string::npos) && (iDot < iSeparator))) ? sFilename.size() : iDot;
+    return (iStemEnd >= sSuffix.size()) && (sFilename.compare(iStemEnd - sSuffix.size(), sSuffix.size(), sSuffix) == 0);
+} // isOutputFilename()
+
+
+bool elte_fail::MeshOptimizer::optimize(
+    const ObjFile& obj,
+    const ObjFile* pObjLightmap,
+    ObjFile& objOut,
+    ObjFile* pObjLightmapOut,
+    MeshOptimizerStats& stats)
+{
+    stats = {};
+    if (pObjLightmap && (!pObjLightmapOut || !obj.hasSameFaces(*pObjLightmap)))
+    {
+        return false;
+    }
+
+    // merging groups by material, merged group takes the place of its first group
+    std::vector<MergedGroup> vMerged;
+    std::map<std::pair<std::string, std::string>, size_t> mapMaterials;
+    for (size_t iGroup = 0; iGroup < obj.getGroups().size(); iGroup++)
+    {
+        const ObjGroup& group = obj.getGroups()[iGroup];
+        if (group.m_vCorners.size() < 3)
+        {
+            continue;
+        }
+
+        // before: renderer creates a vertex for each distinct index triplet of a group, in both models
+        std::map<std::pair<TIndexTriplet, TIndexTriplet>, uint32_t> mapVertices;
+        std::vector<uint32_t> vIndices;
+        vIndices.reserve(group.m_vCorners.size());
+        for (size_t i = 0; i < group.m_vCorners.size(); i++)
+        {
+            const auto vertex = std::make_pair(
+                getIndexTriplet(group.m_vCorners[i]),
+                pObjLightmap ? getIndexTriplet(pObjLightmap->getGroups()[iGroup].m_vCorners[i]) : TIndexTriplet(-1, -1, -1));
+            vIndices.push_back(mapVertices.emplace(vertex, static_cast<uint32_t>(mapVertices.size())).first->second);
+        }
+        stats.m_nVerticesBefore += static_cast<uint32_t>(mapVertices.size());
+        stats.m_fAcmrBefore += static_cast<float>(getCacheMisses(vIndices, nAcmrCacheSize));
+        stats.m_nDrawCallsBefore++;
+        stats.m_nTriangles += static_cast<uint32_t>(group.m_vCorners.size() / 3);
+
+        const std::string sLightmapName = pObjLightmap ? pObjLightmap->getGroups()[iGroup].m_sName : "";
+        const auto material = std::make_pair(getMaterialName(group.m_sName), getMaterialName(sLightmapName));
+        const auto itMaterial = mapMaterials.find(material);
+        if (itMaterial == mapMaterials.end())
+        {
+            mapMaterials.emplace(material, vMerged.size());
+            vMerged.push_back({ group.m_sName, sLightmapName, { iGroup } });
+        }
+        else
+        {
+            vMerged[itMaterial->second].m_vSourceGroups.push_back(iGroup);
+        }
+    }
+
+    std::vector<ObjVertex> vPositions, vTexCoords, vNormals;
+    std::vector<ObjVertex> vLightmapPositions, vLightmapTexCoords, vLightmapNormals;
+    std::vector<ObjGroup> vGroups, vLightmapGroups;
+    for (const auto& merged : vMerged)
+    {
+        // welding: corners having the same attributes in both models become the same vertex
+        std::map<TJointKey, uint32_t> mapVertices;
+        std::vector<JointVertex> vVertices;
+        std::vector<uint32_t> vIndices;
+        for (const auto iGroup : merged.m_vSourceGroups)
+        {
+            const ObjGroup& group = obj.getGroups()[iGroup];
+            const size_t nCorners = group.m_vCorners.size() - group.m_vCorners.size() % 3;
+            for (size_t i = 0; i < nCorners; i++)
+            {
+                const ObjFaceCorner& corner = group.m_vCorners[i];
+                const ObjFaceCorner cornerLightmap = pObjLightmap ? pObjLightmap->getGroups()[iGroup].m_vCorners[i] : ObjFaceCorner{ -1, -1, -1 };
+
+                TJointKey key;
+                size_t iKey = 0;
+                appendKey(key, iKey, obj, corner);
+                if (pObjLightmap)
+                {
+                    appendKey(key, iKey, *pObjLightmap, cornerLightmap);
+                }
+                std::fill(key.begin() + iKey, key.end(), 0u);
+
+                const auto itVertex = mapVertices.emplace(key, static_cast<uint32_t>(vVertices.size())).first;
+                if (itVertex->second == vVertices.size())
+                {
+                    vVertices.push_back({ corner, cornerLightmap });
+                }
+                vIndices.push_back(itVertex->second);
+            }
+        }
+
+        reorderForVertexCache(vIndices, static_cast<uint32_t>(vVertices.size()));
+        stats.m_nVerticesAfter += static_cast<uint32_t>(vVertices.size());
+        stats.m_fAcmrAfter += static_cast<float>(getCacheMisses(vIndices, nAcmrCacheSize));
+        stats.m_nDrawCallsAfter++;
+
+        // vertices are appended in order of first use, so they are also fetched in order
+        std::vector<int32_t> vMap(vVertices.size(), -1);
+        vGroups.push_back({ merged.m_sName, {} });
+        vGroups.back().m_vCorners.reserve(vIndices.size());
+        if (pObjLightmap)
+        {
+            vLightmapGroups.push_back({ merged.m_sLightmapName, {} });
+            vLightmapGroups.back().m_vCorners.reserve(vIndices.size());
+        }
+        for (const auto i : vIndices)
+        {
+            const JointVertex& vertex = vVertices[i];
+            if (vMap[i] < 0)
+            {
+                vMap[i] = static_cast<int32_t>(vPositions.size());
+                appendVertex(obj, vertex.m_corner, vPositions, vTexCoords, vNormals);
+                if (pObjLightmap)
+                {
+                    appendVertex(*pObjLightmap, vertex.m_cornerLightmap, vLightmapPositions, vLightmapTexCoords, vLightmapNormals);
+                }
+            }
+            vGroups.back().m_vCorners.push_back({
+                vMap[i],
+                (vertex.m_corner.m_iTexCoord >= 0) ? vMap[i] : -1,
+                (vertex.m_corner.m_iNormal >= 0) ? vMap[i] : -1 });
+            if (pObjLightmap)
+            {
+                vLightmapGroups.back().m_vCorners.push_back({
+                    vMap[i],
+                    (vertex.m_cornerLightmap.m_iTexCoord >= 0) ? vMap[i] : -1,
+                    (vertex.m_cornerLightmap.m_iNormal >= 0) ? vMap[i] : -1 });
+            }
+        }
+    }
+
+    if (stats.m_nTriangles > 0)
+    {
+        stats.m_fAcmrBefore /= stats.m_nTriangles;
+        stats.m_fAcmrAfter /= stats.m_nTriangles;
+    }
+
+    objOut.assign(std::move(vPositions), std::move(vTexCoords), std::move(vNormals), std::move(vGroups));
+    if (pObjLightmap)
+    {
+        pObjLightmapOut->assign(
+            std::move(vLightmapPositions), std::move(vLightmapTexCoords), std::move(vLightmapNormals), std::move(vLightmapGroups));
+    }
+    return true;
+} // optimize()
+
+
+bool elte_fail::MeshOptimizer::optimizeFile(const std::string& sFilename, const std::string& sLightmapFilename, MeshOptimizerStats& stats)
+{
+    stats = {};
+
+    ObjFile obj;
+    ObjFile objLightmap;
+    if (!obj.load(sFilename) || (!sLightmapFilename.empty() && !objLightmap.load(sLightmapFilename)))
+    {
+        return false;
+    }
+
+    ObjFile objOut;
+    ObjFile objLightmapOut;
+    const bool bLightmap = !sLightmapFilename.empty();
+    if (!optimize(obj, bLightmap ? &objLightmap : nullptr, objOut, bLightmap ? &objLightmapOut : nullptr, stats))
+    {
+        return false;
+    }
+
+    const std::string sOutFilename = getOutputFilename(sFilename);
+    const std::string sLightmapOutFilename = bLightmap ? getOutputFilename(sLightmapFilename) : "";
+    if (FileUtils::isUpToDate(sOutFilename, sFilename) && (!bLightmap || FileUtils::isUpToDate(sLightmapOutFilename, sLightmapFilename)))
+    {
+        return true;
+    }
+
+    if (!objOut.save(sOutFilename, "ELTE-FAIL optimized model, generated from " + sFilename + ", do not edit") ||
+        (bLightmap && !objLightmapOut.save(sLightmapOutFilename, "ELTE-FAIL optimized model, generated from " + sLightmapFilename + ", do not edit")))
+    {
+        return false;
+    }
+    stats.m_bWritten = true;
+    return true;
+} // optimizeFile()
+
+
+float elte_fail::MeshOptimizer::getAcmr(const std::vector<uint32_t>& vIndices, uint32_t nCacheSize)
+{
+    if (vIndices.size() < 3)
+    {
+        return 0.f;
+    }
+    return static_cast<float>(getCacheMisses(vIndices, nCacheSize)) / (vIndices.size() / 3);
+} // getAcmr()
+
+
+void elte_fail::MeshOptimizer::reorderForVertexCache(std::vector<uint32_t>& vIndices, uint32_t nVertices)
+{
+    const size_t nTriangles = vIndices.size() / 3;
+    if (nTriangles < 2)
+    {
+        return;
+    }
+
+    // triangles of each vertex, emitted triangles are moved to the end of the range of the vertex
+    std::vector<uint32_t> vRemaining(nVertices, 0);
+    for (size_t i = 0; i < nTriangles * 3; i++)
+    {
+        vRemaining[vIndices[i]]++;
+    }
+    std::vector<uint32_t> vOffsets(nVertices + 1, 0);
+    for (uint32_t i = 0; i < nVertices; i++)
+    {
+        vOffsets[i + 1] = vOffsets[i] + vRemaining[i];
+    }
+    std::vector<uint32_t> vAdjacency(nTriangles * 3);
+    {
+        std::vector<uint32_t> vFill(vOffsets.begin(), vOffsets.end() - 1);
+        for (size_t i = 0; i < nTriangles * 3; i++)
+        {
+            vAdjacency[vFill[vIndices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::vector<float> vVertexScores(nVertices);
+    for (uint32_t i = 0; i < nVertices; i++)
+    {
+        vVertexScores[i] = getVertexScore(-1, vRemaining[i]);
+    }
+    std::vector<float> vTriangleScores(nTriangles);
+    for (size_t i = 0; i < nTriangles; i++)
+    {
+        vTriangleScores[i] = vVertexScores[vIndices[i * 3]] + vVertexScores[vIndices[i * 3 + 1]] + vVertexScores[vIndices[i * 3 + 2]];
+    }
+    std::vector<bool> vEmitted(nTriangles, false);
+
+    std::vector<uint32_t> vOut;
+    vOut.reserve(nTriangles * 3);
+    std::vector<uint32_t> vCache;
+    std::vector<uint32_t> vNewCache;
+    vCache.reserve(nReorderCacheSize + 3);
+    vNewCache.reserve(nReorderCacheSize + 3);
+    size_t iBest = nTriangles;
+    size_t iScanFrom = 0;
+    while (vOut.size() < nTriangles * 3)
+    {
+        if (iBest == nTriangles)
+        {
+            // no triangle touches the cache, taking the best one from all remaining triangles
+            float fBestScore = -FLT_MAX;
+            while (vEmitted[iScanFrom])
+            {
+                iScanFrom++;
+            }
+            for (size_t i = iScanFrom; i < nTriangles; i++)
+            {
+                if (!vEmitted[i] && (vTriangleScores[i] > fBestScore))
+                {
+                    fBestScore = vTriangleScores[i];
+                    iBest = i;
+                }
+            }
+        }
+
+        vEmitted[iBest] = true;
+        vNewCache.clear();
+        for (size_t j = iBest * 3; j < iBest * 3 + 3; j++)
+        {
+            const uint32_t iVertex = vIndices[j];
+            vOut.push_back(iVertex);
+            vNewCache.push_back(iVertex);
+
+            // moving the triangle out of the remaining range of the vertex
+            const uint32_t iBegin = vOffsets[iVertex];
+            const uint32_t iEnd = iBegin + vRemaining[iVertex];
+            const auto it = std::find(vAdjacency.begin() + iBegin, vAdjacency.begin() + iEnd, static_cast<uint32_t>(iBest));
+            std::iter_swap(it, vAdjacency.begin() + iEnd - 1);
+            vRemaining[iVertex]--;
+        }
+        for (const auto iVertex : vCache)
+        {
+            if (std::find(vNewCache.begin(), vNewCache.begin() + 3, iVertex) == vNewCache.begin() + 3)
+            {
+                vNewCache.push_back(iVertex);
+            }
+        }
+        std::swap(vCache, vNewCache);
+
+        // vertices pushed out of the cache lose their cache score
+        for (size_t i = nReorderCacheSize; i < vCache.size(); i++)
+        {
+            const uint32_t iVertex = vCache[i];
+            vVertexScores[iVertex] = getVertexScore(-1, vRemaining[iVertex]);
+            for (uint32_t k = vOffsets[iVertex]; k < vOffsets[iVertex] + vRemaining[iVertex]; k++)
+            {
+                const uint32_t iTriangle = vAdjacency[k];
+                vTriangleScores[iTriangle] =
+                    vVertexScores[vIndices[iTriangle * 3]] + vVertexScores[vIndices[iTriangle * 3 + 1]] + vVertexScores[vIndices[iTriangle * 3 + 2]];
+            }
+        }
+        if (vCache.size() > nReorderCacheSize)
+        {
+            vCache.resize(nReorderCacheSize);
+        }
+        for (size_t i = 0; i < vCache.size(); i++)
+        {
+            vVertexScores[vCache[i]] = getVertexScore(static_cast<int32_t>(i), vRemaining[vCache[i]]);
+        }
+
+        // only triangles of cached vertices changed their score, next triangle is picked from them
+        iBest = nTriangles;
+        float fBestScore = -FLT_MAX;
+        for (const auto iVertex : vCache)
+        {
+            for (uint32_t k = vOffsets[iVertex]; k < vOffsets[iVertex] + vRemaining[iVertex]; k++)
+            {
+                const uint32_t iTriangle = vAdjacency[k];
+                vTriangleScores[iTriangle] =
+                    vVertexScores[vIndices[iTriangle * 3]] + vVertexScores[vIndices[iTriangle * 3 + 1]] + vVertexScores[vIndices[iTriangle * 3 + 2]];
+                if (vTriangleScores[iTriangle] > fBestScore)
+                {
+                    fBestScore = vTriangleScores[iTriangle];
+                    iBest = iTriangle;
+                }
+            }
+        }
+    }
+
+    std::copy(vOut.begin(), vOut.end(), vIndices.begin());
+} // reorderForVertexCache()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
@@ -0,0 +1,94 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailMeshOptimizer.h
+    Import-time optimization of ELTE-FAIL models: welding, vertex cache ordering, material merging.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace elte_fail
+{
+
+    class ObjFile;
+
+    struct MeshOptimizerStats
+    {
+        uint32_t m_nTriangles;
+        uint32_t m_nVerticesBefore;    /**< Distinct v/vt/vn index triplets per group (of both models), as the renderer creates vertices. */
+        uint32_t m_nVerticesAfter;
+        uint32_t m_nDrawCallsBefore;   /**< Groups having faces, each one is a subobject drawn separately. */
+        uint32_t m_nDrawCallsAfter;
+        float m_fAcmrBefore;           /**< Average cache miss ratio: transformed vertices per triangle, see MeshOptimizer::getAcmr(). */
+        float m_fAcmrAfter;
+        bool m_bWritten;               /**< True if the optimized files were (re)written, false if they were up to date. */
+    };
+
+    /**
+        Optimizes models exported by Max2Obj before they are given to the renderer:
+         - groups with the same material are merged, so they are drawn by 1 call instead of 1 call per group;
+         - vertices having exactly the same attributes are welded, since the exporter writes the same vertex multiple times;
+         - triangles of each group are reordered for the post-transform vertex cache (Tom Forsyth's linear-speed algorithm).
+        Material of a group is the texture name after '|' in the group name. If a lightmap model is given, it is optimized
+        together with the model and its lightmap texture is part of the material too, so the output lightmap model still has
+        the same subobjects with the same vertices as the output model.
+    */
+    class MeshOptimizer
+    {
+    public:
+        static const uint32_t nReorderCacheSize = 32;   /**< LRU cache size assumed by the reordering. */
+        static const uint32_t nAcmrCacheSize = 16;      /**< FIFO cache size used for the reported ACMR, as of older GPUs. */
+
+        /**
+            @return Filename of the optimized model written by optimizeFile(), e.g. "snail_opt.obj" for "snail.obj".
+        */
+        static std::string getOutputFilename(const std::string& sFilename);
+
+        /**
+            @return True if the given filename is of an optimized model, i.e. it was made by getOutputFilename().
+        */
+        static bool isOutputFilename(const std::string& sFilename);
+
+        /**
+            @param pObjLightmap       Lightmap model with the same faces as obj, or nullptr.
+            @param pObjLightmapOut    Receives the optimized lightmap model, must be given if pObjLightmap is given.
+            @return False if the lightmap model doesn't have the same faces as obj.
+        */
+        static bool optimize(
+            const ObjFile& obj,
+            const ObjFile* pObjLightmap,
+            ObjFile& objOut,
+            ObjFile* pObjLightmapOut,
+            MeshOptimizerStats& stats);
+
+        /**
+            Optimizes the given model and lightmap model, writing the results into files named by getOutputFilename().
+            Files are written only if they don't exist or are older than the source files, but stats are always calculated.
+
+            @param sLightmapFilename  Lightmap model with the same faces as the model, or empty string.
+            @return False if any file cannot be read or written.
+        */
+        static bool optimizeFile(const std::string& sFilename, const std::string& sLightmapFilename, MeshOptimizerStats& stats);
+
+        /**
+            @return Vertices transformed per triangle, simulating a FIFO post-transform cache with the given size.
+                    Between 0.5 (ideal, for big regular grids) and 3 (no reuse at all).
+        */
+        static float getAcmr(const std::vector<uint32_t>& vIndices, uint32_t nCacheSize);
+
+        /**
+            Reorders triangles of the given triangle list so vertices are reused while they are still in the post-transform cache.
+            Vertex indices must be less than nVertices.
+        */
+        static void reorderForVertexCache(std::vector<uint32_t>& vIndices, uint32_t nVertices);
+
+    private:
+        MeshOptimizer();
+    }; // class MeshOptimizer
+
+} // namespace elte_fail
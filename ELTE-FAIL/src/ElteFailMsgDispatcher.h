@@ -0,0 +1,292 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailMsgDispatcher.h
+    Compile-time generated dispatch table for ELTE-FAIL app messages.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <array>
+#include <chrono>
+#include <type_traits>
+
+#include "ElteFailPacket.h"
+
+namespace elte_fail
+{
+
+    /**
+        Deduces the handled message type from a handler member function pointer.
+        Handlers must have the signature: bool TOwner::handler(pge_network::PgeNetworkConnectionHandle, const TMsg&).
+    */
+    template <class THandlerFn>
+    struct MsgAppHandlerTraits;
+
+    template <class TOwner, class TMsg>
+    struct MsgAppHandlerTraits<bool (TOwner::*)(pge_network::PgeNetworkConnectionHandle, const TMsg&)>
+    {
+        using TMsgType = TMsg;
+    };
+
+    /**
+        Tells whether the message type has stateless validation: static bool TMsg::isValid(const TMsg&).
+    */
+    template <class TMsg, class = void>
+    struct MsgAppHasValidator : std::false_type {};
+
+    template <class TMsg>
+    struct MsgAppHasValidator<TMsg, std::void_t<decltype(TMsg::isValid(std::declval<const TMsg&>()))>> : std::true_type {};
+
+    /**
+        Tells whether the message type has a sequence number: uint16_t TMsg::m_nSeq.
+    */
+    template <class TMsg, class = void>
+    struct MsgAppHasSeq : std::false_type {};
+
+    template <class TMsg>
+    struct MsgAppHasSeq<TMsg, std::enable_if_t<std::is_same_v<decltype(TMsg::m_nSeq), uint16_t>>> : std::true_type {};
+
+    /**
+        Per-message-type handler statistics collected by MsgAppDispatcher.
+    */
+    struct MsgAppHandlerStats
+    {
+        /** Bucket 0 counts calls below 1 usec, bucket i counts calls in [2^(i-1), 2^i) usecs, the last bucket counts everything above. */
+        static const size_t nTimeHistogramBuckets = 16;
+
+        static constexpr size_t getTimeHistogramBucket(uint64_t nDurationNSecs)
+        {
+            size_t iBucket = 0;
+            for (uint64_t nDurationUSecs = nDurationNSecs / 1000; (nDurationUSecs > 0) && (iBucket < nTimeHistogramBuckets - 1); nDurationUSecs >>= 1)
+            {
+                iBucket++;
+            }
+            return iBucket;
+        }
+
+        uint64_t m_nCalls;            /**< Number of times the handler was invoked. */
+        uint64_t m_nFailedCalls;      /**< Number of times the handler returned false. */
+        uint64_t m_nTotalTimeNSecs;   /**< Total time spent in the handler. */
+        uint64_t m_nMaxTimeNSecs;     /**< Longest single invocation of the handler. */
+        std::array<uint32_t, nTimeHistogramBuckets> m_nTimeHistogram;  /**< Handler time distribution, see getTimeHistogramBucket(). */
+    };
+
+    using TMsgAppHandlerStatsArray = std::array<MsgAppHandlerStats, static_cast<size_t>(ElteFailMsgId::LastMsgId)>;
+
+    /**
+        Dispatches app messages to their handlers with O(1) lookup by ElteFailMsgId.
+        The table is generated at compile-time from the given handler member function pointers, one per message type.
+        Code cannot compile if any ElteFailMsgId is left without a handler or has more than one.
+        Also generates the allow-list of messages accepted over network, based on MsgDirection of each message,
+        and tells the MsgChannel and sequence number of messages.
+    */
+    template <class TOwner, auto... fnHandlers>
+    class MsgAppDispatcher
+    {
+    public:
+        static constexpr size_t nMsgCount = static_cast<size_t>(ElteFailMsgId::LastMsgId);
+        static_assert(sizeof...(fnHandlers) == nMsgCount, "number of handlers must be the number of ElteFailMsgIds");
+
+        static constexpr bool isKnownMsgId(const pge_network::MsgApp::TMsgId& msgAppId)
+        {
+            return msgAppId < nMsgCount;
+        }
+
+        /**
+            Inserts the ids of all messages accepted by the given side into the given allow-list.
+
+            @param allowList   Allow-list of the server or client instance.
+            @param bServerSide True if allow-list is of the server, false if it is of a client.
+        */
+        template <class TAllowList>
+        static void fillAllowList(TAllowList& allowList, bool bServerSide)
+        {
+            const MsgDirection dirAccepted = bServerSide ? MsgDirection::ClientToServer : MsgDirection::ServerToClient;
+            for (size_t i = 0; i < nMsgCount; i++)
+            {
+                if (table[i].direction == dirAccepted)
+                {
+                    allowList.insert(static_cast<pge_network::MsgApp::TMsgId>(i));
+                }
+            }
+        }
+
+        /**
+            Stateless validation of the given app message, without invoking its handler. Thread-safe.
+            Caller must make sure isKnownMsgId(msgAppId) is true.
+
+            @return False if the message is invalid by its own TMsg::isValid(), true if valid or the message type has no validation.
+        */
+        static bool validate(const pge_network::MsgApp::TMsgId& msgAppId, const pge_network::PgePacket& pkt)
+        {
+            return table[msgAppId].validator(pkt);
+        }
+
+        /**
+            Caller must make sure isKnownMsgId(msgAppId) is true.
+        */
+        static constexpr MsgChannel getChannel(const pge_network::MsgApp::TMsgId& msgAppId)
+        {
+            return table[msgAppId].channel;
+        }
+
+        /**
+            Caller must make sure isKnownMsgId(msgAppId) is true.
+
+            @return Sequence number of the given app message, 0 if its channel is not MsgChannel::UnreliableSequenced.
+        */
+        static uint16_t getSeq(const pge_network::MsgApp::TMsgId& msgAppId, const pge_network::PgePacket& pkt)
+        {
+            return table[msgAppId].seqGetter(pkt);
+        }
+
+        MsgAppDispatcher() :
+            m_stats{}
+        {}
+
+        /**
+            Invokes the handler of the given app message.
+            Caller must make sure isKnownMsgId(msgAppId) is true.
+
+            @return Result of the handler.
+        */
+        bool dispatch(TOwner& owner, const pge_network::MsgApp::TMsgId& msgAppId, const pge_network::PgePacket& pkt)
+        {
+            const auto timeStart = std::chrono::steady_clock::now();
+            const bool bRet = table[msgAppId].thunk(owner, pkt);
+            const uint64_t nDurationNSecs = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - timeStart).count());
+
+            MsgAppHandlerStats& stats = m_stats[msgAppId];
+            stats.m_nCalls++;
+            if (!bRet)
+            {
+                stats.m_nFailedCalls++;
+            }
+            stats.m_nTotalTimeNSecs += nDurationNSecs;
+            if (nDurationNSecs > stats.m_nMaxTimeNSecs)
+            {
+                stats.m_nMaxTimeNSecs = nDurationNSecs;
+            }
+            stats.m_nTimeHistogram[MsgAppHandlerStats::getTimeHistogramBucket(nDurationNSecs)]++;
+            return bRet;
+        }
+
+        const MsgAppHandlerStats& getStats(const ElteFailMsgId& msgId) const
+        {
+            return m_stats[static_cast<size_t>(msgId)];
+        }
+
+        const TMsgAppHandlerStatsArray& getStats() const
+        {
+            return m_stats;
+        }
+
+        void resetStats()
+        {
+            m_stats = {};
+        }
+
+    private:
+        using TThunk = bool (*)(TOwner&, const pge_network::PgePacket&);
+        using TValidator = bool (*)(const pge_network::PgePacket&);
+        using TSeqGetter = uint16_t (*)(const pge_network::PgePacket&);
+
+        struct TableEntry
+        {
+            TThunk thunk;
+            TValidator validator;
+            TSeqGetter seqGetter;
+            MsgDirection direction;
+            MsgChannel channel;
+        };
+
+        template <auto fnHandler>
+        static bool invoke(TOwner& owner, const pge_network::PgePacket& pkt)
+        {
+            using TMsg = typename MsgAppHandlerTraits<decltype(fnHandler)>::TMsgType;
+            return (owner.*fnHandler)(
+                pge_network::PgePacket::getServerSideConnectionHandle(pkt),
+                pge_network::PgePacket::getMsgAppDataFromPkt<TMsg>(pkt));
+        }
+
+        template <auto fnHandler>
+        static bool validateMsg(const pge_network::PgePacket& pkt)
+        {
+            using TMsg = typename MsgAppHandlerTraits<decltype(fnHandler)>::TMsgType;
+            if constexpr (MsgAppHasValidator<TMsg>::value)
+            {
+                return TMsg::isValid(pge_network::PgePacket::getMsgAppDataFromPkt<TMsg>(pkt));
+            }
+            else
+            {
+                return true;
+            }
+        }
+
+        template <auto fnHandler>
+        static uint16_t getMsgSeq(const pge_network::PgePacket& pkt)
+        {
+            using TMsg = typename MsgAppHandlerTraits<decltype(fnHandler)>::TMsgType;
+            static_assert((TMsg::channel != MsgChannel::UnreliableSequenced) || MsgAppHasSeq<TMsg>::value,
+                "messages of UnreliableSequenced channel must have uint16_t m_nSeq");
+            if constexpr (TMsg::channel == MsgChannel::UnreliableSequenced)
+            {
+                return pge_network::PgePacket::getMsgAppDataFromPkt<TMsg>(pkt).m_nSeq;
+            }
+            else
+            {
+                return 0;
+            }
+        }
+
+        static constexpr std::array<TableEntry, nMsgCount> makeTable()
+        {
+            std::array<TableEntry, nMsgCount> t{};
+            ((t[static_cast<size_t>(MsgAppHandlerTraits<decltype(fnHandlers)>::TMsgType::id)] = TableEntry{
+                &invoke<fnHandlers>,
+                &validateMsg<fnHandlers>,
+                &getMsgSeq<fnHandlers>,
+                MsgAppHandlerTraits<decltype(fnHandlers)>::TMsgType::direction,
+                MsgAppHandlerTraits<decltype(fnHandlers)>::TMsgType::channel }), ...);
+            return t;
+        }
+
+        static constexpr bool isEveryMsgIdHandledOnce()
+        {
+            constexpr ElteFailMsgId msgIds[] = { MsgAppHandlerTraits<decltype(fnHandlers)>::TMsgType::id... };
+            for (size_t i = 0; i < sizeof...(fnHandlers); i++)
+            {
+                for (size_t j = i + 1; j < sizeof...(fnHandlers); j++)
+                {
+                    if (msgIds[i] == msgIds[j])
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        static constexpr bool isEveryMsgIdHandled(const std::array<TableEntry, nMsgCount>& t)
+        {
+            for (const auto& entry : t)
+            {
+                if (entry.thunk == nullptr)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        static constexpr std::array<TableEntry, nMsgCount> table = makeTable();
+        static_assert(isEveryMsgIdHandledOnce(), "same ElteFailMsgId is handled by more than one handler");
+        static_assert(isEveryMsgIdHandled(table), "an ElteFailMsgId is not handled by any handler");
+
+        TMsgAppHandlerStatsArray m_stats;
+    }; // class MsgAppDispatcher
+
+} // namespace elte_fail
@@ -0,0 +1,309 @@
+/*
+    ###################################################################################
+    ElteFailNetCapture.cpp
+    Binary capture of network traffic of ELTE-FAIL, for offline replay.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailNetCapture.h"
+
+#include <cstring>
+#include <type_traits>
+
+#include "ElteFailCompression.h"
+
+
+static_assert(std::is_trivially_copyable_v<pge_network::PgePacket>, "PgePacket is captured as raw bytes");
+
+static const char     szMagic[4]          = { 'E', 'F', 'C', 'P' };
+static const uint16_t nFormatVersion      = 2;   // 2: sequence numbers in latest-wins messages
+static const size_t   nHeaderLength       = 4 + 2 + 1 + 4 + 4;
+static const size_t   nRecordHeaderLength = 1 + 4 + 4 + 4 + 4 + 4;
+static const uint32_t nMaxPayloadLength   = 16 * 1024 * 1024;  /**< Sanity limit for reading. */
+
+static void writeU16(std::vector<uint8_t>& vDst, uint16_t n)
+{
+    vDst.push_back(static_cast<uint8_t>(n & 0xFF));
+    vDst.push_back(static_cast<uint8_t>((n >> 8) & 0xFF));
+}
+
+static void writeU32(std::vector<uint8_t>& vDst, uint32_t n)
+{
+    writeU16(vDst, static_cast<uint16_t>(n & 0xFFFF));
+    writeU16(vDst, static_cast<uint16_t>((n >> 16) & 0xFFFF));
+}
+
+static void patchU32(std::vector<uint8_t>& vDst, size_t iPos, uint32_t n)
+{
+    for (size_t i = 0; i < 4; i++)
+    {
+        vDst[iPos + i] = static_cast<uint8_t>((n >> (8 * i)) & 0xFF);
+    }
+}
+
+static uint32_t readU32(const uint8_t* p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::NetCaptureWriter::NetCaptureWriter() :
+    m_file(nullptr),
+    m_nLastTimeUSecs(0),
+    m_nRecords(0),
+    m_bWriteError(false)
+{
+
+} // NetCaptureWriter()
+
+
+elte_fail::NetCaptureWriter::~NetCaptureWriter()
+{
+    close();
+} // ~NetCaptureWriter()
+
+
+bool elte_fail::NetCaptureWriter::open(const std::string& sFilename, bool bServer, uint32_t nRandSeed)
+{
+    if (isOpen())
+    {
+        return false;
+    }
+
+    if ((fopen_s(&m_file, sFilename.c_str(), "wb") != 0) || !m_file)
+    {
+        m_file = nullptr;
+        return false;
+    }
+
+    m_vBuffer.clear();
+    m_vBuffer.reserve(nFlushThresholdBytes * 2);
+    m_vBuffer.insert(m_vBuffer.end(), szMagic, szMagic + sizeof(szMagic));
+    writeU16(m_vBuffer, nFormatVersion);
+    m_vBuffer.push_back(bServer ? 1 : 0);
+    writeU32(m_vBuffer, nRandSeed);
+    writeU32(m_vBuffer, static_cast<uint32_t>(sizeof(pge_network::PgePacket)));
+
+    m_timeStart = std::chrono::steady_clock::now();
+    m_nLastTimeUSecs = 0;
+    m_nRecords = 0;
+    m_bWriteError = false;
+    return true;
+} // open()
+
+
+bool elte_fail::NetCaptureWriter::isOpen() const
+{
+    return m_file != nullptr;
+} // isOpen()
+
+
+bool elte_fail::NetCaptureWriter::close()
+{
+    if (!isOpen())
+    {
+        return false;
+    }
+
+    flush();
+    m_bWriteError |= (fclose(m_file) != 0);
+    m_file = nullptr;
+    return !m_bWriteError;
+} // close()
+
+
+void elte_fail::NetCaptureWriter::writePktReceived(const pge_network::PgePacket& pkt)
+{
+    writeRecord(
+        NetCaptureRecordType::PktReceived,
+        pge_network::PgePacket::getServerSideConnectionHandle(pkt),
+        0,
+        reinterpret_cast<const uint8_t*>(&pkt),
+        sizeof(pkt));
+} // writePktReceived()
+
+
+void elte_fail::NetCaptureWriter::writePktSent(
+    const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide, uint32_t nRecipients)
+{
+    writeRecord(NetCaptureRecordType::PktSent, connHandleServerSide, nRecipients, reinterpret_cast<const uint8_t*>(&pkt), sizeof(pkt));
+} // writePktSent()
+
+
+void elte_fail::NetCaptureWriter::writeFinalState(const std::vector<uint8_t>& vSnapshot)
+{
+    writeRecord(NetCaptureRecordType::FinalState, 0, 0, vSnapshot.data(), vSnapshot.size());
+} // writeFinalState()
+
+
+uint32_t elte_fail::NetCaptureWriter::getRecordCount() const
+{
+    return m_nRecords;
+} // getRecordCount()
+
+
+elte_fail::NetCaptureReader::NetCaptureReader() :
+    m_iPos(0),
+    m_nTimeUSecs(0),
+    m_nRandSeed(0),
+    m_bServer(false),
+    m_bError(false)
+{
+
+} // NetCaptureReader()
+
+
+bool elte_fail::NetCaptureReader::open(const std::string& sFilename)
+{
+    m_vFile.clear();
+    m_iPos = 0;
+    m_nTimeUSecs = 0;
+    m_bError = true;
+
+    FILE* f = nullptr;
+    if ((fopen_s(&f, sFilename.c_str(), "rb") != 0) || !f)
+    {
+        return false;
+    }
+
+    uint8_t chunk[64 * 1024];
+    size_t nRead;
+    while ((nRead = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    {
+        m_vFile.insert(m_vFile.end(), chunk, chunk + nRead);
+    }
+    const bool bReadError = (ferror(f) != 0);
+    fclose(f);
+
+    if (bReadError ||
+        (m_vFile.size() < nHeaderLength) ||
+        (memcmp(m_vFile.data(), szMagic, sizeof(szMagic)) != 0) ||
+        ((m_vFile[4] | (m_vFile[5] << 8)) != nFormatVersion) ||
+        (readU32(&m_vFile[11]) != sizeof(pge_network::PgePacket)))
+    {
+        return false;
+    }
+
+    m_bServer = (m_vFile[6] != 0);
+    m_nRandSeed = readU32(&m_vFile[7]);
+    m_iPos = nHeaderLength;
+    m_bError = false;
+    return true;
+} // open()
+
+
+bool elte_fail::NetCaptureReader::isServer() const
+{
+    return m_bServer;
+} // isServer()
+
+
+uint32_t elte_fail::NetCaptureReader::getRandSeed() const
+{
+    return m_nRandSeed;
+} // getRandSeed()
+
+
+bool elte_fail::NetCaptureReader::readNext(NetCaptureRecord& record)
+{
+    if (m_bError || (m_iPos == m_vFile.size()))
+    {
+        return false;
+    }
+
+    // from here any early return is an error
+    m_bError = true;
+    if (m_vFile.size() - m_iPos < nRecordHeaderLength)
+    {
+        return false;
+    }
+
+    const uint8_t* const p = &m_vFile[m_iPos];
+    if (p[0] > static_cast<uint8_t>(NetCaptureRecordType::FinalState))
+    {
+        return false;
+    }
+
+    const uint32_t nDataLength = readU32(p + 13);
+    const uint32_t nCompressedLength = readU32(p + 17);
+    if ((nDataLength > nMaxPayloadLength) || (nCompressedLength > m_vFile.size() - m_iPos - nRecordHeaderLength))
+    {
+        return false;
+    }
+
+    record.m_type = static_cast<NetCaptureRecordType>(p[0]);
+    m_nTimeUSecs += readU32(p + 1);
+    record.m_nTimeUSecs = m_nTimeUSecs;
+    record.m_connHandleServerSide = readU32(p + 5);
+    record.m_nRecipients = readU32(p + 9);
+    record.m_vData.resize(nDataLength);
+    if (!Compression::decompress(p + nRecordHeaderLength, nCompressedLength, record.m_vData.data(), record.m_vData.size()))
+    {
+        return false;
+    }
+
+    m_iPos += nRecordHeaderLength + nCompressedLength;
+    m_bError = false;
+    return true;
+} // readNext()
+
+
+bool elte_fail::NetCaptureReader::hasError() const
+{
+    return m_bError;
+} // hasError()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+void elte_fail::NetCaptureWriter::writeRecord(
+    NetCaptureRecordType type,
+    pge_network::PgeNetworkConnectionHandle connHandleServerSide,
+    uint32_t nRecipients,
+    const uint8_t* pData,
+    size_t nDataLength)
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    const uint64_t nTimeUSecs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_timeStart).count());
+    const uint64_t nDeltaUSecs = nTimeUSecs - m_nLastTimeUSecs;
+    m_nLastTimeUSecs = nTimeUSecs;
+
+    m_vBuffer.push_back(static_cast<uint8_t>(type));
+    writeU32(m_vBuffer, (nDeltaUSecs > UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(nDeltaUSecs));
+    writeU32(m_vBuffer, static_cast<uint32_t>(connHandleServerSide));
+    writeU32(m_vBuffer, nRecipients);
+    writeU32(m_vBuffer, static_cast<uint32_t>(nDataLength));
+    const size_t iCompressedLength = m_vBuffer.size();
+    writeU32(m_vBuffer, 0);
+    const size_t nCompressedLength = Compression::compress(pData, nDataLength, m_vBuffer);
+    patchU32(m_vBuffer, iCompressedLength, static_cast<uint32_t>(nCompressedLength));
+
+    m_nRecords++;
+    if (m_vBuffer.size() >= nFlushThresholdBytes)
+    {
+        flush();
+    }
+} // writeRecord()
+
+
+void elte_fail::NetCaptureWriter::flush()
+{
+    if (!m_vBuffer.empty() && (fwrite(m_vBuffer.data(), 1, m_vBuffer.size(), m_file) != m_vBuffer.size()))
+    {
+        m_bWriteError = true;
+    }
+    m_vBuffer.clear();
+} // flush()
@@ -0,0 +1,123 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailNetCapture.h
+    Binary capture of network traffic of ELTE-FAIL, for offline replay.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../../../PGE/PGE/Network/PgePacket.h"
+
+namespace elte_fail
+{
+
+    enum class NetCaptureRecordType : uint8_t
+    {
+        PktReceived = 0,    /**< Packet passed to onPacketReceived(), including packets injected by server to itself. */
+        PktSent,            /**< Packet sent by any of the send functions. */
+        FinalState          /**< World state snapshot (see WorldState) at the end of the capture. */
+    };
+
+    /**
+        1 record of the capture file, with the payload already decompressed.
+    */
+    struct NetCaptureRecord
+    {
+        NetCaptureRecordType m_type;
+        uint64_t m_nTimeUSecs;                                       /**< Since the capture was started. */
+        pge_network::PgeNetworkConnectionHandle m_connHandleServerSide;  /**< For sent packets, the recipient client or 0 if not a single client. */
+        uint32_t m_nRecipients;                                      /**< For sent packets only. */
+        std::vector<uint8_t> m_vData;                                /**< PgePacket bytes, or snapshot for FinalState. */
+    };
+
+    /**
+        Writes capture file. Records are collected in memory and written in big chunks, so capturing does not do file I/O for every packet.
+
+        Capture file format, all integers little-endian:
+         - header: magic "EFCP", u16 format version, u8 bServer, u32 seed of rand(), u32 sizeof(PgePacket);
+         - records: u8 type, u32 time delta from previous record in usecs, u32 connHandleServerSide, u32 number of recipients,
+           u32 payload length, u32 compressed payload length, compressed payload (see Compression).
+        Every PgePacket is stored in full, compression removes the unused part of its message area.
+    */
+    class NetCaptureWriter
+    {
+    public:
+        NetCaptureWriter();
+        ~NetCaptureWriter();
+
+        bool open(const std::string& sFilename, bool bServer, uint32_t nRandSeed);
+        bool isOpen() const;
+        bool close();                    /**< Writes out buffered records and closes the file. @return False if anything failed to be written. */
+
+        void writePktReceived(const pge_network::PgePacket& pkt);
+        void writePktSent(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide, uint32_t nRecipients);
+        void writeFinalState(const std::vector<uint8_t>& vSnapshot);
+
+        uint32_t getRecordCount() const;
+
+    private:
+        static const size_t nFlushThresholdBytes = 256 * 1024;
+
+        FILE* m_file;
+        std::vector<uint8_t> m_vBuffer;
+        std::chrono::steady_clock::time_point m_timeStart;
+        uint64_t m_nLastTimeUSecs;
+        uint32_t m_nRecords;
+        bool m_bWriteError;
+
+        // ---------------------------------------------------------------------------
+
+        NetCaptureWriter(const NetCaptureWriter&);
+        NetCaptureWriter& operator=(const NetCaptureWriter&);
+
+        void writeRecord(
+            NetCaptureRecordType type,
+            pge_network::PgeNetworkConnectionHandle connHandleServerSide,
+            uint32_t nRecipients,
+            const uint8_t* pData,
+            size_t nDataLength);
+        void flush();
+    }; // class NetCaptureWriter
+
+    /**
+        Reads the whole capture file into memory at once, so replay is not slowed down by file I/O.
+    */
+    class NetCaptureReader
+    {
+    public:
+        NetCaptureReader();
+
+        bool open(const std::string& sFilename);  /**< @return False if file cannot be read or header is invalid. */
+
+        bool isServer() const;
+        uint32_t getRandSeed() const;
+
+        /**
+            @return False at the end of the capture or if the next record is corrupt, see hasError().
+        */
+        bool readNext(NetCaptureRecord& record);
+
+        bool hasError() const;
+
+    private:
+        std::vector<uint8_t> m_vFile;
+        size_t m_iPos;
+        uint64_t m_nTimeUSecs;
+        uint32_t m_nRandSeed;
+        bool m_bServer;
+        bool m_bError;
+
+        // ---------------------------------------------------------------------------
+
+        NetCaptureReader(const NetCaptureReader&);
+        NetCaptureReader& operator=(const NetCaptureReader&);
+    }; // class NetCaptureReader
+
+} // namespace elte_fail
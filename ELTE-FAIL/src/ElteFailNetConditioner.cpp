@@ -0,0 +1,275 @@
+/*
+    ###################################################################################
+    ElteFailNetConditioner.cpp
+    Simulated latency, jitter, loss, duplication and reordering of sent packets for ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailNetConditioner.h"
+
+#include "ElteFailPacket.h"
+#include "ElteFailSequenceFilter.h"
+
+
+// ############################### PUBLIC ################################
+
+
+bool elte_fail::NetConditions::isEnabled() const
+{
+    return (m_nLatencyMSecs > 0) || (m_nJitterMSecs > 0) ||
+        (m_fLossPercent > 0.f) || (m_fDuplicatePercent > 0.f) || (m_fReorderPercent > 0.f);
+} // isEnabled()
+
+
+elte_fail::NetConditioner::NetConditioner() :
+    m_conditions{},
+    m_nOrder(0),
+    m_stats{}
+{
+
+} // NetConditioner()
+
+
+void elte_fail::NetConditioner::configure(const NetConditions& conditions)
+{
+    m_conditions = conditions;
+    m_rng.seed(conditions.m_nSeed);
+} // configure()
+
+
+const elte_fail::NetConditions& elte_fail::NetConditioner::getConditions() const
+{
+    return m_conditions;
+} // getConditions()
+
+
+bool elte_fail::NetConditioner::isEnabled() const
+{
+    return m_conditions.isEnabled();
+} // isEnabled()
+
+
+void elte_fail::NetConditioner::submit(
+    const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide, bool bReliable, uint64_t nNowUSecs)
+{
+    m_stats.m_nSubmitted++;
+
+    uint64_t nDeliverUSecs = nNowUSecs + getDelayUSecs();
+    bool bReordered = false;
+    if (roll(m_conditions.m_fLossPercent))
+    {
+        if (!bReliable)
+        {
+            m_stats.m_nDropped++;
+            return;
+        }
+        // sender notices the loss after a round trip and sends it again
+        nDeliverUSecs += 2 * getDelayUSecs();
+        m_stats.m_nRetransmitted++;
+    }
+    else if (!bReliable && roll(m_conditions.m_fReorderPercent))
+    {
+        // held back by at least 1 msec, so packets sent right after it can overtake it
+        nDeliverUSecs += 1000 + std::uniform_int_distribution<uint64_t>(0, (m_conditions.m_nLatencyMSecs + m_conditions.m_nJitterMSecs) * 1000ull)(m_rng);
+        bReordered = true;
+        m_stats.m_nReordered++;
+    }
+
+    if (!bReordered)
+    {
+        uint64_t& nLastDeliverUSecs = m_mapLastDeliverUSecs[connHandleServerSide];
+        nDeliverUSecs = std::max(nDeliverUSecs, nLastDeliverUSecs);
+        nLastDeliverUSecs = nDeliverUSecs;
+    }
+    enqueue(pkt, connHandleServerSide, nDeliverUSecs, nNowUSecs);
+
+    if (!bReliable && roll(m_conditions.m_fDuplicatePercent))
+    {
+        enqueue(pkt, connHandleServerSide, nDeliverUSecs + std::uniform_int_distribution<uint64_t>(0, m_conditions.m_nJitterMSecs * 1000ull)(m_rng), nNowUSecs);
+        m_stats.m_nDuplicated++;
+    }
+} // submit()
+
+
+void elte_fail::NetConditioner::forget(pge_network::PgeNetworkConnectionHandle connHandleServerSide)
+{
+    m_vQueue.erase(
+        std::remove_if(m_vQueue.begin(), m_vQueue.end(),
+            [connHandleServerSide](const QueuedPkt& queued) { return queued.m_connHandleServerSide == connHandleServerSide; }),
+        m_vQueue.end());
+    std::make_heap(m_vQueue.begin(), m_vQueue.end(), isDeliveredLater);
+    m_mapLastDeliverUSecs.erase(connHandleServerSide);
+} // forget()
+
+
+void elte_fail::NetConditioner::clear()
+{
+    m_vQueue.clear();
+    m_mapLastDeliverUSecs.clear();
+} // clear()
+
+
+size_t elte_fail::NetConditioner::getQueuedCount() const
+{
+    return m_vQueue.size();
+} // getQueuedCount()
+
+
+const elte_fail::NetConditionerStats& elte_fail::NetConditioner::getStats() const
+{
+    return m_stats;
+} // getStats()
+
+
+elte_fail::NetConditionerBenchmarkResult elte_fail::NetConditionerBenchmark::run(
+    const NetConditions& conditions, uint32_t nSecs, uint32_t nClients, uint32_t nTickRate)
+{
+    NetConditionerBenchmarkResult result{};
+    if ((nSecs == 0) || (nClients == 0) || (nTickRate == 0))
+    {
+        return result;
+    }
+
+    static const uint64_t nStepUSecs = 1000;
+    static const pge_network::PgeNetworkConnectionHandle connHandleMovingPlayer = 1000;
+    const uint64_t nTickUSecs = 1000000ull / nTickRate;
+    const uint64_t nSendUntilUSecs = nSecs * 1000000ull;
+    // after the last send, everything still queued must be released too
+    const uint64_t nRunUntilUSecs = nSendUntilUSecs + 4 * (conditions.m_nLatencyMSecs + conditions.m_nJitterMSecs) * 1000ull + 1000000ull;
+
+    NetConditioner conditioner;
+    conditioner.configure(conditions);
+    SequenceFilter seqFilter;   // recipient is the key, since all updates are about the same player
+    std::vector<uint64_t> vSendUSecs(65536);   // by sequence number, in-flight updates are much less than 32768
+    std::vector<uint64_t> vNewestAcceptedSendUSecs(nClients, 0);
+    std::vector<bool> vHasState(nClients, false);
+    uint64_t nSumLatencyUSecs = 0;
+    uint64_t nMaxLatencyUSecs = 0;
+    uint64_t nSumStateAgeUSecs = 0;
+    uint64_t nStateAgeSamples = 0;
+    uint16_t nSeq = 0;
+
+    const auto fnReceive = [&](const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleClient, uint64_t nNowUSecs)
+    {
+        const uint16_t nSeqReceived = pge_network::PgePacket::getMsgAppDataFromPkt<MsgUserUpdateFromServer>(pkt).m_nSeq;
+        if (!seqFilter.accept(MsgUserUpdateFromServer::id, connHandleClient, nSeqReceived))
+        {
+            result.m_nUpdatesStale++;
+            return;
+        }
+        const uint64_t nLatencyUSecs = nNowUSecs - vSendUSecs[nSeqReceived];
+        nSumLatencyUSecs += nLatencyUSecs;
+        nMaxLatencyUSecs = std::max(nMaxLatencyUSecs, nLatencyUSecs);
+        vNewestAcceptedSendUSecs[connHandleClient - 1] = vSendUSecs[nSeqReceived];
+        vHasState[connHandleClient - 1] = true;
+        result.m_nUpdatesAccepted++;
+    };
+
+    const auto fnSendUpdate = [&](uint64_t nNowUSecs)
+    {
+        for (uint32_t iClient = 0; iClient < nClients; iClient++)
+        {
+            if (vHasState[iClient])
+            {
+                nSumStateAgeUSecs += nNowUSecs - vNewestAcceptedSendUSecs[iClient];
+                nStateAgeSamples++;
+            }
+        }
+
+        pge_network::PgePacket pkt;
+        nSeq++;
+        if (!MsgUserUpdateFromServer::initPkt(pkt, connHandleMovingPlayer, nSeq, static_cast<float>(nSeq), 0.f, 0.f))
+        {
+            return false;
+        }
+        vSendUSecs[nSeq] = nNowUSecs;
+        result.m_nUpdatesSent++;
+        for (uint32_t iClient = 0; iClient < nClients; iClient++)
+        {
+            conditioner.submit(pkt, static_cast<pge_network::PgeNetworkConnectionHandle>(iClient + 1), false, nNowUSecs);
+        }
+        return true;
+    };
+
+    uint64_t nNextTickUSecs = 0;
+    for (uint64_t nNowUSecs = 0; nNowUSecs <= nRunUntilUSecs; nNowUSecs += nStepUSecs)
+    {
+        if ((nNowUSecs >= nNextTickUSecs) && (nNowUSecs < nSendUntilUSecs))
+        {
+            nNextTickUSecs += nTickUSecs;
+            if (!fnSendUpdate(nNowUSecs))
+            {
+                return result;
+            }
+        }
+        // released in the same step, so without conditions latency is 0
+        conditioner.release(nNowUSecs, [&](const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleClient)
+            { fnReceive(pkt, connHandleClient, nNowUSecs); });
+    }
+
+    result.m_nUpdatesLost = conditioner.getStats().m_nDropped;
+    if (result.m_nUpdatesAccepted > 0)
+    {
+        result.m_fAvgLatencyMSecs = static_cast<float>(static_cast<double>(nSumLatencyUSecs) / result.m_nUpdatesAccepted / 1000.0);
+        result.m_fMaxLatencyMSecs = static_cast<float>(nMaxLatencyUSecs / 1000.0);
+    }
+    if (nStateAgeSamples > 0)
+    {
+        result.m_fAvgStateAgeMSecs = static_cast<float>(static_cast<double>(nSumStateAgeUSecs) / nStateAgeSamples / 1000.0);
+    }
+    result.m_fKBytesPerSec = static_cast<float>(conditioner.getStats().m_nDeliveredBytes / 1024.0 / nSecs);
+    return result;
+} // run()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+bool elte_fail::NetConditioner::isDeliveredLater(const QueuedPkt& a, const QueuedPkt& b)
+{
+    return (a.m_nDeliverUSecs != b.m_nDeliverUSecs) ? (a.m_nDeliverUSecs > b.m_nDeliverUSecs) : (a.m_nOrder > b.m_nOrder);
+} // isDeliveredLater()
+
+
+bool elte_fail::NetConditioner::roll(float fPercent)
+{
+    if (fPercent <= 0.f)
+    {
+        return false;
+    }
+    return std::uniform_real_distribution<float>(0.f, 100.f)(m_rng) < fPercent;
+} // roll()
+
+
+uint64_t elte_fail::NetConditioner::getDelayUSecs()
+{
+    const int64_t nJitterUSecs = m_conditions.m_nJitterMSecs * 1000ll;
+    int64_t nDelayUSecs = m_conditions.m_nLatencyMSecs * 1000ll;
+    if (nJitterUSecs > 0)
+    {
+        nDelayUSecs += std::uniform_int_distribution<int64_t>(-nJitterUSecs, nJitterUSecs)(m_rng);
+    }
+    return static_cast<uint64_t>(std::max<int64_t>(0, nDelayUSecs));
+} // getDelayUSecs()
+
+
+void elte_fail::NetConditioner::enqueue(
+    const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide, uint64_t nDeliverUSecs, uint64_t nNowUSecs)
+{
+    m_vQueue.push_back({ nDeliverUSecs, m_nOrder++, nNowUSecs, connHandleServerSide, pkt });
+    std::push_heap(m_vQueue.begin(), m_vQueue.end(), isDeliveredLater);
+} // enqueue()
+
+
+void elte_fail::NetConditioner::onReleased(const QueuedPkt& queued, uint64_t nNowUSecs)
+{
+    const uint64_t nDelayUSecs = nNowUSecs - queued.m_nSubmitUSecs;
+    m_stats.m_nDelivered++;
+    m_stats.m_nDeliveredBytes += pge_network::PgePacket::getMessageAppsTotalActualLengthBytes(queued.m_pkt);
+    m_stats.m_nSumDelayUSecs += nDelayUSecs;
+    m_stats.m_nMaxDelayUSecs = std::max(m_stats.m_nMaxDelayUSecs, nDelayUSecs);
+} // onReleased()
@@ -0,0 +1,170 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailNetConditioner.h
+    Simulated latency, jitter, loss, duplication and reordering of sent packets for ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "../../../PGE/PGE/Network/PgePacket.h"
+
+namespace elte_fail
+{
+
+    /**
+        Simulated network conditions of 1 direction, applied to every sent packet.
+    */
+    struct NetConditions
+    {
+        uint32_t m_nLatencyMSecs;       /**< One-way delay added to every packet. */
+        uint32_t m_nJitterMSecs;        /**< Delay of every packet is changed by a random value in [-jitter, +jitter]. */
+        float    m_fLossPercent;
+        float    m_fDuplicatePercent;
+        float    m_fReorderPercent;     /**< Packets held back so later packets to the same recipient overtake them. */
+        uint32_t m_nSeed;               /**< Same seed and same sends give the same conditions. */
+
+        bool isEnabled() const;
+    };
+
+    struct NetConditionerStats
+    {
+        uint64_t m_nSubmitted;
+        uint64_t m_nDelivered;          /**< Including duplicates. */
+        uint64_t m_nDeliveredBytes;     /**< App message bytes, without PGE packet overhead. */
+        uint64_t m_nDropped;            /**< Lost unreliable packets. */
+        uint64_t m_nRetransmitted;      /**< Lost reliable packets, delivered later instead. */
+        uint64_t m_nDuplicated;
+        uint64_t m_nReordered;
+        uint64_t m_nSumDelayUSecs;      /**< Of delivered packets, between submit() and release(). */
+        uint64_t m_nMaxDelayUSecs;
+    };
+
+    /**
+        Sits between the game and the transport on the sending side: packets are queued with a simulated delivery time
+        instead of being sent, and release() gives them to the transport when that time has come.
+        PGE delivers everything reliably and in order, so effects follow what a reliable transport would show to the game:
+         - reliable packets are never dropped nor duplicated, a lost one is retransmitted, i.e. delayed by a round trip;
+         - unreliable packets (MsgChannel::UnreliableSequenced) are dropped, duplicated and reordered as they are.
+        Without reordering, jitter only delays packets, so they still arrive in the order they were sent.
+        Time is given by the caller in microseconds, so headless benchmarks can run on simulated time.
+        Not thread-safe.
+    */
+    class NetConditioner
+    {
+    public:
+        NetConditioner();
+
+        /**
+            Also reseeds the random generator. Packets already queued keep their delivery times.
+        */
+        void configure(const NetConditions& conditions);
+
+        const NetConditions& getConditions() const;
+
+        bool isEnabled() const;   /**< If false, packets should be sent directly instead of submit(). */
+
+        /**
+            Queues the given packet to be released later, unless it is lost.
+
+            @param connHandleServerSide Recipient, kept only for release(), also used for keeping the order per recipient.
+        */
+        void submit(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide, bool bReliable, uint64_t nNowUSecs);
+
+        /**
+            Invokes fnSend(pkt, connHandleServerSide) for every queued packet due at the given time, in delivery order.
+
+            @return Number of packets released.
+        */
+        template <class F>
+        uint32_t release(uint64_t nNowUSecs, F&& fnSend)
+        {
+            uint32_t nReleased = 0;
+            while (!m_vQueue.empty() && (m_vQueue.front().m_nDeliverUSecs <= nNowUSecs))
+            {
+                std::pop_heap(m_vQueue.begin(), m_vQueue.end(), isDeliveredLater);
+                const QueuedPkt queued = m_vQueue.back();
+                m_vQueue.pop_back();
+                onReleased(queued, nNowUSecs);
+                fnSend(queued.m_pkt, queued.m_connHandleServerSide);
+                nReleased++;
+            }
+            return nReleased;
+        }
+
+        /**
+            Drops packets queued for the given recipient, e.g. when it disconnected.
+        */
+        void forget(pge_network::PgeNetworkConnectionHandle connHandleServerSide);
+
+        void clear();   /**< Drops all queued packets, keeps the stats. */
+
+        size_t getQueuedCount() const;
+
+        const NetConditionerStats& getStats() const;
+
+    private:
+
+        struct QueuedPkt
+        {
+            uint64_t m_nDeliverUSecs;
+            uint64_t m_nOrder;          /**< Submit order, for packets having the same delivery time. */
+            uint64_t m_nSubmitUSecs;
+            pge_network::PgeNetworkConnectionHandle m_connHandleServerSide;
+            pge_network::PgePacket m_pkt;
+        };
+
+        static bool isDeliveredLater(const QueuedPkt& a, const QueuedPkt& b);   /**< Makes m_vQueue a min-heap. */
+
+        NetConditions m_conditions;
+        std::mt19937 m_rng;
+        std::vector<QueuedPkt> m_vQueue;   /**< Heap, earliest delivery at front. */
+        std::map<pge_network::PgeNetworkConnectionHandle, uint64_t>
+            m_mapLastDeliverUSecs;         /**< Per recipient, latest delivery time given to a packet not reordered. */
+        uint64_t m_nOrder;
+        NetConditionerStats m_stats;
+
+        // ---------------------------------------------------------------------------
+
+        NetConditioner(const NetConditioner&);
+        NetConditioner& operator=(const NetConditioner&);
+
+        bool roll(float fPercent);
+        uint64_t getDelayUSecs();   /**< Latency with random jitter. */
+        void enqueue(const pge_network::PgePacket& pkt, pge_network::PgeNetworkConnectionHandle connHandleServerSide, uint64_t nDeliverUSecs, uint64_t nNowUSecs);
+        void onReleased(const QueuedPkt& queued, uint64_t nNowUSecs);
+    }; // class NetConditioner
+
+    struct NetConditionerBenchmarkResult
+    {
+        uint32_t m_nUpdatesSent;        /**< Per client. */
+        uint64_t m_nUpdatesAccepted;    /**< By SequenceFilter of the clients. */
+        uint64_t m_nUpdatesStale;       /**< Older than or same as an already accepted one, incl. duplicates. */
+        uint64_t m_nUpdatesLost;
+        float    m_fAvgLatencyMSecs;    /**< Between sending and accepting an update. */
+        float    m_fMaxLatencyMSecs;
+        float    m_fAvgStateAgeMSecs;   /**< Age of the newest update accepted by a client, sampled every tick. */
+        float    m_fKBytesPerSec;       /**< Received by all clients together. */
+    };
+
+    /**
+        Headless simulation of a server sending MsgUserUpdateFromServer to clients every tick through a NetConditioner,
+        on simulated time, so it runs much faster than real time and gives the same result for the same conditions.
+    */
+    class NetConditionerBenchmark
+    {
+    public:
+        static NetConditionerBenchmarkResult run(const NetConditions& conditions, uint32_t nSecs, uint32_t nClients, uint32_t nTickRate);
+
+    private:
+        NetConditionerBenchmark();
+    }; // class NetConditionerBenchmark
+
+} // namespace elte_fail
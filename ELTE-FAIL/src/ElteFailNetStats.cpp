@@ -0,0 +1,196 @@
+/*
+    ###################################################################################
+    ElteFailNetStats.cpp
+    Per-message-type network statistics for ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailNetStats.h"
+
+#include <cassert>
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::NetStats::NetStats() :
+    m_rx{},
+    m_tx{},
+    m_timeStart(std::chrono::steady_clock::now()),
+    m_timeRateWindowStart(m_timeStart),
+    m_timeLastDump(m_timeStart),
+    m_nDumpIntervalSecs(0)
+{
+
+} // NetStats()
+
+
+void elte_fail::NetStats::onMsgAppReceived(const pge_network::MsgApp::TMsgId& msgAppId, uint32_t nBytes)
+{
+    assert(msgAppId < m_rx.size());
+    m_rx[msgAppId].m_nCount++;
+    m_rx[msgAppId].m_nBytes += nBytes;
+} // onMsgAppReceived()
+
+
+void elte_fail::NetStats::onMsgAppSent(const pge_network::MsgApp::TMsgId& msgAppId, uint32_t nBytes, uint32_t nRecipients)
+{
+    assert(msgAppId < m_tx.size());
+    m_tx[msgAppId].m_nCount += nRecipients;
+    m_tx[msgAppId].m_nBytes += static_cast<uint64_t>(nBytes) * nRecipients;
+} // onMsgAppSent()
+
+
+const elte_fail::MsgAppTrafficCounters& elte_fail::NetStats::getRx(const ElteFailMsgId& msgId) const
+{
+    return m_rx[static_cast<size_t>(msgId)];
+} // getRx()
+
+
+const elte_fail::MsgAppTrafficCounters& elte_fail::NetStats::getTx(const ElteFailMsgId& msgId) const
+{
+    return m_tx[static_cast<size_t>(msgId)];
+} // getTx()
+
+
+void elte_fail::NetStats::setPeriodicDump(const std::string& sFilename, unsigned int nIntervalSecs)
+{
+    m_sDumpFilename = sFilename;
+    m_nDumpIntervalSecs = nIntervalSecs;
+    m_timeLastDump = std::chrono::steady_clock::now();
+} // setPeriodicDump()
+
+
+void elte_fail::NetStats::update(const TMsgAppHandlerStatsArray& handlerStats)
+{
+    const auto timeNow = std::chrono::steady_clock::now();
+
+    const auto nWindowMSecs = std::chrono::duration_cast<std::chrono::milliseconds>(timeNow - m_timeRateWindowStart).count();
+    if (nWindowMSecs >= nRateWindowMSecs)
+    {
+        updateRates(m_rx, nWindowMSecs / 1000.f);
+        updateRates(m_tx, nWindowMSecs / 1000.f);
+        m_timeRateWindowStart = timeNow;
+    }
+
+    if (m_sDumpFilename.empty() || (m_nDumpIntervalSecs == 0))
+    {
+        return;
+    }
+
+    if (std::chrono::duration_cast<std::chrono::seconds>(timeNow - m_timeLastDump).count() >= m_nDumpIntervalSecs)
+    {
+        // dont retry in every frame if file cannot be written, next attempt will be in the next interval
+        m_timeLastDump = timeNow;
+        dump(m_sDumpFilename, handlerStats);
+    }
+} // update()
+
+
+/**
+    Appends the current state of all counters to the given file.
+    Format is JSON Lines (1 JSON object per dump) if filename ends with ".json", otherwise CSV (1 row per message type per dump).
+
+    @return True on success, false if file could not be written.
+*/
+bool elte_fail::NetStats::dump(const std::string& sFilename, const TMsgAppHandlerStatsArray& handlerStats) const
+{
+    const bool bJson = (sFilename.length() >= 5) && (sFilename.compare(sFilename.length() - 5, 5, ".json") == 0);
+
+    FILE* f = nullptr;
+    if ((fopen_s(&f, sFilename.c_str(), "a") != 0) || !f)
+    {
+        return false;
+    }
+
+    // header is needed only when we are at the beginning of a new CSV file,
+    // position of an append stream is 0 until the first write on MSVC, so it is moved to the end first
+    const bool bWriteHeader = !bJson && (fseek(f, 0, SEEK_END) == 0) && (ftell(f) == 0);
+
+    const float fTimestampSecs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_timeStart).count() / 1000.f;
+    const bool bRet = bJson ? dumpJson(f, fTimestampSecs, handlerStats) : dumpCsv(f, bWriteHeader, fTimestampSecs, handlerStats);
+
+    fclose(f);
+    return bRet;
+} // dump()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+void elte_fail::NetStats::updateRates(TMsgAppTrafficCountersArray& counters, float fWindowSecs)
+{
+    for (auto& counter : counters)
+    {
+        counter.m_fCountPerSec = (counter.m_nCount - counter.m_nCountAtWindowStart) / fWindowSecs;
+        counter.m_fBytesPerSec = (counter.m_nBytes - counter.m_nBytesAtWindowStart) / fWindowSecs;
+        counter.m_nCountAtWindowStart = counter.m_nCount;
+        counter.m_nBytesAtWindowStart = counter.m_nBytes;
+    }
+} // updateRates()
+
+
+bool elte_fail::NetStats::dumpCsv(FILE* f, bool bWriteHeader, float fTimestampSecs, const TMsgAppHandlerStatsArray& handlerStats) const
+{
+    if (bWriteHeader)
+    {
+        fprintf(f, "time_s,msg,rx_count,rx_bytes,rx_count_per_s,rx_bytes_per_s,tx_count,tx_bytes,tx_count_per_s,tx_bytes_per_s,"
+            "handler_calls,handler_failed,handler_avg_ns,handler_max_ns");
+        for (size_t iBucket = 0; iBucket < MsgAppHandlerStats::nTimeHistogramBuckets; iBucket++)
+        {
+            fprintf(f, ",handler_hist_%u", static_cast<unsigned int>(iBucket));
+        }
+        fprintf(f, "\n");
+    }
+
+    for (const auto& msgAppId2StringPair : MapMsgAppId2String)
+    {
+        const size_t i = static_cast<size_t>(msgAppId2StringPair.msgId);
+        const MsgAppHandlerStats& hs = handlerStats[i];
+        fprintf(f, "%.3f,%s,%llu,%llu,%.2f,%.2f,%llu,%llu,%.2f,%.2f,%llu,%llu,%llu,%llu",
+            fTimestampSecs, msgAppId2StringPair.zstring,
+            m_rx[i].m_nCount, m_rx[i].m_nBytes, m_rx[i].m_fCountPerSec, m_rx[i].m_fBytesPerSec,
+            m_tx[i].m_nCount, m_tx[i].m_nBytes, m_tx[i].m_fCountPerSec, m_tx[i].m_fBytesPerSec,
+            hs.m_nCalls, hs.m_nFailedCalls, (hs.m_nCalls > 0) ? (hs.m_nTotalTimeNSecs / hs.m_nCalls) : 0ull, hs.m_nMaxTimeNSecs);
+        for (const auto& nBucket : hs.m_nTimeHistogram)
+        {
+            fprintf(f, ",%u", nBucket);
+        }
+        fprintf(f, "\n");
+    }
+
+    return ferror(f) == 0;
+} // dumpCsv()
+
+
+bool elte_fail::NetStats::dumpJson(FILE* f, float fTimestampSecs, const TMsgAppHandlerStatsArray& handlerStats) const
+{
+    fprintf(f, "{\"time_s\":%.3f,\"msgs\":[", fTimestampSecs);
+    bool bFirst = true;
+    for (const auto& msgAppId2StringPair : MapMsgAppId2String)
+    {
+        const size_t i = static_cast<size_t>(msgAppId2StringPair.msgId);
+        const MsgAppHandlerStats& hs = handlerStats[i];
+        fprintf(f, "%s{\"msg\":\"%s\","
+            "\"rx\":{\"count\":%llu,\"bytes\":%llu,\"count_per_s\":%.2f,\"bytes_per_s\":%.2f},"
+            "\"tx\":{\"count\":%llu,\"bytes\":%llu,\"count_per_s\":%.2f,\"bytes_per_s\":%.2f},"
+            "\"handler\":{\"calls\":%llu,\"failed\":%llu,\"avg_ns\":%llu,\"max_ns\":%llu,\"hist\":[",
+            bFirst ? "" : ",", msgAppId2StringPair.zstring,
+            m_rx[i].m_nCount, m_rx[i].m_nBytes, m_rx[i].m_fCountPerSec, m_rx[i].m_fBytesPerSec,
+            m_tx[i].m_nCount, m_tx[i].m_nBytes, m_tx[i].m_fCountPerSec, m_tx[i].m_fBytesPerSec,
+            hs.m_nCalls, hs.m_nFailedCalls, (hs.m_nCalls > 0) ? (hs.m_nTotalTimeNSecs / hs.m_nCalls) : 0ull, hs.m_nMaxTimeNSecs);
+        for (size_t iBucket = 0; iBucket < hs.m_nTimeHistogram.size(); iBucket++)
+        {
+            fprintf(f, "%s%u", (iBucket == 0) ? "" : ",", hs.m_nTimeHistogram[iBucket]);
+        }
+        fprintf(f, "]}}");
+        bFirst = false;
+    }
+    fprintf(f, "]}\n");
+
+    return ferror(f) == 0;
+} // dumpJson()
@@ -0,0 +1,90 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailNetStats.h
+    Per-message-type network statistics for ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "ElteFailMsgDispatcher.h"
+
+namespace elte_fail
+{
+
+    /**
+        Traffic counters of 1 message type in 1 direction.
+    */
+    struct MsgAppTrafficCounters
+    {
+        uint64_t m_nCount;            /**< Number of messages. */
+        uint64_t m_nBytes;            /**< Number of app message bytes, without PGE packet overhead. */
+        float    m_fCountPerSec;      /**< Message rate measured in the last completed rate window. */
+        float    m_fBytesPerSec;      /**< Byte rate measured in the last completed rate window. */
+        uint64_t m_nCountAtWindowStart;
+        uint64_t m_nBytesAtWindowStart;
+    };
+
+    using TMsgAppTrafficCountersArray = std::array<MsgAppTrafficCounters, static_cast<size_t>(ElteFailMsgId::LastMsgId)>;
+
+    /**
+        Counts received and sent app messages per ElteFailMsgId, used by both server and clients.
+        Received messages are counted once they are accepted by the app, sent messages are counted once per recipient.
+        Handler times are not collected here but by MsgAppDispatcher, this class only merges them into the dumps.
+        Optionally dumps everything into a CSV file or a JSON Lines file at regular intervals.
+    */
+    class NetStats
+    {
+    public:
+        static const unsigned int nRateWindowMSecs = 1000;
+
+        NetStats();
+
+        void onMsgAppReceived(const pge_network::MsgApp::TMsgId& msgAppId, uint32_t nBytes);
+        void onMsgAppSent(const pge_network::MsgApp::TMsgId& msgAppId, uint32_t nBytes, uint32_t nRecipients);
+
+        const MsgAppTrafficCounters& getRx(const ElteFailMsgId& msgId) const;
+        const MsgAppTrafficCounters& getTx(const ElteFailMsgId& msgId) const;
+
+        /**
+            Enables periodic dump. Format is JSON Lines if filename ends with ".json", otherwise CSV. Records are always appended.
+
+            @param sFilename     Path of the dump file, empty string disables periodic dump.
+            @param nIntervalSecs Time between 2 dumps, 0 disables periodic dump.
+        */
+        void setPeriodicDump(const std::string& sFilename, unsigned int nIntervalSecs);
+
+        /**
+            Recalculates rates when the rate window elapsed and does the periodic dump when due.
+            Should be called once per frame.
+        */
+        void update(const TMsgAppHandlerStatsArray& handlerStats);
+
+        bool dump(const std::string& sFilename, const TMsgAppHandlerStatsArray& handlerStats) const;
+
+    private:
+        TMsgAppTrafficCountersArray m_rx;
+        TMsgAppTrafficCountersArray m_tx;
+        std::chrono::steady_clock::time_point m_timeStart;
+        std::chrono::steady_clock::time_point m_timeRateWindowStart;
+        std::chrono::steady_clock::time_point m_timeLastDump;
+        std::string m_sDumpFilename;
+        unsigned int m_nDumpIntervalSecs;
+
+        // ---------------------------------------------------------------------------
+
+        NetStats(const NetStats&);
+        NetStats& operator=(const NetStats&);
+
+        static void updateRates(TMsgAppTrafficCountersArray& counters, float fWindowSecs);
+        bool dumpCsv(FILE* f, bool bWriteHeader, float fTimestampSecs, const TMsgAppHandlerStatsArray& handlerStats) const;
+        bool dumpJson(FILE* f, float fTimestampSecs, const TMsgAppHandlerStatsArray& handlerStats) const;
+
+    }; // class NetStats
+
+} // namespace elte_fail
@@ -0,0 +1,369 @@
+/*
+    ###################################################################################
+    ElteFailObjFile.cpp
+    Minimal Wavefront OBJ reader for game-side processing of ELTE-FAIL models.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailObjFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "ElteFailFileUtils.h"
+
+static const size_t nMaxLineLength = 1024;
+
+static const char* skipSpaces(const char* p)
+{
+    while ((*p == ' ') || (*p == '\t'))
+    {
+        p++;
+    }
+    return p;
+}
+
+static elte_fail::ObjVertex parseVertex(const char* p)
+{
+    elte_fail::ObjVertex vertex = { 0.f, 0.f, 0.f };
+    char* pEnd = nullptr;
+    vertex.m_fX = strtof(p, &pEnd);
+    vertex.m_fY = strtof(pEnd, &pEnd);
+    vertex.m_fZ = strtof(pEnd, &pEnd);
+    return vertex;
+}
+
+/**
+    Converts 1-based or negative (relative) OBJ index to 0-based index.
+
+    @return -1 if index is missing or out of range.
+*/
+static int32_t resolveIndex(long nIndex, size_t nCount)
+{
+    if (nIndex > 0)
+    {
+        return (static_cast<size_t>(nIndex) <= nCount) ? static_cast<int32_t>(nIndex - 1) : -1;
+    }
+    if (nIndex < 0)
+    {
+        return (static_cast<size_t>(-nIndex) <= nCount) ? static_cast<int32_t>(static_cast<long>(nCount) + nIndex) : -1;
+    }
+    return -1;
+}
+
+static void writeVertices(FILE* f, const char* szPrefix, const std::vector<elte_fail::ObjVertex>& vVertices, const std::vector<int32_t>& vIndices)
+{
+    for (const auto i : vIndices)
+    {
+        const elte_fail::ObjVertex& v = vVertices[i];
+        fprintf(f, "%s  %.7g %.7g %.7g\n", szPrefix, v.m_fX, v.m_fY, v.m_fZ);
+    }
+}
+
+/**
+    Writes 1-based indices, 0 means missing attribute.
+*/
+static void writeCorner(FILE* f, const elte_fail::ObjFaceCorner& corner)
+{
+    if ((corner.m_iTexCoord > 0) && (corner.m_iNormal > 0))
+    {
+        fprintf(f, " %d/%d/%d", corner.m_iPosition, corner.m_iTexCoord, corner.m_iNormal);
+    }
+    else if (corner.m_iNormal > 0)
+    {
+        fprintf(f, " %d//%d", corner.m_iPosition, corner.m_iNormal);
+    }
+    else if (corner.m_iTexCoord > 0)
+    {
+        fprintf(f, " %d/%d", corner.m_iPosition, corner.m_iTexCoord);
+    }
+    else
+    {
+        fprintf(f, " %d", corner.m_iPosition);
+    }
+}
+
+/**
+    Maps the given 0-based index to the 1-based index to be written, collecting indices used first time by the current group.
+
+    @param vMap  Written index of each source index, 0 if not yet written in the current group.
+    @return 0 if the corner doesn't have this attribute.
+*/
+static int32_t remapIndex(int32_t iSource, std::vector<int32_t>& vMap, int32_t& nWritten, std::vector<int32_t>& vNewIndices)
+{
+    if (iSource < 0)
+    {
+        return 0;
+    }
+    if (vMap[iSource] == 0)
+    {
+        vMap[iSource] = ++nWritten;
+        vNewIndices.push_back(iSource);
+    }
+    return vMap[iSource];
+}
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::ObjFile::ObjFile()
+{
+
+} // ObjFile()
+
+
+bool elte_fail::ObjFile::load(const std::string& sFilename)
+{
+    clear();
+
+    MappedFile file;
+    if (!file.open(sFilename))
+    {
+        return false;
+    }
+    return parse(reinterpret_cast<const char*>(file.getData()), file.getSize());
+} // load()
+
+
+bool elte_fail::ObjFile::parse(const char* pText, size_t nLength)
+{
+    clear();
+
+    bool bRet = true;
+    char szLine[nMaxLineLength];
+    const char* const pEnd = pText + nLength;
+    const char* pLineBegin = pText;
+    while (bRet && (pLineBegin < pEnd))
+    {
+        const char* pLineEnd = static_cast<const char*>(memchr(pLineBegin, '\n', static_cast<size_t>(pEnd - pLineBegin)));
+        if (!pLineEnd)
+        {
+            pLineEnd = pEnd;
+        }
+        // parsers below need terminated lines, longer lines are truncated
+        const size_t nLineLength = std::min(static_cast<size_t>(pLineEnd - pLineBegin), nMaxLineLength - 1);
+        memcpy(szLine, pLineBegin, nLineLength);
+        szLine[nLineLength] = '\0';
+        pLineBegin = pLineEnd + 1;
+
+        const char* const p = skipSpaces(szLine);
+        if ((p[0] == 'v') && (p[1] == ' '))
+        {
+            m_vPositions.push_back(parseVertex(p + 2));
+        }
+        else if ((p[0] == 'v') && (p[1] == 't') && (p[2] == ' '))
+        {
+            m_vTexCoords.push_back(parseVertex(p + 3));
+        }
+        else if ((p[0] == 'v') && (p[1] == 'n') && (p[2] == ' '))
+        {
+            m_vNormals.push_back(parseVertex(p + 3));
+        }
+        else if ((p[0] == 'f') && (p[1] == ' '))
+        {
+            bRet = parseFace(p + 2);
+        }
+        else if ((p[0] == 'g') && ((p[1] == ' ') || (p[1] == '\t') || (p[1] == '\r') || (p[1] == '\n') || (p[1] == '\0')))
+        {
+            std::string sName = skipSpaces(p + 1);
+            sName.erase(sName.find_last_not_of(" \t\r\n") + 1);
+            m_vGroups.push_back({ sName, {} });
+        }
+    }
+
+    return bRet;
+} // parse()
+
+
+bool elte_fail::ObjFile::save(const std::string& sFilename, const std::string& sComment) const
+{
+    FILE* f = nullptr;
+    if ((fopen_s(&f, sFilename.c_str(), "wt") != 0) || !f)
+    {
+        return false;
+    }
+
+    fprintf(f, "# %s\n#\n", sComment.c_str());
+
+    int32_t nPositions = 0;
+    int32_t nTexCoords = 0;
+    int32_t nNormals = 0;
+    for (const auto& group : m_vGroups)
+    {
+        if (group.m_vCorners.empty())
+        {
+            continue;
+        }
+
+        // first pass: remap indices so vertices of the group can be written before its faces
+        std::vector<int32_t> vMapPositions(m_vPositions.size(), 0);
+        std::vector<int32_t> vMapTexCoords(m_vTexCoords.size(), 0);
+        std::vector<int32_t> vMapNormals(m_vNormals.size(), 0);
+        std::vector<int32_t> vNewPositions;
+        std::vector<int32_t> vNewTexCoords;
+        std::vector<int32_t> vNewNormals;
+        std::vector<ObjFaceCorner> vCorners;
+        vCorners.reserve(group.m_vCorners.size());
+        for (const auto& corner : group.m_vCorners)
+        {
+            vCorners.push_back({
+                remapIndex(corner.m_iPosition, vMapPositions, nPositions, vNewPositions),
+                remapIndex(corner.m_iTexCoord, vMapTexCoords, nTexCoords, vNewTexCoords),
+                remapIndex(corner.m_iNormal, vMapNormals, nNormals, vNewNormals) });
+        }
+
+        fprintf(f, "# object %s to come ...\n#\n", group.m_sName.c_str());
+        writeVertices(f, "v", m_vPositions, vNewPositions);
+        writeVertices(f, "vt", m_vTexCoords, vNewTexCoords);
+        writeVertices(f, "vn", m_vNormals, vNewNormals);
+        fprintf(f, "\ng %s\n", group.m_sName.c_str());
+        for (size_t i = 0; i + 2 < vCorners.size(); i += 3)
+        {
+            fprintf(f, "f");
+            for (size_t j = i; j < i + 3; j++)
+            {
+                writeCorner(f, vCorners[j]);
+            }
+            fprintf(f, "\n");
+        }
+        fprintf(f, "g\n\n");
+    }
+
+    const bool bRet = (ferror(f) == 0);
+    fclose(f);
+    return bRet;
+} // save()
+
+
+void elte_fail::ObjFile::assign(
+    std::vector<ObjVertex> vPositions,
+    std::vector<ObjVertex> vTexCoords,
+    std::vector<ObjVertex> vNormals,
+    std::vector<ObjGroup> vGroups)
+{
+    m_vPositions = std::move(vPositions);
+    m_vTexCoords = std::move(vTexCoords);
+    m_vNormals = std::move(vNormals);
+    m_vGroups = std::move(vGroups);
+} // assign()
+
+
+void elte_fail::ObjFile::clear()
+{
+    m_vPositions.clear();
+    m_vTexCoords.clear();
+    m_vNormals.clear();
+    m_vGroups.clear();
+} // clear()
+
+
+const std::vector<elte_fail::ObjVertex>& elte_fail::ObjFile::getPositions() const
+{
+    return m_vPositions;
+} // getPositions()
+
+
+const std::vector<elte_fail::ObjVertex>& elte_fail::ObjFile::getTexCoords() const
+{
+    return m_vTexCoords;
+} // getTexCoords()
+
+
+const std::vector<elte_fail::ObjVertex>& elte_fail::ObjFile::getNormals() const
+{
+    return m_vNormals;
+} // getNormals()
+
+
+const std::vector<elte_fail::ObjGroup>& elte_fail::ObjFile::getGroups() const
+{
+    return m_vGroups;
+} // getGroups()
+
+
+size_t elte_fail::ObjFile::getTriangleCount() const
+{
+    size_t nCorners = 0;
+    for (const auto& group : m_vGroups)
+    {
+        nCorners += group.m_vCorners.size();
+    }
+    return nCorners / 3;
+} // getTriangleCount()
+
+
+bool elte_fail::ObjFile::hasSameFaces(const ObjFile& other) const
+{
+    if (m_vGroups.size() != other.m_vGroups.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < m_vGroups.size(); i++)
+    {
+        if (m_vGroups[i].m_vCorners.size() != other.m_vGroups[i].m_vCorners.size())
+        {
+            return false;
+        }
+    }
+    return true;
+} // hasSameFaces()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+bool elte_fail::ObjFile::parseFace(const char* szLine)
+{
+    if (m_vGroups.empty())
+    {
+        // faces before the first "g" line
+        m_vGroups.push_back({ "", {} });
+    }
+
+    std::vector<ObjFaceCorner> vPolygon;
+    const char* p = skipSpaces(szLine);
+    while ((*p != '\0') && (*p != '\r') && (*p != '\n'))
+    {
+        // v, v/vt, v//vn or v/vt/vn
+        char* pEnd = nullptr;
+        ObjFaceCorner corner = { resolveIndex(strtol(p, &pEnd, 10), m_vPositions.size()), -1, -1 };
+        if (corner.m_iPosition < 0)
+        {
+            return false;
+        }
+        if (*pEnd == '/')
+        {
+            if (pEnd[1] != '/')
+            {
+                corner.m_iTexCoord = resolveIndex(strtol(pEnd + 1, &pEnd, 10), m_vTexCoords.size());
+            }
+            else
+            {
+                pEnd++;
+            }
+            if (*pEnd == '/')
+            {
+                corner.m_iNormal = resolveIndex(strtol(pEnd + 1, &pEnd, 10), m_vNormals.size());
+            }
+        }
+        vPolygon.push_back(corner);
+        p = skipSpaces(pEnd);
+    }
+
+    std::vector<ObjFaceCorner>& vCorners = m_vGroups.back().m_vCorners;
+    for (size_t i = 2; i < vPolygon.size(); i++)
+    {
+        vCorners.push_back(vPolygon[0]);
+        vCorners.push_back(vPolygon[i - 1]);
+        vCorners.push_back(vPolygon[i]);
+    }
+    return true;
+} // parseFace()
@@ -0,0 +1,107 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailObjFile.h
+    Minimal Wavefront OBJ reader for game-side processing of ELTE-FAIL models.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace elte_fail
+{
+
+    struct ObjVertex
+    {
+        float m_fX;
+        float m_fY;
+        float m_fZ;
+    };
+
+    /**
+        Indices are 0-based, -1 if the corner doesn't have the given attribute.
+    */
+    struct ObjFaceCorner
+    {
+        int32_t m_iPosition;
+        int32_t m_iTexCoord;
+        int32_t m_iNormal;
+    };
+
+    /**
+        Faces under a "g" line, up to the next "g" line. Same name may appear in multiple groups.
+        Polygons are triangulated as fans, so every 3 corners make a triangle.
+    */
+    struct ObjGroup
+    {
+        std::string m_sName;
+        std::vector<ObjFaceCorner> m_vCorners;
+    };
+
+    /**
+        Reads geometry of an OBJ file the same way as Pure loads it, so the game can work on the same data as the renderer
+        (e.g. collision). Only v, vt, vn, f and g lines are processed, everything else is ignored.
+        Can also write geometry generated by the game (e.g. arena chunks, optimized models) in the same layout as Max2Obj does.
+    */
+    class ObjFile
+    {
+    public:
+        ObjFile();
+
+        /**
+            @return False if file cannot be mapped or any face refers to a nonexistent vertex.
+        */
+        bool load(const std::string& sFilename);
+
+        /**
+            Same as load() but from text already in memory, e.g. an entry of an AssetPack. Text doesn't need to be terminated.
+
+            @return False if any face refers to a nonexistent vertex.
+        */
+        bool parse(const char* pText, size_t nLength);
+
+        /**
+            Writes groups having any faces in the layout of Max2Obj: vertices used by a group are written right before the
+            group, so faces refer only to vertices of their own group. Unused vertices are not written.
+
+            @param sComment Written as the first comment line.
+        */
+        bool save(const std::string& sFilename, const std::string& sComment) const;
+
+        void assign(
+            std::vector<ObjVertex> vPositions,
+            std::vector<ObjVertex> vTexCoords,
+            std::vector<ObjVertex> vNormals,
+            std::vector<ObjGroup> vGroups);
+
+        void clear();
+
+        const std::vector<ObjVertex>& getPositions() const;
+        const std::vector<ObjVertex>& getTexCoords() const;
+        const std::vector<ObjVertex>& getNormals() const;
+        const std::vector<ObjGroup>& getGroups() const;
+        size_t getTriangleCount() const;
+
+        /**
+            @return True if the other model has the same groups with the same number of corners, e.g. a lightmap model made
+                    for this model, so any per-triangle processing of this model can be applied to the other model too.
+        */
+        bool hasSameFaces(const ObjFile& other) const;
+
+    private:
+        std::vector<ObjVertex> m_vPositions;
+        std::vector<ObjVertex> m_vTexCoords;
+        std::vector<ObjVertex> m_vNormals;
+        std::vector<ObjGroup> m_vGroups;
+
+        // ---------------------------------------------------------------------------
+
+        bool parseFace(const char* szLine);
+    }; // class ObjFile
+
+} // namespace elte_fail
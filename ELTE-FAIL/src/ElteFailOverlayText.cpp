@@ -0,0 +1,232 @@
+/*
+    ###################################################################################
+    ElteFailOverlayText.cpp
+    Retained overlay text lines of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailOverlayText.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::OverlayText::OverlayText() :
+    m_mode(OverlayTextMode::Retained),
+    m_stats{}
+{
+
+} // OverlayText()
+
+
+elte_fail::TOverlayTextId elte_fail::OverlayText::add(int x, int y)
+{
+    m_vLines.push_back({ x, y, std::string(), nullptr, false });
+    return static_cast<TOverlayTextId>(m_vLines.size() - 1);
+} // add()
+
+
+void elte_fail::OverlayText::set(TOverlayTextId id, const std::string& sText)
+{
+    assert(id < m_vLines.size());
+    Line& line = m_vLines[id];
+    if (line.m_sText == sText)
+    {
+        m_stats.m_nUnchanged++;
+        return;
+    }
+    line.m_sText.assign(sText);
+    line.m_bDirty = true;
+} // set()
+
+
+void elte_fail::OverlayText::clear(TOverlayTextId id)
+{
+    set(id, m_sEmpty);
+} // clear()
+
+
+const std::string& elte_fail::OverlayText::get(TOverlayTextId id) const
+{
+    assert(id < m_vLines.size());
+    return m_vLines[id].m_sText;
+} // get()
+
+
+void elte_fail::OverlayText::setMode(OverlayTextMode mode)
+{
+    if (mode == m_mode)
+    {
+        return;
+    }
+    m_mode = mode;
+    if (m_mode == OverlayTextMode::Retained)
+    {
+        // permanent texts were emptied while in Temporal mode
+        for (auto& line : m_vLines)
+        {
+            line.m_bDirty = true;
+        }
+    }
+} // setMode()
+
+
+elte_fail::OverlayTextMode elte_fail::OverlayText::getMode() const
+{
+    return m_mode;
+} // getMode()
+
+
+void elte_fail::OverlayText::flush(PureUiManager& uiManager)
+{
+    m_stats.m_nFlushes++;
+    for (auto& line : m_vLines)
+    {
+        if (m_mode == OverlayTextMode::Temporal)
+        {
+            if (line.m_pText && !line.m_pText->getText().empty())
+            {
+                line.m_pText->SetText(m_sEmpty);
+            }
+            if (!line.m_sText.empty())
+            {
+                uiManager.textTemporalLegacy(line.m_sText, line.m_nX, line.m_nY);
+                m_stats.m_nRebuilds++;
+            }
+            continue;
+        }
+
+        if (!line.m_bDirty)
+        {
+            continue;
+        }
+        line.m_bDirty = false;
+        if (line.m_pText)
+        {
+            line.m_pText->SetText(line.m_sText);
+        }
+        else if (!line.m_sText.empty())
+        {
+            line.m_pText = uiManager.textPermanentLegacy(line.m_sText, line.m_nX, line.m_nY);
+        }
+        else
+        {
+            continue;
+        }
+        m_stats.m_nRebuilds++;
+    }
+} // flush()
+
+
+const elte_fail::OverlayTextStats& elte_fail::OverlayText::getStats() const
+{
+    return m_stats;
+} // getStats()
+
+
+elte_fail::OverlayTextBenchmark::OverlayTextBenchmark() :
+    m_pOverlay(nullptr),
+    m_originalMode(OverlayTextMode::Retained),
+    m_nFramesPerMode(0),
+    m_nFrame(0),
+    m_fSumFrameMSecs(0.0),
+    m_nSumOverlayUSecs(0),
+    m_nRebuildsAtStart(0),
+    m_bRunning(false)
+{
+
+} // OverlayTextBenchmark()
+
+
+bool elte_fail::OverlayTextBenchmark::start(OverlayText& overlay, uint32_t nFramesPerMode)
+{
+    if (m_bRunning || (nFramesPerMode == 0))
+    {
+        return false;
+    }
+
+    m_pOverlay = &overlay;
+    m_originalMode = overlay.getMode();
+    m_vResults.clear();
+    m_nFramesPerMode = nFramesPerMode;
+    m_bRunning = true;
+    beginMode(OverlayTextMode::Temporal);
+    return true;
+} // start()
+
+
+bool elte_fail::OverlayTextBenchmark::isRunning() const
+{
+    return m_bRunning;
+} // isRunning()
+
+
+bool elte_fail::OverlayTextBenchmark::onFrame(uint32_t nOverlayUSecs)
+{
+    if (!m_bRunning)
+    {
+        return false;
+    }
+
+    const auto timeNow = std::chrono::steady_clock::now();
+    const double fFrameMSecs = std::chrono::duration<double, std::milli>(timeNow - m_timeLastFrame).count();
+    m_timeLastFrame = timeNow;
+
+    m_nFrame++;
+    if (m_nFrame <= nWarmupFrames)
+    {
+        m_nRebuildsAtStart = m_pOverlay->getStats().m_nRebuilds;
+        return false;
+    }
+
+    OverlayTextResult& result = m_vResults.back();
+    m_fSumFrameMSecs += fFrameMSecs;
+    m_nSumOverlayUSecs += nOverlayUSecs;
+    result.m_nFrames++;
+    result.m_fMinFrameMSecs = std::min(result.m_fMinFrameMSecs, static_cast<float>(fFrameMSecs));
+    if (result.m_nFrames < m_nFramesPerMode)
+    {
+        return false;
+    }
+
+    result.m_fAvgFrameMSecs = static_cast<float>(m_fSumFrameMSecs / result.m_nFrames);
+    result.m_fAvgOverlayUSecs = static_cast<float>(static_cast<double>(m_nSumOverlayUSecs) / result.m_nFrames);
+    result.m_nRebuilds = m_pOverlay->getStats().m_nRebuilds - m_nRebuildsAtStart;
+    if (result.m_mode == OverlayTextMode::Temporal)
+    {
+        beginMode(OverlayTextMode::Retained);
+        return false;
+    }
+
+    m_pOverlay->setMode(m_originalMode);
+    m_bRunning = false;
+    return true;
+} // onFrame()
+
+
+const std::vector<elte_fail::OverlayTextResult>& elte_fail::OverlayTextBenchmark::getResults() const
+{
+    return m_vResults;
+} // getResults()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+void elte_fail::OverlayTextBenchmark::beginMode(OverlayTextMode mode)
+{
+    m_pOverlay->setMode(mode);
+    m_vResults.push_back({ mode, 0, 0.f, FLT_MAX, 0.f, 0 });
+    m_nFrame = 0;
+    m_fSumFrameMSecs = 0.0;
+    m_nSumOverlayUSecs = 0;
+    m_timeLastFrame = std::chrono::steady_clock::now();
+} // beginMode()
@@ -0,0 +1,151 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailOverlayText.h
+    Retained overlay text lines of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../../../PGE/PGE/Pure/include/external/PureUiManager.h"
+
+namespace elte_fail
+{
+
+    typedef uint32_t TOverlayTextId;
+
+    enum class OverlayTextMode
+    {
+        Retained,  /**< Lines are PURE permanent texts, their glyph geometry is rebuilt only when their content changes. */
+        Temporal   /**< Lines are drawn by textTemporalLegacy() every frame, i.e. their glyph geometry is rebuilt every frame. */
+    };
+
+    struct OverlayTextStats
+    {
+        uint64_t m_nFlushes;
+        uint64_t m_nRebuilds;     /**< Lines given to PURE with new content, or every visible line in Temporal mode. */
+        uint64_t m_nUnchanged;    /**< Lines set to the same content as they already had, costing only a compare. */
+    };
+
+    /**
+        Overlay text lines set every frame but changed rarely, e.g. network and culling stats.
+        Content of every line is kept and compared to the newly set content, so PURE is given only the lines actually changed,
+        and the rest keep the geometry PURE built for them last time. All lines are drawn together by PURE in its UI pass.
+        Lines are created in PURE by the first flush() after they get non-empty content, an empty line is not drawn.
+    */
+    class OverlayText
+    {
+    public:
+        OverlayText();
+
+        TOverlayTextId add(int x, int y);   /**< New empty line at the given window position. */
+
+        /**
+            Copies the given content if it differs from the current one, reusing the capacity of the line.
+        */
+        void set(TOverlayTextId id, const std::string& sText);
+
+        void clear(TOverlayTextId id);      /**< Hides the line by setting empty content. */
+
+        const std::string& get(TOverlayTextId id) const;
+
+        /**
+            Switching from Temporal to Retained mode gives all lines to PURE again at the next flush().
+        */
+        void setMode(OverlayTextMode mode);
+
+        OverlayTextMode getMode() const;
+
+        /**
+            Gives the changed lines to PURE, or in Temporal mode draws all non-empty lines for the current frame.
+            Must be called once per frame, after setting the lines.
+        */
+        void flush(PureUiManager& uiManager);
+
+        const OverlayTextStats& getStats() const;
+
+    private:
+
+        struct Line
+        {
+            int m_nX;
+            int m_nY;
+            std::string m_sText;
+            PureText* m_pText;   /**< Created by the first flush() when content is not empty. */
+            bool m_bDirty;       /**< Content not yet given to PURE. */
+        };
+
+        std::vector<Line> m_vLines;
+        OverlayTextMode m_mode;
+        OverlayTextStats m_stats;
+        const std::string m_sEmpty;
+
+        // ---------------------------------------------------------------------------
+
+        OverlayText(const OverlayText&);
+        OverlayText& operator=(const OverlayText&);
+    }; // class OverlayText
+
+    struct OverlayTextResult
+    {
+        OverlayTextMode m_mode;
+        uint32_t m_nFrames;
+        float m_fAvgFrameMSecs;
+        float m_fMinFrameMSecs;
+        float m_fAvgOverlayUSecs;   /**< Time spent in OverlayText::flush(), per frame. */
+        uint64_t m_nRebuilds;       /**< Lines given to PURE during the measured frames. */
+    };
+
+    /**
+        Measures frame times and overlay times with the overlay in Temporal mode first, then in Retained mode, with the same lines.
+        Driven by the game loop: onFrame() must be called once per frame, after OverlayText::flush(). VSync should be disabled
+        while running, otherwise every frame takes the same time.
+    */
+    class OverlayTextBenchmark
+    {
+    public:
+        static const uint32_t nWarmupFrames = 10;   /**< Frames skipped after each mode switch. */
+
+        OverlayTextBenchmark();
+
+        /**
+            @return False if nFramesPerMode is 0.
+        */
+        bool start(OverlayText& overlay, uint32_t nFramesPerMode);
+
+        bool isRunning() const;
+
+        /**
+            Records the time elapsed since the previous call and the given time spent in OverlayText::flush(),
+            and switches to the next mode if needed. Mode of the overlay is restored at the end.
+
+            @return True in the frame when the benchmark finished.
+        */
+        bool onFrame(uint32_t nOverlayUSecs);
+
+        const std::vector<OverlayTextResult>& getResults() const;
+
+    private:
+        OverlayText* m_pOverlay;
+        OverlayTextMode m_originalMode;
+        std::vector<OverlayTextResult> m_vResults;
+        uint32_t m_nFramesPerMode;
+        uint32_t m_nFrame;              /**< Frames since current mode was set, including warmup. */
+        double m_fSumFrameMSecs;
+        uint64_t m_nSumOverlayUSecs;
+        uint64_t m_nRebuildsAtStart;    /**< Rebuilds of the overlay when the measurement of current mode started. */
+        std::chrono::steady_clock::time_point m_timeLastFrame;
+        bool m_bRunning;
+
+        // ---------------------------------------------------------------------------
+
+        void beginMode(OverlayTextMode mode);
+    }; // class OverlayTextBenchmark
+
+} // namespace elte_fail
@@ -11,6 +11,10 @@
 #include "../../../PGE/PGE/Network/PgePacket.h"
 
 #include <array>
+#include <cstddef>
+#include <cstring>
+
+#include "ElteFailStringTable.h"
 
 namespace elte_fail
 {
@@ -20,37 +24,57 @@ namespace elte_fail
         UserSetupFromServer = 0,
         UserCmdMoveFromClient,
         UserUpdateFromServer,
+        WorldStateFromServer,
+        StringDefFromServer,
+        UserCmdFireFromClient,
+        ProjectileEventsFromServer,
         LastMsgId
     };
 
     struct ElteFailMsgId2ZStringPair
     {
         ElteFailMsgId msgId;
-        const char* const zstring;
+        const char* zstring;
     };
 
-    // this way of defining std::array makes sure code cannot compile if we forget to align the array after changing ElteFailMsgId
-    constexpr std::array<ElteFailMsgId2ZStringPair, static_cast<size_t>(ElteFailMsgId::LastMsgId)> MapMsgAppId2String
-    { {
-         {ElteFailMsgId::UserSetupFromServer,    "MsgUserSetupFromServer"},
-         {ElteFailMsgId::UserCmdMoveFromClient,  "MsgUserCmdFromClient"},
-         {ElteFailMsgId::UserUpdateFromServer,   "MsgUserUpdateFromServer"}
-    } };
+    /**
+        Tells which side accepts the message over the network, so the allow-lists of server and client can be generated from it.
+    */
+    enum class MsgDirection : uint8_t
+    {
+        ServerToClient = 0,  /**< Server injects it into its own queue and sends it to clients. MUST NOT be received by server over network! */
+        ClientToServer       /**< Clients send it to server. */
+    };
+
+    /**
+        Delivery semantics of the message.
+        PGE sends every packet reliably, so for UnreliableSequenced the sender coalesces the messages not yet sent, and the receiver
+        drops the ones older than the newest already handled (see SequenceFilter). Messages of this channel must have a
+        uint16_t m_nSeq, incremented by the sender for every message of the same type about the same connection.
+    */
+    enum class MsgChannel : uint8_t
+    {
+        ReliableOrdered = 0,   /**< Every message must be handled, in order. */
+        UnreliableSequenced    /**< Message is pure state, only the newest one matters, older ones can be dropped. */
+    };
 
     // server -> self (inject) and clients
+    // Strings are referred to by their id in the interned string table of server, clients receive the strings in MsgStringDefFromServer
+    // before receiving this message.
     struct MsgUserSetupFromServer
     {
         static const ElteFailMsgId id = ElteFailMsgId::UserSetupFromServer;
-        static const uint8_t nUserNameBufferLength = 64;
-        static const uint8_t nTrollfaceTexMaxLength = 64;
+        static constexpr MsgDirection direction = MsgDirection::ServerToClient;
+        static constexpr MsgChannel channel = MsgChannel::ReliableOrdered;
+        static constexpr const char* zstring = "MsgUserSetupFromServer";
 
         static bool initPkt(
             pge_network::PgePacket& pkt,
             const pge_network::PgeNetworkConnectionHandle& connHandleServerSide,
             bool bCurrentClient,
-            const std::string& sUserName,
-            const std::string& sTrollFaceTex,
-            const std::string& sIpAddress)
+            TStringId nUserNameId,
+            TStringId nTrollfaceTexId,
+            TStringId nIpAddressId)
         {
             // although preparePktMsgAppFill() does runtime check, we should fail already at compile-time if msg is too big!
             static_assert(sizeof(MsgUserSetupFromServer) <= pge_network::MsgAppArea::nMaxMessagesAreaLengthBytes, "msg size");
@@ -66,17 +90,17 @@ namespace elte_fail
 
             elte_fail::MsgUserSetupFromServer& msgUserSetup = reinterpret_cast<elte_fail::MsgUserSetupFromServer&>(*pMsgAppData);
             msgUserSetup.m_bCurrentClient = bCurrentClient;
-            strncpy_s(msgUserSetup.m_szUserName, nUserNameBufferLength, sUserName.c_str(), sUserName.length());
-            strncpy_s(msgUserSetup.m_szTrollfaceTex, nTrollfaceTexMaxLength, sTrollFaceTex.c_str(), sTrollFaceTex.length());
-            strncpy_s(msgUserSetup.m_szIpAddress, sizeof(msgUserSetup.m_szIpAddress), sIpAddress.c_str(), sIpAddress.length());
+            msgUserSetup.m_nUserNameId = nUserNameId;
+            msgUserSetup.m_nTrollfaceTexId = nTrollfaceTexId;
+            msgUserSetup.m_nIpAddressId = nIpAddressId;
 
             return true;
         }
 
         bool m_bCurrentClient;
-        char m_szUserName[nUserNameBufferLength];
-        char m_szTrollfaceTex[nTrollfaceTexMaxLength];
-        char m_szIpAddress[pge_network::MsgUserConnectedServerSelf::nIpAddressMaxLength];
+        TStringId m_nUserNameId;
+        TStringId m_nTrollfaceTexId;
+        TStringId m_nIpAddressId;
     };
     static_assert(std::is_trivial_v<MsgUserSetupFromServer>);
     static_assert(std::is_trivially_copyable_v<MsgUserSetupFromServer>);
@@ -101,9 +125,13 @@ namespace elte_fail
     struct MsgUserCmdMoveFromClient
     {
         static const ElteFailMsgId id = ElteFailMsgId::UserCmdMoveFromClient;
+        static constexpr MsgDirection direction = MsgDirection::ClientToServer;
+        static constexpr MsgChannel channel = MsgChannel::UnreliableSequenced;
+        static constexpr const char* zstring = "MsgUserCmdMoveFromClient";
 
         static bool initPkt(
             pge_network::PgePacket& pkt,
+            uint16_t nSeq,
             const HorizontalDirection& dirHorizontal,
             const VerticalDirection& dirVertical)
         {
@@ -120,12 +148,25 @@ namespace elte_fail
             }
 
             elte_fail::MsgUserCmdMoveFromClient& msgUserCmdMove = reinterpret_cast<elte_fail::MsgUserCmdMoveFromClient&>(*pMsgAppData);
+            msgUserCmdMove.m_nSeq = nSeq;
             msgUserCmdMove.m_dirHorizontal = dirHorizontal;
             msgUserCmdMove.m_dirVertical = dirVertical;
 
             return true;
         }
 
+        /**
+            Stateless validation, invoked by the decode thread of server, see PacketPipeline.
+            Moving without any direction is invalid.
+        */
+        static bool isValid(const MsgUserCmdMoveFromClient& msg)
+        {
+            return (msg.m_dirHorizontal <= HorizontalDirection::RIGHT) &&
+                (msg.m_dirVertical <= VerticalDirection::DOWN) &&
+                ((msg.m_dirHorizontal != HorizontalDirection::NONE) || (msg.m_dirVertical != VerticalDirection::NONE));
+        }
+
+        uint16_t m_nSeq;
         HorizontalDirection m_dirHorizontal;
         VerticalDirection m_dirVertical;
     };
@@ -137,10 +178,14 @@ namespace elte_fail
     struct MsgUserUpdateFromServer
     {
         static const ElteFailMsgId id = ElteFailMsgId::UserUpdateFromServer;
+        static constexpr MsgDirection direction = MsgDirection::ServerToClient;
+        static constexpr MsgChannel channel = MsgChannel::UnreliableSequenced;
+        static constexpr const char* zstring = "MsgUserUpdateFromServer";
 
         static bool initPkt(
             pge_network::PgePacket& pkt,
             const pge_network::PgeNetworkConnectionHandle& connHandleServerSide,
+            uint16_t nSeq,
             const TPureFloat x,
             const TPureFloat y, 
             const TPureFloat z)
@@ -158,6 +203,7 @@ namespace elte_fail
             }
 
             elte_fail::MsgUserUpdateFromServer& msgUserCmdUpdate = reinterpret_cast<elte_fail::MsgUserUpdateFromServer&>(*pMsgAppData);
+            msgUserCmdUpdate.m_nSeq = nSeq;
             msgUserCmdUpdate.m_pos.x = x;
             msgUserCmdUpdate.m_pos.y = y;
             msgUserCmdUpdate.m_pos.z = z;
@@ -165,10 +211,303 @@ namespace elte_fail
             return true;
         }
 
+        uint16_t m_nSeq;
         TXYZ m_pos;  // Z-coord is actually unused because it never gets changed during the whole gameplay ...
     };
     static_assert(std::is_trivial_v<MsgUserUpdateFromServer>);
     static_assert(std::is_trivially_copyable_v<MsgUserUpdateFromServer>);
     static_assert(std::is_standard_layout_v<MsgUserUpdateFromServer>);
 
+    // server -> clients
+    // Sent to a newly connected client about all already connected players, instead of 1 MsgUserSetupFromServer and 1 MsgUserUpdateFromServer per player.
+    // Payload is a variable-length serialized snapshot (see WorldState), optionally compressed, split into as many fragments as needed.
+    // Only the used part of m_data is transferred.
+    struct MsgWorldStateFromServer
+    {
+        static const ElteFailMsgId id = ElteFailMsgId::WorldStateFromServer;
+        static constexpr MsgDirection direction = MsgDirection::ServerToClient;
+        static constexpr MsgChannel channel = MsgChannel::ReliableOrdered;
+        static constexpr const char* zstring = "MsgWorldStateFromServer";
+        static const uint16_t nHeaderLength = 12;
+        static const uint16_t nMaxFragmentDataLength = static_cast<uint16_t>(
+            pge_network::MsgAppArea::nMaxMessagesAreaLengthBytes - sizeof(pge_network::MsgApp) - nHeaderLength);
+
+        static bool initPkt(
+            pge_network::PgePacket& pkt,
+            uint16_t nSnapshotId,
+            uint8_t iFragment,
+            uint8_t nFragmentCount,
+            bool bCompressed,
+            uint32_t nSnapshotLength,
+            const pge_network::TByte* pData,
+            uint16_t nDataLength)
+        {
+            // although preparePktMsgAppFill() does runtime check, we should fail already at compile-time if msg is too big!
+            static_assert(sizeof(MsgWorldStateFromServer) <= pge_network::MsgAppArea::nMaxMessagesAreaLengthBytes, "msg size");
+
+            if (nDataLength > nMaxFragmentDataLength)
+            {
+                return false;
+            }
+
+            pge_network::PgePacket::initPktMsgApp(pkt, 0 /* m_connHandleServerSide is ignored in this message */);
+
+            pge_network::TByte* const pMsgAppData = pge_network::PgePacket::preparePktMsgAppFill(
+                pkt, static_cast<pge_network::MsgApp::TMsgId>(id), nHeaderLength + nDataLength);
+            if (!pMsgAppData)
+            {
+                return false;
+            }
+
+            elte_fail::MsgWorldStateFromServer& msgWorldState = reinterpret_cast<elte_fail::MsgWorldStateFromServer&>(*pMsgAppData);
+            msgWorldState.m_nSnapshotId = nSnapshotId;
+            msgWorldState.m_iFragment = iFragment;
+            msgWorldState.m_nFragmentCount = nFragmentCount;
+            msgWorldState.m_bCompressed = bCompressed;
+            msgWorldState.m_nDataLength = nDataLength;
+            msgWorldState.m_nSnapshotLength = nSnapshotLength;
+            memcpy(msgWorldState.m_data, pData, nDataLength);
+
+            return true;
+        }
+
+        uint16_t m_nSnapshotId;         /**< Fragments of the same snapshot have the same id. */
+        uint8_t  m_iFragment;           /**< 0-based index of this fragment. */
+        uint8_t  m_nFragmentCount;      /**< Number of fragments of this snapshot. */
+        bool     m_bCompressed;         /**< True if the concatenated fragments need to be decompressed. */
+        uint16_t m_nDataLength;         /**< Number of used bytes in m_data. */
+        uint32_t m_nSnapshotLength;     /**< Length of the snapshot after decompression. */
+        pge_network::TByte m_data[nMaxFragmentDataLength];
+    };
+    static_assert(std::is_trivial_v<MsgWorldStateFromServer>);
+    static_assert(std::is_trivially_copyable_v<MsgWorldStateFromServer>);
+    static_assert(std::is_standard_layout_v<MsgWorldStateFromServer>);
+    static_assert(offsetof(MsgWorldStateFromServer, m_data) == MsgWorldStateFromServer::nHeaderLength);
+
+    // server -> clients
+    // Defines 1 string of the interned string table of server. Server sends it to a client only once per string, right before the
+    // first message referring to the string. Only the used part of m_szString is transferred.
+    struct MsgStringDefFromServer
+    {
+        static const ElteFailMsgId id = ElteFailMsgId::StringDefFromServer;
+        static constexpr MsgDirection direction = MsgDirection::ServerToClient;
+        static constexpr MsgChannel channel = MsgChannel::ReliableOrdered;
+        static constexpr const char* zstring = "MsgStringDefFromServer";
+        static const uint16_t nHeaderLength = 3;
+
+        static bool initPkt(
+            pge_network::PgePacket& pkt,
+            TStringId nStringId,
+            const std::string& str)
+        {
+            // although preparePktMsgAppFill() does runtime check, we should fail already at compile-time if msg is too big!
+            static_assert(sizeof(MsgStringDefFromServer) <= pge_network::MsgAppArea::nMaxMessagesAreaLengthBytes, "msg size");
+
+            if (str.length() > StringTable::nMaxStringLength)
+            {
+                return false;
+            }
+
+            pge_network::PgePacket::initPktMsgApp(pkt, 0 /* m_connHandleServerSide is ignored in this message */);
+
+            pge_network::TByte* const pMsgAppData = pge_network::PgePacket::preparePktMsgAppFill(
+                pkt, static_cast<pge_network::MsgApp::TMsgId>(id), static_cast<uint16_t>(nHeaderLength + str.length()));
+            if (!pMsgAppData)
+            {
+                return false;
+            }
+
+            elte_fail::MsgStringDefFromServer& msgStringDef = reinterpret_cast<elte_fail::MsgStringDefFromServer&>(*pMsgAppData);
+            msgStringDef.m_nStringId = nStringId;
+            msgStringDef.m_nLength = static_cast<uint8_t>(str.length());
+            memcpy(msgStringDef.m_szString, str.c_str(), str.length());
+
+            return true;
+        }
+
+        TStringId m_nStringId;
+        uint8_t m_nLength;                                    /**< Number of used chars in m_szString, there is no terminating zero. */
+        char m_szString[StringTable::nMaxStringLength];
+    };
+    static_assert(std::is_trivial_v<MsgStringDefFromServer>);
+    static_assert(std::is_trivially_copyable_v<MsgStringDefFromServer>);
+    static_assert(std::is_standard_layout_v<MsgStringDefFromServer>);
+    static_assert(offsetof(MsgStringDefFromServer, m_szString) == MsgStringDefFromServer::nHeaderLength);
+
+    // clients -> server
+    // Fires a projectile from the player of the client in the given direction, server limits the fire rate.
+    struct MsgUserCmdFireFromClient
+    {
+        static const ElteFailMsgId id = ElteFailMsgId::UserCmdFireFromClient;
+        static constexpr MsgDirection direction = MsgDirection::ClientToServer;
+        static constexpr MsgChannel channel = MsgChannel::ReliableOrdered;
+        static constexpr const char* zstring = "MsgUserCmdFireFromClient";
+
+        static bool initPkt(
+            pge_network::PgePacket& pkt,
+            const HorizontalDirection& dirHorizontal,
+            const VerticalDirection& dirVertical)
+        {
+            // although preparePktMsgAppFill() does runtime check, we should fail already at compile-time if msg is too big!
+            static_assert(sizeof(MsgUserCmdFireFromClient) <= pge_network::MsgAppArea::nMaxMessagesAreaLengthBytes, "msg size");
+
+            pge_network::PgePacket::initPktMsgApp(pkt, 0 /* m_connHandleServerSide is ignored in this message */);
+
+            pge_network::TByte* const pMsgAppData = pge_network::PgePacket::preparePktMsgAppFill(
+                pkt, static_cast<pge_network::MsgApp::TMsgId>(id), sizeof(MsgUserCmdFireFromClient));
+            if (!pMsgAppData)
+            {
+                return false;
+            }
+
+            elte_fail::MsgUserCmdFireFromClient& msgUserCmdFire = reinterpret_cast<elte_fail::MsgUserCmdFireFromClient&>(*pMsgAppData);
+            msgUserCmdFire.m_dirHorizontal = dirHorizontal;
+            msgUserCmdFire.m_dirVertical = dirVertical;
+
+            return true;
+        }
+
+        /**
+            Stateless validation, invoked by the decode thread of server, see PacketPipeline.
+            Firing without any direction is invalid.
+        */
+        static bool isValid(const MsgUserCmdFireFromClient& msg)
+        {
+            return (msg.m_dirHorizontal <= HorizontalDirection::RIGHT) &&
+                (msg.m_dirVertical <= VerticalDirection::DOWN) &&
+                ((msg.m_dirHorizontal != HorizontalDirection::NONE) || (msg.m_dirVertical != VerticalDirection::NONE));
+        }
+
+        HorizontalDirection m_dirHorizontal;
+        VerticalDirection m_dirVertical;
+    };
+    static_assert(std::is_trivial_v<MsgUserCmdFireFromClient>);
+    static_assert(std::is_trivially_copyable_v<MsgUserCmdFireFromClient>);
+    static_assert(std::is_standard_layout_v<MsgUserCmdFireFromClient>);
+
+    enum class ProjectileEventType : uint8_t
+    {
+        Spawn = 0,
+        Expired,        /**< Lifetime is over or left the arena. */
+        HitWorld,
+        HitPlayer
+    };
+
+    /**
+        Projectiles fly in straight line with constant speed, so only their spawn and despawn are replicated,
+        clients simulate them in between. Position is fixed-point, direction is 1 of the 8 directions of movement.
+    */
+    struct ProjectileEvent
+    {
+        static constexpr float fPosUnitsPerWorldUnit = 4096.f;   /**< Arena fits into +-8 world units. */
+
+        static int16_t quantizePos(float fPos)
+        {
+            const float fUnits = fPos * fPosUnitsPerWorldUnit;
+            return static_cast<int16_t>((fUnits < -32768.f) ? -32768.f : ((fUnits > 32767.f) ? 32767.f : fUnits));
+        }
+
+        static float dequantizePos(int16_t nPos)
+        {
+            return nPos / fPosUnitsPerWorldUnit;
+        }
+
+        uint16_t m_nId;
+        ProjectileEventType m_type;
+        uint8_t m_nDir;                  /**< Spawn only: HorizontalDirection in bits 0-1, VerticalDirection in bits 2-3. */
+        int16_t m_nPosX;                 /**< Spawn only. */
+        int16_t m_nPosY;                 /**< Spawn only. */
+    };
+    static_assert(sizeof(ProjectileEvent) == 8);
+
+    // server -> clients
+    // Projectiles spawned and despawned since the previous message, in order. Only the used part of m_events is transferred.
+    struct MsgProjectileEventsFromServer
+    {
+        static const ElteFailMsgId id = ElteFailMsgId::ProjectileEventsFromServer;
+        static constexpr MsgDirection direction = MsgDirection::ServerToClient;
+        static constexpr MsgChannel channel = MsgChannel::ReliableOrdered;
+        static constexpr const char* zstring = "MsgProjectileEventsFromServer";
+        static const uint16_t nHeaderLength = 2;
+        static const uint8_t nMaxEvents = static_cast<uint8_t>(
+            (pge_network::MsgAppArea::nMaxMessagesAreaLengthBytes - sizeof(pge_network::MsgApp) - nHeaderLength) / sizeof(ProjectileEvent));
+
+        static bool initPkt(
+            pge_network::PgePacket& pkt,
+            const ProjectileEvent* pEvents,
+            uint8_t nEvents)
+        {
+            // although preparePktMsgAppFill() does runtime check, we should fail already at compile-time if msg is too big!
+            static_assert(sizeof(MsgProjectileEventsFromServer) <= pge_network::MsgAppArea::nMaxMessagesAreaLengthBytes, "msg size");
+
+            if ((nEvents == 0) || (nEvents > nMaxEvents))
+            {
+                return false;
+            }
+
+            pge_network::PgePacket::initPktMsgApp(pkt, 0 /* m_connHandleServerSide is ignored in this message */);
+
+            pge_network::TByte* const pMsgAppData = pge_network::PgePacket::preparePktMsgAppFill(
+                pkt, static_cast<pge_network::MsgApp::TMsgId>(id), static_cast<uint16_t>(nHeaderLength + nEvents * sizeof(ProjectileEvent)));
+            if (!pMsgAppData)
+            {
+                return false;
+            }
+
+            elte_fail::MsgProjectileEventsFromServer& msgProjectileEvents = reinterpret_cast<elte_fail::MsgProjectileEventsFromServer&>(*pMsgAppData);
+            msgProjectileEvents.m_nEvents = nEvents;
+            memcpy(msgProjectileEvents.m_events, pEvents, nEvents * sizeof(ProjectileEvent));
+
+            return true;
+        }
+
+        static bool isValid(const MsgProjectileEventsFromServer& msg)
+        {
+            return (msg.m_nEvents > 0) && (msg.m_nEvents <= nMaxEvents);
+        }
+
+        uint8_t m_nEvents;              /**< Number of used events in m_events. */
+        ProjectileEvent m_events[nMaxEvents];
+    };
+    static_assert(std::is_trivial_v<MsgProjectileEventsFromServer>);
+    static_assert(std::is_trivially_copyable_v<MsgProjectileEventsFromServer>);
+    static_assert(std::is_standard_layout_v<MsgProjectileEventsFromServer>);
+    static_assert(offsetof(MsgProjectileEventsFromServer, m_events) == MsgProjectileEventsFromServer::nHeaderLength);
+
+    template <class... TMsgs>
+    struct MsgTypeList
+    {
+        static constexpr size_t size = sizeof...(TMsgs);
+    };
+
+    // All app messages, in the order of ElteFailMsgId. Name map is generated from this list, while dispatch table and allow-lists
+    // are generated from the handlers given to MsgAppDispatcher, see CustomPGE::TMsgAppDispatcher.
+    using ElteFailMsgTypes = MsgTypeList<
+        MsgUserSetupFromServer,
+        MsgUserCmdMoveFromClient,
+        MsgUserUpdateFromServer,
+        MsgWorldStateFromServer,
+        MsgStringDefFromServer,
+        MsgUserCmdFireFromClient,
+        MsgProjectileEventsFromServer>;
+
+    template <class... TMsgs>
+    constexpr bool isMsgTypeListInIdOrder(MsgTypeList<TMsgs...>)
+    {
+        size_t i = 0;
+        return ((static_cast<size_t>(TMsgs::id) == i++) && ...);
+    }
+
+    template <class... TMsgs>
+    constexpr std::array<ElteFailMsgId2ZStringPair, sizeof...(TMsgs)> makeMsgAppId2StringMap(MsgTypeList<TMsgs...>)
+    {
+        return { { {TMsgs::id, TMsgs::zstring}... } };
+    }
+
+    static_assert(isMsgTypeListInIdOrder(ElteFailMsgTypes{}), "ElteFailMsgTypes must list the messages in ElteFailMsgId order");
+
+    // this way of defining std::array makes sure code cannot compile if we forget to align ElteFailMsgTypes after changing ElteFailMsgId
+    constexpr std::array<ElteFailMsgId2ZStringPair, static_cast<size_t>(ElteFailMsgId::LastMsgId)> MapMsgAppId2String =
+        makeMsgAppId2StringMap(ElteFailMsgTypes{});
+
 } // namespace elte_fail
\ No newline at end of file
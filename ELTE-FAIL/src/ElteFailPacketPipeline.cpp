@@ -0,0 +1,149 @@
+/*
+    ###################################################################################
+    ElteFailPacketPipeline.cpp
+    Multi-threaded receive pipeline of network packets for ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailPacketPipeline.h"
+
+static const unsigned int nDecoderIdleYields = 64;       /**< Decode thread yields this many times in a row before going to sleep. */
+static const unsigned int nDecoderIdleSleepMSecs = 1;
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::PacketPipeline::PacketPipeline() :
+    m_bRunning(false),
+    m_nSubmitted(0),
+    m_nRejected(0),
+    m_nApplied(0),
+    m_nIngressStalls(0),
+    m_nDecodedStalls(0),
+    m_nMaxIngressQueued(0),
+    m_nMaxDecodedQueued(0),
+    m_nTotalLatencyUSecs(0),
+    m_nMaxLatencyUSecs(0)
+{
+
+} // PacketPipeline()
+
+
+elte_fail::PacketPipeline::~PacketPipeline()
+{
+    stop();
+} // ~PacketPipeline()
+
+
+bool elte_fail::PacketPipeline::start(const TValidator& validator)
+{
+    if (isStarted() || !validator)
+    {
+        return false;
+    }
+
+    m_validator = validator;
+    m_bRunning = true;
+    m_decodeThread = std::thread(&PacketPipeline::runDecoder, this);
+    return true;
+} // start()
+
+
+void elte_fail::PacketPipeline::stop()
+{
+    if (!isStarted())
+    {
+        return;
+    }
+
+    m_bRunning = false;
+    m_decodeThread.join();
+} // stop()
+
+
+bool elte_fail::PacketPipeline::isStarted() const
+{
+    return m_decodeThread.joinable();
+} // isStarted()
+
+
+elte_fail::PacketPipelineStats elte_fail::PacketPipeline::getStats() const
+{
+    PacketPipelineStats stats;
+    stats.m_nSubmitted = m_nSubmitted.load(std::memory_order_relaxed);
+    stats.m_nRejected = m_nRejected.load(std::memory_order_relaxed);
+    stats.m_nApplied = m_nApplied.load(std::memory_order_relaxed);
+    stats.m_nIngressStalls = m_nIngressStalls.load(std::memory_order_relaxed);
+    stats.m_nDecodedStalls = m_nDecodedStalls.load(std::memory_order_relaxed);
+    stats.m_nMaxIngressQueued = m_nMaxIngressQueued.load(std::memory_order_relaxed);
+    stats.m_nMaxDecodedQueued = m_nMaxDecodedQueued.load(std::memory_order_relaxed);
+    stats.m_nTotalLatencyUSecs = m_nTotalLatencyUSecs.load(std::memory_order_relaxed);
+    stats.m_nMaxLatencyUSecs = m_nMaxLatencyUSecs.load(std::memory_order_relaxed);
+    return stats;
+} // getStats()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+void elte_fail::PacketPipeline::updateMax(std::atomic<uint32_t>& nMax, uint32_t nValue)
+{
+    uint32_t nCurrent = nMax.load(std::memory_order_relaxed);
+    while ((nValue > nCurrent) && !nMax.compare_exchange_weak(nCurrent, nValue, std::memory_order_relaxed))
+    {
+    }
+} // updateMax()
+
+
+void elte_fail::PacketPipeline::onApplied(const Entry& entry)
+{
+    const uint64_t nLatencyUSecs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - entry.m_timeSubmitted).count());
+    m_nApplied.fetch_add(1, std::memory_order_relaxed);
+    m_nTotalLatencyUSecs.fetch_add(nLatencyUSecs, std::memory_order_relaxed);
+    updateMax(m_nMaxLatencyUSecs, (nLatencyUSecs > UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(nLatencyUSecs));
+} // onApplied()
+
+
+void elte_fail::PacketPipeline::runDecoder()
+{
+    unsigned int nIdleRounds = 0;
+    Entry entry;
+    while (m_bRunning)
+    {
+        if (!m_qIngress.tryPop(entry))
+        {
+            if (++nIdleRounds < nDecoderIdleYields)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(nDecoderIdleSleepMSecs));
+            }
+            continue;
+        }
+        nIdleRounds = 0;
+
+        if (!m_validator(entry.m_pkt))
+        {
+            m_nRejected.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        if (!m_qDecoded.tryPush(entry))
+        {
+            m_nDecodedStalls.fetch_add(1, std::memory_order_relaxed);
+            while (m_bRunning && !m_qDecoded.tryPush(entry))
+            {
+                std::this_thread::yield();
+            }
+        }
+        updateMax(m_nMaxDecodedQueued, static_cast<uint32_t>(m_qDecoded.size()));
+    }
+} // runDecoder()
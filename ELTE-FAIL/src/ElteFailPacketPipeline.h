@@ -0,0 +1,154 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailPacketPipeline.h
+    Multi-threaded receive pipeline of network packets for ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#include "../../../PGE/PGE/Network/PgePacket.h"
+
+#include "ElteFailSpscQueue.h"
+
+namespace elte_fail
+{
+
+    /**
+        Counters of PacketPipeline, can be read from any thread.
+    */
+    struct PacketPipelineStats
+    {
+        uint64_t m_nSubmitted;          /**< Packets entered the pipeline. */
+        uint64_t m_nRejected;           /**< Packets dropped by the validator. */
+        uint64_t m_nApplied;            /**< Packets passed to the apply function. */
+        uint64_t m_nIngressStalls;      /**< Times submit() found the ingress queue full and had to apply packets to make room. */
+        uint64_t m_nDecodedStalls;      /**< Times decode thread found the decoded queue full and had to wait for main thread. */
+        uint32_t m_nMaxIngressQueued;   /**< High-water mark of the ingress queue. */
+        uint32_t m_nMaxDecodedQueued;   /**< High-water mark of the decoded queue. */
+        uint64_t m_nTotalLatencyUSecs;  /**< Sum of time from submit() to apply of all applied packets. */
+        uint32_t m_nMaxLatencyUSecs;    /**< Longest time from submit() to apply. */
+    };
+
+    /**
+        Moves decoding and stateless validation of received packets off the thread calling submit(), i.e. the main thread
+        in which PGE invokes onPacketReceived().
+        Stages are connected by bounded lock-free SPSC queues:
+         - ingress: submit() -> decode thread;
+         - decoded: decode thread -> drain(), where the main thread applies packets to the game state.
+        Order of packets is kept. Nothing is dropped due to full queues, instead backpressure is counted:
+        if ingress is full, submit() applies already decoded packets until there is room; if decoded queue is full, the decode thread waits.
+        Validator runs on the decode thread, so it must not touch game state, only the packet itself.
+    */
+    class PacketPipeline
+    {
+    public:
+        static const size_t nQueueCapacity = 1024;   /**< Packets per queue, must be power of 2. */
+
+        using TValidator = std::function<bool(const pge_network::PgePacket& pkt)>;
+
+        PacketPipeline();
+        ~PacketPipeline();
+
+        /**
+            Starts the decode thread.
+
+            @param validator Invoked on the decode thread for every packet, packets for which it returns false are dropped.
+        */
+        bool start(const TValidator& validator);
+
+        /**
+            Stops the decode thread. Packets already decoded can still be drained, packets not yet decoded are discarded.
+        */
+        void stop();
+
+        bool isStarted() const;
+
+        /**
+            Puts the packet into the pipeline. Must be called from the same thread as drain(), and only if isStarted().
+            fnApply is used only in case of backpressure, see drain().
+        */
+        template <class F>
+        void submit(const pge_network::PgePacket& pkt, F&& fnApply)
+        {
+            const Entry entry = { pkt, std::chrono::steady_clock::now() };
+            if (!m_qIngress.tryPush(entry))
+            {
+                m_nIngressStalls.fetch_add(1, std::memory_order_relaxed);
+                do
+                {
+                    if (drain(fnApply) == 0)
+                    {
+                        std::this_thread::yield();
+                    }
+                } while (!m_qIngress.tryPush(entry));
+            }
+            m_nSubmitted.fetch_add(1, std::memory_order_relaxed);
+            updateMax(m_nMaxIngressQueued, static_cast<uint32_t>(m_qIngress.size()));
+        }
+
+        /**
+            Invokes fnApply(pkt) for every packet already validated by the decode thread, in the order they were submitted.
+
+            @return Number of packets applied.
+        */
+        template <class F>
+        uint32_t drain(F&& fnApply)
+        {
+            uint32_t nApplied = 0;
+            Entry entry;
+            while (m_qDecoded.tryPop(entry))
+            {
+                fnApply(entry.m_pkt);
+                onApplied(entry);
+                nApplied++;
+            }
+            return nApplied;
+        }
+
+        PacketPipelineStats getStats() const;
+
+    private:
+
+        struct Entry
+        {
+            pge_network::PgePacket m_pkt;
+            std::chrono::steady_clock::time_point m_timeSubmitted;
+        };
+
+        static void updateMax(std::atomic<uint32_t>& nMax, uint32_t nValue);
+
+        SpscQueue<Entry, nQueueCapacity> m_qIngress;
+        SpscQueue<Entry, nQueueCapacity> m_qDecoded;
+
+        TValidator m_validator;
+        std::thread m_decodeThread;
+        std::atomic<bool> m_bRunning;
+
+        std::atomic<uint64_t> m_nSubmitted;
+        std::atomic<uint64_t> m_nRejected;
+        std::atomic<uint64_t> m_nApplied;
+        std::atomic<uint64_t> m_nIngressStalls;
+        std::atomic<uint64_t> m_nDecodedStalls;
+        std::atomic<uint32_t> m_nMaxIngressQueued;
+        std::atomic<uint32_t> m_nMaxDecodedQueued;
+        std::atomic<uint64_t> m_nTotalLatencyUSecs;
+        std::atomic<uint32_t> m_nMaxLatencyUSecs;
+
+        // ---------------------------------------------------------------------------
+
+        PacketPipeline(const PacketPipeline&);
+        PacketPipeline& operator=(const PacketPipeline&);
+
+        void onApplied(const Entry& entry);
+        void runDecoder();
+    }; // class PacketPipeline
+
+} // namespace elte_fail
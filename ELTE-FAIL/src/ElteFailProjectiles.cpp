@@ -0,0 +1,508 @@
+/*
+    ###################################################################################
+    ElteFailProjectiles.cpp
+    Pooled projectile simulation of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailProjectiles.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define ELTE_FAIL_PROJECTILES_SSE
+#include <emmintrin.h>
+#endif
+
+#include "ElteFailMatchRules.h"
+
+
+// ############################### PUBLIC ################################
+
+
+void elte_fail::ProjectilePool::getVelocity(HorizontalDirection dirHorizontal, VerticalDirection dirVertical, float& fVelX, float& fVelY)
+{
+    MatchRules::getMoveDelta(dirHorizontal, dirVertical, fVelX, fVelY);
+    const float fLength = std::sqrt(fVelX * fVelX + fVelY * fVelY);
+    if (fLength > 0.f)
+    {
+        fVelX = fVelX / fLength * fSpeed;
+        fVelY = fVelY / fLength * fSpeed;
+    }
+} // getVelocity()
+
+
+uint8_t elte_fail::ProjectilePool::encodeDir(HorizontalDirection dirHorizontal, VerticalDirection dirVertical)
+{
+    return static_cast<uint8_t>(static_cast<uint8_t>(dirHorizontal) | (static_cast<uint8_t>(dirVertical) << 2));
+} // encodeDir()
+
+
+bool elte_fail::ProjectilePool::decodeDir(uint8_t nDir, HorizontalDirection& dirHorizontal, VerticalDirection& dirVertical)
+{
+    dirHorizontal = static_cast<HorizontalDirection>(nDir & 0x03);
+    dirVertical = static_cast<VerticalDirection>((nDir >> 2) & 0x03);
+    return (nDir <= 0x0F) &&
+        (dirHorizontal <= HorizontalDirection::RIGHT) &&
+        (dirVertical <= VerticalDirection::DOWN) &&
+        ((dirHorizontal != HorizontalDirection::NONE) || (dirVertical != VerticalDirection::NONE));
+} // decodeDir()
+
+
+elte_fail::ProjectilePool::ProjectilePool() :
+    m_nCapacity(0),
+    m_nCount(0),
+    m_nLastId(nInvalidId),
+    m_stats{}
+{
+
+} // ProjectilePool()
+
+
+void elte_fail::ProjectilePool::reset(uint32_t nCapacity)
+{
+    m_nCapacity = std::min(nCapacity, nMaxCapacity);
+    const size_t nPadded = (static_cast<size_t>(m_nCapacity) + 3) & ~static_cast<size_t>(3);
+    m_vPosX.assign(nPadded, 0.f);
+    m_vPosY.assign(nPadded, 0.f);
+    m_vVelX.assign(nPadded, 0.f);
+    m_vVelY.assign(nPadded, 0.f);
+    m_vAgeSecs.assign(nPadded, 0.f);
+    m_vIds.assign(nPadded, nInvalidId);
+    m_vOwners.assign(nPadded, 0);
+    m_vReasons.assign(nPadded, ProjectileEventType::Spawn);
+    m_vHits.assign(nPadded, 0);
+    m_vSlotById.assign(static_cast<size_t>(nMaxCapacity) + 1, nInvalidSlot);
+    m_vDespawned.clear();
+    m_vDespawned.reserve(m_nCapacity);
+    m_nCount = 0;
+    m_nLastId = nInvalidId;
+} // reset()
+
+
+uint32_t elte_fail::ProjectilePool::getCapacity() const
+{
+    return m_nCapacity;
+} // getCapacity()
+
+
+uint32_t elte_fail::ProjectilePool::getCount() const
+{
+    return m_nCount;
+} // getCount()
+
+
+elte_fail::TProjectileId elte_fail::ProjectilePool::spawn(
+    pge_network::PgeNetworkConnectionHandle connHandleOwner, float fPosX, float fPosY, float fVelX, float fVelY)
+{
+    if (m_nCount >= m_nCapacity)
+    {
+        m_stats.m_nSpawnFailures++;
+        return nInvalidId;
+    }
+
+    // there is always a free id since capacity is less than the number of ids
+    do
+    {
+        m_nLastId++;
+    } while ((m_nLastId == nInvalidId) || (m_vSlotById[m_nLastId] != nInvalidSlot));
+
+    add(m_nLastId, connHandleOwner, fPosX, fPosY, fVelX, fVelY);
+    return m_nLastId;
+} // spawn()
+
+
+bool elte_fail::ProjectilePool::spawnWithId(
+    TProjectileId nId, pge_network::PgeNetworkConnectionHandle connHandleOwner, float fPosX, float fPosY, float fVelX, float fVelY)
+{
+    if ((nId == nInvalidId) || m_vSlotById.empty())
+    {
+        return false;
+    }
+
+    const uint32_t iSlot = m_vSlotById[nId];
+    if (iSlot != nInvalidSlot)
+    {
+        m_vPosX[iSlot] = fPosX;
+        m_vPosY[iSlot] = fPosY;
+        m_vVelX[iSlot] = fVelX;
+        m_vVelY[iSlot] = fVelY;
+        m_vAgeSecs[iSlot] = 0.f;
+        m_vOwners[iSlot] = connHandleOwner;
+        return true;
+    }
+
+    if (m_nCount >= m_nCapacity)
+    {
+        m_stats.m_nSpawnFailures++;
+        return false;
+    }
+
+    add(nId, connHandleOwner, fPosX, fPosY, fVelX, fVelY);
+    return true;
+} // spawnWithId()
+
+
+bool elte_fail::ProjectilePool::despawn(TProjectileId nId)
+{
+    if ((nId == nInvalidId) || m_vSlotById.empty() || (m_vSlotById[nId] == nInvalidSlot))
+    {
+        return false;
+    }
+    remove(m_vSlotById[nId]);
+    return true;
+} // despawn()
+
+
+void elte_fail::ProjectilePool::clear()
+{
+    for (uint32_t i = 0; i < m_nCount; i++)
+    {
+        m_vSlotById[m_vIds[i]] = nInvalidSlot;
+    }
+    m_nCount = 0;
+    m_vDespawned.clear();
+} // clear()
+
+
+void elte_fail::ProjectilePool::step(float fDtSecs, const CollisionWorld& world, const ProjectileTarget* pTargets, size_t nTargets)
+{
+    m_vDespawned.clear();
+    if (m_nCount == 0)
+    {
+        return;
+    }
+    std::fill(m_vReasons.begin(), m_vReasons.begin() + m_nCount, ProjectileEventType::Spawn);
+
+#ifdef ELTE_FAIL_PROJECTILES_SSE
+    const __m128 dt = _mm_set1_ps(fDtSecs);
+    for (uint32_t i = 0; i < m_nCount; i += 4)
+    {
+        _mm_storeu_ps(&m_vPosX[i], _mm_add_ps(_mm_loadu_ps(&m_vPosX[i]), _mm_mul_ps(_mm_loadu_ps(&m_vVelX[i]), dt)));
+        _mm_storeu_ps(&m_vPosY[i], _mm_add_ps(_mm_loadu_ps(&m_vPosY[i]), _mm_mul_ps(_mm_loadu_ps(&m_vVelY[i]), dt)));
+        _mm_storeu_ps(&m_vAgeSecs[i], _mm_add_ps(_mm_loadu_ps(&m_vAgeSecs[i]), dt));
+    }
+#else
+    for (uint32_t i = 0; i < m_nCount; i++)
+    {
+        m_vPosX[i] += m_vVelX[i] * fDtSecs;
+        m_vPosY[i] += m_vVelY[i] * fDtSecs;
+        m_vAgeSecs[i] += fDtSecs;
+    }
+#endif
+
+    // without world, nothing is out of bounds
+    markOutOfBoundsOrExpired(world.isEmpty() ?
+        Aabb{ { -FLT_MAX, -FLT_MAX, -FLT_MAX }, { FLT_MAX, FLT_MAX, FLT_MAX } } :
+        world.getBounds());
+
+    for (size_t iTarget = 0; iTarget < nTargets; iTarget++)
+    {
+        markHits(pTargets[iTarget]);
+    }
+
+    if (!world.isEmpty())
+    {
+        for (uint32_t i = 0; i < m_nCount; i++)
+        {
+            if (m_vReasons[i] != ProjectileEventType::Spawn)
+            {
+                continue;
+            }
+            m_stats.m_nWorldQueries++;
+            const Aabb box = {
+                { m_vPosX[i] - fHalfSize, m_vPosY[i] - fHalfSize, MatchRules::fPlayerPosZ - fHalfSize },
+                { m_vPosX[i] + fHalfSize, m_vPosY[i] + fHalfSize, MatchRules::fPlayerPosZ + fHalfSize } };
+            if (world.intersects(box))
+            {
+                m_vReasons[i] = ProjectileEventType::HitWorld;
+            }
+        }
+    }
+
+    // backwards, so the last projectile moved into a removed slot is already processed
+    for (uint32_t i = m_nCount; i-- > 0; )
+    {
+        if (m_vReasons[i] == ProjectileEventType::Spawn)
+        {
+            continue;
+        }
+        m_vDespawned.push_back({ m_vIds[i], m_vReasons[i], m_vOwners[i], m_vHits[i] });
+        switch (m_vReasons[i])
+        {
+        case ProjectileEventType::Expired:
+            m_stats.m_nExpired++;
+            break;
+        case ProjectileEventType::HitWorld:
+            m_stats.m_nHitWorld++;
+            break;
+        default:
+            m_stats.m_nHitPlayer++;
+            break;
+        }
+        remove(i);
+    }
+} // step()
+
+
+const std::vector<elte_fail::ProjectileDespawn>& elte_fail::ProjectilePool::getDespawned() const
+{
+    return m_vDespawned;
+} // getDespawned()
+
+
+const float* elte_fail::ProjectilePool::getPosX() const
+{
+    return m_vPosX.data();
+} // getPosX()
+
+
+const float* elte_fail::ProjectilePool::getPosY() const
+{
+    return m_vPosY.data();
+} // getPosY()
+
+
+const float* elte_fail::ProjectilePool::getVelX() const
+{
+    return m_vVelX.data();
+} // getVelX()
+
+
+const float* elte_fail::ProjectilePool::getVelY() const
+{
+    return m_vVelY.data();
+} // getVelY()
+
+
+const elte_fail::TProjectileId* elte_fail::ProjectilePool::getIds() const
+{
+    return m_vIds.data();
+} // getIds()
+
+
+const elte_fail::ProjectileStats& elte_fail::ProjectilePool::getStats() const
+{
+    return m_stats;
+} // getStats()
+
+
+elte_fail::ProjectileBenchmarkResult elte_fail::ProjectileBenchmark::run(
+    const CollisionWorld& world, uint32_t nProjectiles, uint32_t nTicks, uint32_t nTargets)
+{
+    ProjectileBenchmarkResult result{};
+    if (world.isEmpty() || (nProjectiles == 0) || (nTicks == 0))
+    {
+        return result;
+    }
+
+    // own generator with fixed seed, so the benchmark is repeatable and rand() sequence of the game is not disturbed
+    std::mt19937 rng(12345);
+    const Aabb& bounds = world.getBounds();
+    std::uniform_real_distribution<float> distX(bounds.m_fMin[0], bounds.m_fMax[0]);
+    std::uniform_real_distribution<float> distY(bounds.m_fMin[1], bounds.m_fMax[1]);
+    std::uniform_int_distribution<int> distDir(0, 15);
+    std::uniform_int_distribution<uint32_t> distOwner(1, std::max(1u, nTargets));
+
+    std::vector<ProjectileTarget> vTargets(nTargets);
+    for (uint32_t i = 0; i < nTargets; i++)
+    {
+        vTargets[i] = { static_cast<pge_network::PgeNetworkConnectionHandle>(i + 1), distX(rng), distY(rng) };
+    }
+
+    ProjectilePool pool;
+    pool.reset(nProjectiles);
+    const auto fnSpawn = [&]()
+    {
+        HorizontalDirection dirHorizontal;
+        VerticalDirection dirVertical;
+        while (!ProjectilePool::decodeDir(static_cast<uint8_t>(distDir(rng)), dirHorizontal, dirVertical))
+        {
+            // not every 4-bit value is a valid direction
+        }
+        float fVelX;
+        float fVelY;
+        ProjectilePool::getVelocity(dirHorizontal, dirVertical, fVelX, fVelY);
+        pool.spawn(distOwner(rng), distX(rng), distY(rng), fVelX, fVelY);
+    };
+    while (pool.getCount() < pool.getCapacity())
+    {
+        fnSpawn();
+    }
+
+    uint64_t nSumActive = 0;
+    uint64_t nSumStepUSecs = 0;
+    uint64_t nMaxStepUSecs = 0;
+    uint64_t nEventBytes = 0;
+    const uint64_t nWorldQueriesBefore = pool.getStats().m_nWorldQueries;
+    for (uint32_t iTick = 0; iTick < nTicks; iTick++)
+    {
+        nSumActive += pool.getCount();
+        const auto timeStart = std::chrono::steady_clock::now();
+        pool.step(ProjectilePool::fStepSecs, world, vTargets.data(), vTargets.size());
+        const uint64_t nStepUSecs = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - timeStart).count());
+        nSumStepUSecs += nStepUSecs;
+        nMaxStepUSecs = std::max(nMaxStepUSecs, nStepUSecs);
+
+        // every despawned one is respawned, both are replicated
+        const uint64_t nEvents = pool.getDespawned().size() * 2;
+        const uint64_t nMsgs = (nEvents + MsgProjectileEventsFromServer::nMaxEvents - 1) / MsgProjectileEventsFromServer::nMaxEvents;
+        nEventBytes += nEvents * sizeof(ProjectileEvent) + nMsgs * (sizeof(pge_network::MsgApp) + MsgProjectileEventsFromServer::nHeaderLength);
+
+        while (pool.getCount() < pool.getCapacity())
+        {
+            fnSpawn();
+        }
+    }
+
+    const ProjectileStats& stats = pool.getStats();
+    result.m_nTicks = nTicks;
+    result.m_fAvgActive = static_cast<float>(nSumActive) / nTicks;
+    result.m_fAvgStepUSecs = static_cast<float>(nSumStepUSecs) / nTicks;
+    result.m_fMaxStepUSecs = static_cast<float>(nMaxStepUSecs);
+    result.m_fAvgWorldQueries = static_cast<float>(stats.m_nWorldQueries - nWorldQueriesBefore) / nTicks;
+    result.m_nSpawned = stats.m_nSpawned;
+    result.m_nExpired = stats.m_nExpired;
+    result.m_nHitWorld = stats.m_nHitWorld;
+    result.m_nHitPlayer = stats.m_nHitPlayer;
+    result.m_fEventBytesPerTick = static_cast<float>(nEventBytes) / nTicks;
+    return result;
+} // run()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+void elte_fail::ProjectilePool::add(
+    TProjectileId nId, pge_network::PgeNetworkConnectionHandle connHandleOwner, float fPosX, float fPosY, float fVelX, float fVelY)
+{
+    const uint32_t iSlot = m_nCount++;
+    m_vPosX[iSlot] = fPosX;
+    m_vPosY[iSlot] = fPosY;
+    m_vVelX[iSlot] = fVelX;
+    m_vVelY[iSlot] = fVelY;
+    m_vAgeSecs[iSlot] = 0.f;
+    m_vIds[iSlot] = nId;
+    m_vOwners[iSlot] = connHandleOwner;
+    m_vSlotById[nId] = iSlot;
+    m_stats.m_nSpawned++;
+    m_stats.m_nMaxActive = std::max(m_stats.m_nMaxActive, m_nCount);
+} // add()
+
+
+void elte_fail::ProjectilePool::remove(uint32_t iSlot)
+{
+    const uint32_t iLast = m_nCount - 1;
+    m_vSlotById[m_vIds[iSlot]] = nInvalidSlot;
+    if (iSlot != iLast)
+    {
+        m_vPosX[iSlot] = m_vPosX[iLast];
+        m_vPosY[iSlot] = m_vPosY[iLast];
+        m_vVelX[iSlot] = m_vVelX[iLast];
+        m_vVelY[iSlot] = m_vVelY[iLast];
+        m_vAgeSecs[iSlot] = m_vAgeSecs[iLast];
+        m_vIds[iSlot] = m_vIds[iLast];
+        m_vOwners[iSlot] = m_vOwners[iLast];
+        m_vReasons[iSlot] = m_vReasons[iLast];
+        m_vHits[iSlot] = m_vHits[iLast];
+        m_vSlotById[m_vIds[iSlot]] = iSlot;
+    }
+    m_nCount--;
+} // remove()
+
+
+void elte_fail::ProjectilePool::markOutOfBoundsOrExpired(const Aabb& bounds)
+{
+    const float fMinX = bounds.m_fMin[0] - fBoundsMargin;
+    const float fMinY = bounds.m_fMin[1] - fBoundsMargin;
+    const float fMaxX = bounds.m_fMax[0] + fBoundsMargin;
+    const float fMaxY = bounds.m_fMax[1] + fBoundsMargin;
+
+#ifdef ELTE_FAIL_PROJECTILES_SSE
+    const __m128 minX = _mm_set1_ps(fMinX);
+    const __m128 minY = _mm_set1_ps(fMinY);
+    const __m128 maxX = _mm_set1_ps(fMaxX);
+    const __m128 maxY = _mm_set1_ps(fMaxY);
+    const __m128 lifetime = _mm_set1_ps(fLifetimeSecs);
+    for (uint32_t i = 0; i < m_nCount; i += 4)
+    {
+        const __m128 x = _mm_loadu_ps(&m_vPosX[i]);
+        const __m128 y = _mm_loadu_ps(&m_vPosY[i]);
+        const __m128 outX = _mm_or_ps(_mm_cmplt_ps(x, minX), _mm_cmpgt_ps(x, maxX));
+        const __m128 outY = _mm_or_ps(_mm_cmplt_ps(y, minY), _mm_cmpgt_ps(y, maxY));
+        const __m128 expired = _mm_cmpge_ps(_mm_loadu_ps(&m_vAgeSecs[i]), lifetime);
+        const unsigned int nMask = static_cast<unsigned int>(_mm_movemask_ps(_mm_or_ps(_mm_or_ps(outX, outY), expired)));
+        if (nMask == 0)
+        {
+            continue;
+        }
+        // slots beyond m_nCount are stale, they must not be marked
+        for (uint32_t iBit = 0; (iBit < 4) && (i + iBit < m_nCount); iBit++)
+        {
+            if (nMask & (1u << iBit))
+            {
+                m_vReasons[i + iBit] = ProjectileEventType::Expired;
+            }
+        }
+    }
+#else
+    for (uint32_t i = 0; i < m_nCount; i++)
+    {
+        if ((m_vPosX[i] < fMinX) || (m_vPosX[i] > fMaxX) || (m_vPosY[i] < fMinY) || (m_vPosY[i] > fMaxY) || (m_vAgeSecs[i] >= fLifetimeSecs))
+        {
+            m_vReasons[i] = ProjectileEventType::Expired;
+        }
+    }
+#endif
+} // markOutOfBoundsOrExpired()
+
+
+void elte_fail::ProjectilePool::markHits(const ProjectileTarget& target)
+{
+    const float fReach = MatchRules::fPlayerCollisionHalfWidth + fHalfSize;
+
+#ifdef ELTE_FAIL_PROJECTILES_SSE
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 reach = _mm_set1_ps(fReach);
+    const __m128 targetX = _mm_set1_ps(target.m_fPosX);
+    const __m128 targetY = _mm_set1_ps(target.m_fPosY);
+    for (uint32_t i = 0; i < m_nCount; i += 4)
+    {
+        const __m128 dx = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(&m_vPosX[i]), targetX), absMask);
+        const __m128 dy = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(&m_vPosY[i]), targetY), absMask);
+        const unsigned int nMask = static_cast<unsigned int>(_mm_movemask_ps(_mm_and_ps(_mm_cmplt_ps(dx, reach), _mm_cmplt_ps(dy, reach))));
+        if (nMask == 0)
+        {
+            continue;
+        }
+        for (uint32_t iBit = 0; (iBit < 4) && (i + iBit < m_nCount); iBit++)
+        {
+            const uint32_t iSlot = i + iBit;
+            if ((nMask & (1u << iBit)) && (m_vReasons[iSlot] == ProjectileEventType::Spawn) && (m_vOwners[iSlot] != target.m_connHandleServerSide))
+            {
+                m_vReasons[iSlot] = ProjectileEventType::HitPlayer;
+                m_vHits[iSlot] = target.m_connHandleServerSide;
+            }
+        }
+    }
+#else
+    for (uint32_t i = 0; i < m_nCount; i++)
+    {
+        if ((std::fabs(m_vPosX[i] - target.m_fPosX) < fReach) && (std::fabs(m_vPosY[i] - target.m_fPosY) < fReach) &&
+            (m_vReasons[i] == ProjectileEventType::Spawn) && (m_vOwners[i] != target.m_connHandleServerSide))
+        {
+            m_vReasons[i] = ProjectileEventType::HitPlayer;
+            m_vHits[i] = target.m_connHandleServerSide;
+        }
+    }
+#endif
+} // markHits()
@@ -0,0 +1,190 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailProjectiles.h
+    Pooled projectile simulation of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <cstdint>
+#include <vector>
+
+#include "../../../PGE/PGE/Network/PgePacket.h"
+
+#include "ElteFailCollisionWorld.h"
+#include "ElteFailPacket.h"
+
+namespace elte_fail
+{
+
+    typedef uint16_t TProjectileId;
+
+    /**
+        Player that can be hit by projectiles, with the same box as the player collision box.
+    */
+    struct ProjectileTarget
+    {
+        pge_network::PgeNetworkConnectionHandle m_connHandleServerSide;
+        float m_fPosX;
+        float m_fPosY;
+    };
+
+    struct ProjectileDespawn
+    {
+        TProjectileId m_nId;
+        ProjectileEventType m_reason;
+        pge_network::PgeNetworkConnectionHandle m_connHandleOwner;
+        pge_network::PgeNetworkConnectionHandle m_connHandleHit;   /**< HitPlayer only. */
+    };
+
+    struct ProjectileStats
+    {
+        uint64_t m_nSpawned;
+        uint64_t m_nSpawnFailures;      /**< Pool was full. */
+        uint64_t m_nExpired;
+        uint64_t m_nHitWorld;
+        uint64_t m_nHitPlayer;
+        uint64_t m_nWorldQueries;       /**< Projectiles tested against the collision world. */
+        uint32_t m_nMaxActive;
+    };
+
+    /**
+        Fixed-capacity pool of projectiles, all memory allocated by reset().
+        Projectiles are stored as structure of arrays, active ones packed at the beginning, so step() runs over contiguous
+        float arrays 4 projectiles at a time with SSE: integration, lifetime, arena bounds and player hits. Only projectiles
+        still alive after these are tested against the collision world, 1 by 1 through its BVH.
+        Despawned projectiles are replaced by the last one, so ids are looked up through a table indexed by id.
+        Ids are allocated either by spawn(), or by the caller of spawnWithId(), e.g. clients spawn with the ids replicated by the server.
+    */
+    class ProjectilePool
+    {
+    public:
+        static const TProjectileId nInvalidId = 0;
+        static const uint32_t nMaxCapacity = 65535;             /**< Every id must fit into TProjectileId, except nInvalidId. */
+        static constexpr float fSpeed = 1.f;                    /**< World units per sec. */
+        static constexpr float fLifetimeSecs = 3.f;
+        static constexpr float fHalfSize = 0.03f;               /**< Collision box of a projectile is a cube. */
+        static constexpr float fBoundsMargin = 1.f;             /**< Projectiles this far outside the collision world expire. */
+        static constexpr float fStepSecs = 1.f / 60.f;          /**< Fixed time step used by both server and clients. */
+
+        /**
+            @return Velocity of a projectile fired in the given direction, diagonal directions have the same speed too.
+        */
+        static void getVelocity(HorizontalDirection dirHorizontal, VerticalDirection dirVertical, float& fVelX, float& fVelY);
+
+        static uint8_t encodeDir(HorizontalDirection dirHorizontal, VerticalDirection dirVertical);   /**< For ProjectileEvent::m_nDir. */
+        static bool decodeDir(uint8_t nDir, HorizontalDirection& dirHorizontal, VerticalDirection& dirVertical);
+
+        ProjectilePool();
+
+        /**
+            Removes all projectiles and allocates the arrays for the given number of projectiles, clamped to nMaxCapacity.
+        */
+        void reset(uint32_t nCapacity);
+
+        uint32_t getCapacity() const;
+        uint32_t getCount() const;   /**< Active projectiles. */
+
+        /**
+            @return Id of the new projectile, nInvalidId if the pool is full.
+        */
+        TProjectileId spawn(pge_network::PgeNetworkConnectionHandle connHandleOwner, float fPosX, float fPosY, float fVelX, float fVelY);
+
+        /**
+            Spawns with an id allocated by the server, replacing the projectile of the same id if any.
+
+            @param connHandleOwner 0 on clients, which don't decide hits against players.
+            @return False if the pool is full.
+        */
+        bool spawnWithId(
+            TProjectileId nId, pge_network::PgeNetworkConnectionHandle connHandleOwner, float fPosX, float fPosY, float fVelX, float fVelY);
+
+        /**
+            @return False if there is no active projectile with the given id, e.g. it already hit a wall on client side.
+        */
+        bool despawn(TProjectileId nId);
+
+        void clear();
+
+        /**
+            Advances all projectiles by fDtSecs, then despawns those expired, left the arena, hit a target other than their owner,
+            or hit the collision world, in this order of precedence. Despawned ones can be read by getDespawned() until next step().
+
+            @param world    Can be empty, then projectiles fly through everything but the targets.
+            @param pTargets Can be nullptr if nTargets is 0, e.g. on clients where hits are decided by the server.
+        */
+        void step(float fDtSecs, const CollisionWorld& world, const ProjectileTarget* pTargets, size_t nTargets);
+
+        const std::vector<ProjectileDespawn>& getDespawned() const;
+
+        // arrays of getCount() active projectiles, for rendering
+        const float* getPosX() const;
+        const float* getPosY() const;
+        const float* getVelX() const;
+        const float* getVelY() const;
+        const TProjectileId* getIds() const;
+
+        const ProjectileStats& getStats() const;
+
+    private:
+        static const uint32_t nInvalidSlot = UINT32_MAX;
+
+        // SoA, sized to capacity rounded up to 4, so SSE loops can run over the last partial group of 4
+        std::vector<float> m_vPosX;
+        std::vector<float> m_vPosY;
+        std::vector<float> m_vVelX;
+        std::vector<float> m_vVelY;
+        std::vector<float> m_vAgeSecs;
+        std::vector<TProjectileId> m_vIds;
+        std::vector<pge_network::PgeNetworkConnectionHandle> m_vOwners;
+        std::vector<ProjectileEventType> m_vReasons;   /**< Written by step(), Spawn means not despawned. */
+        std::vector<pge_network::PgeNetworkConnectionHandle> m_vHits;
+        std::vector<uint32_t> m_vSlotById;     /**< Index into the arrays above by id, nInvalidSlot if not active. */
+        std::vector<ProjectileDespawn> m_vDespawned;
+        uint32_t m_nCapacity;
+        uint32_t m_nCount;
+        TProjectileId m_nLastId;
+        ProjectileStats m_stats;
+
+        // ---------------------------------------------------------------------------
+
+        ProjectilePool(const ProjectilePool&);
+        ProjectilePool& operator=(const ProjectilePool&);
+
+        void add(TProjectileId nId, pge_network::PgeNetworkConnectionHandle connHandleOwner, float fPosX, float fPosY, float fVelX, float fVelY);
+        void remove(uint32_t iSlot);   /**< Moves the last projectile into the given slot. */
+        void markOutOfBoundsOrExpired(const Aabb& bounds);
+        void markHits(const ProjectileTarget& target);
+    }; // class ProjectilePool
+
+    struct ProjectileBenchmarkResult
+    {
+        uint32_t m_nTicks;
+        float    m_fAvgActive;
+        float    m_fAvgStepUSecs;
+        float    m_fMaxStepUSecs;
+        float    m_fAvgWorldQueries;    /**< Per tick. */
+        uint64_t m_nSpawned;
+        uint64_t m_nExpired;
+        uint64_t m_nHitWorld;
+        uint64_t m_nHitPlayer;
+        float    m_fEventBytesPerTick;  /**< MsgProjectileEventsFromServer bytes a client would receive per tick. */
+    };
+
+    /**
+        Keeps the given number of projectiles active in the given world for the given number of ticks, respawning despawned ones
+        at random positions with random directions, with a few static players as targets. Only step() is timed.
+        Random generator has a fixed seed, so the same world gives the same result.
+    */
+    class ProjectileBenchmark
+    {
+    public:
+        static ProjectileBenchmarkResult run(const CollisionWorld& world, uint32_t nProjectiles, uint32_t nTicks, uint32_t nTargets);
+
+    private:
+        ProjectileBenchmark();
+    }; // class ProjectileBenchmark
+
+} // namespace elte_fail
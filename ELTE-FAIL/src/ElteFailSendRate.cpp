@@ -0,0 +1,159 @@
+/*
+    ###################################################################################
+    ElteFailSendRate.cpp
+    Per-client adaptive send rate of ELTE-FAIL server.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailSendRate.h"
+
+#include <algorithm>
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::SendRateController::SendRateController() :
+    m_config{ 60.f, 60.f, 0, 0.f },
+    m_metrics{ 0, -1.f, -1.f, 0.f, 0 },
+    m_fRate(60.f),
+    m_nLastUpdateUSecs(0),
+    m_nHoldUntilUSecs(0),
+    m_nNextSendUSecs(0),
+    m_nSends(0),
+    m_nBackoffs(0),
+    m_bStarted(false)
+{
+
+} // SendRateController()
+
+
+void elte_fail::SendRateController::configure(const SendRateConfig& config)
+{
+    m_config = config;
+    m_config.m_fMinRate = std::max(1.f, m_config.m_fMinRate);
+    m_config.m_fMaxRate = std::max(m_config.m_fMinRate, m_config.m_fMaxRate);
+    m_fRate = m_bStarted ? std::min(m_config.m_fMaxRate, std::max(m_config.m_fMinRate, m_fRate)) : m_config.m_fMaxRate;
+} // configure()
+
+
+void elte_fail::SendRateController::update(const ConnectionMetrics& metrics, uint64_t nNowUSecs)
+{
+    m_metrics = metrics;
+    if (!m_bStarted)
+    {
+        m_bStarted = true;
+        m_nLastUpdateUSecs = nNowUSecs;
+        return;
+    }
+
+    const float fElapsedSecs = (nNowUSecs - m_nLastUpdateUSecs) / 1000000.f;
+    m_nLastUpdateUSecs = nNowUSecs;
+    if (nNowUSecs < m_nHoldUntilUSecs)
+    {
+        return;
+    }
+
+    // negative quality means not yet measured
+    const bool bLossy =
+        ((metrics.m_fQualityLocal >= 0.f) && (metrics.m_fQualityLocal < m_config.m_fMinQuality)) ||
+        ((metrics.m_fQualityRemote >= 0.f) && (metrics.m_fQualityRemote < m_config.m_fMinQuality));
+    const bool bQueueing = (m_config.m_nMaxQueueTimeUSecs > 0) && (metrics.m_nQueueTimeUSecs > static_cast<int64_t>(m_config.m_nMaxQueueTimeUSecs));
+    if (bLossy || bQueueing)
+    {
+        if (m_fRate > m_config.m_fMinRate)
+        {
+            m_fRate = std::max(m_config.m_fMinRate, m_fRate * fDecreaseFactor);
+            m_nBackoffs++;
+        }
+        m_nHoldUntilUSecs = nNowUSecs + std::max(
+            static_cast<uint64_t>(nHoldUSecs),
+            static_cast<uint64_t>(std::max(0, metrics.m_nPingMSecs)) * 1000 * nHoldRoundTrips);
+        return;
+    }
+
+    m_fRate = std::min(m_config.m_fMaxRate, m_fRate + fIncreasePerSec * fElapsedSecs);
+} // update()
+
+
+bool elte_fail::SendRateController::isDue(uint64_t nNowUSecs)
+{
+    if (nNowUSecs < m_nNextSendUSecs)
+    {
+        return false;
+    }
+
+    const uint64_t nIntervalUSecs = static_cast<uint64_t>(1000000.f / m_fRate);
+    // not catching up after a long frame, that would be a burst
+    m_nNextSendUSecs = std::max(m_nNextSendUSecs + nIntervalUSecs, nNowUSecs + nIntervalUSecs / 2);
+    m_nSends++;
+    return true;
+} // isDue()
+
+
+bool elte_fail::SendRateController::isOthersDue() const
+{
+    switch (getDetail())
+    {
+    case SendDetail::Full:
+        return true;
+    case SendDetail::Reduced:
+        return (m_nSends % 2) == 0;
+    default:
+        return (m_nSends % 4) == 0;
+    }
+} // isOthersDue()
+
+
+float elte_fail::SendRateController::getRate() const
+{
+    return m_fRate;
+} // getRate()
+
+
+elte_fail::SendDetail elte_fail::SendRateController::getDetail() const
+{
+    if (m_config.m_fMaxRate <= m_config.m_fMinRate)
+    {
+        return SendDetail::Full;
+    }
+    const float fRatio = (m_fRate - m_config.m_fMinRate) / (m_config.m_fMaxRate - m_config.m_fMinRate);
+    if (fRatio >= 2.f / 3.f)
+    {
+        return SendDetail::Full;
+    }
+    return (fRatio >= 1.f / 3.f) ? SendDetail::Reduced : SendDetail::Minimal;
+} // getDetail()
+
+
+uint32_t elte_fail::SendRateController::getBackoffCount() const
+{
+    return m_nBackoffs;
+} // getBackoffCount()
+
+
+const elte_fail::ConnectionMetrics& elte_fail::SendRateController::getMetrics() const
+{
+    return m_metrics;
+} // getMetrics()
+
+
+const char* elte_fail::SendRateController::getDetailName(SendDetail detail)
+{
+    switch (detail)
+    {
+    case SendDetail::Full:
+        return "full";
+    case SendDetail::Reduced:
+        return "reduced";
+    default:
+        return "minimal";
+    }
+} // getDetailName()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
@@ -0,0 +1,103 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailSendRate.h
+    Per-client adaptive send rate of ELTE-FAIL server.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <cstdint>
+
+namespace elte_fail
+{
+
+    /**
+        How much of the world state a client gets when it is due, see SendRateController::isOthersDue().
+    */
+    enum class SendDetail
+    {
+        Full,       /**< Updates about all players at every send. */
+        Reduced,    /**< Updates about other players at every 2nd send only. */
+        Minimal     /**< Updates about other players at every 4th send only. */
+    };
+
+    struct SendRateConfig
+    {
+        float    m_fMinRate;            /**< Sends per sec, never backing off below this. */
+        float    m_fMaxRate;            /**< Sends per sec, also the initial rate. Server frame rate is an upper limit anyway. */
+        uint32_t m_nMaxQueueTimeUSecs;  /**< Backing off when the connection's internal queue time is above this. */
+        float    m_fMinQuality;         /**< Backing off when local or remote connection quality (0..1) is below this. */
+    };
+
+    /**
+        Connection metrics reported by PGE for 1 connection.
+    */
+    struct ConnectionMetrics
+    {
+        int      m_nPingMSecs;
+        float    m_fQualityLocal;       /**< Ratio of packets delivered, negative if not yet known. */
+        float    m_fQualityRemote;
+        float    m_fTxBytesPerSec;
+        int64_t  m_nQueueTimeUSecs;     /**< Time a packet sent now would wait in the send queue. */
+    };
+
+    /**
+        Decides when the server sends latest-wins updates to 1 client, and how much of them.
+        Rate is adjusted by AIMD from the metrics of the connection: halved when the queue time or the loss grows too big,
+        otherwise increased slowly. After a backoff, the rate is held for a while, at least a few round trips, so the effect
+        of the backoff shows up in the metrics before deciding again.
+        A slow client thus gets less frequent and less detailed updates, instead of its send queue growing and adding
+        latency to everything it receives.
+    */
+    class SendRateController
+    {
+    public:
+        static const uint32_t nHoldUSecs = 1000000;       /**< Min time between a backoff and the next change of rate. */
+        static const uint32_t nHoldRoundTrips = 4;        /**< Hold time is at least this many round trips. */
+        static constexpr float fIncreasePerSec = 5.f;     /**< Additive increase of rate, per sec. */
+        static constexpr float fDecreaseFactor = 0.5f;    /**< Multiplicative decrease of rate at backoff. */
+
+        SendRateController();
+
+        /**
+            Current rate is clamped into the new limits.
+        */
+        void configure(const SendRateConfig& config);
+
+        /**
+            Adjusts the rate, should be called regularly with fresh metrics.
+        */
+        void update(const ConnectionMetrics& metrics, uint64_t nNowUSecs);
+
+        /**
+            @return True if sending to the client is due, i.e. at least 1/rate elapsed since the last time it returned true.
+        */
+        bool isDue(uint64_t nNowUSecs);
+
+        /**
+            @return True if updates about other players should be sent too, in the send found due by the last isDue().
+        */
+        bool isOthersDue() const;
+
+        float getRate() const;
+        SendDetail getDetail() const;
+        uint32_t getBackoffCount() const;
+        const ConnectionMetrics& getMetrics() const;   /**< Given to the last update(). */
+
+        static const char* getDetailName(SendDetail detail);
+
+    private:
+        SendRateConfig m_config;
+        ConnectionMetrics m_metrics;
+        float m_fRate;
+        uint64_t m_nLastUpdateUSecs;
+        uint64_t m_nHoldUntilUSecs;
+        uint64_t m_nNextSendUSecs;
+        uint32_t m_nSends;
+        uint32_t m_nBackoffs;
+        bool m_bStarted;                /**< False until the first update(). */
+    }; // class SendRateController
+
+} // namespace elte_fail
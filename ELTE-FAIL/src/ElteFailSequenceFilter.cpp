@@ -0,0 +1,59 @@
+/*
+    ###################################################################################
+    ElteFailSequenceFilter.cpp
+    Receiver side of the latest-wins message channel of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailSequenceFilter.h"
+
+
+// ############################### PUBLIC ################################
+
+
+bool elte_fail::SequenceFilter::isNewer(uint16_t nSeq, uint16_t nSeqOther)
+{
+    return static_cast<int16_t>(static_cast<uint16_t>(nSeq - nSeqOther)) > 0;
+} // isNewer()
+
+
+elte_fail::SequenceFilter::SequenceFilter() :
+    m_nDropped{}
+{
+
+} // SequenceFilter()
+
+
+bool elte_fail::SequenceFilter::accept(ElteFailMsgId msgId, pge_network::PgeNetworkConnectionHandle connHandleServerSide, uint16_t nSeq)
+{
+    const size_t iMsg = static_cast<size_t>(msgId);
+    LastSeqs& lastSeqs = m_mapLastSeqs.try_emplace(connHandleServerSide, LastSeqs{}).first->second;
+    if (lastSeqs.m_bAccepted[iMsg] && !isNewer(nSeq, lastSeqs.m_nSeq[iMsg]))
+    {
+        m_nDropped[iMsg]++;
+        return false;
+    }
+    lastSeqs.m_nSeq[iMsg] = nSeq;
+    lastSeqs.m_bAccepted[iMsg] = true;
+    return true;
+} // accept()
+
+
+void elte_fail::SequenceFilter::forget(pge_network::PgeNetworkConnectionHandle connHandleServerSide)
+{
+    m_mapLastSeqs.erase(connHandleServerSide);
+} // forget()
+
+
+void elte_fail::SequenceFilter::clear()
+{
+    m_mapLastSeqs.clear();
+    m_nDropped = {};
+} // clear()
+
+
+uint64_t elte_fail::SequenceFilter::getDroppedCount(ElteFailMsgId msgId) const
+{
+    return m_nDropped[static_cast<size_t>(msgId)];
+} // getDroppedCount()
@@ -0,0 +1,64 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailSequenceFilter.h
+    Receiver side of the latest-wins message channel of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+#include "ElteFailPacket.h"
+
+namespace elte_fail
+{
+
+    /**
+        Drops messages of MsgChannel::UnreliableSequenced that are not newer than the newest already accepted message
+        of the same type about the same connection. Sequence numbers wrap around, a number is newer if it is less than half
+        of the number space ahead.
+        Connection handles are reused by PGE, so connections must be forgotten when they disconnect.
+    */
+    class SequenceFilter
+    {
+    public:
+        static bool isNewer(uint16_t nSeq, uint16_t nSeqOther);
+
+        SequenceFilter();
+
+        /**
+            @return True if the message should be handled, i.e. it is the first or newer than the last accepted.
+        */
+        bool accept(ElteFailMsgId msgId, pge_network::PgeNetworkConnectionHandle connHandleServerSide, uint16_t nSeq);
+
+        void forget(pge_network::PgeNetworkConnectionHandle connHandleServerSide);
+        void clear();
+
+        uint64_t getDroppedCount(ElteFailMsgId msgId) const;
+
+    private:
+        static const size_t nMsgCount = static_cast<size_t>(ElteFailMsgId::LastMsgId);
+
+        /**
+            Per message type, the last accepted sequence number.
+        */
+        struct LastSeqs
+        {
+            std::array<uint16_t, nMsgCount> m_nSeq;
+            std::array<bool, nMsgCount> m_bAccepted;   /**< False until the first message of the type is accepted. */
+        };
+
+        std::unordered_map<pge_network::PgeNetworkConnectionHandle, LastSeqs> m_mapLastSeqs;
+        std::array<uint64_t, nMsgCount> m_nDropped;
+
+        // ---------------------------------------------------------------------------
+
+        SequenceFilter(const SequenceFilter&);
+        SequenceFilter& operator=(const SequenceFilter&);
+    }; // class SequenceFilter
+
+} // namespace elte_fail
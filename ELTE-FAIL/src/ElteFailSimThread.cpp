@@ -0,0 +1,210 @@
+/*
+    ###################################################################################
+    ElteFailSimThread.cpp
+    Fixed-rate simulation thread of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailSimThread.h"
+
+#include <algorithm>
+#include <chrono>
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::SimThread::SimThread() :
+    m_pWorld(nullptr),
+    m_nMaxSnapshotProjectiles(0),
+    m_stats{ 0, 0, 0, 0, 0 },
+    m_bRunning(false)
+{
+
+} // SimThread()
+
+
+elte_fail::SimThread::~SimThread()
+{
+    stop();
+} // ~SimThread()
+
+
+bool elte_fail::SimThread::start(const CollisionWorld& world, uint32_t nCapacity, uint32_t nMaxSnapshotProjectiles)
+{
+    if (isStarted())
+    {
+        return false;
+    }
+
+    m_pWorld = &world;
+    m_projectiles.reset(nCapacity);
+    m_nMaxSnapshotProjectiles = nMaxSnapshotProjectiles;
+    m_stats = { 0, 0, 0, 0, 0 };
+    m_bRunning = true;
+    m_thread = std::thread(&SimThread::run, this);
+    return true;
+} // start()
+
+
+void elte_fail::SimThread::stop()
+{
+    if (!isStarted())
+    {
+        return;
+    }
+
+    m_bRunning = false;
+    m_thread.join();
+
+    SimCommand cmd;
+    while (m_commands.tryPop(cmd))
+    {
+    }
+} // stop()
+
+
+bool elte_fail::SimThread::isStarted() const
+{
+    return m_thread.joinable();
+} // isStarted()
+
+
+bool elte_fail::SimThread::push(const SimCommand& cmd)
+{
+    if (!m_commands.tryPush(cmd))
+    {
+        m_stats.m_nCommandsDropped++;
+        return false;
+    }
+    return true;
+} // push()
+
+
+std::vector<elte_fail::ProjectileTarget>& elte_fail::SimThread::getTargets()
+{
+    return m_targets.getBack();
+} // getTargets()
+
+
+void elte_fail::SimThread::publishTargets()
+{
+    m_targets.publish();
+} // publishTargets()
+
+
+bool elte_fail::SimThread::popDespawn(ProjectileDespawn& despawn)
+{
+    return m_despawns.tryPop(despawn);
+} // popDespawn()
+
+
+bool elte_fail::SimThread::updateSnapshot()
+{
+    return m_snapshots.update();
+} // updateSnapshot()
+
+
+const elte_fail::SimSnapshot& elte_fail::SimThread::getSnapshot() const
+{
+    return m_snapshots.getFront();
+} // getSnapshot()
+
+
+const elte_fail::SimThreadStats& elte_fail::SimThread::getStats() const
+{
+    return m_stats;
+} // getStats()
+
+
+const elte_fail::ProjectilePool& elte_fail::SimThread::getProjectiles() const
+{
+    return m_projectiles;
+} // getProjectiles()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+void elte_fail::SimThread::run()
+{
+    const std::chrono::microseconds tickDuration(static_cast<int64_t>(ProjectilePool::fStepSecs * 1000000.f));
+    std::chrono::steady_clock::time_point timeNextTick = std::chrono::steady_clock::now();
+
+    while (m_bRunning)
+    {
+        const std::chrono::steady_clock::time_point timeNow = std::chrono::steady_clock::now();
+        if (timeNow < timeNextTick)
+        {
+            // might oversleep by the timer resolution, then the next wake runs more ticks
+            std::this_thread::sleep_until(timeNextTick);
+            continue;
+        }
+
+        uint32_t nTicks = 0;
+        while (timeNow >= timeNextTick)
+        {
+            if (++nTicks > nMaxTicksPerWake)
+            {
+                const auto nSkipped = (timeNow - timeNextTick) / tickDuration + 1;
+                m_stats.m_nSkippedTicks += static_cast<uint64_t>(nSkipped);
+                timeNextTick += tickDuration * nSkipped;
+                break;
+            }
+            tick(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(timeNextTick.time_since_epoch()).count()));
+            timeNextTick += tickDuration;
+        }
+    }
+} // run()
+
+
+void elte_fail::SimThread::tick(uint64_t nTimeUSecs)
+{
+    const auto timeStart = std::chrono::steady_clock::now();
+
+    SimCommand cmd;
+    while (m_commands.tryPop(cmd))
+    {
+        if (cmd.m_type == SimCommandType::Despawn)
+        {
+            m_projectiles.despawn(cmd.m_nId);
+        }
+        else if (!m_projectiles.spawnWithId(cmd.m_nId, cmd.m_connHandleOwner, cmd.m_fPosX, cmd.m_fPosY, cmd.m_fVelX, cmd.m_fVelY))
+        {
+            // spawn has been already replicated by server, clients must forget it too
+            if (!m_despawns.tryPush({ cmd.m_nId, ProjectileEventType::Expired, cmd.m_connHandleOwner, 0 }))
+            {
+                m_stats.m_nDespawnsDropped++;
+            }
+        }
+    }
+
+    m_targets.update();
+    const std::vector<ProjectileTarget>& vTargets = m_targets.getFront();
+    m_projectiles.step(ProjectilePool::fStepSecs, *m_pWorld, vTargets.data(), vTargets.size());
+    for (const auto& despawn : m_projectiles.getDespawned())
+    {
+        if (!m_despawns.tryPush(despawn))
+        {
+            m_stats.m_nDespawnsDropped++;
+        }
+    }
+
+    SimSnapshot& snapshot = m_snapshots.getBack();
+    snapshot.m_nTick = ++m_stats.m_nTicks;
+    snapshot.m_nTimeUSecs = nTimeUSecs;
+    snapshot.m_nProjectiles = m_projectiles.getCount();
+    const uint32_t nSnapshotProjectiles = std::min(m_projectiles.getCount(), m_nMaxSnapshotProjectiles);
+    snapshot.m_vPosX.assign(m_projectiles.getPosX(), m_projectiles.getPosX() + nSnapshotProjectiles);
+    snapshot.m_vPosY.assign(m_projectiles.getPosY(), m_projectiles.getPosY() + nSnapshotProjectiles);
+    snapshot.m_vVelX.assign(m_projectiles.getVelX(), m_projectiles.getVelX() + nSnapshotProjectiles);
+    snapshot.m_vVelY.assign(m_projectiles.getVelY(), m_projectiles.getVelY() + nSnapshotProjectiles);
+    m_snapshots.publish();
+
+    m_stats.m_nMaxTickUSecs = std::max(m_stats.m_nMaxTickUSecs, static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - timeStart).count()));
+} // tick()
@@ -0,0 +1,167 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailSimThread.h
+    Fixed-rate simulation thread of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "ElteFailCollisionWorld.h"
+#include "ElteFailProjectiles.h"
+#include "ElteFailSpscQueue.h"
+#include "ElteFailTripleBuffer.h"
+
+namespace elte_fail
+{
+
+    enum class SimCommandType : uint8_t
+    {
+        Spawn,
+        Despawn
+    };
+
+    /**
+        Change of the simulated state requested by the game thread, e.g. from a received message.
+    */
+    struct SimCommand
+    {
+        SimCommandType m_type;
+        TProjectileId m_nId;
+        pge_network::PgeNetworkConnectionHandle m_connHandleOwner;  /**< Spawn only, 0 on clients. */
+        float m_fPosX;
+        float m_fPosY;
+        float m_fVelX;
+        float m_fVelY;
+    };
+
+    /**
+        Simulated state after a tick, immutable once published.
+    */
+    struct SimSnapshot
+    {
+        uint64_t m_nTick;                 /**< 0 until the first tick. */
+        uint64_t m_nTimeUSecs;            /**< Steady clock time the state belongs to. */
+        uint32_t m_nProjectiles;          /**< Active projectiles, might be more than the ones in the arrays below. */
+        std::vector<float> m_vPosX;       /**< First projectiles of the pool, at most as many as given to start(). */
+        std::vector<float> m_vPosY;
+        std::vector<float> m_vVelX;
+        std::vector<float> m_vVelY;
+    };
+
+    struct SimThreadStats
+    {
+        uint64_t m_nTicks;
+        uint64_t m_nSkippedTicks;         /**< Ticks not simulated after the thread was late by more than nMaxTicksPerWake. */
+        uint64_t m_nCommandsDropped;      /**< Command queue was full. */
+        uint64_t m_nDespawnsDropped;      /**< Despawn queue was full. */
+        uint32_t m_nMaxTickUSecs;
+    };
+
+    /**
+        Steps the projectiles on its own thread at the fixed rate of ProjectilePool::fStepSecs, independently of the frame rate
+        and stalls of the game thread calling PGE and PURE.
+        Game thread talks to it only through lock-free queues and triple buffers:
+         - commands go in through push(),
+         - players as targets go in through getTargets() and publishTargets(),
+         - despawns come out through popDespawn(), to be replicated by the server,
+         - state comes out as a snapshot after every tick, see updateSnapshot().
+        The collision world given to start() is read by both threads, so it must not change until stop().
+        Only projectiles are simulated here: players of the server's own match are moved by the game thread when their messages
+        are applied, since their handlers move their PURE objects directly. Hosted matches are ticked by MatchHost on its own thread.
+    */
+    class SimThread
+    {
+    public:
+        static const uint32_t nMaxTicksPerWake = 8;         /**< After a longer stall, the simulation skips time instead of catching up. */
+        static const size_t nCommandQueueSize = 4096;
+        static const size_t nDespawnQueueSize = 8192;
+
+        SimThread();
+        ~SimThread();
+
+        /**
+            Allocates the pool for the given number of projectiles, and starts the thread.
+
+            @param nMaxSnapshotProjectiles Projectiles beyond this are simulated but not put into snapshots.
+        */
+        bool start(const CollisionWorld& world, uint32_t nCapacity, uint32_t nMaxSnapshotProjectiles);
+
+        /**
+            Stops the thread, commands not yet executed are dropped.
+        */
+        void stop();
+
+        bool isStarted() const;
+
+        /**
+            Game thread only.
+
+            @return False if the command queue is full, in that case command is dropped.
+        */
+        bool push(const SimCommand& cmd);
+
+        /**
+            Game thread only. Targets to be filled before publishTargets(), content is undefined before that.
+        */
+        std::vector<ProjectileTarget>& getTargets();
+
+        /**
+            Game thread only. Targets are used from the next tick until the next publish.
+        */
+        void publishTargets();
+
+        /**
+            Game thread only. Projectiles failed to spawn because the pool was full also come out as expired.
+
+            @return False if there is no more despawn.
+        */
+        bool popDespawn(ProjectileDespawn& despawn);
+
+        /**
+            Game thread only. Takes the latest snapshot, if there is any newer than the current one.
+
+            @return True if the snapshot returned by getSnapshot() changed.
+        */
+        bool updateSnapshot();
+
+        const SimSnapshot& getSnapshot() const;   /**< Game thread only. */
+
+        /**
+            Valid only while stopped.
+        */
+        const SimThreadStats& getStats() const;
+
+        /**
+            Only getCapacity() can be called while running, the rest is valid only while stopped.
+        */
+        const ProjectilePool& getProjectiles() const;
+
+    private:
+        const CollisionWorld* m_pWorld;
+        ProjectilePool m_projectiles;                       /**< Owned by the sim thread while running. */
+        SpscQueue<SimCommand, nCommandQueueSize> m_commands;
+        SpscQueue<ProjectileDespawn, nDespawnQueueSize> m_despawns;
+        TripleBuffer<std::vector<ProjectileTarget>> m_targets;
+        TripleBuffer<SimSnapshot> m_snapshots;
+        uint32_t m_nMaxSnapshotProjectiles;
+        SimThreadStats m_stats;                             /**< Written by sim thread, except m_nCommandsDropped. */
+        std::thread m_thread;
+        std::atomic<bool> m_bRunning;
+
+        // ---------------------------------------------------------------------------
+
+        SimThread(const SimThread&);
+        SimThread& operator=(const SimThread&);
+
+        void run();
+        void tick(uint64_t nTimeUSecs);
+    }; // class SimThread
+
+} // namespace elte_fail
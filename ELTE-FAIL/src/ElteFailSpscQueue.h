@@ -0,0 +1,103 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailSpscQueue.h
+    Bounded lock-free single-producer single-consumer queue for ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace elte_fail
+{
+
+    /**
+        Bounded wait-free queue for exactly 1 producer thread and 1 consumer thread (they can be the same thread).
+        Elements are copied into preallocated storage, so push and pop never allocate.
+        Producer and consumer positions are on separate cache lines so the 2 threads don't keep invalidating each other's line.
+    */
+    template <class T, size_t nCapacity>
+    class SpscQueue
+    {
+        static_assert((nCapacity >= 2) && ((nCapacity & (nCapacity - 1)) == 0), "capacity must be power of 2");
+
+    public:
+        static const size_t nCacheLineSize = 64;
+
+        SpscQueue() :
+            m_elements(new T[nCapacity]),
+            m_nHead(0),
+            m_nTail(0)
+        {}
+
+        static constexpr size_t getCapacity()
+        {
+            return nCapacity;
+        }
+
+        /**
+            Producer only.
+
+            @return False if the queue is full, in that case element is not pushed.
+        */
+        bool tryPush(const T& element)
+        {
+            const size_t nTail = m_nTail.load(std::memory_order_relaxed);
+            if (nTail - m_nHead.load(std::memory_order_acquire) == nCapacity)
+            {
+                return false;
+            }
+            m_elements[nTail & (nCapacity - 1)] = element;
+            m_nTail.store(nTail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+            Consumer only.
+
+            @return False if the queue is empty.
+        */
+        bool tryPop(T& element)
+        {
+            const size_t nHead = m_nHead.load(std::memory_order_relaxed);
+            if (nHead == m_nTail.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            element = m_elements[nHead & (nCapacity - 1)];
+            m_nHead.store(nHead + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+            Can be called from any thread, but the result is only a snapshot when the other side is active.
+        */
+        size_t size() const
+        {
+            return m_nTail.load(std::memory_order_acquire) - m_nHead.load(std::memory_order_acquire);
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+    private:
+        std::unique_ptr<T[]> m_elements;
+        // padded instead of alignas, which makes MSVC warn C4324 about the padding of every instantiation
+        std::atomic<size_t> m_nHead;   /**< Next position to pop, written by consumer. */
+        char m_padHead[nCacheLineSize - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t> m_nTail;   /**< Next position to push, written by producer. */
+        char m_padTail[nCacheLineSize - sizeof(std::atomic<size_t>)];
+
+        // ---------------------------------------------------------------------------
+
+        SpscQueue(const SpscQueue&);
+        SpscQueue& operator=(const SpscQueue&);
+    }; // class SpscQueue
+
+} // namespace elte_fail
@@ -0,0 +1,158 @@
+/*
+    ###################################################################################
+    ElteFailStringTable.cpp
+    Interned strings of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailStringTable.h"
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::StringTable::StringTable()
+{
+
+} // StringTable()
+
+
+elte_fail::TStringId elte_fail::StringTable::intern(const std::string& str)
+{
+    const std::string sTruncated = str.substr(0, nMaxStringLength);
+
+    const auto it = m_mapIds.find(sTruncated);
+    if (it != m_mapIds.end())
+    {
+        m_vRefs[it->second]++;
+        return it->second;
+    }
+
+    TStringId nId = nInvalidStringId;
+    if (!m_vFreeIds.empty())
+    {
+        nId = m_vFreeIds.back();
+        m_vFreeIds.pop_back();
+    }
+    else if (m_vStrings.size() < nInvalidStringId)
+    {
+        nId = static_cast<TStringId>(m_vStrings.size());
+        m_vStrings.emplace_back();
+        m_vDefined.push_back(false);
+        m_vRefs.push_back(0);
+    }
+    else
+    {
+        return nInvalidStringId;
+    }
+
+    m_vStrings[nId] = sTruncated;
+    m_vDefined[nId] = true;
+    m_vRefs[nId] = 1;
+    m_mapIds[sTruncated] = nId;
+    return nId;
+} // intern()
+
+
+bool elte_fail::StringTable::addRef(TStringId nId)
+{
+    if (!isDefined(nId) || (nId >= m_vRefs.size()))
+    {
+        return false;
+    }
+
+    m_vRefs[nId]++;
+    return true;
+} // addRef()
+
+
+bool elte_fail::StringTable::release(TStringId nId)
+{
+    if (!isDefined(nId) || (nId >= m_vRefs.size()) || (m_vRefs[nId] == 0))
+    {
+        return false;
+    }
+
+    if (--m_vRefs[nId] > 0)
+    {
+        return false;
+    }
+
+    m_mapIds.erase(m_vStrings[nId]);
+    m_vStrings[nId].clear();
+    m_vDefined[nId] = false;
+    m_vFreeIds.push_back(nId);
+    return true;
+} // release()
+
+
+elte_fail::TStringId elte_fail::StringTable::find(const std::string& str) const
+{
+    const auto it = m_mapIds.find(str);
+    return (it == m_mapIds.end()) ? nInvalidStringId : it->second;
+} // find()
+
+
+bool elte_fail::StringTable::define(TStringId nId, const std::string& str)
+{
+    if ((nId == nInvalidStringId) || (str.length() > nMaxStringLength))
+    {
+        return false;
+    }
+
+    if (isDefined(nId))
+    {
+        if (m_vStrings[nId] == str)
+        {
+            // server might send the same definition again
+            return true;
+        }
+
+        // server released the previous string and reused its id
+        const auto it = m_mapIds.find(m_vStrings[nId]);
+        if ((it != m_mapIds.end()) && (it->second == nId))
+        {
+            m_mapIds.erase(it);
+        }
+    }
+    else if (nId >= m_vStrings.size())
+    {
+        m_vStrings.resize(static_cast<size_t>(nId) + 1);
+        m_vDefined.resize(static_cast<size_t>(nId) + 1, false);
+    }
+
+    m_vStrings[nId] = str;
+    m_vDefined[nId] = true;
+    m_mapIds[str] = nId;
+    return true;
+} // define()
+
+
+bool elte_fail::StringTable::isDefined(TStringId nId) const
+{
+    return (nId < m_vDefined.size()) && m_vDefined[nId];
+} // isDefined()
+
+
+const std::string& elte_fail::StringTable::getString(TStringId nId) const
+{
+    static const std::string sEmpty;
+    return isDefined(nId) ? m_vStrings[nId] : sEmpty;
+} // getString()
+
+
+size_t elte_fail::StringTable::size() const
+{
+    return m_mapIds.size();
+} // size()
+
+
+void elte_fail::StringTable::clear()
+{
+    m_vStrings.clear();
+    m_vDefined.clear();
+    m_vRefs.clear();
+    m_vFreeIds.clear();
+    m_mapIds.clear();
+} // clear()
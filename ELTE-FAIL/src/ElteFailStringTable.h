@@ -0,0 +1,84 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailStringTable.h
+    Interned strings of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace elte_fail
+{
+
+    using TStringId = uint16_t;
+
+    /**
+        Interned string table: every distinct string is stored once and referred to by a small integer id.
+        Server interns user names, IP addresses and trollface texture paths, and it is the only side assigning ids.
+        Clients only store the strings defined by server (MsgStringDefFromServer, world state snapshot) under the same ids,
+        so players and messages can refer to these strings by id on both sides, and every string crosses the wire only once per client.
+        Server counts the references to its strings, and reuses the id of a string after its last reference is released,
+        so ids don't run out while players keep joining and leaving. Clients just get the new string under the reused id.
+    */
+    class StringTable
+    {
+    public:
+        static const TStringId nInvalidStringId = UINT16_MAX;
+        static const size_t nMaxStringLength = 255;  /**< Longer strings are truncated, so they can be transferred with 1 byte length. */
+
+        StringTable();
+
+        /**
+            Server only. Adds a reference to the given string, to be released by release().
+            @return Id of the given string, a new id is assigned if the string is not yet in the table.
+                    nInvalidStringId if the table is full.
+        */
+        TStringId intern(const std::string& str);
+
+        /**
+            Server only. Adds a reference to the already interned string with the given id.
+            @return False if id is not defined.
+        */
+        bool addRef(TStringId nId);
+
+        /**
+            Server only. Releases a reference taken by intern() or addRef(), the string is removed with its last reference.
+            @return True if the string is removed, so its id can be reused for another string.
+        */
+        bool release(TStringId nId);
+
+        TStringId find(const std::string& str) const;  /**< @return Id of the given string, or nInvalidStringId if not in the table. */
+
+        /**
+            Client only. Stores the string received from server under the given id,
+            replacing the string the id was defined with before the server released and reused it.
+            @return False if id is invalid or string is too long.
+        */
+        bool define(TStringId nId, const std::string& str);
+
+        bool isDefined(TStringId nId) const;
+        const std::string& getString(TStringId nId) const;  /**< @return The string with the given id, empty string if not defined. */
+        size_t size() const;                                 /**< @return Number of defined strings. */
+
+        void clear();
+
+    private:
+        std::vector<std::string> m_vStrings;   /**< Indexed by id. */
+        std::vector<bool> m_vDefined;          /**< Indexed by id, ids defined by server might arrive out of order on client side. */
+        std::vector<uint32_t> m_vRefs;         /**< Indexed by id, server only. */
+        std::vector<TStringId> m_vFreeIds;     /**< Ids of released strings, server only. */
+        std::unordered_map<std::string, TStringId> m_mapIds;
+
+        // ---------------------------------------------------------------------------
+
+        StringTable(const StringTable&);
+        StringTable& operator=(const StringTable&);
+    }; // class StringTable
+
+} // namespace elte_fail
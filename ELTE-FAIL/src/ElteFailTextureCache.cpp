@@ -0,0 +1,181 @@
+/*
+    ###################################################################################
+    ElteFailTextureCache.cpp
+    Reference-counted texture cache of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailTextureCache.h"
+
+#include <algorithm>
+#include <cassert>
+
+
+// ############################### PUBLIC ################################
+
+
+elte_fail::TextureCache::TextureCache() :
+    m_nBudgetBytes(0),
+    m_stats{}
+{
+
+} // TextureCache()
+
+
+void elte_fail::TextureCache::setBudget(uint64_t nBytes)
+{
+    m_nBudgetBytes = nBytes;
+    evict();
+} // setBudget()
+
+
+uint64_t elte_fail::TextureCache::getBudget() const
+{
+    return m_nBudgetBytes;
+} // getBudget()
+
+
+PureTexture* elte_fail::TextureCache::acquire(PureTextureManager& texMgr, const std::string& sFilename)
+{
+    const auto it = m_mapEntries.find(sFilename);
+    if (it != m_mapEntries.end())
+    {
+        m_stats.m_nHits++;
+        reference(it->second);
+        return it->second.m_pTex;
+    }
+
+    PureTexture* const pTex = texMgr.createFromFile(sFilename.c_str());
+    if (!pTex)
+    {
+        m_stats.m_nLoadFailures++;
+        return nullptr;
+    }
+    m_stats.m_nLoads++;
+    add(sFilename, *pTex);
+    return pTex;
+} // acquire()
+
+
+PureTexture* elte_fail::TextureCache::acquireLoaded(PureTexture& tex)
+{
+    if (tex.getFilename().empty())
+    {
+        // not from a file, cannot be shared, nor released later
+        return &tex;
+    }
+
+    const auto it = m_mapEntries.find(tex.getFilename());
+    if (it == m_mapEntries.end())
+    {
+        add(tex.getFilename(), tex);
+        return &tex;
+    }
+
+    m_stats.m_nHits++;
+    reference(it->second);
+    if (it->second.m_pTex != &tex)
+    {
+        delete &tex;
+        m_stats.m_nDuplicatesDeleted++;
+    }
+    return it->second.m_pTex;
+} // acquireLoaded()
+
+
+void elte_fail::TextureCache::release(PureTexture& tex)
+{
+    const auto itFilename = m_mapFilenames.find(&tex);
+    if (itFilename == m_mapFilenames.end())
+    {
+        return;
+    }
+
+    Entry& entry = m_mapEntries.at(itFilename->second);
+    assert(entry.m_nRefs > 0);
+    if (--entry.m_nRefs > 0)
+    {
+        return;
+    }
+    entry.m_itLru = m_lruUnreferenced.insert(m_lruUnreferenced.end(), itFilename->second);
+    m_stats.m_nReferenced--;
+    m_stats.m_nReferencedBytes -= entry.m_nBytes;
+    evict();
+} // release()
+
+
+void elte_fail::TextureCache::clear()
+{
+    m_mapEntries.clear();
+    m_mapFilenames.clear();
+    m_lruUnreferenced.clear();
+    m_stats.m_nTextures = 0;
+    m_stats.m_nReferenced = 0;
+    m_stats.m_nBytes = 0;
+    m_stats.m_nReferencedBytes = 0;
+} // clear()
+
+
+const elte_fail::TextureCacheStats& elte_fail::TextureCache::getStats() const
+{
+    return m_stats;
+} // getStats()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+uint64_t elte_fail::TextureCache::getEstimatedBytes(const PureTexture& tex)
+{
+    // full mipmap chain adds 1/3
+    return static_cast<uint64_t>(tex.getWidth()) * tex.getHeight() * 4 * 4 / 3;
+} // getEstimatedBytes()
+
+
+void elte_fail::TextureCache::add(const std::string& sFilename, PureTexture& tex)
+{
+    Entry& entry = m_mapEntries[sFilename];
+    entry.m_pTex = &tex;
+    entry.m_nRefs = 1;
+    entry.m_nBytes = getEstimatedBytes(tex);
+    m_mapFilenames[&tex] = sFilename;
+
+    m_stats.m_nTextures++;
+    m_stats.m_nReferenced++;
+    m_stats.m_nBytes += entry.m_nBytes;
+    m_stats.m_nReferencedBytes += entry.m_nBytes;
+    m_stats.m_nMaxBytes = std::max(m_stats.m_nMaxBytes, m_stats.m_nBytes);
+    evict();
+} // add()
+
+
+void elte_fail::TextureCache::reference(Entry& entry)
+{
+    if (entry.m_nRefs == 0)
+    {
+        m_lruUnreferenced.erase(entry.m_itLru);
+        m_stats.m_nReferenced++;
+        m_stats.m_nReferencedBytes += entry.m_nBytes;
+    }
+    entry.m_nRefs++;
+} // reference()
+
+
+void elte_fail::TextureCache::evict()
+{
+    while ((m_stats.m_nBytes > m_nBudgetBytes) && !m_lruUnreferenced.empty())
+    {
+        const auto it = m_mapEntries.find(m_lruUnreferenced.front());
+        m_lruUnreferenced.pop_front();
+        m_stats.m_nBytes -= it->second.m_nBytes;
+        m_stats.m_nTextures--;
+        m_stats.m_nEvictions++;
+        m_mapFilenames.erase(it->second.m_pTex);
+        delete it->second.m_pTex;  // yes, dtor will remove this from its TextureManager too!
+        m_mapEntries.erase(it);
+    }
+} // evict()
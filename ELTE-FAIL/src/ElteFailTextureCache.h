@@ -0,0 +1,113 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailTextureCache.h
+    Reference-counted texture cache of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "../../../PGE/PGE/Pure/include/external/Material/PureTextureManager.h"
+
+namespace elte_fail
+{
+
+    struct TextureCacheStats
+    {
+        uint64_t m_nHits;               /**< Textures given out without loading. */
+        uint64_t m_nLoads;
+        uint64_t m_nLoadFailures;
+        uint64_t m_nDuplicatesDeleted;  /**< Textures loaded by others, e.g. by the OBJ loader, already being in the cache. */
+        uint64_t m_nEvictions;
+        uint32_t m_nTextures;           /**< Currently in the cache, referenced or not. */
+        uint32_t m_nReferenced;
+        uint64_t m_nBytes;              /**< Estimated memory of the textures currently in the cache. */
+        uint64_t m_nReferencedBytes;
+        uint64_t m_nMaxBytes;           /**< High-water mark of m_nBytes. */
+    };
+
+    /**
+        Textures by filename, each kept by PURE only once, with the number of users.
+        PURE materials don't own their textures, so the game acquires a texture for every material using it and releases it
+        when the object is deleted. Textures not used by anything are kept for later use while the cache fits into its budget,
+        beyond that the least recently released ones are deleted. So memory doesn't grow with players joining and leaving,
+        or arena chunks being loaded and unloaded, while textures used again soon are not loaded again.
+        Texture memory is estimated from the size of the textures as RGBA8 with full mipmap chain, since PURE doesn't tell.
+    */
+    class TextureCache
+    {
+    public:
+        TextureCache();
+
+        /**
+            @param nBytes Estimated memory of referenced and unreferenced textures together. Referenced textures are never
+                          evicted, so only unreferenced ones are kept within the budget, 0 means they are deleted right away.
+        */
+        void setBudget(uint64_t nBytes);
+
+        uint64_t getBudget() const;
+
+        /**
+            Increments the reference count of the texture of the given file, loading it by the given texture manager if not cached.
+
+            @return Nullptr if the texture could not be loaded.
+        */
+        PureTexture* acquire(PureTextureManager& texMgr, const std::string& sFilename);
+
+        /**
+            Acquires a texture already loaded by someone else, e.g. by the OBJ loader for a material. If the cache already has
+            a texture of the same file, that one is acquired and the given one is deleted, so it must not be used by any other
+            material than the one the returned texture is set to.
+
+            @return The texture to be used instead of the given one.
+        */
+        PureTexture* acquireLoaded(PureTexture& tex);
+
+        /**
+            Decrements the reference count of the given texture, the texture may be deleted at once if it is not referenced anymore.
+            Textures not acquired from the cache are ignored.
+        */
+        void release(PureTexture& tex);
+
+        /**
+            Forgets all textures without deleting them, for the end of the game when PURE deletes all its textures anyway.
+        */
+        void clear();
+
+        const TextureCacheStats& getStats() const;
+
+    private:
+
+        struct Entry
+        {
+            PureTexture* m_pTex;
+            uint32_t m_nRefs;
+            uint64_t m_nBytes;
+            std::list<std::string>::iterator m_itLru;   /**< Valid only while m_nRefs is 0. */
+        };
+
+        static uint64_t getEstimatedBytes(const PureTexture& tex);
+
+        std::unordered_map<std::string, Entry> m_mapEntries;
+        std::unordered_map<const PureTexture*, std::string> m_mapFilenames;   /**< Texture -> key in m_mapEntries, for release(). */
+        std::list<std::string> m_lruUnreferenced;   /**< Filenames of unreferenced textures, least recently released at front. */
+        uint64_t m_nBudgetBytes;
+        TextureCacheStats m_stats;
+
+        // ---------------------------------------------------------------------------
+
+        TextureCache(const TextureCache&);
+        TextureCache& operator=(const TextureCache&);
+
+        void add(const std::string& sFilename, PureTexture& tex);   /**< Added as referenced once. */
+        void reference(Entry& entry);
+        void evict();   /**< Deletes unreferenced textures while over budget. */
+    }; // class TextureCache
+
+} // namespace elte_fail
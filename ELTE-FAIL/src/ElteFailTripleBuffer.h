@@ -0,0 +1,97 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailTripleBuffer.h
+    Lock-free triple buffer for ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace elte_fail
+{
+
+    /**
+        Passes the latest value from exactly 1 writer thread to exactly 1 reader thread, without locks and without either side
+        ever waiting for the other.
+        Writer fills its back buffer and publishes it, reader takes the latest published buffer as its front buffer. Values
+        published while the reader didn't look are overwritten, so it is for state, not for events.
+        The 3 buffers are swapped, never copied, so T can be a big struct with preallocated vectors, allocating only when
+        they grow.
+    */
+    template <class T>
+    class TripleBuffer
+    {
+    public:
+        static const size_t nCacheLineSize = 64;
+
+        TripleBuffer() :
+            m_buffers(),
+            m_nMiddle(1),
+            m_iBack(0),
+            m_iFront(2)
+        {}
+
+        /**
+            Writer only. Contents are whatever was published 2 times before, must be overwritten fully.
+        */
+        T& getBack()
+        {
+            return m_buffers[m_iBack];
+        }
+
+        /**
+            Writer only. Back buffer becomes the latest value, writer gets another buffer as back buffer.
+        */
+        void publish()
+        {
+            m_iBack = static_cast<uint8_t>(m_nMiddle.exchange(static_cast<uint8_t>(m_iBack | nFreshBit), std::memory_order_acq_rel) & nIndexMask);
+        }
+
+        /**
+            Reader only. Takes the latest published value as front buffer, if there is any newer than the current front buffer.
+
+            @return True if front buffer changed.
+        */
+        bool update()
+        {
+            if ((m_nMiddle.load(std::memory_order_relaxed) & nFreshBit) == 0)
+            {
+                return false;
+            }
+            m_iFront = static_cast<uint8_t>(m_nMiddle.exchange(m_iFront, std::memory_order_acq_rel) & nIndexMask);
+            return true;
+        }
+
+        /**
+            Reader only. Default constructed T until the first update() returning true.
+        */
+        const T& getFront() const
+        {
+            return m_buffers[m_iFront];
+        }
+
+    private:
+        static const uint8_t nIndexMask = 0x3;
+        static const uint8_t nFreshBit = 0x4;       /**< Set in m_nMiddle when it was published but not yet taken by reader. */
+
+        T m_buffers[3];
+        // padded instead of alignas, which makes MSVC warn C4324 about the padding of every instantiation
+        std::atomic<uint8_t> m_nMiddle;   /**< Index of the buffer between the 2 threads, plus nFreshBit. */
+        char m_padMiddle[nCacheLineSize - sizeof(std::atomic<uint8_t>)];
+        uint8_t m_iBack;                  /**< Owned by writer. */
+        char m_padBack[nCacheLineSize - sizeof(uint8_t)];
+        uint8_t m_iFront;                 /**< Owned by reader. */
+        char m_padFront[nCacheLineSize - sizeof(uint8_t)];
+
+        // ---------------------------------------------------------------------------
+
+        TripleBuffer(const TripleBuffer&);
+        TripleBuffer& operator=(const TripleBuffer&);
+    }; // class TripleBuffer
+
+} // namespace elte_fail
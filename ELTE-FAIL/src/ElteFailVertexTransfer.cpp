@@ -0,0 +1,230 @@
+/*
+    ###################################################################################
+    ElteFailVertexTransfer.cpp
+    Selecting and benchmarking vertex transfer modes of ELTE-FAIL meshes.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailVertexTransfer.h"
+
+#include <algorithm>
+#include <cfloat>
+
+
+// ############################### PUBLIC ################################
+
+
+TPURE_TRANSFER_MODE elte_fail::VertexTransferPolicy::select(uint32_t nVertices, MeshUsage usage)
+{
+    if (usage == MeshUsage::Static)
+    {
+        return (nVertices >= nMinVerticesStaticInVideoMemory) ? PURE_VT_STA_IND_SVA_GEN : PURE_VT_DYN_IND_SVA_GEN;
+    }
+    return (nVertices >= nMinVerticesDynamicArrays) ? PURE_VT_DYN_IND_SVA_GEN : PURE_VT_DYN_DIR_1_BY_1;
+} // select()
+
+
+TPURE_TRANSFER_MODE elte_fail::VertexTransferPolicy::apply(PureObject3D& obj, MeshUsage usage)
+{
+    const TPURE_TRANSFER_MODE mode = select(getVertexCount(obj), usage);
+    obj.setVertexTransferMode(mode);
+    if (obj.getVertexTransferMode() != mode)
+    {
+        obj.setVertexTransferMode(PURE_VT_DYN_IND_SVA_GEN);
+    }
+    return obj.getVertexTransferMode();
+} // apply()
+
+
+uint32_t elte_fail::VertexTransferPolicy::getVertexCount(const PureObject3D& obj)
+{
+    uint32_t nVertices = obj.getVerticesCount();
+    for (TPureInt i = 0; i < obj.getCount(); i++)
+    {
+        const PureObject3D* const objSub = (const PureObject3D*)obj.getAttachedAt(i);
+        if (objSub)
+        {
+            nVertices += objSub->getVerticesCount();
+        }
+    }
+    return nVertices;
+} // getVertexCount()
+
+
+const char* elte_fail::VertexTransferPolicy::getModeName(TPURE_TRANSFER_MODE mode)
+{
+    switch (mode)
+    {
+    case PURE_VT_DYN_DIR_1_BY_1:
+        return "PURE_VT_DYN_DIR_1_BY_1";
+    case PURE_VT_DYN_DIR_SVA_GEN:
+        return "PURE_VT_DYN_DIR_SVA_GEN";
+    case PURE_VT_DYN_IND_SVA_GEN:
+        return "PURE_VT_DYN_IND_SVA_GEN";
+    case PURE_VT_STA_DIR_SVA_GEN:
+        return "PURE_VT_STA_DIR_SVA_GEN";
+    case PURE_VT_STA_IND_SVA_GEN:
+        return "PURE_VT_STA_IND_SVA_GEN";
+    default:
+        return "unknown";
+    }
+} // getModeName()
+
+
+const std::vector<TPURE_TRANSFER_MODE>& elte_fail::VertexTransferPolicy::getModes()
+{
+    static const std::vector<TPURE_TRANSFER_MODE> vModes = {
+        PURE_VT_DYN_DIR_1_BY_1,
+        PURE_VT_DYN_DIR_SVA_GEN,
+        PURE_VT_DYN_IND_SVA_GEN,
+        PURE_VT_STA_DIR_SVA_GEN,
+        PURE_VT_STA_IND_SVA_GEN
+    };
+    return vModes;
+} // getModes()
+
+
+elte_fail::VertexTransferBenchmark::VertexTransferBenchmark() :
+    m_iMesh(0),
+    m_iMode(0),
+    m_nFramesPerMode(0),
+    m_nFrame(0),
+    m_fSumFrameMSecs(0.0),
+    m_bRunning(false)
+{
+
+} // VertexTransferBenchmark()
+
+
+void elte_fail::VertexTransferBenchmark::addMesh(const std::string& sName, PureObject3D& obj)
+{
+    m_vMeshes.push_back({ sName, &obj, obj.getVertexTransferMode(), VertexTransferPolicy::getVertexCount(obj) });
+} // addMesh()
+
+
+bool elte_fail::VertexTransferBenchmark::start(uint32_t nFramesPerMode)
+{
+    if (m_bRunning || m_vMeshes.empty() || (nFramesPerMode == 0))
+    {
+        return false;
+    }
+
+    m_vResults.clear();
+    m_nFramesPerMode = nFramesPerMode;
+    m_iMesh = 0;
+    m_iMode = 0;
+    m_bRunning = true;
+    beginMode();
+    return true;
+} // start()
+
+
+bool elte_fail::VertexTransferBenchmark::isRunning() const
+{
+    return m_bRunning;
+} // isRunning()
+
+
+bool elte_fail::VertexTransferBenchmark::onFrame()
+{
+    if (!m_bRunning)
+    {
+        return false;
+    }
+
+    const auto timeNow = std::chrono::steady_clock::now();
+    const double fFrameMSecs = std::chrono::duration<double, std::milli>(timeNow - m_timeLastFrame).count();
+    m_timeLastFrame = timeNow;
+
+    m_nFrame++;
+    if (m_nFrame <= nWarmupFrames)
+    {
+        return false;
+    }
+
+    VertexTransferResult& result = m_vResults.back();
+    m_fSumFrameMSecs += fFrameMSecs;
+    result.m_nFrames++;
+    result.m_fMinFrameMSecs = std::min(result.m_fMinFrameMSecs, static_cast<float>(fFrameMSecs));
+    if (result.m_nFrames < m_nFramesPerMode)
+    {
+        return false;
+    }
+
+    result.m_fAvgFrameMSecs = static_cast<float>(m_fSumFrameMSecs / result.m_nFrames);
+    m_iMode++;
+    beginMode();
+    return !m_bRunning;
+} // onFrame()
+
+
+const std::vector<elte_fail::VertexTransferResult>& elte_fail::VertexTransferBenchmark::getResults() const
+{
+    return m_vResults;
+} // getResults()
+
+
+const elte_fail::VertexTransferResult* elte_fail::VertexTransferBenchmark::getBestResult(const std::string& sMeshName) const
+{
+    const VertexTransferResult* pBest = nullptr;
+    for (const auto& result : m_vResults)
+    {
+        if ((result.m_sMeshName == sMeshName) && result.m_bSupported && (result.m_nFrames > 0) &&
+            (!pBest || (result.m_fAvgFrameMSecs < pBest->m_fAvgFrameMSecs)))
+        {
+            pBest = &result;
+        }
+    }
+    return pBest;
+} // getBestResult()
+
+
+// ############################## PROTECTED ##############################
+
+
+// ############################### PRIVATE ###############################
+
+
+void elte_fail::VertexTransferBenchmark::beginMode()
+{
+    const std::vector<TPURE_TRANSFER_MODE>& vModes = VertexTransferPolicy::getModes();
+    while (m_iMesh < m_vMeshes.size())
+    {
+        Mesh& mesh = m_vMeshes[m_iMesh];
+        if (m_iMode >= vModes.size())
+        {
+            mesh.m_pObj->setVertexTransferMode(mesh.m_originalMode);
+            m_iMesh++;
+            m_iMode = 0;
+            continue;
+        }
+
+        const TPURE_TRANSFER_MODE mode = vModes[m_iMode];
+        mesh.m_pObj->setVertexTransferMode(mode);
+        const bool bSupported = (mesh.m_pObj->getVertexTransferMode() == mode);
+        m_vResults.push_back({ mesh.m_sName, mesh.m_nVertices, mode, bSupported, 0, 0.f, FLT_MAX });
+        if (bSupported)
+        {
+            m_nFrame = 0;
+            m_fSumFrameMSecs = 0.0;
+            m_timeLastFrame = std::chrono::steady_clock::now();
+            return;
+        }
+        m_iMode++;
+    }
+    finish();
+} // beginMode()
+
+
+void elte_fail::VertexTransferBenchmark::finish()
+{
+    for (auto& result : m_vResults)
+    {
+        if (result.m_nFrames == 0)
+        {
+            result.m_fMinFrameMSecs = 0.f;
+        }
+    }
+    m_bRunning = false;
+} // finish()
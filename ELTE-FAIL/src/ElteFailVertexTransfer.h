@@ -0,0 +1,135 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailVertexTransfer.h
+    Selecting and benchmarking vertex transfer modes of ELTE-FAIL meshes.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../../../PGE/PGE/Pure/include/external/Object3D/PureObject3DManager.h"
+
+namespace elte_fail
+{
+
+    enum class MeshUsage
+    {
+        Static,    /**< Vertices are not changed after loading, only the object is transformed. */
+        Dynamic    /**< Vertices are changed by the game, so they must be sent to the GPU every frame. */
+    };
+
+    /**
+        Picks vertex transfer mode of a mesh from its vertex count and usage, so modes are not hand-picked per asset:
+         - static meshes are stored in video memory, except tiny ones for which the buffer bind costs more than sending the vertices;
+         - dynamic meshes are sent from client memory, by indexed arrays, except tiny ones for which setting up arrays costs more
+           than sending the vertices 1 by 1.
+        Thresholds are starting points, VertexTransferBenchmark shows whether they fit the actual hardware.
+    */
+    class VertexTransferPolicy
+    {
+    public:
+        static const uint32_t nMinVerticesStaticInVideoMemory = 64;
+        static const uint32_t nMinVerticesDynamicArrays = 16;
+
+        static TPURE_TRANSFER_MODE select(uint32_t nVertices, MeshUsage usage);
+
+        /**
+            Sets the mode selected for the given object, falling back to PURE_VT_DYN_IND_SVA_GEN if the selected mode is not
+            supported by the hardware.
+
+            @return The mode set.
+        */
+        static TPURE_TRANSFER_MODE apply(PureObject3D& obj, MeshUsage usage);
+
+        static uint32_t getVertexCount(const PureObject3D& obj);   /**< Vertices of the object and all its subobjects. */
+
+        static const char* getModeName(TPURE_TRANSFER_MODE mode);
+
+        static const std::vector<TPURE_TRANSFER_MODE>& getModes();   /**< Modes compared by VertexTransferBenchmark. */
+
+    private:
+        VertexTransferPolicy();
+    }; // class VertexTransferPolicy
+
+    struct VertexTransferResult
+    {
+        std::string m_sMeshName;
+        uint32_t m_nVertices;
+        TPURE_TRANSFER_MODE m_mode;
+        bool m_bSupported;          /**< False if the mode could not be set, in that case no frames were measured. */
+        uint32_t m_nFrames;
+        float m_fAvgFrameMSecs;
+        float m_fMinFrameMSecs;
+    };
+
+    /**
+        Measures frame times while switching the meshes one by one through all modes of VertexTransferPolicy::getModes(),
+        other meshes keeping their modes. Since only the mode of 1 mesh differs between the measurements of that mesh, the
+        difference of frame times is the difference of the costs of the modes for that mesh.
+        Driven by the game loop: onFrame() must be called once per frame. VSync should be disabled while running, otherwise
+        every frame takes the same time.
+        Meshes must not be deleted while the benchmark is running, their original modes are restored at the end.
+    */
+    class VertexTransferBenchmark
+    {
+    public:
+        static const uint32_t nWarmupFrames = 10;   /**< Frames skipped after each mode switch, e.g. for buffer uploads. */
+
+        VertexTransferBenchmark();
+
+        void addMesh(const std::string& sName, PureObject3D& obj);
+
+        /**
+            @return False if there are no meshes or nFramesPerMode is 0.
+        */
+        bool start(uint32_t nFramesPerMode);
+
+        bool isRunning() const;
+
+        /**
+            Records the time elapsed since the previous call, and switches to the next mode or mesh if needed.
+
+            @return True in the frame when the benchmark finished.
+        */
+        bool onFrame();
+
+        const std::vector<VertexTransferResult>& getResults() const;
+
+        /**
+            @return Result with the lowest average frame time for the given mesh, nullptr if there is no measured result for it.
+        */
+        const VertexTransferResult* getBestResult(const std::string& sMeshName) const;
+
+    private:
+
+        struct Mesh
+        {
+            std::string m_sName;
+            PureObject3D* m_pObj;
+            TPURE_TRANSFER_MODE m_originalMode;
+            uint32_t m_nVertices;
+        };
+
+        std::vector<Mesh> m_vMeshes;
+        std::vector<VertexTransferResult> m_vResults;
+        size_t m_iMesh;
+        size_t m_iMode;
+        uint32_t m_nFramesPerMode;
+        uint32_t m_nFrame;              /**< Frames since current mode was set, including warmup. */
+        double m_fSumFrameMSecs;
+        std::chrono::steady_clock::time_point m_timeLastFrame;
+        bool m_bRunning;
+
+        // ---------------------------------------------------------------------------
+
+        void beginMode();   /**< Sets current mode for current mesh, skipping unsupported modes and finished meshes. */
+        void finish();
+    }; // class VertexTransferBenchmark
+
+} // namespace elte_fail
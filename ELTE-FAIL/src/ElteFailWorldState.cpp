@@ -0,0 +1,321 @@
+/*
+    ###################################################################################
+    ElteFailWorldState.cpp
+    Join-time world state snapshot of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include "ElteFailWorldState.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "ElteFailCompression.h"
+
+
+static const uint32_t nMaxSnapshotLength = 1024 * 1024;  /**< Sanity limit for decompression buffer, way above any real snapshot. */
+
+static void writeU8(std::vector<uint8_t>& vDst, uint8_t n)
+{
+    vDst.push_back(n);
+}
+
+static void writeU16(std::vector<uint8_t>& vDst, uint16_t n)
+{
+    vDst.push_back(static_cast<uint8_t>(n & 0xFF));
+    vDst.push_back(static_cast<uint8_t>((n >> 8) & 0xFF));
+}
+
+static void writeU32(std::vector<uint8_t>& vDst, uint32_t n)
+{
+    writeU16(vDst, static_cast<uint16_t>(n & 0xFFFF));
+    writeU16(vDst, static_cast<uint16_t>((n >> 16) & 0xFFFF));
+}
+
+static void writeFloat(std::vector<uint8_t>& vDst, float f)
+{
+    uint32_t n;
+    memcpy(&n, &f, sizeof(n));
+    writeU32(vDst, n);
+}
+
+static void writeString(std::vector<uint8_t>& vDst, const std::string& str)
+{
+    // interned strings are never longer than this anyway
+    const size_t nLength = (str.length() > elte_fail::StringTable::nMaxStringLength) ? elte_fail::StringTable::nMaxStringLength : str.length();
+    writeU8(vDst, static_cast<uint8_t>(nLength));
+    vDst.insert(vDst.end(), str.begin(), str.begin() + nLength);
+}
+
+/**
+    Bounds-checked reading of the serialized snapshot. Once a read fails, all subsequent reads fail too.
+*/
+class SnapshotReader
+{
+public:
+    SnapshotReader(const uint8_t* pSrc, size_t nSrcLength) :
+        m_pSrc(pSrc),
+        m_nSrcLength(nSrcLength),
+        m_iPos(0),
+        m_bOk(true)
+    {}
+
+    bool isOk() const
+    {
+        return m_bOk;
+    }
+
+    bool isAtEnd() const
+    {
+        return m_iPos == m_nSrcLength;
+    }
+
+    uint8_t readU8()
+    {
+        if (!m_bOk || (m_iPos + 1 > m_nSrcLength))
+        {
+            m_bOk = false;
+            return 0;
+        }
+        return m_pSrc[m_iPos++];
+    }
+
+    uint16_t readU16()
+    {
+        const uint16_t nLo = readU8();
+        const uint16_t nHi = readU8();
+        return static_cast<uint16_t>(nLo | (nHi << 8));
+    }
+
+    uint32_t readU32()
+    {
+        const uint32_t nLo = readU16();
+        const uint32_t nHi = readU16();
+        return nLo | (nHi << 16);
+    }
+
+    float readFloat()
+    {
+        const uint32_t n = readU32();
+        float f;
+        memcpy(&f, &n, sizeof(f));
+        return f;
+    }
+
+    std::string readString()
+    {
+        const size_t nLength = readU8();
+        if (!m_bOk || (m_iPos + nLength > m_nSrcLength))
+        {
+            m_bOk = false;
+            return std::string();
+        }
+        std::string str(reinterpret_cast<const char*>(m_pSrc + m_iPos), nLength);
+        m_iPos += nLength;
+        return str;
+    }
+
+private:
+    const uint8_t* m_pSrc;
+    size_t m_nSrcLength;
+    size_t m_iPos;
+    bool m_bOk;
+};
+
+
+// ############################### PUBLIC ################################
+
+
+void elte_fail::WorldState::serialize(
+    const std::vector<WorldStateStringDef>& vStringDefs,
+    const std::vector<WorldStatePlayer>& vPlayers,
+    std::vector<uint8_t>& vDst)
+{
+    assert(vStringDefs.size() <= UINT16_MAX);
+    assert(vPlayers.size() <= UINT16_MAX);
+
+    writeU8(vDst, nFormatVersion);
+    writeU16(vDst, static_cast<uint16_t>(vStringDefs.size()));
+    for (const auto& stringDef : vStringDefs)
+    {
+        writeU16(vDst, stringDef.m_nStringId);
+        writeString(vDst, stringDef.m_sString);
+    }
+
+    writeU16(vDst, static_cast<uint16_t>(vPlayers.size()));
+    for (const auto& player : vPlayers)
+    {
+        writeU32(vDst, player.m_connHandleServerSide);
+        writeU16(vDst, player.m_nUserNameId);
+        writeU16(vDst, player.m_nTrollfaceId);
+        writeU16(vDst, player.m_nIpAddressId);
+        writeFloat(vDst, player.m_fPosX);
+        writeFloat(vDst, player.m_fPosY);
+    }
+} // serialize()
+
+
+bool elte_fail::WorldState::deserialize(
+    const uint8_t* pSrc,
+    size_t nSrcLength,
+    std::vector<WorldStateStringDef>& vStringDefs,
+    std::vector<WorldStatePlayer>& vPlayers)
+{
+    SnapshotReader reader(pSrc, nSrcLength);
+    if (reader.readU8() != nFormatVersion)
+    {
+        return false;
+    }
+
+    const uint16_t nStringDefs = reader.readU16();
+    vStringDefs.reserve(vStringDefs.size() + nStringDefs);
+    for (uint16_t i = 0; (i < nStringDefs) && reader.isOk(); i++)
+    {
+        WorldStateStringDef stringDef;
+        stringDef.m_nStringId = reader.readU16();
+        stringDef.m_sString = reader.readString();
+        if (reader.isOk())
+        {
+            vStringDefs.push_back(stringDef);
+        }
+    }
+
+    const uint16_t nPlayers = reader.readU16();
+    vPlayers.reserve(vPlayers.size() + nPlayers);
+    for (uint16_t i = 0; (i < nPlayers) && reader.isOk(); i++)
+    {
+        WorldStatePlayer player;
+        player.m_connHandleServerSide = reader.readU32();
+        player.m_nUserNameId = reader.readU16();
+        player.m_nTrollfaceId = reader.readU16();
+        player.m_nIpAddressId = reader.readU16();
+        player.m_fPosX = reader.readFloat();
+        player.m_fPosY = reader.readFloat();
+        if (reader.isOk())
+        {
+            vPlayers.push_back(player);
+        }
+    }
+
+    return reader.isOk() && reader.isAtEnd();
+} // deserialize()
+
+
+bool elte_fail::WorldState::initPkts(
+    std::vector<pge_network::PgePacket>& vPkts,
+    uint16_t nSnapshotId,
+    const std::vector<uint8_t>& vSnapshot,
+    bool bAllowCompression)
+{
+    std::vector<uint8_t> vCompressed;
+    if (bAllowCompression)
+    {
+        Compression::compress(vSnapshot.data(), vSnapshot.size(), vCompressed);
+    }
+
+    const bool bCompressed = bAllowCompression && (vCompressed.size() < vSnapshot.size());
+    const std::vector<uint8_t>& vData = bCompressed ? vCompressed : vSnapshot;
+
+    const size_t nFragmentCount = (vData.size() + MsgWorldStateFromServer::nMaxFragmentDataLength - 1) / MsgWorldStateFromServer::nMaxFragmentDataLength;
+    if ((nFragmentCount == 0) || (nFragmentCount > UINT8_MAX))
+    {
+        return false;
+    }
+
+    vPkts.resize(nFragmentCount);
+    for (size_t iFragment = 0; iFragment < nFragmentCount; iFragment++)
+    {
+        const size_t iStart = iFragment * MsgWorldStateFromServer::nMaxFragmentDataLength;
+        const size_t nLength = std::min<size_t>(vData.size() - iStart, MsgWorldStateFromServer::nMaxFragmentDataLength);
+        if (!MsgWorldStateFromServer::initPkt(
+            vPkts[iFragment],
+            nSnapshotId,
+            static_cast<uint8_t>(iFragment),
+            static_cast<uint8_t>(nFragmentCount),
+            bCompressed,
+            static_cast<uint32_t>(vSnapshot.size()),
+            vData.data() + iStart,
+            static_cast<uint16_t>(nLength)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+} // initPkts()
+
+
+elte_fail::WorldStateAssembler::WorldStateAssembler() :
+    m_nSnapshotId(0),
+    m_nFragmentCount(0),
+    m_bStarted(false)
+{
+
+} // WorldStateAssembler()
+
+
+elte_fail::WorldStateAssembler::Result elte_fail::WorldStateAssembler::addFragment(const MsgWorldStateFromServer& msg)
+{
+    if ((msg.m_nFragmentCount == 0) ||
+        (msg.m_iFragment >= msg.m_nFragmentCount) ||
+        (msg.m_nDataLength > MsgWorldStateFromServer::nMaxFragmentDataLength) ||
+        (msg.m_nSnapshotLength > nMaxSnapshotLength))
+    {
+        return Result::Error;
+    }
+
+    // only the last fragment can be shorter, this way every fragment can be copied to its final place immediately
+    if ((msg.m_iFragment + 1 < msg.m_nFragmentCount) && (msg.m_nDataLength != MsgWorldStateFromServer::nMaxFragmentDataLength))
+    {
+        return Result::Error;
+    }
+
+    if (!m_bStarted || (msg.m_nSnapshotId != m_nSnapshotId) || (msg.m_nFragmentCount != m_nFragmentCount))
+    {
+        m_bStarted = true;
+        m_nSnapshotId = msg.m_nSnapshotId;
+        m_nFragmentCount = msg.m_nFragmentCount;
+        m_fragmentsReceived.reset();
+        m_vData.assign(static_cast<size_t>(msg.m_nFragmentCount) * MsgWorldStateFromServer::nMaxFragmentDataLength, 0);
+    }
+
+    const size_t iStart = static_cast<size_t>(msg.m_iFragment) * MsgWorldStateFromServer::nMaxFragmentDataLength;
+    memcpy(m_vData.data() + iStart, msg.m_data, msg.m_nDataLength);
+    if (msg.m_iFragment + 1 == msg.m_nFragmentCount)
+    {
+        m_vData.resize(iStart + msg.m_nDataLength);
+    }
+    m_fragmentsReceived.set(msg.m_iFragment);
+
+    if (m_fragmentsReceived.count() < m_nFragmentCount)
+    {
+        return Result::Incomplete;
+    }
+
+    m_bStarted = false;
+    if (msg.m_bCompressed)
+    {
+        m_vSnapshot.resize(msg.m_nSnapshotLength);
+        if (!Compression::decompress(m_vData.data(), m_vData.size(), m_vSnapshot.data(), m_vSnapshot.size()))
+        {
+            return Result::Error;
+        }
+    }
+    else
+    {
+        if (m_vData.size() != msg.m_nSnapshotLength)
+        {
+            return Result::Error;
+        }
+        m_vSnapshot = m_vData;
+    }
+
+    return Result::Complete;
+} // addFragment()
+
+
+const std::vector<uint8_t>& elte_fail::WorldStateAssembler::getSnapshot() const
+{
+    return m_vSnapshot;
+} // getSnapshot()
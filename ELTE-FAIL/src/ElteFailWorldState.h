@@ -0,0 +1,117 @@
+#pragma once
+
+/*
+    ###################################################################################
+    ElteFailWorldState.h
+    Join-time world state snapshot of ELTE-FAIL.
+    Made by PR00F88
+    ###################################################################################
+*/
+
+#include <bitset>
+#include <string>
+#include <vector>
+
+#include "ElteFailPacket.h"
+#include "ElteFailStringTable.h"
+
+namespace elte_fail
+{
+
+    /**
+        State of 1 player as transferred in the world state snapshot.
+    */
+    struct WorldStatePlayer
+    {
+        pge_network::PgeNetworkConnectionHandle m_connHandleServerSide;
+        TStringId m_nUserNameId;
+        TStringId m_nTrollfaceId;
+        TStringId m_nIpAddressId;
+        TPureFloat m_fPosX;
+        TPureFloat m_fPosY;
+    };
+
+    /**
+        Definition of 1 interned string as transferred in the world state snapshot.
+    */
+    struct WorldStateStringDef
+    {
+        TStringId m_nStringId;
+        std::string m_sString;
+    };
+
+    /**
+        Serializes and deserializes the world state snapshot sent to newly connected clients in MsgWorldStateFromServer.
+        Players refer to strings by interned string id. Snapshot also carries the definitions of the strings not yet known
+        by the client, as variable-length strings (1 byte length + characters).
+    */
+    class WorldState
+    {
+    public:
+        static const uint8_t nFormatVersion = 2;
+
+        static void serialize(
+            const std::vector<WorldStateStringDef>& vStringDefs,
+            const std::vector<WorldStatePlayer>& vPlayers,
+            std::vector<uint8_t>& vDst);
+        static bool deserialize(
+            const uint8_t* pSrc,
+            size_t nSrcLength,
+            std::vector<WorldStateStringDef>& vStringDefs,
+            std::vector<WorldStatePlayer>& vPlayers);
+
+        /**
+            Creates the MsgWorldStateFromServer packets carrying the given snapshot.
+            Snapshot is compressed if compression makes it smaller and bAllowCompression is true.
+
+            @return False if the snapshot cannot fit into the max number of fragments or a packet cannot be initialized.
+        */
+        static bool initPkts(
+            std::vector<pge_network::PgePacket>& vPkts,
+            uint16_t nSnapshotId,
+            const std::vector<uint8_t>& vSnapshot,
+            bool bAllowCompression);
+
+    private:
+        WorldState();
+    }; // class WorldState
+
+    /**
+        Collects the fragments of a snapshot on client side.
+    */
+    class WorldStateAssembler
+    {
+    public:
+        enum class Result
+        {
+            Incomplete,
+            Complete,
+            Error
+        };
+
+        WorldStateAssembler();
+
+        /**
+            Stores the given fragment. A fragment with different snapshot id than the previous one starts a new snapshot.
+
+            @return Complete if this was the last missing fragment, then the snapshot is available by getSnapshot().
+        */
+        Result addFragment(const MsgWorldStateFromServer& msg);
+
+        const std::vector<uint8_t>& getSnapshot() const;   /**< Decompressed snapshot, valid after addFragment() returned Complete. */
+
+    private:
+        std::vector<uint8_t> m_vData;                  /**< Fragments as received (compressed or not). */
+        std::vector<uint8_t> m_vSnapshot;
+        std::bitset<256> m_fragmentsReceived;
+        uint16_t m_nSnapshotId;
+        uint8_t m_nFragmentCount;
+        bool m_bStarted;
+
+        // ---------------------------------------------------------------------------
+
+        WorldStateAssembler(const WorldStateAssembler&);
+        WorldStateAssembler& operator=(const WorldStateAssembler&);
+    }; // class WorldStateAssembler
+
+} // namespace elte_fail